@@ -0,0 +1,78 @@
+#include "bench.hpp"
+
+#include <ctime>
+#include <nlohmann/json.hpp>
+#include "angelscript/include/angelscript.h"
+#include "tools/log.hpp"
+
+#ifndef SERAPH_BENCH_BUILD_TYPE
+#define SERAPH_BENCH_BUILD_TYPE "unknown"
+#endif
+
+void srph::bench::Runner::Run(const std::string& name, uint64_t operations, const Body& body)
+{
+    if (!m_filter.empty() && name.find(m_filter) == std::string::npos) return;
+
+    // Warm up caches, JIT-free AngelScript still benefits from hot instruction and data caches
+    body(std::max<uint64_t>(operations / 10, 1));
+
+    std::vector<double> samples;
+    uint64_t done = 0;
+    for (uint32_t i = 0; i < m_repetitions; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        done = body(operations);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        samples.push_back(elapsed / static_cast<double>(std::max<uint64_t>(done, 1)));
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.operations = done;
+    result.nsPerOp = samples[samples.size() / 2];
+    result.minNsPerOp = samples.front();
+    result.maxNsPerOp = samples.back();
+
+    SRPH_LOG_INFO("{:<40} {:>14.1f} ns/op  (min {:.1f}, max {:.1f}, {} ops)",
+                  result.name,
+                  result.nsPerOp,
+                  result.minNsPerOp,
+                  result.maxNsPerOp,
+                  result.operations);
+
+    m_results.push_back(std::move(result));
+}
+
+void srph::bench::Runner::Fail(const std::string& message)
+{
+    SRPH_LOG_ERROR("{}", message);
+    m_failures++;
+}
+
+std::string srph::bench::Runner::Json() const
+{
+    nlohmann::json benchmarks = nlohmann::json::array();
+    for (const Result& result : m_results)
+    {
+        benchmarks.push_back({{"name", result.name},
+                              {"operations", result.operations},
+                              {"ns_per_op", result.nsPerOp},
+                              {"min_ns_per_op", result.minNsPerOp},
+                              {"max_ns_per_op", result.maxNsPerOp}});
+    }
+
+    const std::time_t now = std::time(nullptr);
+    char date[32] = {};
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    nlohmann::json context = {{"date", date},
+                              {"build_type", SERAPH_BENCH_BUILD_TYPE},
+                              {"angelscript_version", ANGELSCRIPT_VERSION_STRING},
+                              {"angelscript_options", asGetLibraryOptions()},
+                              {"repetitions", m_repetitions}};
+
+    return nlohmann::json{{"context", context}, {"benchmarks", benchmarks}}.dump(2);
+}
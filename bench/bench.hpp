@@ -0,0 +1,45 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace srph::bench
+{
+
+struct Result
+{
+    std::string name;
+    uint64_t operations = 0;
+    double nsPerOp = 0.0;
+    double minNsPerOp = 0.0;
+    double maxNsPerOp = 0.0;
+};
+
+// Runs every benchmark a few times and keeps the median. A benchmark receives the number of operations to perform and
+// returns how many it actually did (e.g. a script loop that counts for itself).
+class Runner
+{
+public:
+    using Body = std::function<uint64_t(uint64_t operations)>;
+
+    Runner(std::string filter, uint32_t repetitions) : m_filter(std::move(filter)), m_repetitions(repetitions) {}
+
+    void Run(const std::string& name, uint64_t operations, const Body& body);
+    // A differential check failed, the bench exits with an error
+    void Fail(const std::string& message);
+
+    const std::vector<Result>& Results() const { return m_results; }
+    uint32_t Failures() const { return m_failures; }
+    std::string Json() const;
+
+private:
+    std::string m_filter;
+    uint32_t m_repetitions;
+    std::vector<Result> m_results;
+    uint32_t m_failures = 0;
+};
+
+}  // namespace srph::bench
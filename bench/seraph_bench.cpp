@@ -0,0 +1,1158 @@
+#include "seraph.hpp"
+#include "bench.hpp"
+#include "runtime/scheduler.hpp"
+#include "runtime/event_bus.hpp"
+#include "jit/jit_compiler.hpp"
+#include "jit/aot.hpp"
+
+#include <cstring>
+#include <magic_enum/magic_enum.hpp>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+namespace fs = std::filesystem;
+
+constexpr const char* MODULE = "Bench";
+
+struct Vec2
+{
+    float x, y;
+
+    Vec2() = default;
+    Vec2(float x, float y) : x(x), y(y) {}
+};
+
+Vec2 operator+(const Vec2& a, const Vec2& b) { return {a.x + b.x, a.y + b.y}; }
+
+struct Options
+{
+    std::string jsonPath;
+    std::string filter;
+    // Only write the native code of the bench script, seraph_bench_aot is built with it
+    std::string aotPath;
+    uint32_t repetitions = 5;
+    uint64_t scale = 1;
+    uint32_t corpusFiles = 1000;
+    srph::memory::AllocatorStrategy allocator = srph::memory::AllocatorStrategy::System;
+};
+
+const char* BENCH_SCRIPT = R"(
+void Args0() {}
+void Args1(float a) {}
+void Args2(float a, float b) {}
+void Args3(float a, float b, float c) {}
+void Args4(float a, float b, float c, float d) {}
+void Args5(float a, float b, float c, float d, float e) {}
+void Args6(float a, float b, float c, float d, float e, float f) {}
+void Args7(float a, float b, float c, float d, float e, float f, float g) {}
+void Args8(float a, float b, float c, float d, float e, float f, float g, float h) {}
+
+class Entity
+{
+    [Serialize] float x = 1;
+    [Serialize] float y = 2;
+    [Serialize] float z = 3;
+    [Serialize] int health = 100;
+    [Serialize] int armor = 5;
+    [Serialize] bool alive = true;
+    [Serialize] string name = "entity";
+    [Serialize] double speed = 4.5;
+    array<int> inventory = {1, 2, 3};
+}
+
+float OpGeneric(uint n)
+{
+    vec2g a(0, 0);
+    vec2g b(1, 2);
+    for (uint i = 0; i < n; i++) a = a + b;
+    return a.x;
+}
+
+float OpNative(uint n)
+{
+    vec2n a(0, 0);
+    vec2n b(1, 2);
+    for (uint i = 0; i < n; i++) a = a + b;
+    return a.x;
+}
+
+class Listener
+{
+    int damage = 0;
+    void OnDamage(int amount) { damage += amount; }
+}
+
+class Bystander
+{
+    int damage = 0;
+}
+
+int Churn(uint n)
+{
+    int sum = 0;
+    for (uint i = 0; i < n; i++)
+    {
+        array<int> values(8, i);
+        string text = "value";
+        sum += values[7] + text.length();
+    }
+    return sum;
+}
+
+void Sleeper()
+{
+    while (true) wait(1000);
+}
+
+void Yielder()
+{
+    while (true) yield();
+}
+
+void Noop() {}
+
+array<uint64> timers;
+
+void PendingTimers(uint n)
+{
+    for (uint i = 0; i < n; i++) timers.insertLast(setTimeout(Noop, 3600 + i * 0.01f));
+}
+
+void IntervalTimers(uint n)
+{
+    for (uint i = 0; i < n; i++) timers.insertLast(setInterval(Noop, 0.001f));
+}
+
+void CancelTimers()
+{
+    for (uint i = 0; i < timers.length(); i++) cancel(timers[i]);
+    timers.resize(0);
+}
+
+int Spin(uint n)
+{
+    int sum = 0;
+    for (uint i = 0; i < n; i++)
+    {
+        sum += i & 7;
+    }
+    return sum;
+}
+
+uint64 Arithmetic(uint n)
+{
+    uint64 hash = 14695981039346656037;
+    int a = 7;
+    int64 b = -5;
+    float f = 1.5f;
+    double d = 2.25;
+    for (uint i = 0; i < n; i++)
+    {
+        a = a * 31 + int(i);
+        a ^= a >> 7;
+        b = b * 6364136223846793005 + 1442695040888963407;
+        f = f * 0.5f + float(i & 15);
+        d = d * 0.25 + double(a % 1000) / 3.0;
+        int q = a / (int(i % 13) - 6 == 0 ? 1 : int(i % 13) - 6);
+        uint64 mixed = uint64(a) ^ uint64(b >> 3) ^ uint64(int(f * 8)) ^ uint64(int64(d)) ^ uint64(q);
+        hash = (hash ^ mixed) * 1099511628211;
+        if (f > d) hash += 1;
+    }
+    return hash;
+}
+
+// Every instruction family the JIT translates. JitCase catches the exceptions, so division by zero and overflow
+// have to leave the native code for the interpreter to raise them. The globals are reset by every case, so the
+// results only depend on the arguments.
+int g_counter = 0;
+int64 g_counter64 = 0;
+float g_float = 0;
+double g_double = 0;
+
+uint64 JitMix(uint64 hash, uint64 value) { return (hash ^ value) * 1099511628211; }
+
+uint64 JitInt(int a, int b)
+{
+    int r = a + b;
+    r = r - a * b;
+    r = (r & 0x5555) | (a ^ b);
+    r = -r + ~a;
+    r += 7;
+    r -= 3;
+    r *= 5;
+    r = (r << (b & 31)) + (r >> (a & 31)) + (r >>> 3);
+    int i = a;
+    i++;
+    i--;
+    g_counter = b;
+    g_counter++;
+    --g_counter;
+    ++g_counter;
+    return JitMix(JitMix(uint64(r), uint64(i)), uint64(g_counter));
+}
+
+uint64 JitInt64(int a, int b)
+{
+    int64 x = a;
+    int64 y = int64(b) * 6364136223846793005;
+    int64 z = uint(b);
+    x = x + y - z;
+    x = (x & y) | (x ^ 0x0F0F0F0F0F);
+    x = -x + ~y;
+    x = (x << (b & 63)) + (x >> (a & 63)) + (x >>> 5);
+    g_counter64 = a;
+    g_counter64++;
+    --g_counter64;
+    ++g_counter64;
+    return JitMix(JitMix(uint64(x), uint64(int(x))), uint64(g_counter64));
+}
+
+uint64 JitFloat(int a, int b)
+{
+    float f = float(a);
+    float g = float(uint(b) & 0xFFFF);
+    f = f * 1.5f + g - 0.25f;
+    f = -f * g;
+    f = f - g;
+    g_float = float(b & 0xFF);
+    g_float += 1.5f;
+    g_float++;
+    --g_float;
+    double d = f;
+    d = d * 0.5 + double(a) - double(uint(b));
+    d = -d * 1.25;
+    d = d - 0.75;
+    g_double = double(a & 0xFF);
+    g_double += 2.5;
+    g_double++;
+    --g_double;
+    f = float(d) + g_float;
+    int fi = f > -1e8f && f < 1e8f ? int(f * 4) : 1;
+    uint fu = f >= 0 && f < 1e8f ? uint(f * 4) : 2;
+    int di = d > -1e14 && d < 1e14 ? int(d / 1e6) : 3;
+    uint du = d >= 0 && d < 1e14 ? uint(d / 1e6) : 4;
+    return JitMix(JitMix(JitMix(uint64(fi), uint64(fu)), uint64(di)), uint64(du) + uint64(g_double));
+}
+
+uint64 JitConversion(int a, int b)
+{
+    int8 s8 = int8(a);
+    int16 s16 = int16(b);
+    uint8 u8 = uint8(b);
+    uint16 u16 = uint16(a);
+    int r = s8 + s16 + u8 + u16;
+    int64 wide = int64(r) * int64(b);
+    return JitMix(uint64(r), uint64(int(wide)));
+}
+
+uint64 JitCompare(int a, int b)
+{
+    int c = 0;
+    if (a < b) c |= 1;
+    if (a == 7) c |= 2;
+    if (uint(a) > uint(b)) c |= 4;
+    if (uint(a) <= 100) c |= 8;
+    int64 x = a;
+    int64 y = b;
+    if (x >= y) c |= 16;
+    if (uint64(x) < uint64(y)) c |= 32;
+    float f = float(a) * 0.5f;
+    if (f < float(b)) c |= 64;
+    if (f > 2.5f) c |= 128;
+    if (double(a) != double(b) * 2) c |= 256;
+    bool positive = a > 0;
+    bool same = a == b;
+    if (positive && !same) c |= 512;
+    if (positive != same) c |= 1024;
+    bool different = a != b;
+    bool atLeast = a >= b;
+    bool atMost = a <= b;
+    bool flag = true;
+    if (different) c |= 2048;
+    if (atLeast == atMost) c |= 4096;
+    if (flag == positive) c |= 8192;
+    int8 small = 5;
+    int16 medium = 300;
+    small += int8(a);
+    medium++;
+    c += small + medium;
+    int steps = 0;
+    while (a > 0 && steps < 10)
+    {
+        a >>= 4;
+        steps++;
+    }
+    return JitMix(uint64(c), uint64(steps));
+}
+
+uint64 JitDivision(int a, int b)
+{
+    uint64 r = uint64(a / b);
+    r = JitMix(r, uint64(a % b));
+    r = JitMix(r, uint(a) / uint(b));
+    return JitMix(r, uint(a) % uint(b));
+}
+
+uint64 JitFloatDivision(int a, int b)
+{
+    float f = float(a) / float(b);
+    double d = double(a) / double(b);
+    return JitMix(uint64(int(f * 16)), uint64(int64(d * 1024)));
+}
+
+uint64 JitCase(uint family, int a, int b)
+{
+    try
+    {
+        switch (family)
+        {
+        case 0: return JitInt(a, b);
+        case 1: return JitInt64(a, b);
+        case 2: return JitFloat(a, b);
+        case 3: return JitConversion(a, b);
+        case 4: return JitCompare(a, b);
+        case 5: return JitDivision(a, b);
+        case 6: return JitFloatDivision(a, b);
+        }
+    }
+    catch
+    {
+        return 0xDEAD0000 + family;
+    }
+    return 0;
+}
+
+class Body
+{
+    private float m_position = 0;
+    private float m_velocity = 1;
+    private int m_steps = 0;
+    private double m_distance = 0;
+    float position { get const { return m_position; } set { m_position = value; } }
+    float velocity { get const { return m_velocity; } set { m_velocity = value; } }
+    int GetSteps() const { return m_steps; }
+    void SetSteps(int steps) { m_steps = steps; }
+    double GetDistance() const { return m_distance; }
+    void SetDistance(double distance) { m_distance = distance; }
+}
+
+class Projectile : Body {}
+
+int Accessors(uint n)
+{
+    Body@ body = Projectile();
+    for (uint i = 0; i < n; i++)
+    {
+        body.velocity = body.velocity * 0.5f + float(i & 3);
+        body.position = body.position + body.velocity;
+        body.SetSteps(body.GetSteps() + (body.position > 100 ? 2 : 1));
+        body.SetDistance(body.GetDistance() + body.velocity);
+    }
+    return body.GetSteps() + int(body.position) + int(body.GetDistance());
+}
+
+// Small functions the inliner replaces by their body and some it has to keep as calls: constant arguments,
+// several temporaries, division, overridden and interface methods. InlineCase catches the exceptions like JitCase.
+int InAdd(int a, int b) { return a + b; }
+int InSub(int a, int b) { return a - b; }
+int InMul(int a, int b) { return a * b; }
+int InSeven() { return 7; }
+int InId(int a) { return a; }
+int InNeg(int a) { return -a; }
+int InNot(int a) { return ~a; }
+int InShift(int a, int b) { return a << b; }
+int InMask(int a, int b) { return (a & b) | (a ^ b); }
+int InAddOne(int a) { return a + 1; }
+int InScale(int a) { return a * 3; }
+int InDiv(int a, int b) { return a / b; }
+uint InUnsigned(uint a, uint b) { return a * b; }
+int64 InWide(int64 a, int64 b) { return a * b; }
+int64 InWiden(int a) { return a; }
+int InNarrow(int64 a) { return int(a); }
+float InSquare(float x) { return x * x; }
+float InHalf(float x) { return x * 0.5f; }
+float InToFloat(int a) { return float(a); }
+double InMix(double a, double b) { return a * b + a; }
+double InToDouble(int a) { return a; }
+int InFromDouble(double d) { return int(d); }
+
+interface IShape { int Area(int scale) const; }
+
+final class Square : IShape
+{
+    int Area(int scale) const { return scale * scale; }
+    int Twice(int v) const { return v + v; }
+}
+
+class Counter
+{
+    int Step(int v) const { return v + 1; }
+    int Scale(int v) const { return v * 2; }
+}
+
+class FastCounter : Counter
+{
+    int Step(int v) const override { return v + 2; }
+}
+
+uint64 InlineArithmetic(int a, int b)
+{
+    int shift = b & 31;
+    int r = InAdd(a, b);
+    r = InSub(r, a) + InMul(a, b);
+    r += InSeven() + InId(b) + InNeg(r) + InNot(a);
+    r = InShift(r, shift) ^ InAddOne(r) ^ InScale(a) ^ InMask(r, b);
+    uint u = InUnsigned(uint(a), uint(b));
+    return JitMix(JitMix(uint64(r), uint64(u)), uint64(InAdd(InAdd(a, b), InSub(b, a))));
+}
+
+uint64 InlineWide(int a, int b)
+{
+    int64 x = InWide(InWiden(a), InWiden(b));
+    int n = InNarrow(x);
+    int low = a & 0xFFF;
+    float half = float(b & 0xFF);
+    float f = InSquare(InToFloat(low)) + InHalf(half);
+    int high = b & 0xFFFF;
+    double d = InMix(InToDouble(a), InToDouble(high));
+    double scaled = double(a & 0xFFFFF) * 0.5;
+    int back = InFromDouble(scaled);
+    return JitMix(JitMix(JitMix(uint64(x), uint64(n)), uint64(int(f))), uint64(int64(d)) + uint64(back));
+}
+
+// The result goes to a variable the arguments also come from
+uint64 InlineAliasing(int a, int b)
+{
+    int n = a;
+    n = InAdd(n, b);
+    n = InSub(b, n);
+    n = InMul(n, n);
+    n = InId(n);
+    n = InMask(n, n);
+    double d = double(b & 0xFF);
+    d = InMix(d, d);
+    int64 w = a;
+    w = InWide(w, w);
+    return JitMix(JitMix(uint64(n), uint64(int64(d))), uint64(w));
+}
+
+uint64 InlineMethods(int a, int b)
+{
+    Square square;
+    Square@ handle = square;
+    IShape@ shape = square;
+    Counter@ counter = Counter();
+    Counter@ fast = FastCounter();
+    int side = a & 0xFF;
+    int r = square.Twice(a) + handle.Twice(b) + shape.Area(side);
+    r += counter.Step(a) + fast.Step(b) + counter.Scale(a) + fast.Scale(b);
+    r = handle.Twice(r) ^ square.Area(b);
+    return JitMix(uint64(r), uint64(a));
+}
+
+// Null handles and division by zero raise the exception whether the call was inlined or not
+uint64 InlineExceptions(int a, int b)
+{
+    Counter@ counter = a >= b ? Counter() : null;
+    Square@ square = a <= b ? Square() : null;
+    Body@ body = a == b ? Body() : null;
+    int r = counter.Scale(a);
+    r += square.Twice(b);
+    body.SetSteps(r);
+    r += body.GetSteps() + InDiv(a, b);
+    return JitMix(uint64(r), uint64(b));
+}
+
+uint64 InlineCase(uint family, int a, int b)
+{
+    try
+    {
+        switch (family)
+        {
+        case 0: return InlineArithmetic(a, b);
+        case 1: return InlineWide(a, b);
+        case 2: return InlineAliasing(a, b);
+        case 3: return InlineMethods(a, b);
+        case 4: return InlineExceptions(a, b);
+        }
+    }
+    catch
+    {
+        return 0xDEAD0000 + family;
+    }
+    return 0;
+}
+)";
+
+fs::path WorkDirectory()
+{
+    fs::path dir = fs::temp_directory_path() / "seraph_bench";
+    fs::create_directories(dir);
+    return dir;
+}
+
+void WriteFile(const fs::path& path, const std::string& content) { std::ofstream(path) << content; }
+
+void RegisterTypes(srph::Engine& engine)
+{
+    srph::TypeRegistration::Class<Vec2, srph::ClassType::Value>(&engine, "vec2g", static_cast<asEObjTypeFlags>(asOBJ_POD | asOBJ_APP_CLASS_ALLFLOATS))
+        .Constructor<float, float>("float x, float y")
+        .Property("float x", offsetof(Vec2, x))
+        .Property("float y", offsetof(Vec2, y))
+        .Operator(SRPH_OPERATOR(operator+, (const Vec2&, const Vec2&), Vec2), srph::TypeRegistration::OperatorType::Add, "vec2g", "vec2g");
+
+    srph::TypeRegistration::Class<Vec2, srph::ClassType::Value>(&engine, "vec2n", static_cast<asEObjTypeFlags>(asOBJ_POD | asOBJ_APP_CLASS_ALLFLOATS))
+        .Constructor<float, float>("float x, float y")
+        .Property("float x", offsetof(Vec2, x))
+        .Property("float y", offsetof(Vec2, y))
+        .Method("vec2n opAdd(const vec2n&in) const", [](const Vec2& a, const Vec2& b) { return a + b; });
+}
+
+srph::EngineConfiguration Configuration(const Options& options)
+{
+    srph::EngineConfiguration configuration{};
+    configuration.scriptTimeoutMillis = 1e9f;
+    configuration.allocator = options.allocator;
+    return configuration;
+}
+
+bool Setup(srph::Engine& engine, const Options& options)
+{
+    engine.Initialize(Configuration(options));
+    RegisterTypes(engine);
+
+    fs::path script = WorkDirectory() / "bench.as";
+    WriteFile(script, BENCH_SCRIPT);
+
+    srph::ScriptLoader loader(&engine);
+    return loader.Module(MODULE).LoadScript(script.string()).Build();
+}
+
+template <size_t... I>
+void CallWithArgs(srph::Engine& engine, const std::string& decl, std::index_sequence<I...>)
+{
+    srph::FunctionCaller caller(&engine);
+    caller.Module(MODULE).Function(decl);
+    (caller.Push(static_cast<float>(I)), ...);
+    caller.Call();
+}
+
+template <size_t N>
+void BenchCall(srph::bench::Runner& runner, srph::Engine& engine, uint64_t operations)
+{
+    std::string decl = fmt::format("void Args{}(", N);
+    for (size_t i = 0; i < N; i++) decl += i == 0 ? "float" : ", float";
+    decl += ")";
+
+    runner.Run(fmt::format("call/args:{}", N),
+               operations,
+               [&](uint64_t ops)
+               {
+                   for (uint64_t i = 0; i < ops; i++) CallWithArgs(engine, decl, std::make_index_sequence<N>());
+                   return ops;
+               });
+}
+
+template <size_t... N>
+void BenchCalls(srph::bench::Runner& runner, srph::Engine& engine, uint64_t operations, std::index_sequence<N...>)
+{
+    (BenchCall<N>(runner, engine, operations), ...);
+}
+
+// Runs a script loop of `n` iterations through FunctionCaller, reported per loop iteration.
+uint64_t RunLoop(srph::Engine& engine, const char* decl, uint64_t n)
+{
+    srph::FunctionCaller(&engine).Module(MODULE).Function(decl).Push(static_cast<unsigned long>(n)).Call();
+    return n;
+}
+
+// Broadcast to 20000 instances of which 2% handle the event, through the event bus and through one FunctionCaller per
+// instance with an optional method
+void BenchEvents(srph::bench::Runner& runner, srph::Engine& engine, const Options& options)
+{
+    const uint32_t instances = 20000 / static_cast<uint32_t>(options.scale);
+
+    std::vector<srph::InstanceHandle> handles;
+    for (uint32_t i = 0; i < instances; i++)
+    {
+        handles.push_back(engine.CreateInstance(i % 50 == 0 ? "Listener" : "Bystander", MODULE));
+    }
+
+    srph::runtime::EventBus* bus = engine.GetEventBus();
+    const srph::runtime::EventId damage = bus->Register("void OnDamage(int)");
+
+    runner.Run(fmt::format("event/bus:{}", instances),
+               100,
+               [&](uint64_t ops)
+               {
+                   for (uint64_t i = 0; i < ops; i++) bus->Publish(damage, 1);
+                   return ops;
+               });
+
+    runner.Run(fmt::format("event/function_caller:{}", instances),
+               10,
+               [&](uint64_t ops)
+               {
+                   for (uint64_t i = 0; i < ops; i++)
+                   {
+                       for (srph::InstanceHandle handle : handles)
+                       {
+                           srph::FunctionCaller(&engine)
+                               .Module(MODULE)
+                               .Function("void OnDamage(int)", handle, srph::FunctionPolicy::Optional)
+                               .Push(1ul)
+                               .Call();
+                       }
+                   }
+                   return ops;
+               });
+}
+
+// Ticks with 10000 sleeping coroutines, then resumes of 1000 coroutines yielding every tick
+void BenchCoroutines(srph::bench::Runner& runner, srph::Engine& engine, const Options& options)
+{
+    constexpr uint64_t YIELDERS = 1000;
+
+    std::vector<srph::runtime::CoroutineId> coroutines;
+    for (int i = 0; i < 10000; i++) coroutines.push_back(engine.StartCoroutine(MODULE, "void Sleeper()"));
+    engine.Tick(0.0);
+
+    runner.Run("coroutine/tick_sleeping",
+               200000 / options.scale,
+               [&](uint64_t ops)
+               {
+                   for (uint64_t i = 0; i < ops; i++) engine.Tick(0.0);
+                   return ops;
+               });
+
+    for (uint64_t i = 0; i < YIELDERS; i++) coroutines.push_back(engine.StartCoroutine(MODULE, "void Yielder()"));
+
+    runner.Run("coroutine/resume",
+               200000 / options.scale,
+               [&](uint64_t ops)
+               {
+                   const uint64_t ticks = std::max<uint64_t>(1, ops / YIELDERS);
+                   for (uint64_t i = 0; i < ticks; i++) engine.Tick(0.0);
+                   return ticks * YIELDERS;
+               });
+
+    for (srph::runtime::CoroutineId id : coroutines) engine.GetScheduler()->Stop(id);
+}
+
+// Millisecond steps with 100000 pending timers, then firing 1000 intervals due every step
+void BenchTimers(srph::bench::Runner& runner, srph::Engine& engine, const Options& options)
+{
+    constexpr uint64_t INTERVALS = 1000;
+
+    RunLoop(engine, "void PendingTimers(uint)", 100000);
+
+    runner.Run("timer/tick_pending",
+               200000 / options.scale,
+               [&](uint64_t ops)
+               {
+                   for (uint64_t i = 0; i < ops; i++) engine.Tick(0.001);
+                   return ops;
+               });
+
+    RunLoop(engine, "void IntervalTimers(uint)", INTERVALS);
+
+    runner.Run("timer/fire",
+               200000 / options.scale,
+               [&](uint64_t ops)
+               {
+                   const uint64_t ticks = std::max<uint64_t>(1, ops / INTERVALS);
+                   for (uint64_t i = 0; i < ticks; i++) engine.Tick(0.001);
+                   return ticks * INTERVALS;
+               });
+
+    srph::FunctionCaller(&engine).Module(MODULE).Function("void CancelTimers()").Call();
+}
+
+uint64_t Arithmetic(srph::Engine& engine, uint64_t n)
+{
+    srph::FunctionResult result = srph::FunctionCaller(&engine)
+                                      .Module(MODULE)
+                                      .Function("uint64 Arithmetic(uint)")
+                                      .Push(static_cast<unsigned long>(n))
+                                      .Call(srph::ReturnType::QWord);
+    return std::get<asQWORD>(result.value);
+}
+
+uint64_t JitCase(srph::Engine& engine, uint32_t family, int32_t a, int32_t b)
+{
+    srph::FunctionResult result = srph::FunctionCaller(&engine)
+                                      .Module(MODULE)
+                                      .Function("uint64 JitCase(uint, int, int)")
+                                      .Push(static_cast<unsigned long>(family))
+                                      .Push(static_cast<unsigned long>(static_cast<uint32_t>(a)))
+                                      .Push(static_cast<unsigned long>(static_cast<uint32_t>(b)))
+                                      .Call(srph::ReturnType::QWord);
+    return std::get<asQWORD>(result.value);
+}
+
+// The JIT corpus families by JitCase index. The inputs include division by zero and INT_MIN / -1.
+constexpr const char* JIT_FAMILIES[] = {"int", "int64", "float", "conversion", "compare", "division", "float division"};
+constexpr int32_t JIT_INPUTS[] = {0, 1, -1, 3, 7, -7, 100000, INT32_MAX, INT32_MIN};
+
+// Runs the arithmetic loop and the JIT corpus on both engines, every result must agree with the reference
+void Compare(srph::bench::Runner& runner, const char* variant, srph::Engine& reference, srph::Engine& engine)
+{
+    for (uint64_t n : {0ul, 1ul, 13ul, 1000ul, 100000ul})
+    {
+        if (Arithmetic(reference, n) != Arithmetic(engine, n))
+        {
+            runner.Fail(fmt::format("{} result of Arithmetic({}) differs from the interpreter.", variant, n));
+        }
+    }
+
+    for (uint32_t family = 0; family < std::size(JIT_FAMILIES); family++)
+    {
+        for (int32_t a : JIT_INPUTS)
+        {
+            for (int32_t b : JIT_INPUTS)
+            {
+                const uint64_t expected = JitCase(reference, family, a, b);
+                const uint64_t actual = JitCase(engine, family, a, b);
+                if (expected != actual)
+                {
+                    runner.Fail(fmt::format("{} result of the {} case ({}, {}) is {:#x}, the interpreter's {:#x}.",
+                                            variant,
+                                            JIT_FAMILIES[family],
+                                            a,
+                                            b,
+                                            actual,
+                                            expected));
+                }
+            }
+        }
+    }
+}
+
+// The arithmetic loop and the JIT corpus in the interpreter and compiled by the JIT, the results of both must agree
+void BenchJit(srph::bench::Runner& runner, srph::Engine& engine, const Options& options)
+{
+    srph::EngineConfiguration configuration = Configuration(options);
+    configuration.jit = true;
+    configuration.jitHotEntries = 0;
+
+    srph::Engine jitEngine;
+    jitEngine.Initialize(configuration);
+    RegisterTypes(jitEngine);
+
+    if (!jitEngine.GetJit())
+    {
+        if (srph::jit::JitCompiler::Supported()) runner.Fail("The JIT failed to start.");
+        jitEngine.Shutdown();
+        return;
+    }
+
+    srph::ScriptLoader loader(&jitEngine);
+    if (!loader.Module(MODULE).LoadScript((WorkDirectory() / "bench.as").string()).Build())
+    {
+        runner.Fail("Failed to build the JIT benchmark script.");
+    }
+    else
+    {
+        Compare(runner, "JIT", engine, jitEngine);
+
+        const uint64_t loop = 2000000 / options.scale;
+        runner.Run("jit/interpreter", loop, [&](uint64_t ops) { return Arithmetic(engine, ops), ops; });
+        runner.Run("jit/native", loop, [&](uint64_t ops) { return Arithmetic(jitEngine, ops), ops; });
+        runner.Run("jit/spin", loop, [&](uint64_t ops) { return RunLoop(jitEngine, "int Spin(uint)", ops); });
+    }
+
+    jitEngine.Shutdown();
+}
+
+// The arithmetic loop and the JIT corpus with and without fused instruction pairs, the results of both must agree
+void BenchSuperinstructions(srph::bench::Runner& runner, srph::Engine& engine, const Options& options)
+{
+    srph::EngineConfiguration configuration = Configuration(options);
+    configuration.superinstructions = true;
+
+    srph::Engine fusedEngine;
+    fusedEngine.Initialize(configuration);
+    RegisterTypes(fusedEngine);
+
+    srph::ScriptLoader loader(&fusedEngine);
+    if (!loader.Module(MODULE).LoadScript((WorkDirectory() / "bench.as").string()).Build())
+    {
+        runner.Fail("Failed to build the superinstruction benchmark script.");
+    }
+    else
+    {
+        Compare(runner, "Fused", engine, fusedEngine);
+
+        const uint64_t loop = 2000000 / options.scale;
+        runner.Run("interpreter/plain", loop, [&](uint64_t ops) { return Arithmetic(engine, ops), ops; });
+        runner.Run("interpreter/fused", loop, [&](uint64_t ops) { return Arithmetic(fusedEngine, ops), ops; });
+    }
+
+    fusedEngine.Shutdown();
+}
+
+// The inlining corpus families by InlineCase index
+constexpr const char* INLINE_FAMILIES[] = {"arithmetic", "wide", "aliasing", "methods", "exceptions"};
+
+// The bench script built twice in the same engine, once with its small calls inlined. The accessor and arithmetic
+// loops, the JIT corpus and the inlining corpus must give the same results from both modules.
+void BenchInlining(srph::bench::Runner& runner, srph::Engine& engine, const Options& options)
+{
+    srph::ScriptLoader loader(&engine);
+    if (!loader.Module("Inlined").LoadScript((WorkDirectory() / "bench.as").string()).InlineAccessors(true).Build())
+    {
+        runner.Fail("Failed to build the inlined benchmark script.");
+        return;
+    }
+
+    if (loader.Inlining().inlined == 0)
+    {
+        runner.Fail(fmt::format("None of the {} calls of the bench script was inlined.", loader.Inlining().calls));
+    }
+
+    auto run = [&](const char* module, const char* function, srph::ReturnType type, uint64_t n) -> uint64_t
+    {
+        srph::FunctionResult result = srph::FunctionCaller(&engine)
+                                          .Module(module)
+                                          .Function(function)
+                                          .Push(static_cast<unsigned long>(n))
+                                          .Call(type);
+        return type == srph::ReturnType::QWord ? std::get<asQWORD>(result.value) : std::get<asDWORD>(result.value);
+    };
+
+    auto corpus = [&](const char* module, const char* function, uint32_t family, int32_t a, int32_t b)
+    {
+        srph::FunctionResult result = srph::FunctionCaller(&engine)
+                                          .Module(module)
+                                          .Function(function)
+                                          .Push(static_cast<unsigned long>(family))
+                                          .Push(static_cast<unsigned long>(static_cast<uint32_t>(a)))
+                                          .Push(static_cast<unsigned long>(static_cast<uint32_t>(b)))
+                                          .Call(srph::ReturnType::QWord);
+        return std::get<asQWORD>(result.value);
+    };
+
+    const std::pair<const char*, srph::ReturnType> loops[] = {{"int Accessors(uint)", srph::ReturnType::DWord},
+                                                              {"uint64 Arithmetic(uint)", srph::ReturnType::QWord}};
+    for (const auto& [function, type] : loops)
+    {
+        for (uint64_t n : {0ul, 1ul, 13ul, 1000ul, 100000ul})
+        {
+            if (run(MODULE, function, type, n) != run("Inlined", function, type, n))
+            {
+                runner.Fail(fmt::format("Inlined result of {} with {} differs from the calls.", function, n));
+            }
+        }
+    }
+
+    const std::pair<const char*, std::vector<const char*>> cases[] = {
+        {"uint64 JitCase(uint, int, int)", {std::begin(JIT_FAMILIES), std::end(JIT_FAMILIES)}},
+        {"uint64 InlineCase(uint, int, int)", {std::begin(INLINE_FAMILIES), std::end(INLINE_FAMILIES)}}};
+    for (const auto& [function, families] : cases)
+    {
+        for (uint32_t family = 0; family < families.size(); family++)
+        {
+            for (int32_t a : JIT_INPUTS)
+            {
+                for (int32_t b : JIT_INPUTS)
+                {
+                    const uint64_t expected = corpus(MODULE, function, family, a, b);
+                    const uint64_t actual = corpus("Inlined", function, family, a, b);
+                    if (expected != actual)
+                    {
+                        runner.Fail(fmt::format("Inlined result of the {} case ({}, {}) is {:#x}, the calls' {:#x}.",
+                                                families[family],
+                                                a,
+                                                b,
+                                                actual,
+                                                expected));
+                    }
+                }
+            }
+        }
+    }
+
+    const uint64_t loop = 2000000 / options.scale;
+    const auto accessors = [&](const char* module, uint64_t ops)
+    { return run(module, "int Accessors(uint)", srph::ReturnType::DWord, ops), ops; };
+    runner.Run("inline/calls", loop, [&](uint64_t ops) { return accessors(MODULE, ops); });
+    runner.Run("inline/inlined", loop, [&](uint64_t ops) { return accessors("Inlined", ops); });
+}
+
+#ifdef SERAPH_BENCH_AOT
+// The arithmetic loop and the JIT corpus bound to the native code generated from the bench script during the build,
+// the results must agree with the interpreter
+void BenchAot(srph::bench::Runner& runner, srph::Engine& engine, const Options& options)
+{
+    srph::EngineConfiguration configuration = Configuration(options);
+    configuration.aot = true;
+
+    srph::Engine aotEngine;
+    aotEngine.Initialize(configuration);
+    RegisterTypes(aotEngine);
+
+    srph::ScriptLoader loader(&aotEngine);
+    if (!loader.Module(MODULE).LoadScript((WorkDirectory() / "bench.as").string()).Build())
+    {
+        runner.Fail("Failed to build the AOT benchmark script.");
+    }
+    else if (aotEngine.GetAot()->Stats().bound == 0 || aotEngine.GetAot()->Stats().stale != 0)
+    {
+        runner.Fail(fmt::format("{} functions were bound to the generated code and {} were stale.",
+                                aotEngine.GetAot()->Stats().bound,
+                                aotEngine.GetAot()->Stats().stale));
+    }
+    else
+    {
+        Compare(runner, "AOT", engine, aotEngine);
+
+        const uint64_t loop = 2000000 / options.scale;
+        runner.Run("aot/interpreter", loop, [&](uint64_t ops) { return Arithmetic(engine, ops), ops; });
+        runner.Run("aot/native", loop, [&](uint64_t ops) { return Arithmetic(aotEngine, ops), ops; });
+    }
+
+    aotEngine.Shutdown();
+}
+#endif
+
+// Writes the native code of the bench script for seraph_bench_aot
+bool GenerateAot(const Options& options)
+{
+    srph::EngineConfiguration configuration = Configuration(options);
+    configuration.aot = true;
+
+    srph::Engine engine;
+    engine.Initialize(configuration);
+    RegisterTypes(engine);
+
+    fs::path script = WorkDirectory() / "bench.as";
+    WriteFile(script, BENCH_SCRIPT);
+
+    srph::ScriptLoader loader(&engine);
+    const bool generated = loader.Module(MODULE).LoadScript(script.string()).GenerateAot(options.aotPath).Build();
+
+    engine.Shutdown();
+    return generated;
+}
+
+void BenchEngine(srph::bench::Runner& runner, const Options& options)
+{
+    srph::Engine engine;
+    if (!Setup(engine, options))
+    {
+        SRPH_LOG_ERROR("Failed to build the benchmark script.");
+        return;
+    }
+
+    BenchCalls(runner, engine, 20000 / options.scale, std::make_index_sequence<9>());
+
+    runner.Run("instance/create",
+               20000 / options.scale,
+               [&](uint64_t ops)
+               {
+                   for (uint64_t i = 0; i < ops; i++) engine.CreateInstance("Entity", MODULE);
+                   return ops;
+               });
+
+    srph::InstanceHandle entity = engine.CreateInstance("Entity", MODULE);
+    runner.Run("reflect/all",
+               20000 / options.scale,
+               [&](uint64_t ops)
+               {
+                   size_t properties = 0;
+                   for (uint64_t i = 0; i < ops; i++) properties += engine.Reflect(entity).size();
+                   return properties > 0 ? ops : 0;
+               });
+    runner.Run("reflect/metadata",
+               20000 / options.scale,
+               [&](uint64_t ops)
+               {
+                   size_t properties = 0;
+                   for (uint64_t i = 0; i < ops; i++) properties += engine.Reflect(entity, "Serialize").size();
+                   return properties > 0 ? ops : 0;
+               });
+
+    const uint64_t loop = 2000000 / options.scale;
+    runner.Run("operator/generic", loop, [&](uint64_t ops) { return RunLoop(engine, "float OpGeneric(uint)", ops); });
+    runner.Run("operator/native", loop, [&](uint64_t ops) { return RunLoop(engine, "float OpNative(uint)", ops); });
+
+    runner.Run("memory/churn", loop / 10, [&](uint64_t ops) { return RunLoop(engine, "int Churn(uint)", ops); });
+
+    BenchCoroutines(runner, engine, options);
+    BenchTimers(runner, engine, options);
+    BenchJit(runner, engine, options);
+    BenchSuperinstructions(runner, engine, options);
+    BenchInlining(runner, engine, options);
+#ifdef SERAPH_BENCH_AOT
+    BenchAot(runner, engine, options);
+#endif
+
+    runner.Run("execute/debugger_detached", loop, [&](uint64_t ops) { return RunLoop(engine, "int Spin(uint)", ops); });
+    engine.AttachDebugger();
+    runner.Run("execute/debugger_attached", loop, [&](uint64_t ops) { return RunLoop(engine, "int Spin(uint)", ops); });
+    engine.StopDebugger();
+
+    // Last, the instances stay alive until shutdown.
+    BenchEvents(runner, engine, options);
+
+    engine.Shutdown();
+}
+
+void BenchBuild(srph::bench::Runner& runner, const Options& options)
+{
+    fs::path corpus = WorkDirectory() / "corpus";
+    fs::create_directories(corpus);
+
+    std::vector<std::string> files;
+    for (uint32_t i = 0; i < options.corpusFiles; i++)
+    {
+        fs::path path = corpus / fmt::format("file_{}.as", i);
+        WriteFile(path,
+                  fmt::format(R"(
+namespace N{0}
+{{
+    enum State{0} {{ Idle, Running, Dead }}
+
+    class Actor{0}
+    {{
+        float x = {0};
+        float y = 0;
+        int health = 100;
+        State{0} state = Idle;
+        array<float> history;
+
+        void Update(float dt)
+        {{
+            x += dt * {0};
+            if (x > 1000) {{ state = Dead; }}
+            history.insertLast(x);
+        }}
+    }}
+
+    int Compute{0}(int value)
+    {{
+        int result = 0;
+        for (int i = 0; i < value; i++) {{ result += i * {0}; }}
+        return result;
+    }}
+}}
+)",
+                              i));
+        files.push_back(path.string());
+    }
+
+    srph::Engine engine;
+    engine.Initialize(Configuration(options));
+
+    runner.Run(fmt::format("build/files:{}", options.corpusFiles),
+               1,
+               [&](uint64_t)
+               {
+                   srph::ScriptLoader loader(&engine);
+                   loader.Module("Corpus");
+                   for (const std::string& file : files) loader.LoadScript(file);
+                   return loader.Build() ? uint64_t{1} : uint64_t{0};
+               });
+
+    engine.Shutdown();
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--json") == 0 && hasValue)
+        {
+            options.jsonPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--filter") == 0 && hasValue)
+        {
+            options.filter = argv[++i];
+        }
+        else if (std::strcmp(arg, "--repetitions") == 0 && hasValue)
+        {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(arg, "--corpus-files") == 0 && hasValue)
+        {
+            options.corpusFiles = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(arg, "--allocator") == 0 && hasValue)
+        {
+            auto strategy = magic_enum::enum_cast<srph::memory::AllocatorStrategy>(argv[++i], magic_enum::case_insensitive);
+            if (!strategy) return false;
+            options.allocator = *strategy;
+        }
+        else if (std::strcmp(arg, "--generate-aot") == 0 && hasValue)
+        {
+            options.aotPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--quick") == 0)
+        {
+            options.scale = 10;
+        }
+        else
+        {
+            fmt::print("Usage: seraph_bench [--json <path>] [--filter <substring>] [--repetitions <n>] [--corpus-files <n>] "
+                       "[--allocator none|system|pooled|threadcache] [--quick] [--generate-aot <path>]\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) return 1;
+
+    if (!options.aotPath.empty())
+    {
+        const bool generated = GenerateAot(options);
+        srph::Log::Flush();
+        return generated ? 0 : 1;
+    }
+
+    srph::bench::Runner runner(options.filter, options.repetitions);
+
+    BenchEngine(runner, options);
+    BenchBuild(runner, options);
+
+    const srph::memory::MemoryStats memory = srph::memory::Stats();
+    SRPH_LOG_INFO("Script memory ({}): {} allocations, peak {} bytes, {} bytes reserved by pools",
+                  magic_enum::enum_name(memory.strategy),
+                  memory.allocations,
+                  memory.peakBytes,
+                  memory.reservedBytes);
+
+    if (!options.jsonPath.empty())
+    {
+        std::ofstream stream(options.jsonPath);
+        stream << runner.Json() << "\n";
+        if (!stream.good())
+        {
+            SRPH_LOG_ERROR("Failed to write {}.", options.jsonPath);
+            srph::Log::Flush();
+            return 1;
+        }
+    }
+
+    if (runner.Failures() != 0)
+    {
+        SRPH_LOG_ERROR("{} differential checks failed.", runner.Failures());
+        srph::Log::Flush();
+        return 1;
+    }
+
+    srph::Log::Flush();
+    return 0;
+}
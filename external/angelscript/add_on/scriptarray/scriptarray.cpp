@@ -28,6 +28,26 @@ void CScriptArray::SetMemoryFunctions(asALLOCFUNC_t allocFunc, asFREEFUNC_t free
 	userFree = freeFunc;
 }
 
+// The element buffers use the same routines unless the application gives separate ones
+static void *DefaultBufferAlloc(CScriptArray *, void *, size_t size)
+{
+	return userAlloc(size);
+}
+
+static void DefaultBufferFree(CScriptArray *, void *buffer)
+{
+	userFree(buffer);
+}
+
+static asARRAYBUFFERALLOCFUNC_t userBufferAlloc = DefaultBufferAlloc;
+static asARRAYBUFFERFREEFUNC_t  userBufferFree  = DefaultBufferFree;
+
+void CScriptArray::SetBufferMemoryFunctions(asARRAYBUFFERALLOCFUNC_t allocFunc, asARRAYBUFFERFREEFUNC_t freeFunc)
+{
+	userBufferAlloc = allocFunc ? allocFunc : DefaultBufferAlloc;
+	userBufferFree = freeFunc ? freeFunc : DefaultBufferFree;
+}
+
 static void RegisterScriptArray_Native(asIScriptEngine *engine);
 static void RegisterScriptArray_Generic(asIScriptEngine *engine);
 
@@ -679,7 +699,7 @@ void CScriptArray::Reserve(asUINT maxElements)
 		return;
 
 	// Allocate memory for the buffer
-	SArrayBuffer *newBuffer = reinterpret_cast<SArrayBuffer*>(userAlloc(sizeof(SArrayBuffer)-1 + elementSize*maxElements));
+	SArrayBuffer *newBuffer = reinterpret_cast<SArrayBuffer*>(userBufferAlloc(this, buffer, sizeof(SArrayBuffer)-1 + elementSize*maxElements));
 	if( newBuffer )
 	{
 		newBuffer->numElements = buffer->numElements;
@@ -699,7 +719,7 @@ void CScriptArray::Reserve(asUINT maxElements)
 	memcpy(newBuffer->data, buffer->data, buffer->numElements*elementSize);
 
 	// Release the old buffer
-	userFree(buffer);
+	userBufferFree(this, buffer);
 
 	buffer = newBuffer;
 }
@@ -765,7 +785,7 @@ void CScriptArray::Resize(int delta, asUINT at)
 	if( buffer->maxElements < buffer->numElements + delta )
 	{
 		// Allocate memory for the buffer
-		SArrayBuffer *newBuffer = reinterpret_cast<SArrayBuffer*>(userAlloc(sizeof(SArrayBuffer)-1 + elementSize*(buffer->numElements + delta)));
+		SArrayBuffer *newBuffer = reinterpret_cast<SArrayBuffer*>(userBufferAlloc(this, buffer, sizeof(SArrayBuffer)-1 + elementSize*(buffer->numElements + delta)));
 		if( newBuffer )
 		{
 			newBuffer->numElements = buffer->numElements + delta;
@@ -790,7 +810,7 @@ void CScriptArray::Resize(int delta, asUINT at)
 		Construct(newBuffer, at, at+delta);
 
 		// Release the old buffer
-		userFree(buffer);
+		userBufferFree(this, buffer);
 
 		buffer = newBuffer;
 	}
@@ -979,7 +999,7 @@ void *CScriptArray::GetBuffer()
 // internal
 void CScriptArray::CreateBuffer(SArrayBuffer **buf, asUINT numElements)
 {
-	*buf = reinterpret_cast<SArrayBuffer*>(userAlloc(sizeof(SArrayBuffer)-1+elementSize*numElements));
+	*buf = reinterpret_cast<SArrayBuffer*>(userBufferAlloc(this, 0, sizeof(SArrayBuffer)-1+elementSize*numElements));
 
 	if( *buf )
 	{
@@ -1002,7 +1022,14 @@ void CScriptArray::DeleteBuffer(SArrayBuffer *buf)
 	Destruct(buf, 0, buf->numElements);
 
 	// Free the buffer
-	userFree(buf);
+	userBufferFree(this, buf);
+}
+
+void CScriptArray::RelocateBuffer(void *newBuffer)
+{
+	// As objects in arrays of objects are not stored inline, the buffer can be moved with memcpy
+	memcpy(newBuffer, buffer, sizeof(SArrayBuffer)-1 + elementSize*buffer->maxElements);
+	buffer = reinterpret_cast<SArrayBuffer*>(newBuffer);
 }
 
 // internal
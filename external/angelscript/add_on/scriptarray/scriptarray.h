@@ -26,12 +26,19 @@ BEGIN_AS_NAMESPACE
 
 struct SArrayBuffer;
 struct SArrayCache;
+class CScriptArray;
+
+// replacedBuffer is the buffer that is about to be replaced when the array grows, or null for a new array
+typedef void *(*asARRAYBUFFERALLOCFUNC_t)(CScriptArray *owner, void *replacedBuffer, size_t size);
+typedef void (*asARRAYBUFFERFREEFUNC_t)(CScriptArray *owner, void *buffer);
 
 class CScriptArray
 {
 public:
 	// Set the memory functions that should be used by all CScriptArrays
 	static void SetMemoryFunctions(asALLOCFUNC_t allocFunc, asFREEFUNC_t freeFunc);
+	// Set separate memory functions for the element buffers, they are told which array owns the buffer
+	static void SetBufferMemoryFunctions(asARRAYBUFFERALLOCFUNC_t allocFunc, asARRAYBUFFERFREEFUNC_t freeFunc);
 
 	// Factory functions
 	static CScriptArray *Create(asITypeInfo *ot);
@@ -57,6 +64,10 @@ public:
 	// Pre-allocates memory for elements
 	void   Reserve(asUINT maxElements);
 
+	// Copies the element buffer to newBuffer, which must be as large as the current buffer, and uses it from then on.
+	// The old buffer is not freed, this is for allocators that move the buffers they handed out.
+	void   RelocateBuffer(void *newBuffer);
+
 	// Resize the array
 	void   Resize(asUINT numElements);
 
@@ -43,6 +43,12 @@
 #define AS_NO_IMPL_OPS_WITH_STRING_AND_PRIMITIVE 0
 #endif
 
+// This option skips the registration of the global format() function, so
+// the application can register its own implementation
+#ifndef AS_NO_STRING_FORMAT
+#define AS_NO_STRING_FORMAT 0
+#endif
+
 BEGIN_AS_NAMESPACE
 
 void RegisterStdString(asIScriptEngine *engine);
@@ -191,6 +191,7 @@ enum asEEngineProp
 	asEP_MEMBER_INIT_MODE                   = 38,
 	asEP_BOOL_CONVERSION_MODE               = 39,
 	asEP_FOREACH_SUPPORT                    = 40,
+	asEP_SUPERINSTRUCTIONS                  = 41,
 
 	asEP_LAST_PROPERTY
 };
@@ -322,7 +323,8 @@ enum asEGCFlags
 	asGC_FULL_CYCLE      = 1,
 	asGC_ONE_STEP        = 2,
 	asGC_DESTROY_GARBAGE = 4,
-	asGC_DETECT_GARBAGE  = 8
+	asGC_DETECT_GARBAGE  = 8,
+	asGC_MARK_ONLY       = 16
 };
 
 // Token classes
@@ -1654,6 +1656,37 @@ enum asEBCInstr
 	asBC_Thiscall1		= 200,
 	asBC_MAXBYTECODE	= 201,
 
+	// Superinstructions replace the first instruction of a frequent pair when asEP_SUPERINSTRUCTIONS
+	// is set, the second one stays in place. They are translated back when the bytecode is saved.
+	asBC_CMPi_JZ		= 201,
+	asBC_CMPi_JNZ		= 202,
+	asBC_CMPi_JS		= 203,
+	asBC_CMPi_JNS		= 204,
+	asBC_CMPi_JP		= 205,
+	asBC_CMPi_JNP		= 206,
+	asBC_CMPu_JZ		= 207,
+	asBC_CMPu_JNZ		= 208,
+	asBC_CMPu_JS		= 209,
+	asBC_CMPu_JNS		= 210,
+	asBC_CMPu_JP		= 211,
+	asBC_CMPu_JNP		= 212,
+	asBC_CMPIi_JZ		= 213,
+	asBC_CMPIi_JNZ		= 214,
+	asBC_CMPIi_JS		= 215,
+	asBC_CMPIi_JNS		= 216,
+	asBC_CMPIi_JP		= 217,
+	asBC_CMPIi_JNP		= 218,
+	asBC_CMPIu_JZ		= 219,
+	asBC_CMPIu_JNZ		= 220,
+	asBC_CMPIu_JS		= 221,
+	asBC_CMPIu_JNS		= 222,
+	asBC_CMPIu_JP		= 223,
+	asBC_CMPIu_JNP		= 224,
+	asBC_PshV4_PshV4	= 225,
+	asBC_PshV8_PshV8	= 226,
+	asBC_PSF_PSF		= 227,
+	asBC_MAXSUPERINSTRUCTION	= 228,
+
 	// Temporary tokens. Can't be output to the final program
 	asBC_TryBlock		= 250,
 	asBC_VarDecl		= 251,
@@ -1744,6 +1777,8 @@ struct asSBCInfo
 
 #define asBCINFO(b,t,s) {asBC_##b, asBCTYPE_##t, s, #b}
 #define asBCINFO_DUMMY(b) {asBC_MAXBYTECODE, asBCTYPE_INFO, 0, "BC_" #b}
+// Superinstructions take the type and stack increment of the instruction they replace, bc holds its opcode
+#define asBCINFO_SUPER(b,f,t,s) {asBC_##f, asBCTYPE_##t, s, #b}
 
 const asSBCInfo asBCInfo[256] =
 {
@@ -1949,33 +1984,33 @@ const asSBCInfo asBCInfo[256] =
 	asBCINFO(POWu64,	wW_rW_rW_ARG,	0),
 	asBCINFO(Thiscall1, DW_ARG,			-AS_PTR_SIZE-1),
 
-	asBCINFO_DUMMY(201),
-	asBCINFO_DUMMY(202),
-	asBCINFO_DUMMY(203),
-	asBCINFO_DUMMY(204),
-	asBCINFO_DUMMY(205),
-	asBCINFO_DUMMY(206),
-	asBCINFO_DUMMY(207),
-	asBCINFO_DUMMY(208),
-	asBCINFO_DUMMY(209),
-	asBCINFO_DUMMY(210),
-	asBCINFO_DUMMY(211),
-	asBCINFO_DUMMY(212),
-	asBCINFO_DUMMY(213),
-	asBCINFO_DUMMY(214),
-	asBCINFO_DUMMY(215),
-	asBCINFO_DUMMY(216),
-	asBCINFO_DUMMY(217),
-	asBCINFO_DUMMY(218),
-	asBCINFO_DUMMY(219),
-	asBCINFO_DUMMY(220),
-	asBCINFO_DUMMY(221),
-	asBCINFO_DUMMY(222),
-	asBCINFO_DUMMY(223),
-	asBCINFO_DUMMY(224),
-	asBCINFO_DUMMY(225),
-	asBCINFO_DUMMY(226),
-	asBCINFO_DUMMY(227),
+	asBCINFO_SUPER(CMPi_JZ,	CMPi,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPi_JNZ,	CMPi,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPi_JS,	CMPi,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPi_JNS,	CMPi,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPi_JP,	CMPi,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPi_JNP,	CMPi,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPu_JZ,	CMPu,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPu_JNZ,	CMPu,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPu_JS,	CMPu,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPu_JNS,	CMPu,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPu_JP,	CMPu,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPu_JNP,	CMPu,	rW_rW_ARG,		0),
+	asBCINFO_SUPER(CMPIi_JZ,	CMPIi,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIi_JNZ,	CMPIi,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIi_JS,	CMPIi,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIi_JNS,	CMPIi,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIi_JP,	CMPIi,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIi_JNP,	CMPIi,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIu_JZ,	CMPIu,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIu_JNZ,	CMPIu,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIu_JS,	CMPIu,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIu_JNS,	CMPIu,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIu_JP,	CMPIu,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(CMPIu_JNP,	CMPIu,	rW_DW_ARG,		0),
+	asBCINFO_SUPER(PshV4_PshV4,	PshV4,	rW_ARG,			1),
+	asBCINFO_SUPER(PshV8_PshV8,	PshV8,	rW_ARG,			2),
+	asBCINFO_SUPER(PSF_PSF,	PSF,	rW_ARG,			AS_PTR_SIZE),
 	asBCINFO_DUMMY(228),
 	asBCINFO_DUMMY(229),
 	asBCINFO_DUMMY(230),
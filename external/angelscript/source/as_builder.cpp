@@ -36,6 +36,8 @@
 //
 
 
+#include <chrono>
+
 #include "as_config.h"
 #include "as_builder.h"
 #include "as_parser.h"
@@ -51,6 +53,11 @@ BEGIN_AS_NAMESPACE
 
 #ifndef AS_NO_COMPILER
 
+double asBuildClock()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // asCSymbolTable template specializations for sGlobalVariableDescription entries
 template<>
 void asCSymbolTable<sGlobalVariableDescription>::GetKey(const sGlobalVariableDescription *entry, asSNameSpaceNamePair &key) const
@@ -203,6 +210,10 @@ void asCBuilder::Reset()
 	// Clear the cache of known types
 	hasCachedKnownTypes = false;
 	knownTypes.EraseAll();
+	hasCachedKnownEnumTypes = false;
+	numCachedModuleEnumTypes = 0;
+	knownEnumTypes.EraseAll();
+	classDeclarationsByType.EraseAll();
 #endif
 }
 
@@ -315,6 +326,7 @@ int asCBuilder::Build()
 		return asERROR;
 
 	// Compile the types first
+	double start = asBuildClock();
 	CompileInterfaces();
 	CompileClasses(numTempl);
 
@@ -322,15 +334,20 @@ int asCBuilder::Build()
 	// all classes have been fully built and it is known which ones will need garbage collection.
 	EvaluateTemplateInstances(numTempl, false);
 	engine->deferValidationOfTemplateTypes = false;
+	module->m_buildTimes.registration += asBuildClock() - start;
 	if (numErrors > 0)
 		return asERROR;
 
 	// Then the global variables. Here the variables declared with auto
 	// will be resolved, so they can be accessed properly in the functions
+	start = asBuildClock();
 	CompileGlobalVariables();
+	module->m_buildTimes.initGlobals += asBuildClock() - start;
 
 	// Finally the global functions and class methods
+	start = asBuildClock();
 	CompileFunctions();
+	module->m_buildTimes.compileFunctions += asBuildClock() - start;
 
 	// TODO: Attempt to reorder the initialization of global variables so that
 	//       they do not access other uninitialized global variables out-of-order
@@ -595,6 +612,8 @@ int asCBuilder::CompileFunction(const char *sectionName, const char *code, int l
 	}
 
 	functions.PushLast(funcDesc);
+	if( func->objectType == 0 )
+		AddDeclaredName(func->nameSpace, func->name, func->IsProperty());
 	funcDesc->script            = scripts[0];
 	funcDesc->node              = node;
 	funcDesc->name              = func->name;
@@ -652,6 +671,7 @@ void asCBuilder::ParseScripts()
 	asCArray<asCParser*> parsers((int)scripts.GetLength());
 
 	// Parse all the files as if they were one
+	double start = asBuildClock();
 	asUINT n = 0;
 	for( n = 0; n < scripts.GetLength(); n++ )
 	{
@@ -664,6 +684,9 @@ void asCBuilder::ParseScripts()
 			parser->ParseScript(scripts[n]);
 		}
 	}
+	module->m_buildTimes.parse += asBuildClock() - start;
+
+	start = asBuildClock();
 
 	if (numErrors == 0)
 	{
@@ -820,6 +843,7 @@ void asCBuilder::ParseScripts()
 	{
 		asDELETE(parsers[n],asCParser);
 	}
+	module->m_buildTimes.registration += asBuildClock() - start;
 }
 
 void asCBuilder::RegisterTypesFromScript(asCScriptNode *node, asCScriptCode *script, asSNameSpace *ns)
@@ -1021,15 +1045,7 @@ void asCBuilder::CompileFunctions()
 		sClassDeclaration *classDecl = 0;
 		if( current->objType && current->name == current->objType->name )
 		{
-			for( asUINT c = 0; c < classDeclarations.GetLength(); c++ )
-			{
-				if( classDeclarations[c]->typeInfo == current->objType )
-				{
-					classDecl = classDeclarations[c];
-					break;
-				}
-			}
-
+			classDecl = GetClassDeclaration(current->objType);
 			asASSERT( classDecl );
 		}
 
@@ -1757,6 +1773,10 @@ int asCBuilder::CheckNameConflict(const char *name, asCScriptNode *node, asCScri
 	}
 
 #ifndef AS_NO_COMPILER
+	// The declarations of the scripts can only conflict with names that were declared
+	if( !declaredNames.Find(asSNameSpaceNamePair(ns, name)) )
+		return 0;
+
 	// Check against interface types
 	asUINT n;
 	for (n = 0; n < interfaceDeclarations.GetLength(); n++)
@@ -2021,6 +2041,21 @@ int asCBuilder::ValidateVirtualProperty(asCScriptFunction *func)
 }
 
 #ifndef AS_NO_COMPILER
+void asCBuilder::AddDeclaredName(asSNameSpace *ns, const asCString &name, bool isProperty)
+{
+	declaredNames.Insert(asSNameSpaceNamePair(ns, name), true);
+
+	// Virtual properties conflict with the name without the get_ or set_ prefix
+	if( isProperty && name.GetLength() > 4 )
+		declaredNames.Insert(asSNameSpaceNamePair(ns, name.SubString(4)), true);
+}
+
+sClassDeclaration *asCBuilder::GetClassDeclaration(asCTypeInfo *type)
+{
+	sClassDeclaration **decl = classDeclarationsByType.Find(type);
+	return decl ? *decl : 0;
+}
+
 sMixinClass *asCBuilder::GetMixinClass(const char *name, asSNameSpace *ns)
 {
 	for( asUINT n = 0; n < mixinClasses.GetLength(); n++ )
@@ -2088,6 +2123,7 @@ int asCBuilder::RegisterFuncDef(asCScriptNode *node, asCScriptCode *file, asSNam
 	fd->idx    = module->AddFuncDef(name, ns, parent);
 
 	funcDefs.PushLast(fd);
+	AddDeclaredName(module->m_funcDefs[fd->idx]->nameSpace, name);
 
 	return 0;
 }
@@ -2328,6 +2364,7 @@ int asCBuilder::RegisterMixinClass(asCScriptNode *node, asCScriptCode *file, asS
 	}
 
 	mixinClasses.PushLast(decl);
+	AddDeclaredName(ns, name);
 	decl->name   = name;
 	decl->ns     = ns;
 	decl->node   = cl;
@@ -2438,6 +2475,7 @@ int asCBuilder::RegisterClass(asCScriptNode *node, asCScriptCode *file, asSNameS
 	}
 
 	classDeclarations.PushLast(decl);
+	AddDeclaredName(ns, name);
 	decl->name             = name;
 	decl->script           = file;
 	decl->node             = node;
@@ -2611,6 +2649,7 @@ int asCBuilder::RegisterInterface(asCScriptNode *node, asCScriptCode *file, asSN
 	}
 
 	interfaceDeclarations.PushLast(decl);
+	AddDeclaredName(ns, name);
 	decl->name             = name;
 	decl->script           = file;
 	decl->node             = node;
@@ -3444,6 +3483,13 @@ void asCBuilder::CompileClasses(asUINT numTempl)
 	asUINT n;
 	asCArray<sClassDeclaration*> toValidate((int)classDeclarations.GetLength());
 
+	// All the classes are registered at this point, so they can be indexed by their type
+	for( n = 0; n < classDeclarations.GetLength(); n++ )
+	{
+		if( !classDeclarationsByType.Find(classDeclarations[n]->typeInfo) )
+			classDeclarationsByType.Insert(classDeclarations[n]->typeInfo, classDeclarations[n]);
+	}
+
 	// Order class declarations so that base classes are compiled before derived classes.
 	// This will allow the derived classes to copy properties and methods in the next step.
 	for( n = 0; n < classDeclarations.GetLength(); n++ )
@@ -3840,15 +3886,7 @@ void asCBuilder::CompileClasses(asUINT numTempl)
 				if( dt.IsObject() && !dt.IsObjectHandle() )
 				{
 					// Find the class declaration
-					sClassDeclaration *pdecl = 0;
-					for( asUINT p = 0; p < classDeclarations.GetLength(); p++ )
-					{
-						if( classDeclarations[p]->typeInfo == dt.GetTypeInfo() )
-						{
-							pdecl = classDeclarations[p];
-							break;
-						}
-					}
+					sClassDeclaration *pdecl = GetClassDeclaration(dt.GetTypeInfo());
 
 					if( pdecl )
 					{
@@ -4456,6 +4494,7 @@ int asCBuilder::CreateVirtualFunction(asCScriptFunction *func, int idx)
 	vf->objectType       = func->objectType;
 	vf->objectType->AddRefInternal();
 	vf->signatureId      = func->signatureId;
+	engine->AddSignatureUser(vf);
 	vf->vfTableIdx       = idx;
 	vf->traits           = func->traits;
 
@@ -4765,6 +4804,7 @@ int asCBuilder::RegisterEnum(asCScriptNode *node, asCScriptCode *file, asSNameSp
 		decl->script           = file;
 		decl->typeInfo         = st;
 		namedTypeDeclarations.PushLast(decl);
+		AddDeclaredName(ns, name);
 
 		asCDataType type = CreateDataTypeFromNode(tmp, file, ns);
 		asASSERT(!type.IsReference());
@@ -4926,6 +4966,7 @@ int asCBuilder::RegisterTypedef(asCScriptNode *node, asCScriptCode *file, asSNam
 			decl->script           = file;
 			decl->typeInfo         = st;
 			namedTypeDeclarations.PushLast(decl);
+			AddDeclaredName(ns, name);
 		}
 	}
 
@@ -5395,6 +5436,8 @@ int asCBuilder::RegisterScriptFunction(asCScriptNode *node, asCScriptCode *file,
 		}
 
 		functions.PushLast(func);
+		if( objType == 0 )
+			AddDeclaredName(ns, name, funcTraits.GetTrait(asTRAIT_PROPERTY));
 
 		func->script            = file;
 		func->node              = node;
@@ -6908,8 +6951,7 @@ bool asCBuilder::DoesTypeExist(const asCString &type)
 		engine->allRegisteredTypes.MoveFirst(&cursor);
 		while( cursor )
 		{
-			if( !knownTypes.MoveTo(0, cursor->key.name) )
-				knownTypes.Insert(cursor->key.name, true);
+			knownTypes.Insert(cursor->key.name, true);
 
 			engine->allRegisteredTypes.MoveNext(&cursor, cursor);
 		}
@@ -6918,28 +6960,24 @@ bool asCBuilder::DoesTypeExist(const asCString &type)
 		{
 			// Add script classes and interfaces
 			for (n = 0; n < module->m_classTypes.GetLength(); n++)
-				if (!knownTypes.MoveTo(0, module->m_classTypes[n]->name))
-					knownTypes.Insert(module->m_classTypes[n]->name, true);
+				knownTypes.Insert(module->m_classTypes[n]->name, true);
 
 			// Add script enums
 			for (n = 0; n < module->m_enumTypes.GetLength(); n++)
-				if (!knownTypes.MoveTo(0, module->m_enumTypes[n]->name))
-					knownTypes.Insert(module->m_enumTypes[n]->name, true);
+				knownTypes.Insert(module->m_enumTypes[n]->name, true);
 
 			// Add script typedefs
 			for (n = 0; n < module->m_typeDefs.GetLength(); n++)
-				if (!knownTypes.MoveTo(0, module->m_typeDefs[n]->name))
-					knownTypes.Insert(module->m_typeDefs[n]->name, true);
+				knownTypes.Insert(module->m_typeDefs[n]->name, true);
 
 			// Add script funcdefs
 			for (n = 0; n < module->m_funcDefs.GetLength(); n++)
-				if (!knownTypes.MoveTo(0, module->m_funcDefs[n]->name))
-					knownTypes.Insert(module->m_funcDefs[n]->name, true);
+				knownTypes.Insert(module->m_funcDefs[n]->name, true);
 		}
 	}
 
 	// Check if the type is known
-	return knownTypes.MoveTo(0, type);
+	return knownTypes.Find(type) != 0;
 }
 #endif
 
@@ -7048,34 +7086,29 @@ int asCBuilder::GetEnumValue(const char *name, asCDataType &outDt, asDWORD &outV
 {
 	bool found = false;
 
-	// Search all available enum types
+	// Group the available enum types by namespace, again if the module got more since the last time
 	asUINT t;
-	for( t = 0; t < engine->registeredEnums.GetLength(); t++ )
+	if( !hasCachedKnownEnumTypes || numCachedModuleEnumTypes != module->m_enumTypes.GetLength() )
 	{
-		asCEnumType *et = engine->registeredEnums[t];
-		if( ns != et->nameSpace ) continue;
+		hasCachedKnownEnumTypes = true;
+		numCachedModuleEnumTypes = module->m_enumTypes.GetLength();
 
-		// Don't bother with types the module doesn't have access to
-		if( (et->accessMask & module->m_accessMask) == 0 )
-			continue;
-
-		if( GetEnumValueFromType(et, name, outDt, outValue) )
+		knownEnumTypes.EraseAll();
+		for( t = 0; t < engine->registeredEnums.GetLength(); t++ )
 		{
-			if( !found )
-				found = true;
-			else
-			{
-				// Found more than one value in different enum types
-				return 2;
-			}
+			// Don't bother with types the module doesn't have access to
+			asCEnumType *et = engine->registeredEnums[t];
+			if( (et->accessMask & module->m_accessMask) != 0 )
+				AddKnownEnumType(et);
 		}
+		for( t = 0; t < module->m_enumTypes.GetLength(); t++ )
+			AddKnownEnumType(module->m_enumTypes[t]);
 	}
 
-	for( t = 0; t < module->m_enumTypes.GetLength(); t++ )
+	asCArray<asCEnumType*> *enumTypes = knownEnumTypes.Find(ns);
+	for( t = 0; enumTypes && t < enumTypes->GetLength(); t++ )
 	{
-		asCEnumType *et = module->m_enumTypes[t];
-		if( ns != et->nameSpace ) continue;
-
+		asCEnumType *et = (*enumTypes)[t];
 		if( GetEnumValueFromType(et, name, outDt, outValue) )
 		{
 			if( !found )
@@ -7095,6 +7128,19 @@ int asCBuilder::GetEnumValue(const char *name, asCDataType &outDt, asDWORD &outV
 	return 0;
 }
 
+void asCBuilder::AddKnownEnumType(asCEnumType *type)
+{
+	asCArray<asCEnumType*> *enumTypes = knownEnumTypes.Find(type->nameSpace);
+	if( enumTypes )
+		enumTypes->PushLast(type);
+	else
+	{
+		asCArray<asCEnumType*> arr(1);
+		arr.PushLast(type);
+		knownEnumTypes.Insert(type->nameSpace, arr);
+	}
+}
+
 #endif // AS_NO_COMPILER
 
 END_AS_NAMESPACE
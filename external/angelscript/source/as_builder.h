@@ -58,6 +58,9 @@ struct sGlobalVariableDescription;
 
 #ifndef AS_NO_COMPILER
 
+// Seconds on a monotonic clock, for the build times of the modules
+double asBuildClock();
+
 struct sFunctionDescription
 {
 	asCScriptCode       *script;
@@ -213,6 +216,8 @@ protected:
 	int                GetNamespaceAndNameFromNode(asCScriptNode *n, asCScriptCode *script, asSNameSpace *implicitNs, asSNameSpace *&outNs, asCString &outName, bool *isExplicitNs = 0);
 	int                RegisterMixinClass(asCScriptNode *node, asCScriptCode *file, asSNameSpace *ns);
 	sMixinClass       *GetMixinClass(const char *name, asSNameSpace *ns);
+	void               AddDeclaredName(asSNameSpace *ns, const asCString &name, bool isProperty = false);
+	sClassDeclaration *GetClassDeclaration(asCTypeInfo *type);
 	void               IncludePropertiesFromMixins(sClassDeclaration *decl);
 	void               IncludeMethodsFromMixins(sClassDeclaration *decl);
 	void               AddInterfaceToClass(sClassDeclaration *decl, asCScriptNode *errNode, asCObjectType *intf);
@@ -248,6 +253,7 @@ protected:
 	void               CompileGlobalVariables();
 	int                GetEnumValueFromType(asCEnumType *type, const char *name, asCDataType &outDt, asDWORD &outValue);
 	int                GetEnumValue(const char *name, asCDataType &outDt, asDWORD &outValue, asSNameSpace *ns);
+	void               AddKnownEnumType(asCEnumType *type);
 	bool               DoesTypeExist(const asCString &type);
 	asCObjectProperty *GetObjectProperty(asCDataType &obj, const char *prop);
 	asCScriptFunction *GetFunctionDescription(int funcId);
@@ -265,9 +271,21 @@ protected:
 	asCArray<sFuncDef *>                              funcDefs;
 	asCArray<sMixinClass *>                           mixinClasses;
 
+	// Namespace and name of the types, funcdefs, mixins and global functions declared by the scripts, and
+	// of the global virtual properties. CheckNameConflict only searches the declarations for these names.
+	asCHashMap<asSNameSpaceNamePair, bool>            declaredNames;
+
 	// For use with the DoesTypeExists() method
-	bool                    hasCachedKnownTypes;
-	asCMap<asCString, bool> knownTypes;
+	bool                        hasCachedKnownTypes;
+	asCHashMap<asCString, bool> knownTypes;
+
+	// For use with the GetEnumValue() method, the enum types the module can see in each namespace
+	bool                                               hasCachedKnownEnumTypes;
+	asUINT                                             numCachedModuleEnumTypes;
+	asCHashMap<asSNameSpace*, asCArray<asCEnumType*> > knownEnumTypes;
+
+	// For use with the GetClassDeclaration() method, filled once the classes are registered
+	asCHashMap<asCTypeInfo*, sClassDeclaration*>       classDeclarationsByType;
 #endif
 };
 
@@ -98,14 +98,14 @@ public:
 			// Output instruction statistics
 			fprintf(f, "\nTotal count\n");
 			int n;
-			for( n = 0; n < asBC_MAXBYTECODE; n++ )
+			for( n = 0; n < asBC_MAXSUPERINSTRUCTION; n++ )
 			{
 				if( asBCInfo[n].name && instrCount[n] > 0 )
 					fprintf(f, "%-10.10s : %.0f\n", asBCInfo[n].name, instrCount[n]);
 			}
 
 			fprintf(f, "\nNever executed\n");
-			for( n = 0; n < asBC_MAXBYTECODE; n++ )
+			for( n = 0; n < asBC_MAXSUPERINSTRUCTION; n++ )
 			{
 				if( asBCInfo[n].name && instrCount[n] == 0 )
 					fprintf(f, "%-10.10s\n", asBCInfo[n].name);
@@ -2269,15 +2269,13 @@ static const void *const dispatch_table[256] = {
 &&INSTRUCTION(asBC_JLowNZ),		&&INSTRUCTION(asBC_AllocMem),	&&INSTRUCTION(asBC_SetListSize),&&INSTRUCTION(asBC_PshListElmnt),
 &&INSTRUCTION(asBC_SetListType),&&INSTRUCTION(asBC_POWi),		&&INSTRUCTION(asBC_POWu),		&&INSTRUCTION(asBC_POWf),
 &&INSTRUCTION(asBC_POWd),		&&INSTRUCTION(asBC_POWdi),		&&INSTRUCTION(asBC_POWi64),		&&INSTRUCTION(asBC_POWu64),
-&&INSTRUCTION(asBC_Thiscall1),
-
-								&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
-&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
-&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
-&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
-&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
-&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
-&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
+&&INSTRUCTION(asBC_Thiscall1),	&&INSTRUCTION(asBC_CMPi_JZ),	&&INSTRUCTION(asBC_CMPi_JNZ),	&&INSTRUCTION(asBC_CMPi_JS),
+&&INSTRUCTION(asBC_CMPi_JNS),	&&INSTRUCTION(asBC_CMPi_JP),	&&INSTRUCTION(asBC_CMPi_JNP),	&&INSTRUCTION(asBC_CMPu_JZ),
+&&INSTRUCTION(asBC_CMPu_JNZ),	&&INSTRUCTION(asBC_CMPu_JS),	&&INSTRUCTION(asBC_CMPu_JNS),	&&INSTRUCTION(asBC_CMPu_JP),
+&&INSTRUCTION(asBC_CMPu_JNP),	&&INSTRUCTION(asBC_CMPIi_JZ),	&&INSTRUCTION(asBC_CMPIi_JNZ),	&&INSTRUCTION(asBC_CMPIi_JS),
+&&INSTRUCTION(asBC_CMPIi_JNS),	&&INSTRUCTION(asBC_CMPIi_JP),	&&INSTRUCTION(asBC_CMPIi_JNP),	&&INSTRUCTION(asBC_CMPIu_JZ),
+&&INSTRUCTION(asBC_CMPIu_JNZ),	&&INSTRUCTION(asBC_CMPIu_JS),	&&INSTRUCTION(asBC_CMPIu_JNS),	&&INSTRUCTION(asBC_CMPIu_JP),
+&&INSTRUCTION(asBC_CMPIu_JNP),	&&INSTRUCTION(asBC_PshV4_PshV4),&&INSTRUCTION(asBC_PshV8_PshV8),&&INSTRUCTION(asBC_PSF_PSF),
 &&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
 &&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
 &&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),			&&INSTRUCTION(FAULT),
@@ -4882,36 +4880,76 @@ static const void *const dispatch_table[256] = {
 		}
 		NEXT_INSTRUCTION();
 
+	//-----------------------------------
+	// Superinstructions, see asCScriptFunction::FuseInstructions. The operands
+	// of the second instruction follow the first instruction as usual.
+
+	// Compare, then jump like the JZ to JNP that follows. The value register
+	// is still set since the original pair leaves the comparison there.
+#define SUPER_COMPARE_AND_JUMP(T, second, condition) \
+		{ \
+			T v1 = *(T*)(l_fp - asBC_SWORDARG0(l_bc)); \
+			T v2 = second; \
+			int r = v1 == v2 ? 0 : (v1 < v2 ? -1 : 1); \
+			*(int*)&m_regs.valueRegister = r; \
+			l_bc += (r condition) ? asBC_INTARG((l_bc+2)) + 4 : 4; \
+		} \
+		NEXT_INSTRUCTION();
+
+	INSTRUCTION(asBC_CMPi_JZ): SUPER_COMPARE_AND_JUMP(int, *(int*)(l_fp - asBC_SWORDARG1(l_bc)), == 0)
+	INSTRUCTION(asBC_CMPi_JNZ): SUPER_COMPARE_AND_JUMP(int, *(int*)(l_fp - asBC_SWORDARG1(l_bc)), != 0)
+	INSTRUCTION(asBC_CMPi_JS): SUPER_COMPARE_AND_JUMP(int, *(int*)(l_fp - asBC_SWORDARG1(l_bc)), < 0)
+	INSTRUCTION(asBC_CMPi_JNS): SUPER_COMPARE_AND_JUMP(int, *(int*)(l_fp - asBC_SWORDARG1(l_bc)), >= 0)
+	INSTRUCTION(asBC_CMPi_JP): SUPER_COMPARE_AND_JUMP(int, *(int*)(l_fp - asBC_SWORDARG1(l_bc)), > 0)
+	INSTRUCTION(asBC_CMPi_JNP): SUPER_COMPARE_AND_JUMP(int, *(int*)(l_fp - asBC_SWORDARG1(l_bc)), <= 0)
+
+	INSTRUCTION(asBC_CMPu_JZ): SUPER_COMPARE_AND_JUMP(asDWORD, *(asDWORD*)(l_fp - asBC_SWORDARG1(l_bc)), == 0)
+	INSTRUCTION(asBC_CMPu_JNZ): SUPER_COMPARE_AND_JUMP(asDWORD, *(asDWORD*)(l_fp - asBC_SWORDARG1(l_bc)), != 0)
+	INSTRUCTION(asBC_CMPu_JS): SUPER_COMPARE_AND_JUMP(asDWORD, *(asDWORD*)(l_fp - asBC_SWORDARG1(l_bc)), < 0)
+	INSTRUCTION(asBC_CMPu_JNS): SUPER_COMPARE_AND_JUMP(asDWORD, *(asDWORD*)(l_fp - asBC_SWORDARG1(l_bc)), >= 0)
+	INSTRUCTION(asBC_CMPu_JP): SUPER_COMPARE_AND_JUMP(asDWORD, *(asDWORD*)(l_fp - asBC_SWORDARG1(l_bc)), > 0)
+	INSTRUCTION(asBC_CMPu_JNP): SUPER_COMPARE_AND_JUMP(asDWORD, *(asDWORD*)(l_fp - asBC_SWORDARG1(l_bc)), <= 0)
+
+	INSTRUCTION(asBC_CMPIi_JZ): SUPER_COMPARE_AND_JUMP(int, asBC_INTARG(l_bc), == 0)
+	INSTRUCTION(asBC_CMPIi_JNZ): SUPER_COMPARE_AND_JUMP(int, asBC_INTARG(l_bc), != 0)
+	INSTRUCTION(asBC_CMPIi_JS): SUPER_COMPARE_AND_JUMP(int, asBC_INTARG(l_bc), < 0)
+	INSTRUCTION(asBC_CMPIi_JNS): SUPER_COMPARE_AND_JUMP(int, asBC_INTARG(l_bc), >= 0)
+	INSTRUCTION(asBC_CMPIi_JP): SUPER_COMPARE_AND_JUMP(int, asBC_INTARG(l_bc), > 0)
+	INSTRUCTION(asBC_CMPIi_JNP): SUPER_COMPARE_AND_JUMP(int, asBC_INTARG(l_bc), <= 0)
+
+	INSTRUCTION(asBC_CMPIu_JZ): SUPER_COMPARE_AND_JUMP(asDWORD, asBC_DWORDARG(l_bc), == 0)
+	INSTRUCTION(asBC_CMPIu_JNZ): SUPER_COMPARE_AND_JUMP(asDWORD, asBC_DWORDARG(l_bc), != 0)
+	INSTRUCTION(asBC_CMPIu_JS): SUPER_COMPARE_AND_JUMP(asDWORD, asBC_DWORDARG(l_bc), < 0)
+	INSTRUCTION(asBC_CMPIu_JNS): SUPER_COMPARE_AND_JUMP(asDWORD, asBC_DWORDARG(l_bc), >= 0)
+	INSTRUCTION(asBC_CMPIu_JP): SUPER_COMPARE_AND_JUMP(asDWORD, asBC_DWORDARG(l_bc), > 0)
+	INSTRUCTION(asBC_CMPIu_JNP): SUPER_COMPARE_AND_JUMP(asDWORD, asBC_DWORDARG(l_bc), <= 0)
+
+#undef SUPER_COMPARE_AND_JUMP
+
+	INSTRUCTION(asBC_PshV4_PshV4):
+		l_sp -= 2;
+		l_sp[1] = *(l_fp - asBC_SWORDARG0(l_bc));
+		l_sp[0] = *(l_fp - asBC_SWORDARG0((l_bc+1)));
+		l_bc += 2;
+		NEXT_INSTRUCTION();
+
+	INSTRUCTION(asBC_PshV8_PshV8):
+		l_sp -= 4;
+		*(asQWORD*)(l_sp+2) = *(asQWORD*)(l_fp - asBC_SWORDARG0(l_bc));
+		*(asQWORD*)l_sp     = *(asQWORD*)(l_fp - asBC_SWORDARG0((l_bc+1)));
+		l_bc += 2;
+		NEXT_INSTRUCTION();
+
+	INSTRUCTION(asBC_PSF_PSF):
+		l_sp -= 2*AS_PTR_SIZE;
+		*(asPWORD*)(l_sp+AS_PTR_SIZE) = asPWORD(l_fp - asBC_SWORDARG0(l_bc));
+		*(asPWORD*)l_sp               = asPWORD(l_fp - asBC_SWORDARG0((l_bc+1)));
+		l_bc += 2;
+		NEXT_INSTRUCTION();
+
 	// Don't let the optimizer optimize for size,
 	// since it requires extra conditions and jumps
 #if AS_USE_COMPUTED_GOTOS == 0
-	INSTRUCTION(201): l_bc = (asDWORD*)201; goto case_FAULT;
-	INSTRUCTION(202): l_bc = (asDWORD*)202; goto case_FAULT;
-	INSTRUCTION(203): l_bc = (asDWORD*)203; goto case_FAULT;
-	INSTRUCTION(204): l_bc = (asDWORD*)204; goto case_FAULT;
-	INSTRUCTION(205): l_bc = (asDWORD*)205; goto case_FAULT;
-	INSTRUCTION(206): l_bc = (asDWORD*)206; goto case_FAULT;
-	INSTRUCTION(207): l_bc = (asDWORD*)207; goto case_FAULT;
-	INSTRUCTION(208): l_bc = (asDWORD*)208; goto case_FAULT;
-	INSTRUCTION(209): l_bc = (asDWORD*)209; goto case_FAULT;
-	INSTRUCTION(210): l_bc = (asDWORD*)210; goto case_FAULT;
-	INSTRUCTION(211): l_bc = (asDWORD*)211; goto case_FAULT;
-	INSTRUCTION(212): l_bc = (asDWORD*)212; goto case_FAULT;
-	INSTRUCTION(213): l_bc = (asDWORD*)213; goto case_FAULT;
-	INSTRUCTION(214): l_bc = (asDWORD*)214; goto case_FAULT;
-	INSTRUCTION(215): l_bc = (asDWORD*)215; goto case_FAULT;
-	INSTRUCTION(216): l_bc = (asDWORD*)216; goto case_FAULT;
-	INSTRUCTION(217): l_bc = (asDWORD*)217; goto case_FAULT;
-	INSTRUCTION(218): l_bc = (asDWORD*)218; goto case_FAULT;
-	INSTRUCTION(219): l_bc = (asDWORD*)219; goto case_FAULT;
-	INSTRUCTION(220): l_bc = (asDWORD*)220; goto case_FAULT;
-	INSTRUCTION(221): l_bc = (asDWORD*)221; goto case_FAULT;
-	INSTRUCTION(222): l_bc = (asDWORD*)222; goto case_FAULT;
-	INSTRUCTION(223): l_bc = (asDWORD*)223; goto case_FAULT;
-	INSTRUCTION(224): l_bc = (asDWORD*)224; goto case_FAULT;
-	INSTRUCTION(225): l_bc = (asDWORD*)225; goto case_FAULT;
-	INSTRUCTION(226): l_bc = (asDWORD*)226; goto case_FAULT;
-	INSTRUCTION(227): l_bc = (asDWORD*)227; goto case_FAULT;
 	INSTRUCTION(228): l_bc = (asDWORD*)228; goto case_FAULT;
 	INSTRUCTION(229): l_bc = (asDWORD*)229; goto case_FAULT;
 	INSTRUCTION(230): l_bc = (asDWORD*)230; goto case_FAULT;
@@ -4961,7 +4999,7 @@ static const void *const dispatch_table[256] = {
 		asDWORD instr = *(asBYTE*)old;
 		if( instr != asBC_JMP && instr != asBC_JMPP && (instr < asBC_JZ || instr > asBC_JNP) && instr != asBC_JLowZ && instr != asBC_JLowNZ &&
 			instr != asBC_CALL && instr != asBC_CALLBND && instr != asBC_CALLINTF && instr != asBC_RET && instr != asBC_ALLOC && instr != asBC_CallPtr &&
-			instr != asBC_JitEntry )
+			instr != asBC_JitEntry && (instr < asBC_MAXBYTECODE || instr >= asBC_MAXSUPERINSTRUCTION) )
 		{
 			asASSERT( (l_bc - old) == asBCTypeSize[asBCInfo[instr].type] );
 		}
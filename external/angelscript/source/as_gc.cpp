@@ -99,6 +99,7 @@ int asCGarbageCollector::AddScriptObjectToGC(void *obj, asCObjectType *objType)
 			if( !isProcessing )
 			{
 				isProcessing = true;
+				ReleaseDeferredObjects();
 
 				// TODO: The number of iterations should be dynamic, and increase 
 				//       if the number of objects in the garbage collector grows high
@@ -183,6 +184,18 @@ int asCGarbageCollector::GarbageCollect(asDWORD flags, asUINT iterations)
 		bool doDetect  = (flags & asGC_DETECT_GARBAGE)  || !(flags & asGC_DESTROY_GARBAGE);
 		bool doDestroy = (flags & asGC_DESTROY_GARBAGE) || !(flags & asGC_DETECT_GARBAGE);
 
+		// Marking only never releases an object, so it can't run destructors and may be done by another thread
+		// than the one executing the scripts, as long as the scripts are not running at the same time. The cyclic
+		// garbage that is found is left for a call without the flag to destroy.
+		bool markOnly = (flags & asGC_MARK_ONLY) && !(flags & asGC_FULL_CYCLE);
+		if( markOnly )
+		{
+			doDetect  = true;
+			doDestroy = false;
+		}
+		else
+			ReleaseDeferredObjects();
+
 		if( flags & asGC_FULL_CYCLE )
 		{
 			// Reset the state
@@ -240,7 +253,21 @@ int asCGarbageCollector::GarbageCollect(asDWORD flags, asUINT iterations)
 
 				// Run another incremental step of the identification of cyclic references
 				if( doDetect && gcOldObjects.GetLength() > 0 )
-					IdentifyGarbageWithCyclicRefs();
+				{
+					if( IdentifyGarbageWithCyclicRefs(markOnly) == 0 && markOnly )
+					{
+						// The marking is done until the garbage is destroyed or the next cycle starts
+						isProcessing = false;
+						LEAVECRITICALSECTION(gcCollecting);
+						return 0;
+					}
+				}
+				else if( markOnly )
+				{
+					isProcessing = false;
+					LEAVECRITICALSECTION(gcCollecting);
+					return 0;
+				}
 			}
 		}
 
@@ -623,13 +650,17 @@ int asCGarbageCollector::DestroyOldGarbage()
 	UNREACHABLE_RETURN;
 }
 
-int asCGarbageCollector::IdentifyGarbageWithCyclicRefs()
+int asCGarbageCollector::IdentifyGarbageWithCyclicRefs(bool markOnly)
 {
 	// This function will only be called within the critical section gcCollecting
 	asASSERT(isProcessing);
 
 	for(;;)
 	{
+		// Breaking the circles calls the destructors, that is left to the thread executing the scripts
+		if( markOnly && detectState >= breakCircles_init )
+			return 0;
+
 		switch( detectState )
 		{
 		case clearCounters_init:
@@ -646,7 +677,13 @@ int asCGarbageCollector::IdentifyGarbageWithCyclicRefs()
 				void *obj = gcMap.GetKey(cursor);
 				asSIntTypePair it = gcMap.GetValue(cursor);
 
-				engine->CallObjectMethod(obj, it.type->beh.release);
+				if( markOnly )
+				{
+					asSObjTypePair deferred = {obj, it.type, 0};
+					deferredReleases.PushLast(deferred);
+				}
+				else
+					engine->CallObjectMethod(obj, it.type->beh.release);
 
 				ReturnNode(gcMap.Remove(cursor));
 
@@ -806,7 +843,13 @@ int asCGarbageCollector::IdentifyGarbageWithCyclicRefs()
 					ReturnNode(gcMap.Remove(cursor));
 
 					// We need to decrease the reference count again as we remove the object from the map
-					engine->CallObjectMethod(gcObj, type->beh.release);
+					if( markOnly )
+					{
+						asSObjTypePair deferred = {gcObj, type, 0};
+						deferredReleases.PushLast(deferred);
+					}
+					else
+						engine->CallObjectMethod(gcObj, type->beh.release);
 
 					// Enumerate all the object's references so that they too can be marked as alive
 					engine->CallObjectMethod(gcObj, engine, type->beh.gcEnumReferences);
@@ -935,6 +978,16 @@ int asCGarbageCollector::IdentifyGarbageWithCyclicRefs()
 	UNREACHABLE_RETURN;
 }
 
+void asCGarbageCollector::ReleaseDeferredObjects()
+{
+	// This function will only be called within the critical section gcCollecting
+	asASSERT(isProcessing);
+
+	for( asUINT n = 0; n < deferredReleases.GetLength(); n++ )
+		engine->CallObjectMethod(deferredReleases[n].obj, deferredReleases[n].type->beh.release);
+	deferredReleases.SetLength(0);
+}
+
 asCGarbageCollector::asSMapNode_t *asCGarbageCollector::GetNode(void *obj, asSIntTypePair it)
 {
 	// This function will only be called within the critical section gcCollecting
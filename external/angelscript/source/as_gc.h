@@ -102,7 +102,8 @@ protected:
 
 	int            DestroyNewGarbage();
 	int            DestroyOldGarbage();
-	int            IdentifyGarbageWithCyclicRefs();
+	int            IdentifyGarbageWithCyclicRefs(bool markOnly = false);
+	void           ReleaseDeferredObjects();
 	asSObjTypePair GetNewObjectAtIdx(int idx);
 	asSObjTypePair GetOldObjectAtIdx(int idx);
 	void           RemoveNewObjectAtIdx(int idx);
@@ -117,6 +118,9 @@ protected:
 	// This array temporarily holds references to objects known to be live objects
 	asCArray<void*>                    liveObjects;
 
+	// References the detection let go of while marking only, they are released by the next call that may destroy
+	asCArray<asSObjTypePair>           deferredReleases;
+
 	// This map holds objects currently being searched for cyclic references, it also holds a 
 	// counter that gives the number of references to the object that the GC can't reach
 	asCMap<void*, asSIntTypePair>      gcMap;
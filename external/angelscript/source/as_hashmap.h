@@ -0,0 +1,270 @@
+/*
+   AngelCode Scripting Library
+   Copyright (c) 2003-2024 Andreas Jonsson
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any
+   purpose, including commercial applications, and to alter it and
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+      distribution.
+
+   The original version of this library can be located at:
+   http://www.angelcode.com/angelscript/
+
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+
+//
+// as_hashmap.h
+//
+// A hash table mapping a key to a value, for the lookups by name
+// that are too frequent for the ordered asCMap
+//
+
+
+#ifndef AS_HASHMAP_H
+#define AS_HASHMAP_H
+
+#include "as_config.h"
+#include "as_array.h"
+#include "as_string.h"
+
+BEGIN_AS_NAMESPACE
+
+// FNV-1a
+inline asUINT asHashBytes(const char *data, size_t length, asUINT hash = 2166136261u)
+{
+	for( size_t n = 0; n < length; n++ )
+		hash = (hash ^ (asBYTE)data[n]) * 16777619u;
+	return hash;
+}
+
+inline asUINT asHashKey(const asCString &key)
+{
+	return asHashBytes(key.AddressOf(), key.GetLength());
+}
+
+inline asUINT asHashKey(const void *key)
+{
+	asPWORD value = (asPWORD)key;
+	return asHashBytes((const char*)&value, sizeof(value));
+}
+
+template <class KEY, class VAL> struct asSHashNode
+{
+	KEY                    key;
+	VAL                    value;
+	asUINT                 hash;
+	asSHashNode<KEY,VAL>  *next;
+};
+
+// Keys need an asHashKey overload and operator==
+template <class KEY, class VAL> class asCHashMap
+{
+public:
+	asCHashMap();
+	~asCHashMap();
+
+	// Replaces the value if the key is already in the map
+	int   Insert(const KEY &key, const VAL &value);
+	// Returns 0 if the key isn't in the map. The value stays in place until it is erased.
+	VAL  *Find(const KEY &key) const;
+	bool  Erase(const KEY &key);
+	void  EraseAll();
+	int   GetCount() const;
+
+	void  SwapWith(asCHashMap<KEY,VAL> &other);
+
+protected:
+	// Don't allow copying
+	asCHashMap(const asCHashMap<KEY,VAL> &) {}
+	asCHashMap<KEY,VAL> &operator=(const asCHashMap<KEY,VAL> &) { return *this; }
+
+	void Rehash(asUINT bucketCount);
+
+	asCArray<asSHashNode<KEY,VAL>*> buckets;
+	asUINT                          count;
+};
+
+//---------------------------------------------------------------------------
+// Implementation
+
+template <class KEY, class VAL>
+asCHashMap<KEY, VAL>::asCHashMap()
+{
+	count = 0;
+}
+
+template <class KEY, class VAL>
+asCHashMap<KEY, VAL>::~asCHashMap()
+{
+	EraseAll();
+}
+
+template <class KEY, class VAL>
+int asCHashMap<KEY, VAL>::Insert(const KEY &key, const VAL &value)
+{
+	asUINT hash = asHashKey(key);
+	if( buckets.GetLength() )
+	{
+		for( asSHashNode<KEY,VAL> *node = buckets[hash & (buckets.GetLength() - 1)]; node; node = node->next )
+		{
+			if( node->hash == hash && node->key == key )
+			{
+				node->value = value;
+				return 0;
+			}
+		}
+	}
+
+	// Keep at most one entry per bucket on average
+	if( count >= buckets.GetLength() )
+		Rehash(buckets.GetLength() ? buckets.GetLength() * 2 : 16);
+	if( buckets.GetLength() == 0 )
+	{
+		// Out of memory
+		return -1;
+	}
+
+	typedef asSHashNode<KEY,VAL> node_t;
+	asSHashNode<KEY,VAL> *node = asNEW(node_t);
+	if( node == 0 )
+	{
+		// Out of memory
+		return -1;
+	}
+
+	asSHashNode<KEY,VAL> *&bucket = buckets[hash & (buckets.GetLength() - 1)];
+	node->key   = key;
+	node->value = value;
+	node->hash  = hash;
+	node->next  = bucket;
+	bucket      = node;
+	count++;
+
+	return 0;
+}
+
+template <class KEY, class VAL>
+VAL *asCHashMap<KEY, VAL>::Find(const KEY &key) const
+{
+	if( count == 0 )
+		return 0;
+
+	asUINT hash = asHashKey(key);
+	for( asSHashNode<KEY,VAL> *node = buckets[hash & (buckets.GetLength() - 1)]; node; node = node->next )
+	{
+		if( node->hash == hash && node->key == key )
+			return &node->value;
+	}
+
+	return 0;
+}
+
+template <class KEY, class VAL>
+bool asCHashMap<KEY, VAL>::Erase(const KEY &key)
+{
+	if( count == 0 )
+		return false;
+
+	asUINT hash = asHashKey(key);
+	asSHashNode<KEY,VAL> **link = &buckets[hash & (buckets.GetLength() - 1)];
+	for( ; *link; link = &(*link)->next )
+	{
+		asSHashNode<KEY,VAL> *node = *link;
+		if( node->hash == hash && node->key == key )
+		{
+			*link = node->next;
+			typedef asSHashNode<KEY,VAL> node_t;
+			asDELETE(node,node_t);
+			count--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template <class KEY, class VAL>
+void asCHashMap<KEY, VAL>::EraseAll()
+{
+	typedef asSHashNode<KEY,VAL> node_t;
+	for( asUINT n = 0; n < buckets.GetLength(); n++ )
+	{
+		asSHashNode<KEY,VAL> *node = buckets[n];
+		while( node )
+		{
+			asSHashNode<KEY,VAL> *next = node->next;
+			asDELETE(node,node_t);
+			node = next;
+		}
+	}
+
+	buckets.SetLength(0);
+	count = 0;
+}
+
+template <class KEY, class VAL>
+int asCHashMap<KEY, VAL>::GetCount() const
+{
+	return int(count);
+}
+
+template <class KEY, class VAL>
+void asCHashMap<KEY, VAL>::SwapWith(asCHashMap<KEY,VAL> &other)
+{
+	buckets.SwapWith(other.buckets);
+
+	asUINT tmpCount = count;
+	count = other.count;
+	other.count = tmpCount;
+}
+
+template <class KEY, class VAL>
+void asCHashMap<KEY, VAL>::Rehash(asUINT bucketCount)
+{
+	// The bucket count is always a power of two
+	asCArray<asSHashNode<KEY,VAL>*> old;
+	old.SwapWith(buckets);
+
+	if( !buckets.SetLength(bucketCount) )
+	{
+		// Out of memory, keep the old buckets
+		buckets.SwapWith(old);
+		return;
+	}
+	for( asUINT n = 0; n < bucketCount; n++ )
+		buckets[n] = 0;
+
+	for( asUINT n = 0; n < old.GetLength(); n++ )
+	{
+		asSHashNode<KEY,VAL> *node = old[n];
+		while( node )
+		{
+			asSHashNode<KEY,VAL> *next = node->next;
+			asSHashNode<KEY,VAL> *&bucket = buckets[node->hash & (bucketCount - 1)];
+			node->next = bucket;
+			bucket     = node;
+			node       = next;
+		}
+	}
+}
+
+END_AS_NAMESPACE
+
+#endif
@@ -54,6 +54,7 @@ asCModule::asCModule(const char *name, asCScriptEngine *engine)
 	m_engine   = engine;
 
 	m_builder = 0;
+	memset(&m_buildTimes, 0, sizeof(m_buildTimes));
 	m_isGlobalVarInitialized = false;
 
 	m_accessMask = 1;
@@ -249,7 +250,8 @@ int asCModule::AddScriptSection(const char *in_name, const char *in_code, size_t
 // internal
 void asCModule::JITCompile()
 {
-	if( !m_engine->jitCompiler )
+	// Without a JIT compiler the functions may still get superinstructions
+	if( !m_engine->jitCompiler && !m_engine->ep.superInstructions )
 		return;
 
 	for (unsigned int i = 0; i < m_scriptFunctions.GetLength(); i++)
@@ -296,6 +298,7 @@ int asCModule::Build()
 	}
 
 	// Compile the script
+	memset(&m_buildTimes, 0, sizeof(m_buildTimes));
 	r = m_builder->Build();
 	asDELETE(m_builder,asCBuilder);
 	m_builder = 0;
@@ -309,7 +312,9 @@ int asCModule::Build()
 		return r;
 	}
 
+	double start = asBuildClock();
 	JITCompile();
+	m_buildTimes.compileFunctions += asBuildClock() - start;
 
 	m_engine->PrepareEngine();
 
@@ -327,7 +332,11 @@ int asCModule::Build()
 
 	// Initialize global variables
 	if( r >= 0 && m_engine->ep.initGlobalVarsAfterBuild )
+	{
+		double start = asBuildClock();
 		r = ResetGlobalVars(0);
+		m_buildTimes.initGlobals += asBuildClock() - start;
+	}
 
 	return r;
 #endif
@@ -1510,32 +1519,41 @@ int asCModule::UnbindAllImportedFunctions()
 	return asSUCCESS;
 }
 
+// internal
+void asCModule::AddTypeLookup(asCTypeInfo *type)
+{
+	// Keep the first type declared with the name, like the ordered map did
+	asSNameSpaceNamePair key(type->nameSpace, type->name);
+	if( m_typeLookup.Find(key) == 0 )
+		m_typeLookup.Insert(key, type);
+}
+
 // internal
 void asCModule::AddClassType(asCObjectType* type)
 {
 	m_classTypes.PushLast(type);
-	m_typeLookup.Insert(asSNameSpaceNamePair(type->nameSpace, type->name), type);
+	AddTypeLookup(type);
 }
 
 // internal
 void asCModule::AddEnumType(asCEnumType* type)
 {
 	m_enumTypes.PushLast(type);
-	m_typeLookup.Insert(asSNameSpaceNamePair(type->nameSpace, type->name), type);
+	AddTypeLookup(type);
 }
 
 // internal
 void asCModule::AddTypeDef(asCTypedefType* type)
 {
 	m_typeDefs.PushLast(type);
-	m_typeLookup.Insert(asSNameSpaceNamePair(type->nameSpace, type->name), type);
+	AddTypeLookup(type);
 }
 
 // internal
 void asCModule::AddFuncDef(asCFuncdefType* type)
 {
 	m_funcDefs.PushLast(type);
-	m_typeLookup.Insert(asSNameSpaceNamePair(type->nameSpace, type->name), type);
+	AddTypeLookup(type);
 }
 
 // internal
@@ -1547,11 +1565,11 @@ void asCModule::ReplaceFuncDef(asCFuncdefType* type, asCFuncdefType* newType)
 		m_funcDefs[i] = newType;
 		
 		// Replace it in the lookup map too
-		asSMapNode<asSNameSpaceNamePair, asCTypeInfo*>* result = 0;
-		if(m_typeLookup.MoveTo(&result, asSNameSpaceNamePair(type->nameSpace, type->name)))
+		asCTypeInfo **result = m_typeLookup.Find(asSNameSpaceNamePair(type->nameSpace, type->name));
+		if( result )
 		{
-			asASSERT( result->value == type );
-			result->value = newType;
+			asASSERT( *result == type );
+			*result = newType;
 		}
 	}
 }
@@ -1559,22 +1577,18 @@ void asCModule::ReplaceFuncDef(asCFuncdefType* type, asCFuncdefType* newType)
 // internal
 asCTypeInfo *asCModule::GetType(const asCString &type, asSNameSpace *ns) const
 {
-	asSMapNode<asSNameSpaceNamePair, asCTypeInfo*>* result = 0;
-	if(m_typeLookup.MoveTo(&result, asSNameSpaceNamePair(ns, type)))
-	{
-		return result->value;
-	}
+	asCTypeInfo **result = m_typeLookup.Find(asSNameSpaceNamePair(ns, type));
+	if( result )
+		return *result;
 	return 0;
 }
 
 // internal
 asCObjectType *asCModule::GetObjectType(const char *type, asSNameSpace *ns) const
 {
-	asSMapNode<asSNameSpaceNamePair, asCTypeInfo*>* result = 0;
-	if(m_typeLookup.MoveTo(&result, asSNameSpaceNamePair(ns, type)))
-	{
-		return CastToObjectType(result->value);
-	}
+	asCTypeInfo **result = m_typeLookup.Find(asSNameSpaceNamePair(ns, type));
+	if( result )
+		return CastToObjectType(*result);
  
 	return 0;
 }
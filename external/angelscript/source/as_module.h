@@ -75,6 +75,15 @@ struct sObjectTypePair
 	asCObjectType *b;
 };
 
+// Wall time in seconds spent in each phase of the last build of the module
+struct asSBuildTimes
+{
+	double parse;            // Parsing the script sections
+	double registration;     // Registering types, functions and properties, and building the class layouts
+	double compileFunctions; // Compiling the functions and methods
+	double initGlobals;      // Compiling and running the initialization of the global variables
+};
+
 
 // TODO: import: Remove function imports. When I have implemented function
 //               pointers the function imports should be deprecated.
@@ -214,6 +223,7 @@ public:
 	asCString         m_name;
 	asCScriptEngine  *m_engine;
 	asCBuilder       *m_builder;
+	asSBuildTimes     m_buildTimes;
 	asCArray<asPWORD> m_userData;
 	asDWORD           m_accessMask;
 	asSNameSpace     *m_defaultNamespace;
@@ -244,7 +254,8 @@ public:
 
 	// This map contains all the types (also contained in the arrays above) for quick lookup
 	// TODO: memory: Can we eliminate the arrays above?
-	asCMap<asSNameSpaceNamePair, asCTypeInfo*> m_typeLookup; // doesn't increase ref count
+	asCHashMap<asSNameSpaceNamePair, asCTypeInfo*> m_typeLookup; // doesn't increase ref count
+	void AddTypeLookup(asCTypeInfo *type);
 
 	// This array holds types that have been explicitly declared with 'external'
 	asCArray<asCTypeInfo*>       m_externalTypes; // doesn't increase ref count
@@ -33,6 +33,7 @@
 #define AS_NAMESPACE_H
 
 #include "as_string.h"
+#include "as_hashmap.h"
 
 BEGIN_AS_NAMESPACE
 
@@ -71,6 +72,12 @@ struct asSNameSpaceNamePair
 	}
 };
 
+inline asUINT asHashKey(const asSNameSpaceNamePair &key)
+{
+	asPWORD ns = (asPWORD)key.ns;
+	return asHashBytes(key.name.AddressOf(), key.name.GetLength(), asHashBytes((const char*)&ns, sizeof(ns)));
+}
+
 END_AS_NAMESPACE
 
 #endif
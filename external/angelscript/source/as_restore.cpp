@@ -1961,7 +1961,7 @@ void asCReader::ReadTypeDeclaration(asCTypeInfo *type, int phase, bool *isExtern
 						{
 							// Destroy the function without releasing any references
 							if( func->id == func->signatureId )
-								engine->signatureIds.RemoveValue(func);
+								engine->RemoveSignatureId(func);
 							func->id = 0;
 							if( func->scriptData )
 								func->scriptData->byteCode.SetLength(0);
@@ -5169,6 +5169,13 @@ void asCWriter::WriteByteCode(asCScriptFunction *func)
 		// Copy the instruction to a temp buffer so we can work on it before saving
 		memcpy(tmpBC, bc, asBCTypeSize[asBCInfo[c].type]*sizeof(asDWORD));
 
+		// Superinstructions are saved as the instruction they replaced
+		if( c >= asBC_MAXBYTECODE && c < asBC_MAXSUPERINSTRUCTION )
+		{
+			c = asBCInfo[c].bc;
+			*(asBYTE*)tmpBC = asBYTE(c);
+		}
+
 		if( c == asBC_ALLOC ) // PTR_DW_ARG
 		{
 			// Translate the object type
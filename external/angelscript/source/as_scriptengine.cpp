@@ -498,6 +498,10 @@ int asCScriptEngine::SetEngineProperty(asEEngineProp property, asPWORD value)
 		tok.InitJumpTable();
 		break;
 
+	case asEP_SUPERINSTRUCTIONS:
+		ep.superInstructions = value ? true : false;
+		break;
+
 	default:
 		return asINVALID_ARG;
 	}
@@ -630,6 +634,9 @@ asPWORD asCScriptEngine::GetEngineProperty(asEEngineProp property) const
 	case asEP_FOREACH_SUPPORT:
 		return ep.foreachSupport;
 
+	case asEP_SUPERINSTRUCTIONS:
+		return ep.superInstructions;
+
 	default:
 		return 0;
 	}
@@ -708,6 +715,7 @@ asCScriptEngine::asCScriptEngine()
 		ep.memberInitMode                = 1;         // 0 = pre 2.38.0, members with init expr in declaration are initialized after super(), 1 = all members initialized in beginning, except if explicitly initialized in body
 		ep.boolConversionMode            = 0;         // 0 = only do use opImplConv for registered value type, 1 = use also opConv in contextual conversion even for reference types
 		ep.foreachSupport                = true;
+		ep.superInstructions             = false;     // true = fuse frequent instruction pairs of functions that aren't JIT compiled
 	}
 
 	gc.engine = this;
@@ -970,6 +978,7 @@ asCScriptEngine::~asCScriptEngine()
 	for( asUINT n = 0; n < nameSpaces.GetLength(); n++ )
 		asDELETE(nameSpaces[n], asSNameSpace);
 	nameSpaces.SetLength(0);
+	nameSpaceLookup.EraseAll();
 
 	asCThreadManager::Unprepare();
 }
@@ -1182,6 +1191,7 @@ asSNameSpace *asCScriptEngine::AddNameSpace(const char *name)
 
 	// TODO: thread-safety: This can potentially be called from multiple threads so it must be protected with critical section
 	nameSpaces.PushLast(ns);
+	nameSpaceLookup.Insert(ns->name, ns);
 
 	return ns;
 }
@@ -1189,12 +1199,8 @@ asSNameSpace *asCScriptEngine::AddNameSpace(const char *name)
 // internal
 asSNameSpace *asCScriptEngine::FindNameSpace(const char *name) const
 {
-	// TODO: optimize: Improve linear search
-	for( asUINT n = 0; n < nameSpaces.GetLength(); n++ )
-		if( nameSpaces[n]->name == name )
-			return nameSpaces[n];
-
-	return 0;
+	asSNameSpace **ns = nameSpaceLookup.Find(name);
+	return ns ? *ns : 0;
 }
 
 // interface
@@ -5008,7 +5014,8 @@ int asCScriptEngine::GarbageCollect(asDWORD flags, asUINT iterations)
 {
 	int r = gc.GarbageCollect(flags, iterations);
 
-	if( r == 0 )
+	// Marking only may be done by a helper thread, the modules are deleted by the thread executing the scripts
+	if( r == 0 && !(flags & asGC_MARK_ONLY) )
 	{
 		// Delete any modules that have been discarded previously but not
 		// removed due to being referred to by objects in the garbage collector
@@ -5989,32 +5996,84 @@ void asCScriptEngine::RemoveScriptFunction(asCScriptFunction *func)
 				freeScriptFunctionIds.PushLast(id);
 			}
 
+			asCArray<int> *users = signatureUsers.Find(func->name);
+			if( users )
+				users->RemoveValue(id);
+
 			// Is the function used as signature id?
 			if( func->signatureId == id )
 			{
 				// Remove the signature id
-				signatureIds.RemoveValue(func);
+				RemoveSignatureId(func);
 
-				// Update all functions using the signature id
+				// Update all functions using the signature id, they have the same name
 				int newSigId = 0;
-				for( asUINT n = 0; n < scriptFunctions.GetLength(); n++ )
+				for( asUINT n = 0; users && n < users->GetLength(); n++ )
 				{
-					if( scriptFunctions[n] && scriptFunctions[n]->signatureId == id )
+					int userId = (*users)[n];
+					if( userId < (int)scriptFunctions.GetLength() && scriptFunctions[userId] && scriptFunctions[userId]->signatureId == id )
 					{
 						if( newSigId == 0 )
 						{
-							newSigId = scriptFunctions[n]->id;
-							signatureIds.PushLast(scriptFunctions[n]);
+							newSigId = scriptFunctions[userId]->id;
+							AddSignatureId(scriptFunctions[userId]);
 						}
 
-						scriptFunctions[n]->signatureId = newSigId;
+						scriptFunctions[userId]->signatureId = newSigId;
 					}
 				}
 			}
+
+			if( users && users->GetLength() == 0 )
+				signatureUsers.Erase(func->name);
 		}
 	}
 }
 
+// internal
+void asCScriptEngine::AddSignatureId(asCScriptFunction *func)
+{
+	asCArray<asCScriptFunction *> *funcs = signatureIds.Find(func->name);
+	if( funcs )
+		funcs->PushLast(func);
+	else
+	{
+		asCArray<asCScriptFunction *> arr(1);
+		arr.PushLast(func);
+		signatureIds.Insert(func->name, arr);
+	}
+}
+
+// internal
+void asCScriptEngine::RemoveSignatureId(asCScriptFunction *func)
+{
+	asCArray<asCScriptFunction *> *funcs = signatureIds.Find(func->name);
+	if( funcs == 0 )
+		return;
+
+	funcs->RemoveValue(func);
+	if( funcs->GetLength() == 0 )
+		signatureIds.Erase(func->name);
+}
+
+// internal
+// Must be called for every function that takes a signature id, whether it is the first one or shares it
+void asCScriptEngine::AddSignatureUser(asCScriptFunction *func)
+{
+	if( func->id <= 0 )
+		return;
+
+	asCArray<int> *users = signatureUsers.Find(func->name);
+	if( users )
+		users->PushLast(func->id);
+	else
+	{
+		asCArray<int> arr(1);
+		arr.PushLast(func->id);
+		signatureUsers.Insert(func->name, arr);
+	}
+}
+
 // internal
 void asCScriptEngine::RemoveFuncdef(asCFuncdefType *funcdef)
 {
@@ -53,6 +53,7 @@
 #include "as_gc.h"
 #include "as_tokenizer.h"
 #include "as_map.h"
+#include "as_hashmap.h"
 
 BEGIN_AS_NAMESPACE
 
@@ -291,6 +292,9 @@ public:
 	void AddScriptFunction(asCScriptFunction *func);
 	void RemoveScriptFunction(asCScriptFunction *func);
 	void RemoveFuncdef(asCFuncdefType *func);
+	void AddSignatureId(asCScriptFunction *func);
+	void RemoveSignatureId(asCScriptFunction *func);
+	void AddSignatureUser(asCScriptFunction *func);
 
 	int ConfigError(int err, const char *funcName, const char *arg1, const char *arg2);
 
@@ -380,7 +384,10 @@ public:
 	// Stores all functions, i.e. registered functions, script functions, class methods, behaviours, etc.
 	asCArray<asCScriptFunction *> scriptFunctions;       // doesn't increase ref count
 	asCArray<int>                 freeScriptFunctionIds;
-	asCArray<asCScriptFunction *> signatureIds;
+	// The first function of each signature, by name. Functions with an equal signature share its id
+	asCHashMap<asCString, asCArray<asCScriptFunction *> > signatureIds;
+	// Ids of all functions that took a signature id, by name, to hand the id over when the first one is removed
+	asCHashMap<asCString, asCArray<int> >                 signatureUsers;
 
 	// An array with all module imported functions
 	asCArray<sBindInfo *>  importedFunctions; // doesn't increase ref count
@@ -459,6 +466,7 @@ public:
 	// These are shared between all entities and are
 	// only deleted once the engine is destroyed
 	asCArray<asSNameSpace*> nameSpaces;
+	asCHashMap<asCString, asSNameSpace*> nameSpaceLookup;
 
 	// Callbacks for context pooling
 	asREQUESTCONTEXTFUNC_t  requestCtxFunc;
@@ -529,6 +537,7 @@ public:
 		asUINT memberInitMode;
 		asUINT boolConversionMode;
 		bool   foreachSupport;
+		bool   superInstructions;
 	} ep;
 
 	// Callbacks
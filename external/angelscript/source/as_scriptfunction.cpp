@@ -1037,19 +1037,22 @@ void asCScriptFunction::ComputeSignatureId()
 	// function name, return type, and parameter types. The object
 	// type for methods is not used, so that class methods and
 	// interface methods match each other.
-	for( asUINT n = 0; n < engine->signatureIds.GetLength(); n++ )
+	// Only functions with the same name can have the same signature
+	engine->AddSignatureUser(this);
+	asCArray<asCScriptFunction *> *funcs = engine->signatureIds.Find(name);
+	for( asUINT n = 0; funcs && n < funcs->GetLength(); n++ )
 	{
-		if( !IsSignatureEqual(engine->signatureIds[n]) ) continue;
+		if( !IsSignatureEqual((*funcs)[n]) ) continue;
 
 		// We don't need to increment the reference counter here, because
-		// asCScriptEngine::FreeScriptFunctionId will maintain the signature
+		// asCScriptEngine::RemoveScriptFunction will maintain the signature
 		// id as the function is freed.
-		signatureId = engine->signatureIds[n]->signatureId;
+		signatureId = (*funcs)[n]->signatureId;
 		return;
 	}
 
 	signatureId = id;
-	engine->signatureIds.PushLast(this);
+	engine->AddSignatureId(this);
 }
 
 // internal
@@ -1594,7 +1597,12 @@ void asCScriptFunction::JITCompile()
 	asASSERT( scriptData );
 
 	if( !engine->jitCompiler )
+	{
+		// The JIT compilers read the bytecode, so only the interpreter sees superinstructions
+		if( engine->ep.superInstructions )
+			FuseInstructions();
 		return;
+	}
 
 	// Make sure the function has been compiled with JitEntry instructions
 	// For functions that has JitEntry this will be a quick test
@@ -1649,6 +1657,54 @@ void asCScriptFunction::JITCompile()
 	}
 }
 
+// internal
+// A superinstruction replaces the opcode of the first instruction of a pair and executes both. The second
+// instruction is left in place, so the instruction sizes, jump targets and line numbers don't change and
+// jumps to the second instruction still work. Only pairs that can't raise exceptions or suspend are fused.
+void asCScriptFunction::FuseInstructions()
+{
+	asDWORD *bc = scriptData->byteCode.AddressOf();
+	asDWORD *end = bc + scriptData->byteCode.GetLength();
+	while( bc < end )
+	{
+		asBYTE op = *(asBYTE*)bc;
+		asDWORD *next = bc + asBCTypeSize[asBCInfo[op].type];
+		if( next >= end )
+			break;
+
+		asBYTE nextOp = *(asBYTE*)next;
+		int fused = 0;
+		if( nextOp >= asBC_JZ && nextOp <= asBC_JNP )
+		{
+			// The compare and branch superinstructions are ordered by compare, then by the jumps from JZ to JNP
+			int jump = nextOp - asBC_JZ;
+			switch( op )
+			{
+			case asBC_CMPi:  fused = asBC_CMPi_JZ + jump; break;
+			case asBC_CMPu:  fused = asBC_CMPu_JZ + jump; break;
+			case asBC_CMPIi: fused = asBC_CMPIi_JZ + jump; break;
+			case asBC_CMPIu: fused = asBC_CMPIu_JZ + jump; break;
+			default: break;
+			}
+		}
+		else if( nextOp == op )
+		{
+			switch( op )
+			{
+			case asBC_PshV4: fused = asBC_PshV4_PshV4; break;
+			case asBC_PshV8: fused = asBC_PshV8_PshV8; break;
+			case asBC_PSF:   fused = asBC_PSF_PSF; break;
+			default: break;
+			}
+		}
+
+		if( fused )
+			*(asBYTE*)bc = asBYTE(fused);
+
+		bc = next;
+	}
+}
+
 // interface
 asDWORD *asCScriptFunction::GetByteCode(asUINT *length)
 {
@@ -278,6 +278,7 @@ public:
 	bool      DoesReturnOnStack() const;
 
 	void      JITCompile();
+	void      FuseInstructions();
 
 	void      AddReferences();
 	void      ReleaseReferences();
@@ -45,6 +45,7 @@
 #include "as_memory.h"
 #include "as_string.h"
 #include "as_map.h"
+#include "as_hashmap.h"
 #include "as_datatype.h"
 #include "as_namespace.h"
 
@@ -149,7 +150,7 @@ private:
 	void GetKey(const T *entry, asSNameSpaceNamePair &key) const;
 	bool CheckIdx(asUINT idx) const;
 
-	asCMap<asSNameSpaceNamePair, asCArray<asUINT> > m_map;
+	asCHashMap<asSNameSpaceNamePair, asCArray<asUINT> > m_map;
 	asCArray<T*>                                    m_entries;
 	unsigned int                                    m_size;
 };
@@ -189,10 +190,10 @@ int asCSymbolTable<T>::GetFirstIndex(
 {
 	asSNameSpaceNamePair key(ns, name);
 
-	asSMapNode<asSNameSpaceNamePair, asCArray<asUINT> > *cursor;
-	if( m_map.MoveTo(&cursor, key) )
+	const asCArray<asUINT> *indexes = m_map.Find(key);
+	if( indexes )
 	{
-		const asCArray<asUINT> &arr = m_map.GetValue(cursor);
+		const asCArray<asUINT> &arr = *indexes;
 		for( asUINT n = 0; n < arr.GetLength(); n++ )
 		{
 			T *entry = m_entries[arr[n]];
@@ -211,9 +212,9 @@ const asCArray<asUINT> &asCSymbolTable<T>::GetIndexes(const asSNameSpace *ns, co
 {
 	asSNameSpaceNamePair key(ns, name);
 
-	asSMapNode<asSNameSpaceNamePair, asCArray<asUINT> > *cursor;
-	if( m_map.MoveTo(&cursor, key) )
-		return m_map.GetValue(cursor);
+	const asCArray<asUINT> *indexes = m_map.Find(key);
+	if( indexes )
+		return *indexes;
 
 	static asCArray<asUINT> dummy;
 	return dummy;
@@ -238,9 +239,9 @@ int asCSymbolTable<T>::GetFirstIndex(const asSNameSpace *ns, const asCString &na
 {
 	asSNameSpaceNamePair key(ns, name);
 
-	asSMapNode<asSNameSpaceNamePair, asCArray<asUINT> > *cursor;
-	if( m_map.MoveTo(&cursor, key) )
-		return m_map.GetValue(cursor)[0];
+	const asCArray<asUINT> *indexes = m_map.Find(key);
+	if( indexes )
+		return (*indexes)[0];
 
 	return -1;
 }
@@ -249,13 +250,23 @@ int asCSymbolTable<T>::GetFirstIndex(const asSNameSpace *ns, const asCString &na
 
 
 // Find the index of a certain symbol
-// ATTENTION: this function has linear runtime complexity O(n)!!
 template<class T>
 int asCSymbolTable<T>::GetIndex(const T* entry) const
 {
-	for( asUINT n = 0; n < m_entries.GetLength(); n++ )
-		if( m_entries[n] == entry )
-			return n;
+	if( entry == 0 )
+		return -1;
+
+	// Only the entries with the same namespace and name need to be compared
+	asSNameSpaceNamePair key;
+	GetKey(entry, key);
+
+	const asCArray<asUINT> *indexes = m_map.Find(key);
+	if( indexes )
+	{
+		for( asUINT n = 0; n < indexes->GetLength(); n++ )
+			if( m_entries[(*indexes)[n]] == entry )
+				return (*indexes)[n];
+	}
 
 	return -1;
 }
@@ -360,13 +371,12 @@ bool asCSymbolTable<T>::Erase(asUINT idx)
 	asSNameSpaceNamePair key;
 	GetKey(entry, key);
 
-	asSMapNode<asSNameSpaceNamePair, asCArray<asUINT> > *cursor;
-	if( m_map.MoveTo(&cursor, key) )
+	asCArray<asUINT> *indexes = m_map.Find(key);
+	if( indexes )
 	{
-		asCArray<asUINT> &arr = m_map.GetValue(cursor);
-		arr.RemoveValue(idx);
-		if( arr.GetLength() == 0 )
-			m_map.Erase(cursor);
+		indexes->RemoveValue(idx);
+		if( indexes->GetLength() == 0 )
+			m_map.Erase(key);
 	}
 	else
 		asASSERT(false);
@@ -383,11 +393,9 @@ bool asCSymbolTable<T>::Erase(asUINT idx)
 		// Update the index in the lookup map
 		entry = m_entries[idx];
 		GetKey(entry, key);
-		if( m_map.MoveTo(&cursor, key) )
-		{
-			asCArray<asUINT> &arr = m_map.GetValue(cursor);
-			arr[arr.IndexOf(prevIdx)] = idx;
-		}
+		indexes = m_map.Find(key);
+		if( indexes )
+			(*indexes)[indexes->IndexOf(prevIdx)] = idx;
 		else
 			asASSERT(false);
 	}
@@ -406,9 +414,9 @@ asUINT asCSymbolTable<T>::Put(T *entry)
 	asSNameSpaceNamePair key;
 	GetKey(entry, key);
 
-	asSMapNode<asSNameSpaceNamePair, asCArray<asUINT> > *cursor;
-	if( m_map.MoveTo(&cursor, key) )
-		m_map.GetValue(cursor).PushLast(idx);
+	asCArray<asUINT> *indexes = m_map.Find(key);
+	if( indexes )
+		indexes->PushLast(idx);
 	else
 	{
 		asCArray<asUINT> arr(1);
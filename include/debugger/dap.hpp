@@ -1,4 +1,5 @@
 #pragma once
+#include <map>
 #include <thread>
 #include <unordered_map>
 #include <optional>
@@ -11,10 +12,31 @@ namespace srph::debugger
 {
 class Debugger;
 
-struct ObjectReference
+enum class ReferenceKind : uint8_t
 {
+    Locals = 0,
+    Globals,
+    Object,
+    Array
+};
+
+// What a variablesReference shows, valid until its thread continues
+struct VariableReference
+{
+    ReferenceKind kind;
+    int threadId;
+    asUINT frame;
     int typeId;
     void* ptr;
+    // Formatted children by start and count of the requests, so pages aren't formatted twice while stopped
+    std::map<std::pair<asUINT, asUINT>, nlohmann::json> pages = {};
+};
+
+// What a frame id shows, valid until its thread continues
+struct FrameReference
+{
+    int threadId;
+    asUINT level;
 };
 
 class DAP : public IDebugAdapter
@@ -24,7 +46,8 @@ public:
     void Start() override;
     void Stop() override;
     void AttachDebugger(Debugger* debugger) override { m_debugger = debugger; }
-    void OnBreakpointHit(std::string file, int line) override;
+    void OnBreakpointHit(int threadId, bool allThreadsStopped, std::string file, int line) override;
+    void OnOutput(const std::string& text) override;
 
 private:
     void ServerLoop();
@@ -49,8 +72,20 @@ private:
     nlohmann::json HandleNext(const nlohmann::json& request);
     nlohmann::json HandleStepIn(const nlohmann::json& request);
     nlohmann::json HandleStepOut(const nlohmann::json& request);
+    std::optional<nlohmann::json> HandleEvaluate(const nlohmann::json& request);
     std::optional<nlohmann::json> HandleDisconnect(const nlohmann::json& request);
 
+    // Formats a value, objects and arrays get a reference and are expanded when the client asks for them
+    nlohmann::json Variable(asIScriptEngine* engine, int threadId, asUINT frame, const std::string& name, int typeId, void* address);
+    // The children of a reference from `start`, at most `count` of them
+    nlohmann::json Children(asIScriptContext* ctx, const VariableReference& reference, asUINT start, asUINT count);
+    int AddReference(const VariableReference& reference);
+    int AddFrame(const FrameReference& frame);
+    // Frame 0 of the stopped thread for ids the client did not get from a stack trace
+    FrameReference Frame(int frameId) const;
+    // Forgets the references and frames of a thread, or of all threads for 0
+    void ForgetReferences(int threadId);
+
     void CloseSocket();
 
 private:
@@ -65,7 +100,10 @@ private:
 
     Debugger* m_debugger = nullptr;
 
-    std::unordered_map<int, ObjectReference> m_objectReferences;
+    std::unordered_map<int, VariableReference> m_references;
+    int m_nextReference = 1;
+    std::unordered_map<int, FrameReference> m_frames;
+    int m_nextFrame = 1;
     std::atomic<int> m_seqCounter{1};
     std::atomic<bool> m_running{true};
 };
@@ -15,6 +15,9 @@ public:
     virtual void Stop() = 0;
     virtual void AttachDebugger(Debugger* debugger) = 0;
 
-    virtual void OnBreakpointHit(std::string file, int line) = 0;
+    // Called on the stopped thread. Without allThreadsStopped the other threads keep running.
+    virtual void OnBreakpointHit(int threadId, bool allThreadsStopped, std::string file, int line) = 0;
+    // Logpoints and failed breakpoint conditions, called on the script thread
+    virtual void OnOutput(const std::string& text) = 0;
 };
 }  // namespace srph::debugger
\ No newline at end of file
@@ -1,7 +1,18 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <tuple>
 #include <unordered_map>
 
+#include "debugger/expression.hpp"
+
 namespace srph
 {
 class Engine;
@@ -19,6 +30,25 @@ enum class StepMode : uint8_t
     In,
     Out
 };
+
+struct Breakpoint
+{
+    int line = 0;
+    // Script expression, the breakpoint only counts hits while it is true
+    std::string condition;
+    // Stops on the hit number: "5" or ">= 5", "== 5", "> 5", "< 5", "<= 5", "% 5" (every fifth)
+    std::string hitCondition;
+    // Logged to the client instead of stopping, {expression} is replaced by its value
+    std::string logMessage;
+};
+
+// A script context shown to the client as a thread
+struct DebugThread
+{
+    int id = 0;
+    std::string name;
+};
+
 class Debugger
 {
 public:
@@ -29,14 +59,87 @@ public:
     bool Started() const { return m_started; }
 
     void Start();
-    void RegisterLineCallback();
 
-    std::unordered_map<std::string, std::vector<int>>& GetBreakpoints() { return m_breakpoints; }
-    void Continue();
+    // Called by the adapter, takes effect on the next line a script runs. Paths are normalized.
+    void SetBreakpoints(const std::string& file, const std::vector<Breakpoint>& breakpoints);
+    void ClearBreakpoints();
+    // Resumes a stopped thread, 0 resumes all of them
+    void Continue(int threadId);
+    void Step(int threadId, StepMode mode);
 
-private:
+    // Called by the adapter. The requests run on the script thread, while it is stopped or on its next Engine::Tick,
+    // and fail if neither happens within a second.
+    std::vector<DebugThread> Threads();
+    // Runs `inspect` with the context of a stopped thread, false if the thread isn't stopped
+    bool Inspect(int threadId, const std::function<void(asIScriptContext*)>& inspect);
+    // False with the error in `result` if the expression doesn't compile or throws, or if the thread isn't stopped
+    bool Evaluate(int threadId, asUINT frame, const std::string& expression, std::string& result);
+
+    // In non-stop mode a coroutine that stops is suspended and the engine keeps running, other contexts still block
+    // their thread since their caller waits for the result.
+    bool NonStop() const { return m_nonStop; }
+
+    // Called by the engine for every line of every context. Returns after a pointer comparison unless the debugger
+    // steps the context or the running function contains a breakpoint.
     void LineCallback(asIScriptContext* context);
-    bool IsBreakpoint(const std::string& file, int line);
+    // Called by Engine::Tick, answers the adapter's requests while no thread blocks
+    void Tick();
+    // Drops what was cached for all functions, when the breakpoints change or a module is rebuilt
+    void ForgetFunctions();
+    // Called by the scheduler and the engine, forget the thread ids of finished coroutines and released contexts
+    void CoroutineFinished(uint32_t coroutine);
+    void ContextReleased(asIScriptContext* context);
+
+private:
+    // One bit per line of a script section
+    using LineBitmap = std::vector<uint64_t>;
+    // Expressions compiled for the functions a line belongs to
+    using ExpressionCache = std::unordered_map<asIScriptFunction*, std::unique_ptr<CompiledExpression>>;
+    struct BreakpointState
+    {
+        Breakpoint breakpoint;
+        uint64_t hits = 0;
+        ExpressionCache conditions;
+        ExpressionCache messages;
+    };
+    struct SectionBreakpoints
+    {
+        LineBitmap lines;
+        // Only the breakpoints with a condition, hit condition or log message
+        std::unordered_map<int, BreakpointState> states;
+    };
+    struct CachedFunction
+    {
+        asIScriptFunction* function = nullptr;
+        bool hasBreakpoint = false;
+    };
+    static constexpr size_t FUNCTION_CACHE_SIZE = 256;
+    static constexpr std::chrono::seconds TASK_TIMEOUT{1};
+
+    // Suspends the coroutine or blocks until the thread is continued
+    void Stop(asIScriptContext* context, const char* section, int line);
+    int ThreadId(asIScriptContext* context);
+    bool Post(const std::function<void()>& task);
+    void RunTasks();
+
+    void RefreshBreakpoints();
+    SectionBreakpoints* FindSection(const char* section);
+    bool HasBreakpoint(asIScriptFunction* function);
+    // Has AngelScript call FunctionDestroyed for the function, whose memory may then be reused by another one
+    void Track(asIScriptFunction* function);
+    static void FunctionDestroyed(asIScriptFunction* function);
+    void ForgetFunction(asIScriptFunction* function);
+    bool IsBreakpoint(const char* section, int line);
+    // Runs the condition, hit condition and logpoint of the breakpoint, true if the script should stop
+    bool ShouldStop(asIScriptContext* context, SectionBreakpoints& section, int line);
+    // Compiles the expression on its first run
+    bool RunExpression(std::unique_ptr<CompiledExpression>& compiled,
+                       asIScriptContext* context,
+                       asUINT frame,
+                       ExpressionKind kind,
+                       const std::string& expression,
+                       bool& condition,
+                       std::string& text);
 
 private:
     friend class DAP;
@@ -47,19 +150,58 @@ private:
 
     bool m_started = false;
 
-    std::unordered_map<std::string, std::vector<int>> m_breakpoints;
-    std::unordered_map<std::string, std::string> m_normalizedPaths;
+    // Written by the adapter's thread, the generation tells the script thread to rebuild its bitmaps
+    std::mutex m_breakpointMutex;
+    std::unordered_map<std::string, std::vector<Breakpoint>> m_breakpoints;
+    std::atomic<uint32_t> m_breakpointGeneration{0};
+
+    // Owned by the script thread. Section names are kept by the engine until it is destroyed, so their pointers
+    // identify the sections.
+    uint32_t m_seenGeneration = 0;
+    std::unordered_map<std::string, SectionBreakpoints> m_files;
+    std::unordered_map<const char*, SectionBreakpoints*> m_sections;
+    std::unordered_map<asIScriptFunction*, bool> m_functions;
+    // Direct mapped by address in front of m_functions, the running function alternates with its callees
+    std::array<CachedFunction, FUNCTION_CACHE_SIZE> m_functionCache = {};
+
+    // Runs the compiled expressions, without line callback so they can't stop themselves
+    asIScriptContext* m_expressionContext = nullptr;
+    // Evaluated expressions by function, line and text
+    std::map<std::tuple<asIScriptFunction*, int, std::string>, std::unique_ptr<CompiledExpression>> m_evaluations;
 
+    bool m_nonStop = false;
+
+    // Thread ids owned by the script thread. Pooled contexts move between coroutines, so a coroutine keeps its id
+    // wherever it runs.
+    std::unordered_map<uint32_t, int> m_coroutineThreads;
+    std::unordered_map<asIScriptContext*, int> m_contextThreads;
+    int m_nextThreadId = 1;
+
+    struct StoppedThread
+    {
+        asIScriptContext* context = nullptr;
+        // Suspended coroutine in non-stop mode, otherwise the thread blocks until resumed
+        uint32_t coroutine = 0;
+        bool resumed = false;
+    };
+
+    struct Task
+    {
+        const std::function<void()>* run = nullptr;
+        bool started = false;
+        bool done = false;
+    };
+
+    // Guards the stopped threads and the tasks
     std::mutex m_resumeMutex;
     std::condition_variable m_resumeCV;
-    bool m_resumed = false;
-    bool m_shouldStop = false;
-
-    asIScriptContext* m_currentContext = nullptr;
-    std::string m_currentFile;
-    int m_currentLine = 0;
-    asUINT m_currentStackDepth = 0;
+    std::condition_variable m_taskCV;
+    std::unordered_map<int, StoppedThread> m_stopped;
+    std::deque<Task*> m_tasks;
 
-    StepMode m_stepMode = StepMode::None;
+    // Written by the adapter's thread, read by LineCallback on every line. The mode is published last.
+    std::atomic<asIScriptContext*> m_stepContext{nullptr};
+    std::atomic<asUINT> m_stepDepth{0};
+    std::atomic<StepMode> m_stepMode{StepMode::None};
 };
-}  // namespace srph::debugger
\ No newline at end of file
+}  // namespace srph::debugger
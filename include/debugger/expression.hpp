@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class asIScriptContext;
+class asIScriptFunction;
+
+namespace srph::debugger
+{
+enum class ExpressionKind : uint8_t
+{
+    // bool, for breakpoint conditions
+    Condition = 0,
+    // Text with {expression} placeholders, for logpoints
+    Message,
+    // Formatted value, for evaluate and watch requests
+    Value
+};
+
+// A script expression compiled once into a function of the variables visible in a stack frame. Running it passes the
+// frame's variables by reference, so evaluating it costs one script call. In a method the object's properties are
+// visible by name and `this` is the object.
+class CompiledExpression
+{
+public:
+    CompiledExpression() = default;
+    ~CompiledExpression();
+    CompiledExpression(const CompiledExpression&) = delete;
+    CompiledExpression& operator=(const CompiledExpression&) = delete;
+
+    // Compiles against the frame's function and the variables in scope at its current line. Compiler errors are kept
+    // and reported by every Run.
+    bool Compile(asIScriptContext* frameContext, asUINT frame, ExpressionKind kind, const std::string& expression);
+
+    // Runs in `context` against the frame it was compiled for. Conditions set `condition`, the other kinds `text`.
+    // Returns false with the compiler errors or the script exception in `text`.
+    bool Run(asIScriptContext* frameContext, asUINT frame, asIScriptContext* context, bool& condition, std::string& text) const;
+
+private:
+    enum class Source : uint8_t
+    {
+        Variable = 0,
+        // Property of the frame's object, by index
+        Property,
+        // The frame's object, passed as a handle
+        This
+    };
+    struct Argument
+    {
+        Source source = Source::Variable;
+        int index = 0;
+        int typeId = 0;
+        bool handle = false;
+        std::string name;
+    };
+
+    asIScriptFunction* m_function = nullptr;
+    ExpressionKind m_kind = ExpressionKind::Condition;
+    std::vector<Argument> m_arguments;
+    std::string m_error;
+};
+}  // namespace srph::debugger
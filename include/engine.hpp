@@ -5,7 +5,9 @@
 #include "engine_configuration.hpp"
 
 #include <unordered_map>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -16,6 +18,7 @@ class asIScriptObject;
 class asITypeInfo;
 class asIScriptModule;
 class asIScriptFunction;
+class asIScriptGeneric;
 
 namespace srph
 {
@@ -26,6 +29,39 @@ class Debugger;
 class DAP;
 }  // namespace debugger
 
+namespace profiler
+{
+class SamplingProfiler;
+class Tracer;
+struct TracerOptions;
+class MetricsRegistry;
+class MetricsServer;
+}  // namespace profiler
+
+namespace memory
+{
+class FrameArena;
+struct FrameArenaStats;
+}  // namespace memory
+
+namespace jit
+{
+class JitCompiler;
+class AotLinker;
+}  // namespace jit
+
+namespace runtime
+{
+class Scheduler;
+class JobPool;
+class EventBus;
+class CommandQueue;
+class TimerWheel;
+class GarbageCollector;
+using CoroutineId = uint32_t;
+using TimerId = uint64_t;
+}  // namespace runtime
+
 namespace TypeRegistration
 {
 enum class ClassType : uint8_t;
@@ -67,18 +103,60 @@ public:
     void Initialize(EngineConfiguration configuration);
     void Shutdown();
 
+    // Frame arena, array buffers created by scripts on this thread until EndFrame come from a bump allocator.
+    // Scripts started during the frame must have finished or be suspended coroutines before EndFrame.
+    void BeginFrame();
+    void EndFrame();
+
+    // Coroutines, resumes the coroutines that are due. 0 is returned when the coroutine could not be started.
+    void Tick(double deltaSeconds);
+    runtime::CoroutineId StartCoroutine(const std::string& moduleName, const std::string& functionDecl, InstanceHandle instance = {});
+    runtime::Scheduler* GetScheduler() const { return m_scheduler; }
+    // Timers, advanced by Tick before the coroutines resume
+    runtime::TimerWheel* GetTimers() const { return m_timers; }
+    // Cycle collection, run by Tick after the coroutines within EngineConfiguration::gcBudgetMicros
+    runtime::GarbageCollector* GetGarbageCollector() const { return m_garbageCollector; }
+
+    // Events, native broadcasts to the instances whose class handles them
+    runtime::EventBus* GetEventBus() const { return m_eventBus; }
+    // Commands, posted by scripts and drained by the application
+    runtime::CommandQueue* GetCommandQueue() const { return m_commandQueue; }
+
+    // JIT, nullptr unless enabled in the configuration and supported on this platform
+    jit::JitCompiler* GetJit() const { return m_jit; }
+    // Binds native code compiled ahead of time, nullptr unless enabled in the configuration
+    jit::AotLinker* GetAot() const { return m_aot; }
+
     // Debugger
     void AttachDebugger();
     void StopDebugger();
 
+    // Profiling
+    void StartProfiler(uint32_t intervalMicros = 1000);
+    void StopProfiler();
+    profiler::SamplingProfiler* GetProfiler() const { return m_profiler; }
+    void StartTracer(const profiler::TracerOptions& options);
+    void StopTracer();
+    profiler::Tracer* GetTracer() const { return m_tracer; }
+    // Serves the metrics over http://127.0.0.1:<httpPort>/metrics when the port is not 0
+    void EnableMetrics(uint16_t httpPort = 0);
+    void DisableMetrics();
+    profiler::MetricsRegistry* GetMetrics() const { return m_metrics; }
+
     // Callbacks
     void RegisterTimeoutCallback(const std::function<void()>& f) { m_timeoutCallback = f; }
     void RegisterLineCallback(const std::string& key, const std::function<void(asIScriptContext* context)>& f);
     void RemoveLineCallback(const std::string& key);
+    // Global to the process like the allocator. Return true to allow the allocation anyway.
+    void RegisterMemoryBudgetCallback(const memory::BudgetCallback& f) { memory::SetBudgetCallback(f); }
 
     // State queries
     const EngineConfiguration& GetConfiguration() const { return m_configuration; }
     bool Built() const { return m_built; }
+    memory::MemoryStats GetMemoryStats() const;
+    // Budget in bytes of a module or tenant, 0 = no limit
+    void SetMemoryBudget(const std::string& account, uint64_t bytes) const;
+    memory::FrameArenaStats GetFrameArenaStats() const;
 
     // Instance management
     std::vector<InstanceHandle> GetInstances() const;
@@ -123,6 +201,21 @@ private:
     // State
     EngineConfiguration m_configuration;
     debugger::Debugger* m_debugger = nullptr;
+    profiler::SamplingProfiler* m_profiler = nullptr;
+    profiler::Tracer* m_tracer = nullptr;
+    profiler::MetricsRegistry* m_metrics = nullptr;
+    profiler::MetricsServer* m_metricsServer = nullptr;
+    memory::FrameArena* m_frameArena = nullptr;
+    jit::JitCompiler* m_jit = nullptr;
+    jit::AotLinker* m_aot = nullptr;
+    runtime::Scheduler* m_scheduler = nullptr;
+    runtime::JobPool* m_jobPool = nullptr;
+    runtime::EventBus* m_eventBus = nullptr;
+    runtime::CommandQueue* m_commandQueue = nullptr;
+    runtime::TimerWheel* m_timers = nullptr;
+    runtime::GarbageCollector* m_garbageCollector = nullptr;
+    // Native functions behind Global::AsyncFunction, referenced by their registrations
+    std::vector<std::shared_ptr<void>> m_asyncFunctions;
     FunctionCaller* m_currentFunctionCaller = nullptr;
     bool m_built = false;
 
@@ -130,6 +223,14 @@ private:
     friend class ScriptLoader;
     friend class FunctionCaller;
     friend class debugger::Debugger;
+    friend class runtime::Scheduler;
+    friend class runtime::EventBus;
+    friend class runtime::CommandQueue;
+    friend class runtime::TimerWheel;
+    friend class runtime::GarbageCollector;
+    friend class profiler::SamplingProfiler;
+    friend class profiler::Tracer;
+    friend class profiler::MetricsRegistry;
     template <typename T>
     friend class TypeRegistration::Enum;
     template <typename T, TypeRegistration::ClassType>
@@ -137,11 +238,22 @@ private:
     friend class TypeRegistration::Global;
     friend class TypeRegistration::Interface;
 
+    // Caches keyed by the address of a function track it, AngelScript then reports its destruction through
+    // FunctionDestroyed before the address can be reused.
+    static void TrackFunction(const asIScriptFunction* function);
+    static void FunctionDestroyed(asIScriptFunction* function);
+
     // Internal AngelScript access
     asIScriptEngine* GetEngine() const { return m_engine; }
     asIScriptContext* GetContext();
     void ReleaseContext(asIScriptContext* ctx);
+    int Execute(asIScriptContext* ctx);
+    // Use instead of asIScriptContext::Suspend, Execute would resume the context if the profiler took a sample at the
+    // same time.
+    void Suspend(asIScriptContext* ctx);
+    runtime::JobPool* GetJobPool();
     asIScriptModule* GetModule(const std::string& moduleName);
+    void AssignMemoryAccount(asIScriptModule* module) const;
     asIScriptFunction* GetMethod(asITypeInfo* type, const std::string& methodDecl);
     asIScriptFunction* GetFunction(asIScriptModule* module, const std::string& functionDecl);
 
@@ -150,7 +262,16 @@ private:
     void LineCallback(asIScriptContext* context) const;
     void Print(const std::string& str) const;
 
+    // Shared by everything that executes scripts. call describes what was executing, e.g. "in timer callback f()".
+    void LogException(asIScriptContext* context, const std::string& call) const;
+    // Aborts context once it has run for longer than the script timeout since start, call from a line callback
+    bool AbortOnTimeout(asIScriptContext* context, std::chrono::steady_clock::time_point start, const char* what) const;
+    // Reports a script aborted by AbortOnTimeout, once it returned
+    void TimedOut() const;
+    static void PrintFormatted(asIScriptGeneric* generic);
+
     void RegisterAddOns() const;
+    void EnableJit();
 
     InstanceHandle RandomHandle() const;
 };
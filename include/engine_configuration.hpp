@@ -1,9 +1,65 @@
 #pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "memory/allocator.hpp"
 
 namespace srph
 {
 struct EngineConfiguration
 {
     float scriptTimeoutMillis;
+    // Maximum script print() calls logged per second and thread, 0 = unlimited.
+    uint32_t scriptPrintsPerSecond = 0;
+    // Global to the process, only the first engine's choice takes effect.
+    memory::AllocatorStrategy allocator = memory::AllocatorStrategy::System;
+    memory::IAllocator* customAllocator = nullptr;
+    // Attributes script memory to the module of the executing function, see Engine::GetMemoryStats.
+    bool moduleMemoryAccounting = false;
+    // Module name -> tenant name, modules of one tenant share an account and budget.
+    std::unordered_map<std::string, std::string> memoryTenants;
+    // Account (module or tenant) name -> budget in bytes. Implies moduleMemoryAccounting.
+    std::unordered_map<std::string, uint64_t> memoryBudgets;
+    // Chunk size of the frame arena used between Engine::BeginFrame and EndFrame.
+    uint32_t frameArenaChunkBytes = 256 * 1024;
+    // Initial stack of every script context, grows on demand. Kept small so thousands of waiting coroutines stay cheap.
+    uint32_t initialStackBytes = 1024;
+    // Worker threads for native functions registered with Global::AsyncFunction, 0 = hardware threads - 1.
+    uint32_t jobThreads = 0;
+    // Slice budget of every coroutine: statements or microseconds per resume before it continues on the next tick.
+    // 0 = unlimited, see Scheduler::SetSliceBudget.
+    uint32_t coroutineSliceLines = 0;
+    uint32_t coroutineSliceMicros = 0;
+    // Time Engine::Tick may spend resuming coroutines, the rest go first on the next tick. 0 = unlimited.
+    uint32_t tickBudgetMicros = 0;
+    // Ring size of the command queue per posting thread, rounded up to a power of two.
+    uint32_t commandQueueBytes = 64 * 1024;
+    // Step of the timer wheel behind setTimeout() and setInterval(), delays are rounded up to whole steps.
+    uint32_t timerResolutionMillis = 1;
+    // Translates hot script functions to native code, x86-64 only. A function is hot after its entries, statements
+    // and loop iterations were reached jitHotEntries times, 0 compiles every function when it is built.
+    bool jit = false;
+    uint32_t jitHotEntries = 1000;
+    // Binds script functions compiled ahead of time, see ScriptLoader::GenerateAot. Functions without native code keep
+    // their bytecode, or go to the JIT when it is enabled too.
+    bool aot = false;
+    // Fuses frequent bytecode instruction pairs (compare and branch, argument pushes) of functions the interpreter
+    // runs. Has no effect on functions seen by the JIT or AOT linker. Changes the vendored interpreter, so it is opt-in.
+    bool superinstructions = false;
+    // Replaces calls of trivial getters, setters and small arithmetic functions by their body after
+    // ScriptLoader::Build, per module with ScriptLoader::InlineAccessors. Inlined calls can't be stepped into.
+    bool inlineAccessors = false;
+    // Time Engine::Tick spends on the incremental cycle collector. 0 = AngelScript runs a few steps after every script
+    // call and new object instead, however long they take.
+    uint32_t gcBudgetMicros = 0;
+    // Marks objects in reference cycles on a helper thread while no script runs, scripts wait at most 0.2 ms for it.
+    // Destroying the garbage stays on the script thread.
+    bool gcBackgroundMarking = false;
+    // Logs the time ScriptLoader::Build spent in each phase, see ScriptLoader::Profile.
+    bool logBuildProfile = false;
+    // A coroutine that stops at a breakpoint is suspended while Engine::Tick keeps running the others. Contexts called
+    // from native code still block until they are continued.
+    bool debuggerNonStop = false;
 };
 }  // namespace srph
\ No newline at end of file
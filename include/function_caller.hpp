@@ -14,6 +14,11 @@ namespace debugger
 class Debugger;
 }
 
+namespace profiler
+{
+enum class TraceStatus : uint8_t;
+}
+
 class Engine;
 
 // If the FunctionPolicy is Optional, the call will nor throw an error or proceed when the function is not found.
@@ -65,7 +70,7 @@ public:
         }
         else
         {
-            context->SetArgObject(m_argIdx++, const_cast<void*>(static_cast<const void*>(&value)));
+            SetArgObject(const_cast<void*>(static_cast<const void*>(&value)));
         }
         return *this;
     }
@@ -76,6 +81,12 @@ public:
     asIScriptContext* GetContext() const;
 
 private:
+    // Shared by both Call overloads, returns the asEXECUTION_* result
+    int Execute();
+    profiler::TraceStatus ToTraceStatus(int result) const;
+    // Copies or references the object, keeps the marking thread of the garbage collector away
+    void SetArgObject(void* object);
+
     void LineCallback(asIScriptContext* context);
 
     // Context release, etc
@@ -94,8 +105,8 @@ private:
     std::string m_instanceName;
     bool m_executionFinished = false;
     bool m_isOptional = false;
+    bool m_timedOut = false;
 
     std::chrono::steady_clock::time_point m_startTime;
-    float m_timeoutMillis;
 };
 }  // namespace srph
\ No newline at end of file
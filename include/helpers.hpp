@@ -194,7 +194,7 @@ struct ScopedTimer
 
     ScopedTimer(const char* funcName) { name = funcName; }
 
-    ~ScopedTimer() { Log::Info("{} took {}ms.", name, t.Elapsed()); }
+    ~ScopedTimer() { SRPH_LOG_INFO("{} took {}ms.", name, t.Elapsed()); }
 };
 
 struct PreciseScopedTimer
@@ -204,7 +204,7 @@ struct PreciseScopedTimer
 
     PreciseScopedTimer(const char* funcName) { name = funcName; }
 
-    ~PreciseScopedTimer() { Log::Info("{} took {}us.", name, t.ElapsedUs()); }
+    ~PreciseScopedTimer() { SRPH_LOG_INFO("{} took {}us.", name, t.ElapsedUs()); }
 };
 
 #define SCOPED_TIMER() ScopedTimer timer(__FUNCTION__)
@@ -0,0 +1,145 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+
+#include "../external/angelscript/include/angelscript.h"
+
+namespace srph::jit
+{
+class JitCompiler;
+
+// Script function translated ahead of time, generated sources register tables of them
+struct AotFunction
+{
+    const char* module;
+    const char* declaration;
+    // Of the bytecode the function was generated from, see AotLinker::Hash
+    uint64_t hash;
+    asJITFunction function;
+};
+
+// Static initializer of every generated source
+struct AotRegistration
+{
+    AotRegistration(const AotFunction* functions, size_t count);
+};
+
+struct AotStats
+{
+    // Script functions seen, bound to native code and found with different bytecode than they were generated from
+    uint32_t functions = 0;
+    uint32_t bound = 0;
+    uint32_t stale = 0;
+};
+
+// Binds the registered native code to the script functions of the same module, declaration and bytecode. The others
+// keep their bytecode, or go to the JIT when there is one.
+class AotLinker : public asIJITCompilerV2
+{
+public:
+    explicit AotLinker(JitCompiler* jit);
+
+    void NewFunction(asIScriptFunction* function) override;
+    void CleanFunction(asIScriptFunction* function, asJITFunction jitFunction) override;
+
+    // Writes C++ source with the native code of the module's functions, compiled into the application it binds them
+    // on the next build of the same scripts. False when the file could not be written.
+    bool Generate(asIScriptModule* module, const std::string& path) const;
+
+    const AotStats& Stats() const { return m_stats; }
+
+    // Covers the instruction layout and the arguments of the translated instructions, the rest runs from the bytecode
+    static uint64_t Hash(asIScriptFunction* function);
+
+private:
+    JitCompiler* m_jit = nullptr;
+    std::unordered_set<asIScriptFunction*> m_bound;
+    AotStats m_stats;
+};
+
+// Used by the generated code
+namespace aot
+{
+// Mirrors asBC_SUSPEND of the interpreter for the instruction in the program pointer, true when the context suspends
+bool Suspend(asSVMRegisters* registers);
+
+// A T in the stack frame, the value register or behind a pointer. The same dwords hold values of any type, so they are
+// read and written with memcpy, which compiles to plain loads and stores.
+template <typename T>
+class Ref
+{
+public:
+    explicit Ref(void* address) : m_address(address) {}
+    Ref(const Ref& other) = default;
+
+    operator T() const
+    {
+        T value;
+        std::memcpy(&value, m_address, sizeof(T));
+        return value;
+    }
+
+    Ref& operator=(T value)
+    {
+        std::memcpy(m_address, &value, sizeof(T));
+        return *this;
+    }
+    // Copies the value, not the address
+    Ref& operator=(const Ref& other) { return *this = static_cast<T>(other); }
+
+    Ref& operator++() { return *this = static_cast<T>(static_cast<T>(*this) + 1); }
+    Ref& operator--() { return *this = static_cast<T>(static_cast<T>(*this) - 1); }
+    Ref& operator&=(T mask) { return *this = static_cast<T>(static_cast<T>(*this) & mask); }
+
+private:
+    void* m_address;
+};
+
+template <typename T>
+Ref<T> Var(asDWORD* frame, int offset)
+{
+    return Ref<T>(frame - offset);
+}
+
+template <typename T>
+Ref<T> Value(asSVMRegisters* registers)
+{
+    return Ref<T>(&registers->valueRegister);
+}
+
+// Through the pointer in the value register
+template <typename T>
+Ref<T> Deref(asSVMRegisters* registers)
+{
+    return Ref<T>(Value<T*>(registers));
+}
+
+template <typename T>
+void Push(asSVMRegisters* registers, T value)
+{
+    registers->stackPointer -= sizeof(T) / sizeof(asDWORD);
+    std::memcpy(registers->stackPointer, &value, sizeof(T));
+}
+
+// Like the interpreter's comparisons, NaN compares greater
+template <typename T>
+int Compare(T a, T b)
+{
+    return a == b ? 0 : (a < b ? -1 : 1);
+}
+
+inline float AsFloat(asDWORD bits)
+{
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Hands the instruction to the interpreter
+inline void Leave(asSVMRegisters* registers, asDWORD* instruction) { registers->programPointer = instruction; }
+}  // namespace aot
+}  // namespace srph::jit
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+#include "../external/angelscript/include/angelscript.h"
+
+namespace srph::jit
+{
+struct InlineStats
+{
+    // Call sites of script functions seen in the module, and the ones replaced by the body of the function
+    uint32_t calls = 0;
+    uint32_t inlined = 0;
+};
+
+// Rewrites calls of trivial getters and setters (a method that only returns or assigns one primitive property of
+// `this`) into the property access itself, and calls of leaf functions (one primitive expression of their primitive
+// parameters, without division or calls) into their body. In place and with the same instruction sizes. Virtual
+// calls are inlined when no class of the module overrides the method. Skipped for modules built with JIT
+// instructions, their native code depends on the bytecode it was generated from. Constant folding across statements,
+// copy elimination and loop-invariant hoisting need a pass that can resize the bytecode and are not part of this one.
+InlineStats InlineAccessors(asIScriptModule* module);
+}  // namespace srph::jit
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "../external/angelscript/include/angelscript.h"
+
+namespace srph::jit
+{
+struct JitStats
+{
+    // Script functions seen, compiled to native code and compiled functions that had nothing worth compiling
+    uint32_t functions = 0;
+    uint32_t compiled = 0;
+    uint32_t rejected = 0;
+    // Bytecode instructions translated, and the ones left to the interpreter
+    uint64_t instructions = 0;
+    uint64_t fallbacks = 0;
+    uint64_t codeBytes = 0;
+};
+
+// x86-64 JIT installed through asIJITCompilerV2. Functions run in the interpreter until their JitEntry instructions
+// (function entry, statements, loop heads) were reached hotEntries times, then they are translated to native code.
+// Instructions without a translation leave to the interpreter, which enters the native code again at the next
+// JitEntry, so every function stays correct whatever it uses.
+class JitCompiler : public asIJITCompilerV2
+{
+public:
+    explicit JitCompiler(uint32_t hotEntries);
+    ~JitCompiler() override;
+
+    // The JIT only emits x86-64
+    static bool Supported();
+
+    void NewFunction(asIScriptFunction* function) override;
+    void CleanFunction(asIScriptFunction* function, asJITFunction jitFunction) override;
+
+    // Translates right away instead of waiting for the function to become hot
+    bool Compile(asIScriptFunction* function);
+
+    const JitStats& Stats() const { return m_stats; }
+
+private:
+    struct Function
+    {
+        JitCompiler* compiler;
+        asIScriptFunction* function;
+        uint32_t entries = 0;
+        void* code = nullptr;
+        size_t codeBytes = 0;
+    };
+
+    // JIT function of functions that are not hot yet, counts the entries
+    static void CountEntry(asSVMRegisters* registers, asPWORD argument);
+
+    bool Translate(Function& function);
+    // Leaves the function to the interpreter for good and drops its record
+    void Reject(Function& function);
+    void Free(Function& function);
+
+private:
+    uint32_t m_hotEntries = 0;
+    // Function whose CountEntry is being replaced, see CleanFunction
+    asIScriptFunction* m_replacing = nullptr;
+    std::unordered_map<asIScriptFunction*, std::unique_ptr<Function>> m_functions;
+    JitStats m_stats;
+};
+}  // namespace srph::jit
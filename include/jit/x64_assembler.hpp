@@ -0,0 +1,209 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace srph::jit
+{
+enum class Reg : uint8_t
+{
+    RAX,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15
+};
+
+enum class Xmm : uint8_t
+{
+    XMM0,
+    XMM1,
+    XMM2,
+    XMM3
+};
+
+// Condition codes in encoding order
+enum class Condition : uint8_t
+{
+    O,
+    NO,
+    B,
+    AE,
+    E,
+    NE,
+    BE,
+    A,
+    S,
+    NS,
+    P,
+    NP,
+    L,
+    GE,
+    LE,
+    G
+};
+
+// The /digit of the 0x81 group, the r/m form of the opcode is (op << 3) | 1 or 3
+enum class Alu : uint8_t
+{
+    ADD = 0,
+    OR = 1,
+    AND = 4,
+    SUB = 5,
+    XOR = 6,
+    CMP = 7
+};
+
+enum class Shift : uint8_t
+{
+    SHL = 4,
+    SHR = 5,
+    SAR = 7
+};
+
+enum class SseOp : uint8_t
+{
+    ADD = 0x58,
+    MUL = 0x59,
+    SUB = 0x5C,
+    DIV = 0x5E
+};
+
+enum class Precision : uint8_t
+{
+    Single,
+    Double
+};
+
+struct Mem
+{
+    Reg base;
+    int32_t disp;
+};
+
+using Label = uint32_t;
+
+// Encoder for the subset of x86-64 the JIT emits. Memory operands are always [base + disp32].
+class X64Assembler
+{
+public:
+    Label NewLabel();
+    void Bind(Label label);
+    size_t Offset(Label label) const { return m_labels[label]; }
+    bool Bound(Label label) const { return m_labels[label] != UNBOUND; }
+
+    // Patches the jumps, false when a jump targets a label that was never bound
+    bool Finish();
+    const std::vector<uint8_t>& Code() const { return m_code; }
+
+    void Push(Reg reg);
+    void Pop(Reg reg);
+    void Ret();
+    void Jmp(Label label);
+    void Jmp(Reg reg);
+    void Jcc(Condition condition, Label label);
+    void Call(Reg reg);
+
+    void Mov32(Reg dst, Mem src);
+    void Mov32(Mem dst, Reg src);
+    void Mov32(Mem dst, int32_t imm);
+    void Mov32(Reg dst, int32_t imm);
+    void Mov64(Reg dst, Mem src);
+    void Mov64(Mem dst, Reg src);
+    void Mov64(Reg dst, Reg src);
+    void Mov64(Reg dst, uint64_t imm);
+    void Lea64(Reg dst, Mem src);
+
+    void Movzx8(Reg dst, Reg src);
+    void Movzx8(Reg dst, Mem src);
+    void Movsx8(Reg dst, Mem src);
+    void Movzx16(Reg dst, Mem src);
+    void Movsx16(Reg dst, Mem src);
+    void Movsxd(Reg dst, Mem src);
+
+    void Alu32(Alu op, Reg dst, Mem src);
+    void Alu32(Alu op, Reg dst, Reg src);
+    void Alu32(Alu op, Reg dst, int32_t imm);
+    void Alu32(Alu op, Mem dst, int32_t imm);
+    void Alu64(Alu op, Reg dst, Mem src);
+    void Alu64(Alu op, Reg dst, Reg src);
+    void Alu64(Alu op, Reg dst, int32_t imm);
+    void Alu64(Alu op, Mem dst, Reg src);
+    void Alu64(Alu op, Mem dst, int32_t imm);
+    void Cmp8(Mem dst, int8_t imm);
+    void Test32(Reg a, Reg b);
+    void Test8(Reg a, Reg b);
+
+    void Imul32(Reg dst, Mem src);
+    void Imul32(Reg dst, Reg src, int32_t imm);
+    void Imul64(Reg dst, Mem src);
+    void Not32(Mem dst);
+    void Neg32(Mem dst);
+    void Not64(Mem dst);
+    void Neg64(Mem dst);
+    // Shifts by cl
+    void Shift32(Shift op, Reg dst);
+    void Shift64(Shift op, Reg dst);
+    // edx:eax
+    void Cdq();
+    void Idiv32(Reg divisor);
+    void Div32(Reg divisor);
+    void Setcc(Condition condition, Reg dst);
+
+    void Movs(Precision precision, Xmm dst, Mem src);
+    void Movs(Precision precision, Mem dst, Xmm src);
+    void Arith(SseOp op, Precision precision, Xmm dst, Mem src);
+    void Arith(SseOp op, Precision precision, Xmm dst, Xmm src);
+    void Ucomis(Precision precision, Xmm a, Xmm b);
+    void Movd(Xmm dst, Reg src);
+    void Movq(Xmm dst, Reg src);
+    // Signed integer to floating point, 64 bit source when wide
+    void Cvtsi2s(Precision precision, Xmm dst, Mem src, bool wide);
+    void Cvtsi2s(Precision precision, Xmm dst, Reg src, bool wide);
+    // Truncating floating point to 32 bit integer
+    void Cvtts2si(Precision precision, Reg dst, Mem src);
+    // Single to double or double to single, precision is the one of the source
+    void Cvts2s(Precision from, Xmm dst, Mem src);
+
+private:
+    static constexpr size_t UNBOUND = SIZE_MAX;
+
+    struct Patch
+    {
+        size_t position;
+        Label label;
+    };
+
+    void Byte(uint8_t value) { m_code.push_back(value); }
+    void Dword(uint32_t value);
+    void Qword(uint64_t value);
+
+    // Emits REX if needed, w selects the 64 bit operand size
+    void Rex(bool w, uint8_t reg, uint8_t index, uint8_t base, bool force = false);
+    void ModRm(uint8_t reg, Mem mem);
+    void ModRm(uint8_t reg, Reg rm);
+
+    // prefix 0 = none
+    void Op(uint8_t prefix, bool w, std::initializer_list<uint8_t> opcode, uint8_t reg, Mem mem);
+    void Op(uint8_t prefix, bool w, std::initializer_list<uint8_t> opcode, uint8_t reg, Reg rm, bool byteRegs = false);
+
+    void Rel32(Label label);
+
+private:
+    std::vector<uint8_t> m_code;
+    std::vector<size_t> m_labels;
+    std::vector<Patch> m_patches;
+};
+}  // namespace srph::jit
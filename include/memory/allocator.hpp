@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class asIScriptModule;
+
+namespace srph::memory
+{
+
+enum class AllocatorStrategy : uint8_t
+{
+    // AngelScript keeps using malloc/free, no statistics
+    None = 0,
+    // malloc/free with statistics
+    System,
+    // Global free lists per size class
+    Pooled,
+    // Pooled, with a per-thread cache in front of the global free lists
+    ThreadCache,
+    // EngineConfiguration::customAllocator, with statistics
+    Custom
+};
+
+// User-supplied allocator. Must return memory aligned to 16 bytes and be callable from any thread.
+class IAllocator
+{
+public:
+    virtual ~IAllocator() = default;
+
+    virtual void* Allocate(size_t size) = 0;
+    virtual void Free(void* memory, size_t size) = 0;
+};
+
+// Requests up to the largest size class are pooled, everything above is forwarded to malloc.
+constexpr std::array<uint32_t, 16> SIZE_CLASSES = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096};
+// The last entry of MemoryStats::sizeClasses counts allocations above the largest size class
+constexpr size_t SIZE_CLASS_COUNT = SIZE_CLASSES.size() + 1;
+
+struct SizeClassStats
+{
+    // Largest request size in this class, 0 for the large class
+    uint32_t maxSize = 0;
+    uint64_t allocations = 0;
+    uint64_t liveAllocations = 0;
+    uint64_t liveBytes = 0;
+};
+
+// Module accounting, allocations are attributed to the module of the executing script function
+constexpr uint32_t MAX_ACCOUNTS = 256;
+
+struct AccountStats
+{
+    // Module or tenant name
+    std::string name;
+    // 0 = no limit
+    uint64_t budgetBytes = 0;
+    uint64_t liveBytes = 0;
+    uint64_t peakBytes = 0;
+    uint64_t allocations = 0;
+    uint64_t deniedAllocations = 0;
+};
+
+struct MemoryStats
+{
+    AllocatorStrategy strategy = AllocatorStrategy::None;
+    // Requested bytes, without allocator overhead
+    uint64_t liveBytes = 0;
+    uint64_t peakBytes = 0;
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    // Bytes held by the pools, including blocks that are currently free
+    uint64_t reservedBytes = 0;
+    std::array<SizeClassStats, SIZE_CLASS_COUNT> sizeClasses = {};
+    std::vector<AccountStats> accounts;
+};
+
+// Called when an allocation would exceed the budget of its account. Return true to allow it, otherwise the executing
+// script gets an exception.
+using BudgetCallback = std::function<bool(const AccountStats& account, size_t requestedBytes)>;
+
+// Installs the strategy as AngelScript's global memory functions. This has to happen before AngelScript allocates
+// anything, so only the first call in the process takes effect and the allocator stays installed until exit.
+// Returns false if a different strategy is already installed.
+bool Install(AllocatorStrategy strategy, IAllocator* custom = nullptr);
+AllocatorStrategy InstalledStrategy();
+
+MemoryStats Stats();
+
+// Module accounting costs a context lookup per allocation, so it is off until enabled.
+void EnableAccounting();
+bool AccountingEnabled();
+// Returns the id of the named account, creating it on first use. 0 (unattributed) when all accounts are in use.
+uint32_t Account(const std::string& name);
+// 0 = no limit
+void SetBudget(uint32_t account, uint64_t bytes);
+void SetBudgetCallback(const BudgetCallback& callback);
+// Attributes allocations made while a function of the module executes to the account, until the module is destroyed.
+void AssignModule(asIScriptModule* module, uint32_t account);
+
+}  // namespace srph::memory
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CScriptArray;
+
+namespace srph::memory
+{
+
+struct FrameArenaStats
+{
+    uint64_t frames = 0;
+    uint64_t allocations = 0;
+    // Bytes handed out during the last frame
+    uint64_t lastFrameBytes = 0;
+    // Buffers still referenced at the end of their frame, moved to the heap
+    uint64_t promotions = 0;
+    uint64_t promotedBytes = 0;
+    // Chunks kept past the end of their frame because their buffers could not be moved
+    uint64_t retainedChunks = 0;
+    uint64_t reservedBytes = 0;
+};
+
+// Bump allocator for the element buffers of script arrays created during a frame. Buffers that are still referenced
+// at the end of the frame are moved to the heap, everything else is dropped by resetting the arena. Suspended scripts
+// may point into the elements of a buffer, so while they exist chunks with live buffers are kept as they are instead.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t chunkSize);
+    ~FrameArena();
+
+    // Serves the array buffers allocated by scripts running on the calling thread until End
+    void Begin();
+    // relocate: no suspended script can point into the buffers, so live ones may be moved to the heap
+    void End(bool relocate);
+    bool Active() const { return m_active; }
+
+    const FrameArenaStats& Stats() const { return m_stats; }
+
+    // Installed with CScriptArray::SetBufferMemoryFunctions, fall back to the script allocator outside of frames
+    static void* AllocateBuffer(CScriptArray* owner, void* replacedBuffer, size_t size);
+    static void FreeBuffer(CScriptArray* owner, void* buffer);
+
+private:
+    struct Chunk
+    {
+        char* memory = nullptr;
+        size_t size = 0;
+        size_t used = 0;
+        // Buffers not freed yet, frees can come from any thread
+        std::atomic<uint32_t> live{0};
+    };
+
+    // Placed in front of every array buffer, defined in the source file
+    struct BufferHeader;
+
+    static BufferHeader* Header(void* buffer);
+    static void* HeapBuffer(CScriptArray* owner, size_t size);
+    void* Allocate(CScriptArray* owner, size_t size);
+    // Returns true if the chunk can be reused
+    bool Release(Chunk* chunk, bool relocate);
+    void Promote(Chunk* chunk);
+
+private:
+    std::vector<Chunk*> m_chunks;
+    // Chunks of earlier frames that still have live buffers
+    std::vector<Chunk*> m_retained;
+    size_t m_chunkSize = 0;
+    size_t m_current = 0;
+    bool m_active = false;
+    FrameArenaStats m_stats;
+};
+
+}  // namespace srph::memory
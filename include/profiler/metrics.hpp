@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class asIScriptFunction;
+
+namespace srph
+{
+class Engine;
+class FunctionCaller;
+}  // namespace srph
+
+namespace srph::profiler
+{
+enum class TraceStatus : uint8_t;
+
+// Lock-free log-linear histogram of nanosecond durations, 4 buckets per power of two (<= 19% relative error).
+class LatencyHistogram
+{
+public:
+    void Record(uint64_t nanos);
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t SumNanos() const { return m_sum.load(std::memory_order_relaxed); }
+    // Upper bound of the bucket containing the percentile, p in [0, 1]
+    uint64_t Percentile(double p) const;
+
+private:
+    static constexpr uint32_t SUB_BUCKET_BITS = 2;
+    static constexpr uint32_t BUCKET_COUNT = 64 << SUB_BUCKET_BITS;
+
+    static uint32_t BucketIndex(uint64_t nanos);
+    static uint64_t BucketUpperBound(uint32_t index);
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+};
+
+struct CallCounters
+{
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> exceptions{0};
+    std::atomic<uint64_t> timeouts{0};
+    LatencyHistogram latency;
+};
+
+struct CallMetrics
+{
+    std::string name;
+    // Module of a function, empty for types
+    std::string module;
+    uint64_t calls = 0;
+    uint64_t exceptions = 0;
+    uint64_t timeouts = 0;
+    uint64_t totalNanos = 0;
+    uint64_t p50Nanos = 0;
+    uint64_t p99Nanos = 0;
+};
+
+struct ContextMetrics
+{
+    uint64_t created = 0;
+    uint64_t active = 0;
+    uint64_t peak = 0;
+};
+
+struct MetricsSnapshot
+{
+    std::vector<CallMetrics> functions;
+    std::vector<CallMetrics> types;
+    ContextMetrics contexts;
+};
+
+// Counts calls made through FunctionCaller per script function and per script type. Recording only takes a shared lock
+// and atomic increments once a function has been seen.
+class MetricsRegistry
+{
+public:
+    MetricsSnapshot Snapshot() const;
+    // Prometheus text exposition format (version 0.0.4)
+    std::string Prometheus() const;
+
+private:
+    friend class srph::Engine;
+    friend class srph::FunctionCaller;
+
+    void Record(const asIScriptFunction* function, const std::string& instanceType, uint64_t nanos, TraceStatus status);
+
+    void ContextCreated();
+    void ContextReleased();
+
+    CallCounters& FunctionCounters(const asIScriptFunction* function);
+    CallCounters& TypeCounters(const std::string& typeName);
+    void FunctionDestroyed(const asIScriptFunction* function);
+
+private:
+    struct FunctionEntry
+    {
+        std::string name;
+        std::string module;
+        CallCounters counters;
+    };
+
+    mutable std::shared_mutex m_mutex;
+    // Series by module and declaration, so a rebuilt module continues the series of its functions. The live
+    // functions point to their series until they are destroyed.
+    std::map<std::pair<std::string, std::string>, std::unique_ptr<FunctionEntry>> m_series;
+    std::unordered_map<const asIScriptFunction*, FunctionEntry*> m_functions;
+    std::unordered_map<std::string, std::unique_ptr<CallCounters>> m_types;
+
+    std::atomic<uint64_t> m_contextsCreated{0};
+    std::atomic<uint64_t> m_contextsActive{0};
+    std::atomic<uint64_t> m_contextsPeak{0};
+};
+}  // namespace srph::profiler
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <asio/asio.hpp>
+
+namespace srph::profiler
+{
+class MetricsRegistry;
+
+// Serves the registry at http://127.0.0.1:<port>/metrics for Prometheus scrapes. Loopback only, one request per
+// connection. Connections that don't complete their request and response within a few seconds are closed.
+class MetricsServer
+{
+public:
+    MetricsServer(const MetricsRegistry* registry, uint16_t port);
+    ~MetricsServer();
+
+    bool Start();
+    void Stop();
+
+private:
+    struct Client;
+
+    void ServerLoop();
+    void Accept();
+    void Read(const std::shared_ptr<Client>& client);
+    void Close(const std::shared_ptr<Client>& client);
+    std::string Response(const std::string& request) const;
+
+private:
+    const MetricsRegistry* m_registry;
+    uint16_t m_port;
+
+    std::unique_ptr<asio::io_context> m_io;
+    std::unique_ptr<asio::ip::tcp::acceptor> m_acceptor;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    // Open connections, owned by the server thread
+    std::set<std::shared_ptr<Client>> m_clients;
+};
+}  // namespace srph::profiler
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class asIScriptContext;
+class asIScriptFunction;
+
+namespace srph
+{
+class Engine;
+}
+
+namespace srph::profiler
+{
+
+struct FunctionSamples
+{
+    std::string name;
+    uint64_t selfSamples = 0;
+    uint64_t totalSamples = 0;
+};
+
+struct LineSamples
+{
+    std::string function;
+    std::string section;
+    int line = 0;
+    uint64_t samples = 0;
+};
+
+// Periodically suspends the innermost executing context of every thread and records its callstack. The engine resumes
+// the context right away, so the only cost is the suspend/resume round trip per sample.
+class SamplingProfiler
+{
+public:
+    SamplingProfiler(uint32_t intervalMicros);
+    ~SamplingProfiler();
+
+    void Start();
+    void Stop();
+    void Reset();
+
+    uint64_t SampleCount() const;
+    std::vector<FunctionSamples> TopFunctions(size_t count) const;
+    std::vector<LineSamples> TopLines(size_t count) const;
+
+    // Collapsed stacks ("outer;inner count" per line) consumed by flamegraph.pl, speedscope, etc.
+    std::string CollapsedStacks() const;
+    bool WriteCollapsedStacks(const std::string& path) const;
+    std::string Report(size_t count) const;
+
+private:
+    friend class srph::Engine;
+
+    // Called by the engine around every execution
+    void Enter(asIScriptContext* context);
+    void Leave(asIScriptContext* context);
+    // Records a pending sample. Returns true if the context was suspended by the profiler only and can be resumed.
+    bool ConsumeSample(asIScriptContext* context);
+    // The context was suspended by someone else, ConsumeSample keeps it suspended
+    void SuspendRequested(asIScriptContext* context);
+
+    void SamplerLoop();
+    void Record(asIScriptContext* context);
+    // Functions are numbered when first sampled, a function created at the address of a destroyed one gets a new id
+    uint32_t FunctionId(asIScriptFunction* function);
+    void FunctionDestroyed(const asIScriptFunction* function);
+
+private:
+    struct ActiveContext
+    {
+        asIScriptContext* context;
+        bool pending;
+        bool suspendRequested;
+    };
+
+    struct Frame
+    {
+        uint32_t function;
+        int line;
+
+        bool operator==(const Frame& o) const { return function == o.function && line == o.line; }
+    };
+
+    struct FrameHash
+    {
+        size_t operator()(const Frame& f) const
+        {
+            size_t h1 = std::hash<uint32_t>{}(f.function);
+            size_t h2 = std::hash<int>{}(f.line);
+            return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
+        }
+    };
+
+    struct StackHash
+    {
+        size_t operator()(const std::vector<uint32_t>& stack) const
+        {
+            size_t h = 0;
+            for (uint32_t f : stack)
+            {
+                h ^= std::hash<uint32_t>{}(f) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            }
+            return h;
+        }
+    };
+
+    struct FunctionInfo
+    {
+        std::string name;
+        std::string section;
+    };
+
+    uint32_t m_intervalMicros;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    // Executing contexts, innermost last
+    std::mutex m_activeMutex;
+    std::unordered_map<std::thread::id, std::vector<ActiveContext>> m_active;
+
+    // Aggregates
+    mutable std::mutex m_samplesMutex;
+    uint64_t m_sampleCount = 0;
+    // Names are resolved when first sampled, so reports stay valid after a module is discarded. Ids of live
+    // functions by address, the infos by id.
+    std::unordered_map<const asIScriptFunction*, uint32_t> m_ids;
+    std::vector<FunctionInfo> m_infos;
+    std::unordered_map<uint32_t, FunctionSamples> m_functions;
+    std::unordered_map<Frame, uint64_t, FrameHash> m_lines;
+    std::unordered_map<std::vector<uint32_t>, uint64_t, StackHash> m_stacks;
+    std::vector<uint32_t> m_scratch;
+};
+}  // namespace srph::profiler
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class asIScriptContext;
+class asIScriptFunction;
+
+namespace srph
+{
+class Engine;
+class FunctionCaller;
+}  // namespace srph
+
+namespace srph::profiler
+{
+
+enum class TraceStatus : uint8_t
+{
+    Finished = 0,
+    Exception,
+    Timeout,
+    Aborted,
+    Suspended
+};
+
+struct TracerOptions
+{
+    // Events kept per thread, the oldest events are overwritten when full.
+    uint32_t eventsPerThread = 1 << 16;
+    // Also trace script-to-script calls. Uses a line callback, so timings are at line granularity and slower.
+    bool scriptCalls = false;
+};
+
+struct TraceEvent
+{
+    uint32_t name;
+    // Index into the names of the thread, UINT32_MAX for global functions
+    uint32_t instanceType;
+    TraceStatus status;
+    bool scriptCall;
+    uint64_t startNanos;
+    uint64_t durationNanos;
+};
+
+// Records one complete event per native-to-script call (and optionally per script-to-script call) into a ring buffer
+// owned by the calling thread. Export as Chrome trace-event JSON, viewable in chrome://tracing or ui.perfetto.dev.
+class Tracer
+{
+public:
+    Tracer(const TracerOptions& options);
+    ~Tracer();
+
+    void Clear();
+
+    uint64_t EventCount() const;
+    uint64_t OverwrittenCount() const;
+
+    std::string ExportChromeTrace() const;
+    bool WriteChromeTrace(const std::string& path) const;
+
+private:
+    friend class srph::Engine;
+    friend class srph::FunctionCaller;
+
+    struct OpenFrame
+    {
+        const asIScriptFunction* function;
+        uint64_t startNanos;
+    };
+
+    struct Scope
+    {
+        asIScriptContext* context;
+        const asIScriptFunction* function;
+        uint32_t instanceType;
+        uint64_t startNanos;
+        // Script-to-script calls currently on the callstack, outermost first
+        std::vector<OpenFrame> frames;
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t index;
+        std::mutex mutex;
+        std::vector<TraceEvent> events;
+        uint64_t head = 0;
+
+        // Interned names, resolved when first recorded so the trace stays valid after a module is discarded. A
+        // destroyed function leaves functionNames, its address may be reused by another one.
+        std::vector<std::string> names;
+        std::unordered_map<const asIScriptFunction*, uint32_t> functionNames;
+        std::unordered_map<std::string, uint32_t> typeNames;
+
+        std::vector<Scope> scopes;
+    };
+
+    // Called by FunctionCaller around every call
+    void Begin(asIScriptContext* context, const std::string& instanceType);
+    void End(TraceStatus status);
+
+    // Registered as a line callback when script calls are traced
+    void LineCallback(asIScriptContext* context);
+
+    ThreadBuffer* Buffer();
+    uint64_t Now() const;
+    void Push(ThreadBuffer* buffer, const TraceEvent& event);
+    uint32_t Intern(ThreadBuffer* buffer, const asIScriptFunction* function);
+    uint32_t Intern(ThreadBuffer* buffer, const std::string& typeName);
+    void FunctionDestroyed(const asIScriptFunction* function);
+
+private:
+    TracerOptions m_options;
+    uint64_t m_id;
+    std::chrono::steady_clock::time_point m_epoch;
+
+    mutable std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+};
+}  // namespace srph::profiler
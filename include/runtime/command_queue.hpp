@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+class asIScriptGeneric;
+
+namespace srph
+{
+class Engine;
+
+namespace runtime
+{
+struct CommandQueueStats
+{
+    uint64_t posted = 0;
+    uint64_t drained = 0;
+    // Posts refused because the ring of their thread was full
+    uint64_t dropped = 0;
+    uint32_t rings = 0;
+};
+
+// Commands posted by scripts and executed by the application at a sync point. Every thread that posts gets its own
+// single producer, single consumer ring, so posting takes no locks and commands of one thread drain in post order.
+class CommandQueue
+{
+public:
+    CommandQueue(Engine* engine, uint32_t ringBytes);
+    ~CommandQueue();
+
+    // Registers "bool post(const <typeName>&in)" for a value type already registered as typeName. post() copies the
+    // command into the ring and returns false when the ring is full.
+    template <typename T>
+    void Register(const std::string& typeName, std::function<void(const T&)> handler)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Commands are copied bytewise and must be trivially copyable.");
+        static_assert(alignof(T) <= 8, "Commands can be aligned to 8 bytes at most.");
+
+        RegisterCommand(typeName, static_cast<uint32_t>(sizeof(T)), [handler = std::move(handler)](const void* data) { handler(*static_cast<const T*>(data)); });
+    }
+
+    // Runs the handlers of everything posted so far, returns the number of commands. Call from one thread at a time.
+    uint32_t Drain();
+
+    CommandQueueStats Stats() const;
+
+private:
+    class Ring;
+
+    struct Command
+    {
+        CommandQueue* queue;
+        uint32_t index;
+        uint32_t size;
+        std::function<void(const void*)> handler;
+    };
+
+    void RegisterCommand(const std::string& typeName, uint32_t size, std::function<void(const void*)> handler);
+    bool Post(const Command& command, const void* data);
+    Ring* ThreadRing();
+
+    static void ScriptPost(asIScriptGeneric* generic);
+
+private:
+    Engine* m_engine = nullptr;
+    uint64_t m_id = 0;
+    uint32_t m_ringBytes = 0;
+
+    // Stable addresses, used as auxiliary pointer of the post() registrations
+    std::deque<Command> m_commands;
+
+    mutable std::mutex m_ringsMutex;
+    std::vector<std::unique_ptr<Ring>> m_rings;
+    std::unordered_map<std::thread::id, Ring*> m_threadRings;
+    std::vector<Ring*> m_draining;
+
+    std::atomic<uint64_t> m_dropped{0};
+    uint64_t m_drained = 0;
+};
+}  // namespace runtime
+}  // namespace srph
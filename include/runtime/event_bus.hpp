@@ -0,0 +1,144 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../external/angelscript/include/angelscript.h"
+
+namespace srph
+{
+class Engine;
+class ScriptLoader;
+
+namespace runtime
+{
+using EventId = uint32_t;
+
+// Broadcasts native events to the script instances whose class has a handler method for them. Handler lookups happen
+// once per type, when a module is built or an event is registered, publishing only visits the subscribed instances.
+class EventBus
+{
+public:
+    explicit EventBus(Engine* engine);
+    ~EventBus();
+
+    // Method declaration of the handler, for example "void OnDamage(int)". Registering twice returns the same id.
+    EventId Register(const std::string& handlerDecl);
+
+    // Calls the handler of every subscribed instance in one context, returns how many finished without errors.
+    template <typename... Args>
+    uint32_t Publish(EventId id, const Args&... args)
+    {
+        if (id >= m_events.size() || m_events[id].subscribers.empty()) return 0;
+        if (!CheckArguments(id, sizeof...(Args))) return 0;
+
+        asIScriptContext* context = BeginPublish();
+        uint32_t delivered = 0;
+
+        // By index and copied, handlers may create instances or register events.
+        for (size_t i = 0; i < m_events[id].subscribers.size(); i++)
+        {
+            const Subscriber subscriber = m_events[id].subscribers[i];
+            if (context->Prepare(subscriber.handler) < 0) continue;
+
+            context->SetObject(subscriber.object);
+            asUINT index = 0;
+            (SetArgument(context, subscriber.handler, index++, args), ...);
+
+            if (Dispatch(context, subscriber.handler)) delivered++;
+        }
+
+        EndPublish(context);
+        return delivered;
+    }
+
+    uint32_t SubscriberCount(EventId id) const
+    {
+        return id < m_events.size() ? static_cast<uint32_t>(m_events[id].subscribers.size()) : 0;
+    }
+
+private:
+    struct Subscriber
+    {
+        asIScriptObject* object;
+        asIScriptFunction* handler;
+    };
+
+    struct Event
+    {
+        std::string handlerDecl;
+        std::vector<Subscriber> subscribers;
+    };
+
+    // Timeout of the handler currently executing in a publish, nested publishes push their own
+    struct Dispatching
+    {
+        asIScriptContext* context;
+        std::chrono::steady_clock::time_point start;
+        bool timedOut;
+    };
+
+    friend class srph::Engine;
+    friend class srph::ScriptLoader;
+
+    // Builds the handler tables of the script classes in module
+    void AddModule(asIScriptModule* module);
+    void AddInstance(asIScriptObject* object);
+    std::vector<asIScriptFunction*>& Handlers(asITypeInfo* type);
+
+    bool CheckArguments(EventId id, size_t count) const;
+    asIScriptContext* BeginPublish();
+    void EndPublish(asIScriptContext* context);
+    bool Dispatch(asIScriptContext* context, asIScriptFunction* handler);
+    void LineCallback(asIScriptContext* context);
+
+    template <typename T>
+    static void SetArgument(asIScriptContext* context, asIScriptFunction* handler, asUINT index, const T& value)
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            context->SetArgFloat(index, value);
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            context->SetArgDouble(index, value);
+        }
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+        {
+            if constexpr (sizeof(T) == 1) context->SetArgByte(index, static_cast<asBYTE>(value));
+            else if constexpr (sizeof(T) == 2) context->SetArgWord(index, static_cast<asWORD>(value));
+            else if constexpr (sizeof(T) == 4) context->SetArgDWord(index, static_cast<asDWORD>(value));
+            else context->SetArgQWord(index, static_cast<asQWORD>(value));
+        }
+        else if constexpr (std::is_pointer_v<T>)
+        {
+            context->SetArgObject(index, const_cast<void*>(static_cast<const void*>(value)));
+        }
+        else
+        {
+            int typeId = 0;
+            asDWORD flags = 0;
+            handler->GetParam(index, &typeId, &flags);
+
+            void* address = const_cast<void*>(static_cast<const void*>(&value));
+            if (flags & asTM_INOUTREF) context->SetArgAddress(index, address);
+            else context->SetArgObject(index, address);
+        }
+    }
+
+private:
+    Engine* m_engine = nullptr;
+
+    std::vector<Event> m_events;
+    // Script class -> handler per event, nullptr when the class does not handle it
+    std::unordered_map<asITypeInfo*, std::vector<asIScriptFunction*>> m_handlers;
+
+    // Reused by publishes that are not nested
+    asIScriptContext* m_context = nullptr;
+    std::vector<Dispatching> m_dispatching;
+};
+}  // namespace runtime
+}  // namespace srph
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+class asIScriptEngine;
+
+namespace srph::runtime
+{
+class Scheduler;
+using CoroutineId = uint32_t;
+
+// Script type future<T>, completed by a native job on the job pool. await() suspends the calling coroutine until the
+// job is done, get() returns the result.
+class ScriptFuture
+{
+public:
+    enum class State : uint8_t
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    explicit ScriptFuture(Scheduler* scheduler) : m_scheduler(scheduler) {}
+
+    // Registers the future<T> type
+    static void Register(asIScriptEngine* engine);
+
+    // Thread safe, called by the job
+    template <typename T>
+    void Complete(T&& value)
+    {
+        m_value = new TypedValue<std::decay_t<T>>(std::forward<T>(value));
+        Resolve(State::Ready, {});
+    }
+    void Fail(std::string error) { Resolve(State::Failed, std::move(error)); }
+
+    State GetState() const { return m_state.load(std::memory_order_acquire); }
+
+    void AddRef() { m_refCount.fetch_add(1, std::memory_order_relaxed); }
+    void Release();
+
+private:
+    struct Value
+    {
+        virtual ~Value() = default;
+        virtual void* Address() = 0;
+    };
+
+    template <typename T>
+    struct TypedValue : Value
+    {
+        explicit TypedValue(T v) : value(std::move(v)) {}
+        void* Address() override { return &value; }
+
+        T value;
+    };
+
+    ~ScriptFuture() { delete m_value; }
+
+    void Resolve(State state, std::string error);
+
+    // Script interface
+    bool Ready() const { return GetState() == State::Ready; }
+    bool Failed() const { return GetState() == State::Failed; }
+    std::string Error() const;
+    void Await();
+    const void* Get() const;
+
+private:
+    std::atomic<int> m_refCount{1};
+    std::atomic<State> m_state{State::Pending};
+
+    Scheduler* m_scheduler;
+    // Guards the waiter against the job completing while a coroutine starts to await
+    mutable std::mutex m_mutex;
+    CoroutineId m_waiter = 0;
+
+    // Written once before the state leaves Pending
+    Value* m_value = nullptr;
+    std::string m_error;
+};
+
+// Owns a job's reference to its future. A job dropped before it ran fails the future, so awaiting coroutines are
+// resumed with an error instead of waiting forever.
+using FutureRef = std::shared_ptr<ScriptFuture>;
+
+inline FutureRef MakeFutureRef(ScriptFuture* future)
+{
+    future->AddRef();
+    return FutureRef(future,
+                     [](ScriptFuture* f)
+                     {
+                         if (f->GetState() == ScriptFuture::State::Pending) f->Fail("The job was dropped.");
+                         f->Release();
+                     });
+}
+}  // namespace srph::runtime
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "profiler/metrics.hpp"
+
+namespace srph
+{
+class Engine;
+
+namespace runtime
+{
+struct GcStats
+{
+    // Objects known to the collector, and the ones destroyed or found in reference cycles since the engine started
+    uint32_t objects = 0;
+    uint64_t destroyed = 0;
+    uint64_t detected = 0;
+    // Incremental steps run by Collect on the script thread and by the marking thread
+    uint64_t steps = 0;
+    uint64_t backgroundSteps = 0;
+    // Time the script thread spent collecting, or waiting for the marking thread before running a script
+    uint64_t pauses = 0;
+    uint64_t p50PauseNanos = 0;
+    uint64_t p99PauseNanos = 0;
+    uint64_t maxPauseNanos = 0;
+};
+
+// Runs AngelScript's incremental cycle collector within a time budget instead of after every script call, and
+// optionally marks on a helper thread. The helper only steps while no script executes and no native code changes
+// script objects through the engine, see ScriptAccess. It never releases an object, destructors and the destruction
+// of garbage stay on the script thread.
+class GarbageCollector
+{
+public:
+    GarbageCollector(Engine* engine, uint32_t budgetMicros, bool backgroundMarking);
+    ~GarbageCollector();
+
+    // Incremental steps until the budget is spent, resumes where the previous call stopped
+    void Collect(uint32_t budgetMicros);
+    // Detects and destroys all garbage, as long as it takes
+    void FullCycle();
+
+    GcStats Stats() const;
+    const profiler::LatencyHistogram& Pauses() const { return m_pauses; }
+
+    // Called on the script thread around script execution and native changes of script objects, they nest
+    void EnterScript()
+    {
+        if (m_background && m_depth++ == 0) Lock();
+    }
+    void LeaveScript()
+    {
+        if (m_background && --m_depth == 0) m_scriptMutex.unlock();
+    }
+
+private:
+    void Lock();
+    void Record(std::chrono::steady_clock::time_point start);
+    void MarkLoop();
+
+private:
+    Engine* m_engine = nullptr;
+    bool m_background = false;
+    uint32_t m_depth = 0;
+
+    // Held by the script thread while scripts run, native code changes script objects or it collects, by the helper
+    // while it marks
+    std::mutex m_scriptMutex;
+    std::thread m_marker;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    profiler::LatencyHistogram m_pauses;
+    std::atomic<uint64_t> m_maxPause{0};
+    uint64_t m_steps = 0;
+    std::atomic<uint64_t> m_backgroundSteps{0};
+};
+
+// Keeps the marking thread away while native code changes script objects outside of a script call, for example
+// when it resizes a script array, writes a reflected property or releases an object. The engine's own entry points
+// take it already.
+class ScriptAccess
+{
+public:
+    explicit ScriptAccess(GarbageCollector* collector) : m_collector(collector) { m_collector->EnterScript(); }
+    ~ScriptAccess() { m_collector->LeaveScript(); }
+
+    ScriptAccess(const ScriptAccess&) = delete;
+    ScriptAccess& operator=(const ScriptAccess&) = delete;
+
+private:
+    GarbageCollector* m_collector;
+};
+}  // namespace runtime
+}  // namespace srph
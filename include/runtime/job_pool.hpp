@@ -0,0 +1,36 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace srph::runtime
+{
+// Worker threads running the native jobs behind future<T>. Jobs that have not started when the pool is destroyed are
+// dropped, running ones are waited for.
+class JobPool
+{
+public:
+    // 0 threads = one less than the hardware threads, at least one
+    explicit JobPool(uint32_t threads);
+    ~JobPool();
+
+    void Submit(std::function<void()> job);
+
+    uint32_t ThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+private:
+    void WorkerLoop();
+
+private:
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_jobs;
+    bool m_stopping = false;
+};
+}  // namespace srph::runtime
@@ -0,0 +1,176 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+class asIScriptContext;
+class asIScriptFunction;
+class asIScriptObject;
+
+namespace srph
+{
+class Engine;
+
+namespace runtime
+{
+using CoroutineId = uint32_t;
+
+enum class WaitKind : uint8_t
+{
+    None,
+    // yield(), resumed on the next tick
+    Yield,
+    // wait(seconds)
+    Time,
+    // waitUntil(condition), the condition is polled every tick
+    Condition,
+    // Suspend(), resumed on the tick after Wake, for example by future<T>.await()
+    External
+};
+
+// Work a coroutine may do per resume before it is suspended until the next tick, 0 = unlimited. Lines count the
+// statements executed and give the same suspension points on every run, microseconds do not.
+struct SliceBudget
+{
+    uint32_t lines = 0;
+    uint32_t micros = 0;
+};
+
+struct SchedulerStats
+{
+    uint32_t coroutines = 0;
+    uint32_t yielded = 0;
+    uint32_t sleeping = 0;
+    uint32_t conditional = 0;
+    uint32_t external = 0;
+    uint32_t pooledContexts = 0;
+    uint64_t resumes = 0;
+    uint64_t completed = 0;
+    // Resumes that ran out of their slice budget
+    uint64_t slices = 0;
+    // Resumes pushed to the next tick by the tick budget
+    uint64_t deferred = 0;
+};
+
+// Runs script coroutines on suspended contexts. Waiting coroutines are not touched until they are due, except for
+// waitUntil conditions, which are evaluated once per tick.
+class Scheduler
+{
+public:
+    explicit Scheduler(Engine* engine);
+    ~Scheduler();
+
+    // Registers yield(), wait(), waitUntil(), startCoroutine(), stopCoroutine() and the future<T> type
+    void RegisterInterface();
+
+    // Advances the scheduler clock and resumes every coroutine whose wait is over, in the order they became due. With a
+    // tick budget, coroutines that did not get their turn go first on the next tick.
+    void Tick(double deltaSeconds);
+
+    // Takes over a reference to the function. Methods are resumed on object, delegates on their own object. The
+    // coroutine gets the slice budget of the engine configuration.
+    CoroutineId Start(asIScriptFunction* function, asIScriptObject* object = nullptr);
+    void SetSliceBudget(CoroutineId id, SliceBudget budget);
+    // Time spent resuming coroutines per tick, 0 = unlimited
+    void SetTickBudget(uint32_t micros) { m_tickBudgetMicros = micros; }
+    void Stop(CoroutineId id);
+    bool Running(CoroutineId id) const { return m_coroutines.find(id) != m_coroutines.end(); }
+    // Coroutines that have not finished
+    size_t Count() const { return m_coroutines.size(); }
+
+    // Called from registered functions. Suspends the running coroutine until Wake, returns 0 and raises a script
+    // exception when no coroutine is running.
+    CoroutineId Suspend(const char* function);
+    // Thread safe
+    void Wake(CoroutineId id);
+    // Suspends the coroutine executing in the context until Wake, used by the debugger to stop a single coroutine.
+    // Returns 0 if the context doesn't run a coroutine or runs it nested in an application call.
+    CoroutineId SuspendContext(asIScriptContext* context);
+    // The coroutine owning the context, 0 for other contexts
+    CoroutineId Find(asIScriptContext* context) const;
+
+    double Time() const { return m_time; }
+    SchedulerStats Stats() const;
+
+private:
+    struct Coroutine
+    {
+        asIScriptContext* context = nullptr;
+        asIScriptFunction* function = nullptr;
+        asIScriptObject* object = nullptr;
+        asIScriptFunction* condition = nullptr;
+        WaitKind wait = WaitKind::None;
+        SliceBudget budget;
+    };
+
+    struct Sleeper
+    {
+        double wakeTime;
+        CoroutineId id;
+
+        bool operator>(const Sleeper& other) const { return wakeTime > other.wakeTime; }
+    };
+
+    void Resume(CoroutineId id);
+    void Finish(CoroutineId id, int result);
+    bool EvaluateCondition(asIScriptFunction* condition);
+
+    asIScriptContext* AcquireContext();
+    // Returns the coroutine that is executing in the active context, raises a script exception otherwise
+    Coroutine* RunningCoroutine(const char* function);
+
+    void LineCallback(asIScriptContext* context);
+
+    // Script interface
+    void ScriptYield();
+    void ScriptWait(float seconds);
+    void ScriptWaitUntil(asIScriptFunction* condition);
+    CoroutineId ScriptStart(asIScriptFunction* function);
+    void ScriptStop(CoroutineId id);
+
+private:
+    Engine* m_engine = nullptr;
+
+    std::unordered_map<CoroutineId, Coroutine> m_coroutines;
+    CoroutineId m_nextId = 1;
+
+    std::vector<CoroutineId> m_yielded;
+    std::priority_queue<Sleeper, std::vector<Sleeper>, std::greater<Sleeper>> m_sleeping;
+    std::vector<CoroutineId> m_conditional;
+    // Reused between ticks
+    std::vector<CoroutineId> m_batch;
+    // Due coroutines left over when the tick budget ran out
+    std::vector<CoroutineId> m_deferred;
+    uint32_t m_tickBudgetMicros = 0;
+
+    std::mutex m_wokenMutex;
+    std::vector<CoroutineId> m_woken;
+    std::atomic<bool> m_wakePending{false};
+
+    std::vector<asIScriptContext*> m_pool;
+    asIScriptContext* m_conditionContext = nullptr;
+
+    double m_time = 0.0;
+    CoroutineId m_running = 0;
+    bool m_stopRunning = false;
+
+    // Timeout of the current resume or condition, slice of the current resume
+    asIScriptContext* m_executing = nullptr;
+    std::chrono::steady_clock::time_point m_executeStart;
+    bool m_timedOut = false;
+    const SliceBudget* m_slice = nullptr;
+    uint32_t m_sliceLines = 0;
+    bool m_sliced = false;
+
+    uint64_t m_resumes = 0;
+    uint64_t m_completed = 0;
+    uint64_t m_slices = 0;
+    uint64_t m_deferredResumes = 0;
+};
+}  // namespace runtime
+}  // namespace srph
@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class asIScriptContext;
+class asIScriptFunction;
+
+namespace srph
+{
+class Engine;
+
+namespace runtime
+{
+// Generation in the upper 32 bits, slot index in the lower, 0 is never a valid id
+using TimerId = uint64_t;
+
+struct TimerStats
+{
+    uint32_t active = 0;
+    uint64_t fired = 0;
+    // Timers moved down a level of the wheel
+    uint64_t cascaded = 0;
+};
+
+// Hierarchical timing wheel behind setTimeout(), setInterval() and cancel(). Inserting and cancelling are O(1), a
+// step only looks at one slot of the innermost wheel and timers are touched again only when their level cascades.
+class TimerWheel
+{
+public:
+    TimerWheel(Engine* engine, uint32_t resolutionMillis);
+    ~TimerWheel();
+
+    // Registers the timerCallback funcdef, setTimeout(), setInterval() and cancel()
+    void RegisterInterface();
+
+    // Fires the timers that expire within deltaSeconds in expiry order, all through one context
+    void Advance(double deltaSeconds);
+
+    // Takes over a reference to the callback. An interval of 0 fires once.
+    TimerId Add(asIScriptFunction* callback, double delaySeconds, double intervalSeconds = 0.0);
+    bool Cancel(TimerId id);
+
+    TimerStats Stats() const;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t ROOT_BITS = 8;
+    static constexpr uint32_t LEVEL_BITS = 6;
+    static constexpr uint32_t LEVELS = 4;
+    static constexpr uint32_t ROOT_SLOTS = 1u << ROOT_BITS;
+    static constexpr uint32_t LEVEL_SLOTS = 1u << LEVEL_BITS;
+
+    struct Timer
+    {
+        asIScriptFunction* callback = nullptr;
+        uint64_t expiry = 0;
+        uint64_t interval = 0;
+        uint32_t generation = 0;
+        uint32_t slot = NONE;
+        uint32_t prev = NONE;
+        uint32_t next = NONE;
+    };
+
+    void Insert(uint32_t index);
+    void Unlink(uint32_t index);
+    // Moves the timers of a slot of an outer level to the levels below, returns the slot index
+    uint32_t Cascade(uint32_t level);
+    uint32_t SlotOf(uint32_t level, uint32_t index) const;
+    void Free(uint32_t index);
+    TimerId IdOf(uint32_t index) const { return (uint64_t(m_timers[index].generation) << 32) | index; }
+    uint32_t IndexOf(TimerId id) const;
+
+    void Fire(asIScriptFunction* callback);
+    void LineCallback(asIScriptContext* context);
+
+    uint64_t Ticks(double seconds) const;
+
+    // Script interface
+    TimerId ScriptSetTimeout(asIScriptFunction* callback, float seconds);
+    TimerId ScriptSetInterval(asIScriptFunction* callback, float seconds);
+    bool ScriptCancel(TimerId id);
+
+private:
+    Engine* m_engine = nullptr;
+    double m_resolutionSeconds = 0.001;
+
+    // Root wheel first, then LEVEL_SLOTS per outer level. Heads of the timer lists.
+    std::array<uint32_t, ROOT_SLOTS + LEVEL_SLOTS * (LEVELS - 1)> m_slots;
+    std::vector<Timer> m_timers;
+    std::vector<uint32_t> m_freeTimers;
+    uint32_t m_active = 0;
+
+    uint64_t m_now = 0;
+    double m_pendingTicks = 0.0;
+
+    // Reused between steps
+    std::vector<TimerId> m_due;
+    asIScriptContext* m_context = nullptr;
+    bool m_timedOut = false;
+    std::chrono::steady_clock::time_point m_fireStart;
+
+    uint64_t m_fired = 0;
+    uint64_t m_cascaded = 0;
+};
+}  // namespace runtime
+}  // namespace srph
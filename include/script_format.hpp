@@ -0,0 +1,14 @@
+#pragma once
+#include <fmt/format.h>
+
+class asIScriptGeneric;
+
+namespace srph::formatting
+{
+// Formats the variadic arguments following the format string at fmtArg directly from their type ids. On a bad format
+// string a script exception is set and false is returned.
+bool FormatArgs(asIScriptGeneric* generic, unsigned fmtArg, fmt::memory_buffer& out);
+
+// string format(const string&in fmt, const ?&in ...)
+void ScriptFormat(asIScriptGeneric* generic);
+}  // namespace srph::formatting
@@ -1,4 +1,8 @@
 #pragma once
+#include <cstdint>
+#include <optional>
+
+#include "jit/inliner.hpp"
 
 namespace srph
 {
@@ -9,6 +13,21 @@ struct ScriptError
     std::string message;
 };
 
+// Wall time of the phases of the last ScriptLoader::Build
+struct BuildProfile
+{
+    // Reading and preprocessing the script files
+    uint64_t loadNanos = 0;
+    uint64_t parseNanos = 0;
+    // Declaring the types, functions and variables of the module and resolving their signatures
+    uint64_t registrationNanos = 0;
+    uint64_t compileFunctionsNanos = 0;
+    // Compiling and running the initializers of global variables
+    uint64_t initGlobalsNanos = 0;
+    // Everything above and the work done after the build, as accessor inlining and AOT generation
+    uint64_t totalNanos = 0;
+};
+
 class ScriptLoader
 {
 public:
@@ -16,11 +35,26 @@ public:
 
     ScriptLoader& Module(const std::string& moduleName);
     ScriptLoader& LoadScript(const std::string& path);
+    // Writes the module's native code to a C++ source after the build, needs EngineConfiguration::aot
+    ScriptLoader& GenerateAot(const std::string& path);
+    // Overrides EngineConfiguration::inlineAccessors for this module
+    ScriptLoader& InlineAccessors(bool enabled);
     bool Build();
+    // Phase times of the last Build, also after a failed one
+    const BuildProfile& Profile() const { return m_profile; }
+    // Calls the last Build inlined, all zero when inlining was off
+    const jit::InlineStats& Inlining() const { return m_inlining; }
+
+private:
+    bool BuildModule();
 
 private:
     std::string m_moduleName = "";
     std::vector<std::string> m_scripts = {};
+    std::string m_aotPath = "";
+    std::optional<bool> m_inlineAccessors;
+    BuildProfile m_profile;
+    jit::InlineStats m_inlining;
 
     Engine* m_engine = nullptr;
 };
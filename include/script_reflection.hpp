@@ -1,6 +1,9 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <variant>
+#include <vector>
 
 class asIScriptObject;
 class asIScriptEngine;
@@ -18,8 +21,46 @@ using Metadata = std::unordered_map<std::string, std::unordered_map<std::string,
 
 namespace reflection
 {
+struct NullValue
+{
+};
+
+struct VoidValue
+{
+};
+
+struct UnknownValue
+{
+};
+
+struct ObjectValue
+{
+    const char* typeName;
+    void* address;
+};
+
+// A typed view of a script value. Strings are referenced, not copied.
+using Value = std::variant<NullValue,
+                           VoidValue,
+                           UnknownValue,
+                           bool,
+                           int8_t,
+                           int16_t,
+                           int32_t,
+                           int64_t,
+                           uint8_t,
+                           uint16_t,
+                           uint32_t,
+                           uint64_t,
+                           float,
+                           double,
+                           const std::string*,
+                           ObjectValue>;
+
 std::vector<ReflectedProperty> ReflectProperties(asIScriptObject* obj, const asIScriptEngine* engine);
 
+Value ReadValue(int typeId, void* value, const asIScriptEngine* engine);
+
 std::string GetValue(int typeId, void* value, const asIScriptEngine* engine);
 
 std::string GetTypename(int typeId, const asIScriptEngine* engine);
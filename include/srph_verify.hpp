@@ -1,10 +1,10 @@
 #pragma once
 
-#define SRPH_VERIFY(call, msg)               \
-    {                                        \
-        int r = (call);                      \
-        if (r < 0)                           \
-        {                                    \
-            Log::Critical("{}: {}", msg, r); \
-        }                                    \
-    }
\ No newline at end of file
+#define SRPH_VERIFY(call, msg)                   \
+    {                                            \
+        int r = (call);                          \
+        if (r < 0)                               \
+        {                                        \
+            SRPH_LOG_CRITICAL("{}: {}", msg, r); \
+        }                                        \
+    }
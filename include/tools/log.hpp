@@ -1,11 +1,60 @@
 #pragma once
 #include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
 #define FMT_HEADER_ONLY
 #include <fmt/core.h>
 
+// Calls below this level are compiled out. Critical messages are never removed.
+#ifndef SRPH_LOG_MIN_LEVEL
+#define SRPH_LOG_MIN_LEVEL 0
+#endif
+
+// The arguments of compiled out levels are not evaluated either
+#define SRPH_LOG_AT(level, function, ...)                                                                \
+    do                                                                                                   \
+    {                                                                                                    \
+        if constexpr (::srph::Log::Enabled(::srph::LogLevel::level)) ::srph::Log::function(__VA_ARGS__); \
+    } while (false)
+
+#define SRPH_LOG_INFO(...) SRPH_LOG_AT(Info, Info, __VA_ARGS__)
+#define SRPH_LOG_SCRIPT(...) SRPH_LOG_AT(Script, ScriptInfo, __VA_ARGS__)
+#define SRPH_LOG_WARN(...) SRPH_LOG_AT(Warn, Warn, __VA_ARGS__)
+#define SRPH_LOG_ERROR(...) SRPH_LOG_AT(Error, Error, __VA_ARGS__)
+#define SRPH_LOG_CRITICAL(...) ::srph::Log::Critical(__VA_ARGS__)
+
 namespace srph
 {
 
+enum class LogLevel : uint8_t
+{
+    Info = 0,
+    Script,
+    Warn,
+    Error,
+    Critical
+};
+
+class ILogSink;
+
+struct LogRecord
+{
+    static constexpr size_t MAX_LENGTH = 500;
+
+    LogLevel level;
+    uint16_t length;
+    char text[MAX_LENGTH];
+    // Messages longer than the text, empty otherwise
+    std::string overflow;
+
+    std::string_view Text() const { return overflow.empty() ? std::string_view(text, length) : std::string_view(overflow); }
+};
+
+// Messages are formatted on the calling thread into a per-thread ring buffer and written to the sinks by a background
+// thread. Critical messages flush the queue and are written synchronously. Errors are never dropped, when the queue
+// is full the calling thread writes it out first.
 class Log
 {
 public:
@@ -24,53 +73,81 @@ public:
     template <typename FormatString, typename... Args>
     static void Critical(const FormatString& fmt, const Args&... args);
 
+    // Sinks. A console sink is installed by default.
+    static void AddSink(std::shared_ptr<ILogSink> sink);
+    static void ClearSinks();
+
+    // Limits how many messages of a level each thread may log per second. 0 disables the limit.
+    static void SetRateLimit(LogLevel level, uint32_t messagesPerSecond);
+
+    // Blocks until every queued message has been written to the sinks.
+    static void Flush();
+
+    static const char* LevelName(LogLevel level);
+
+    static constexpr bool Enabled(LogLevel level) { return level >= MIN_LEVEL; }
+
 private:
-    static constexpr auto magenta = "\033[35m";
-    static constexpr auto green = "\033[32m";
-    static constexpr auto red = "\033[31m";
-    static constexpr auto cyan = "\033[36m";
-    static constexpr auto reset = "\033[0m";
+    static constexpr LogLevel MIN_LEVEL = static_cast<LogLevel>(SRPH_LOG_MIN_LEVEL);
+
+    template <typename FormatString, typename... Args>
+    static void Write(LogLevel level, const FormatString& fmt, const Args&... args);
+
+    // Returns nullptr when the message is rate limited, or when the ring buffer is full and it is below Error.
+    static LogRecord* Acquire(LogLevel level);
+    static void Commit(LogRecord* record);
+    static void WriteImmediate(LogLevel level, std::string_view message);
 };
 
+template <typename FormatString, typename... Args>
+inline void Log::Write(LogLevel level, const FormatString& fmt, const Args&... args)
+{
+    LogRecord* record = Acquire(level);
+    if (!record) return;
+
+    auto result = fmt::format_to_n(record->text, LogRecord::MAX_LENGTH, fmt, args...);
+    if (result.size > LogRecord::MAX_LENGTH)
+    {
+        record->overflow = fmt::format(fmt, args...);
+    }
+    else
+    {
+        record->overflow.clear();
+        record->length = static_cast<uint16_t>(result.size);
+    }
+
+    Commit(record);
+}
+
 template <typename FormatString, typename... Args>
 inline void Log::Info(const FormatString& fmt, const Args&... args)
 {
-    printf("[%sinfo%s] ", green, reset);
-    fmt::print(fmt, args...);
-    printf("\n");
+    if constexpr (Enabled(LogLevel::Info)) Write(LogLevel::Info, fmt, args...);
 }
 
 template <typename FormatString, typename... Args>
 inline void Log::ScriptInfo(const FormatString& fmt, const Args&... args)
 {
-    printf("[%sscript%s] ", cyan, reset);
-    fmt::print(fmt, args...);
-    printf("\n");
+    if constexpr (Enabled(LogLevel::Script)) Write(LogLevel::Script, fmt, args...);
 }
 
 template <typename FormatString, typename... Args>
 inline void Log::Warn(const FormatString& fmt, const Args&... args)
 {
-    printf("[%swarn%s] ", magenta, reset);
-    fmt::print(fmt, args...);
-    printf("\n");
+    if constexpr (Enabled(LogLevel::Warn)) Write(LogLevel::Warn, fmt, args...);
 }
 
 template <typename FormatString, typename... Args>
 inline void Log::Error(const FormatString& fmt, const Args&... args)
 {
-    printf("[%serror%s] ", red, reset);
-    fmt::print(fmt, args...);
-    printf("\n");
+    if constexpr (Enabled(LogLevel::Error)) Write(LogLevel::Error, fmt, args...);
 }
 
 template <typename FormatString, typename... Args>
 inline void Log::Critical(const FormatString& fmt, const Args&... args)
 {
-    printf("[%scritical%s] ", red, reset);
-    fmt::print(fmt, args...);
-    printf("\n");
+    WriteImmediate(LogLevel::Critical, fmt::format(fmt, args...));
     assert(false);
 }
 
-}  // namespace srph
\ No newline at end of file
+}  // namespace srph
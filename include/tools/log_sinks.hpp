@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "log.hpp"
+
+namespace srph
+{
+
+// Sinks are only called from one thread at a time. Write may buffer, Flush is called after every drained batch.
+class ILogSink
+{
+public:
+    virtual ~ILogSink() = default;
+
+    virtual void Write(LogLevel level, std::string_view message) = 0;
+    virtual void Flush() {}
+};
+
+class ConsoleSink : public ILogSink
+{
+public:
+    void Write(LogLevel level, std::string_view message) override;
+    void Flush() override;
+
+private:
+    std::string m_buffer;
+};
+
+class FileSink : public ILogSink
+{
+public:
+    FileSink(const std::string& path);
+    ~FileSink() override;
+
+    void Write(LogLevel level, std::string_view message) override;
+    void Flush() override;
+
+private:
+    FILE* m_file = nullptr;
+    std::string m_buffer;
+};
+
+// Keeps the last `capacity` messages, e.g. for an in-game console.
+class MemorySink : public ILogSink
+{
+public:
+    struct Entry
+    {
+        LogLevel level;
+        std::string message;
+    };
+
+    MemorySink(size_t capacity = 1024) : m_capacity(capacity) {}
+
+    void Write(LogLevel level, std::string_view message) override;
+
+    std::vector<Entry> Entries() const;
+    void Clear();
+
+private:
+    mutable std::mutex m_mutex;
+    std::deque<Entry> m_entries;
+    size_t m_capacity;
+};
+
+}  // namespace srph
@@ -11,6 +11,14 @@
 #include "magic_enum/magic_enum_all.hpp"
 #include "tools/log.hpp"
 #include "srph_verify.hpp"
+#include "runtime/future.hpp"
+#include "runtime/job_pool.hpp"
+
+#include <exception>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
 
 namespace srph
 {
@@ -95,6 +103,61 @@ std::conditional_t<std::is_pointer_v<T>, T, std::add_lvalue_reference_t<T>> Cast
         return *static_cast<PointerType>(obj);
     }
 }
+
+// Copy of an argument, for calls that outlive the generic call
+template <typename T>
+T ArgumentValue(asIScriptGeneric* generic, asUINT index)
+{
+    int typeId = 0;
+    asDWORD flags = 0;
+    generic->GetFunction()->GetParam(index, &typeId, &flags);
+
+    if (flags & asTM_INOUTREF) return *static_cast<T*>(generic->GetArgAddress(index));
+    if constexpr (std::is_class_v<T>)
+    {
+        return *static_cast<T*>(generic->GetArgObject(index));
+    }
+    else
+    {
+        return *static_cast<T*>(generic->GetAddressOfArg(index));
+    }
+}
+
+// Whether typeId is the script type of T, registered value types and enums are matched by size
+template <typename T>
+bool IsTypeId(asIScriptEngine* engine, int typeId)
+{
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        return typeId == asTYPEID_BOOL;
+    }
+    else if constexpr (std::is_same_v<T, float>)
+    {
+        return typeId == asTYPEID_FLOAT;
+    }
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        return typeId == asTYPEID_DOUBLE;
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        constexpr bool SIGNED = std::is_signed_v<T>;
+        if constexpr (sizeof(T) == 1) return typeId == (SIGNED ? asTYPEID_INT8 : asTYPEID_UINT8);
+        else if constexpr (sizeof(T) == 2) return typeId == (SIGNED ? asTYPEID_INT16 : asTYPEID_UINT16);
+        else if constexpr (sizeof(T) == 4) return typeId == (SIGNED ? asTYPEID_INT32 : asTYPEID_UINT32);
+        else return typeId == (SIGNED ? asTYPEID_INT64 : asTYPEID_UINT64);
+    }
+    else if constexpr (std::is_same_v<T, std::string>)
+    {
+        return typeId == engine->GetStringFactory();
+    }
+    else
+    {
+        asITypeInfo* type = engine->GetTypeInfoById(typeId);
+        const asQWORD kind = std::is_enum_v<T> ? asOBJ_ENUM : asOBJ_VALUE;
+        return type && (typeId & asTYPEID_OBJHANDLE) == 0 && (type->GetFlags() & kind) && type->GetSize() == sizeof(T);
+    }
+}
 }  // namespace generics
 
 enum class ClassType : uint8_t
@@ -366,6 +429,103 @@ public:
         return *this;
     }
 
+    // Runs func on the engine's job pool, the script gets a future<R> for the result. Arguments are copied, the
+    // declaration must return future<R>@ with R matching the native return type, the registration fails otherwise.
+    template <typename Func>
+    Global& AsyncFunction(const std::string& funcDecl, Func func)
+    {
+        return AsyncFunction(funcDecl, std::function(std::move(func)));
+    }
+
+    template <typename R, typename... Args>
+    Global& AsyncFunction(const std::string& funcDecl, std::function<R(Args...)> func)
+    {
+        static_assert(!std::is_void_v<R>, "Async functions have to return a value.");
+        static_assert(!std::is_pointer_v<R>, "future<T> cannot hold handles.");
+
+        asIScriptEngine* engine = m_engine->m_engine;
+
+        // The job's result is read back as the future's subtype
+        if (!generics::IsTypeId<R>(engine, FutureSubTypeId(engine, funcDecl)))
+        {
+            SRPH_LOG_CRITICAL("Async function registration failed, {} has to return future<T>@ with T matching the "
+                              "native return type.",
+                              funcDecl);
+            return *this;
+        }
+
+        auto binding = std::make_shared<AsyncBinding<R, Args...>>(AsyncBinding<R, Args...>{m_engine, std::move(func)});
+        m_engine->m_asyncFunctions.push_back(binding);
+        m_engine->GetJobPool();
+
+        SRPH_VERIFY(engine->RegisterGlobalFunction(funcDecl.c_str(),
+                                                   asFUNCTION((CallAsync<R, Args...>)),
+                                                   asCALL_GENERIC,
+                                                   binding.get()),
+                    "Async function registration failed.")
+
+        return *this;
+    }
+
+private:
+    // Type id of T in a declaration returning future<T>@, negative if it does not return a future
+    static int FutureSubTypeId(asIScriptEngine* engine, const std::string& funcDecl)
+    {
+        const size_t begin = funcDecl.find("future<");
+        if (begin == std::string::npos || begin > funcDecl.find('(')) return -1;
+
+        const size_t subTypeBegin = begin + 7;
+        int depth = 1;
+        for (size_t i = subTypeBegin; i < funcDecl.size(); i++)
+        {
+            if (funcDecl[i] == '<') depth++;
+            else if (funcDecl[i] == '>' && --depth == 0)
+            {
+                return engine->GetTypeIdByDecl(funcDecl.substr(subTypeBegin, i - subTypeBegin).c_str());
+            }
+        }
+
+        return -1;
+    }
+
+    template <typename R, typename... Args>
+    struct AsyncBinding
+    {
+        Engine* engine;
+        std::function<R(Args...)> func;
+    };
+
+    template <typename R, typename... Args>
+    static void CallAsync(asIScriptGeneric* generic)
+    {
+        SubmitAsync<R, Args...>(generic, std::index_sequence_for<Args...>());
+    }
+
+    template <typename R, typename... Args, size_t... I>
+    static void SubmitAsync(asIScriptGeneric* generic, std::index_sequence<I...>)
+    {
+        auto* binding = static_cast<AsyncBinding<R, Args...>*>(generic->GetAuxiliary());
+
+        auto* future = new runtime::ScriptFuture(binding->engine->m_scheduler);
+        binding->engine->GetJobPool()->Submit(
+            [binding,
+             future = runtime::MakeFutureRef(future),
+             args = std::make_tuple(generics::ArgumentValue<std::decay_t<Args>>(generic, I)...)]() mutable
+            {
+                try
+                {
+                    future->Complete(std::apply(binding->func, std::move(args)));
+                }
+                catch (const std::exception& e)
+                {
+                    future->Fail(e.what());
+                }
+            });
+
+        generic->SetReturnObject(future);
+        future->Release();
+    }
+
 private:
     Engine* m_engine = nullptr;
 };
@@ -3,6 +3,7 @@
 #include "debugger/debugger.hpp"
 #include "script_reflection.hpp"
 
+#include <cstring>
 #include <filesystem>
 
 using json = nlohmann::json;
@@ -27,7 +28,11 @@ void DAP::Stop()
 
     if (m_acceptor)
     {
+        // Closing the acceptor does not wake a blocking accept on Linux, connecting once does.
         asio::error_code ec;
+        asio::ip::tcp::socket wake(*m_io);
+        wake.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), DEFAULT_PORT), ec);
+
         m_acceptor->close(ec);
     }
 
@@ -60,7 +65,7 @@ void DAP::CloseSocket()
 
 void DAP::ServerLoop()
 {
-    Log::Info("Seraph DAP server listening on port {}", DEFAULT_PORT);
+    SRPH_LOG_INFO("Seraph DAP server listening on port {}", DEFAULT_PORT);
 
     while (m_running.load())
     {
@@ -76,22 +81,23 @@ void DAP::ServerLoop()
         {
             if (m_running.load())
             {
-                Log::Error("Accept failed: {}", ec.message());
+                SRPH_LOG_ERROR("Accept failed: {}", ec.message());
             }
             break;
         }
 
-        Log::Info("DAP client connected");
+        SRPH_LOG_INFO("DAP client connected");
 
         ClientSession();
 
         CloseSocket();
-        m_objectReferences.clear();
+        m_references.clear();
+        m_frames.clear();
 
-        Log::Info("DAP client disconnected");
+        SRPH_LOG_INFO("DAP client disconnected");
     }
 
-    Log::Info("DAP server stopped");
+    SRPH_LOG_INFO("DAP server stopped");
 }
 
 void DAP::ClientSession()
@@ -150,7 +156,7 @@ std::optional<json> DAP::ReadMessage()
         {
             if (ec != asio::error::eof && ec != asio::error::operation_aborted)
             {
-                Log::Error("Failed to read DAP header: {}", ec.message());
+                SRPH_LOG_ERROR("Failed to read DAP header: {}", ec.message());
             }
             return std::nullopt;
         }
@@ -162,7 +168,7 @@ std::optional<json> DAP::ReadMessage()
         size_t contentLengthPos = headers.find("Content-Length: ");
         if (contentLengthPos == std::string::npos)
         {
-            Log::Error("DAP message missing Content-Length header");
+            SRPH_LOG_ERROR("DAP message missing Content-Length header");
             return std::nullopt;
         }
 
@@ -182,7 +188,7 @@ std::optional<json> DAP::ReadMessage()
 
             if (ec)
             {
-                Log::Error("Failed to read DAP body: {}", ec.message());
+                SRPH_LOG_ERROR("Failed to read DAP body: {}", ec.message());
                 return std::nullopt;
             }
 
@@ -193,7 +199,7 @@ std::optional<json> DAP::ReadMessage()
     }
     catch (const std::exception& e)
     {
-        Log::Error("Exception reading DAP message: {}", e.what());
+        SRPH_LOG_ERROR("Exception reading DAP message: {}", e.what());
         return std::nullopt;
     }
 }
@@ -217,7 +223,7 @@ bool DAP::SendMessage(const json& message)
 
         if (ec)
         {
-            Log::Error("Failed to send DAP message: {}", ec.message());
+            SRPH_LOG_ERROR("Failed to send DAP message: {}", ec.message());
             return false;
         }
 
@@ -225,7 +231,7 @@ bool DAP::SendMessage(const json& message)
     }
     catch (const std::exception& e)
     {
-        Log::Error("Exception sending DAP message: {}", e.what());
+        SRPH_LOG_ERROR("Exception sending DAP message: {}", e.what());
         return false;
     }
 }
@@ -242,13 +248,20 @@ bool DAP::SendEvent(const std::string& event, const json& body)
     return SendMessage(eventMessage);
 }
 
-void DAP::OnBreakpointHit(std::string /*file*/, int /*line*/)
+void DAP::OnBreakpointHit(int threadId, bool allThreadsStopped, std::string /*file*/, int /*line*/)
 {
-    json body = {{"reason", "breakpoint"}, {"threadId", 1}, {"allThreadsStopped", true}};
+    json body = {{"reason", "breakpoint"}, {"threadId", threadId}, {"allThreadsStopped", allThreadsStopped}};
 
     SendEvent("stopped", body);
 }
 
+void DAP::OnOutput(const std::string& text)
+{
+    json body = {{"category", "console"}, {"output", text + "\n"}};
+
+    SendEvent("output", body);
+}
+
 std::optional<json> DAP::HandleCommand(const json& request)
 {
     std::string command = request["command"];
@@ -265,15 +278,21 @@ std::optional<json> DAP::HandleCommand(const json& request)
     if (command == "next") return HandleNext(request);
     if (command == "stepIn") return HandleStepIn(request);
     if (command == "stepOut") return HandleStepOut(request);
+    if (command == "evaluate") return HandleEvaluate(request);
     if (command == "disconnect") return HandleDisconnect(request);
 
-    Log::Warn("Unhandled DAP command: {}", command);
+    SRPH_LOG_WARN("Unhandled DAP command: {}", command);
     return json::object();
 }
 
 std::optional<json> DAP::HandleInitialize(const json& request)
 {
-    json response = {{"supportsConfigurationDoneRequest", true}, {"supportsSetVariable", false}};
+    json response = {{"supportsConfigurationDoneRequest", true},
+                     {"supportsSetVariable", false},
+                     {"supportsConditionalBreakpoints", true},
+                     {"supportsHitConditionalBreakpoints", true},
+                     {"supportsLogPoints", true},
+                     {"supportsEvaluateForHovers", true}};
 
     json fullResponse = {{"seq", m_seqCounter++},
                          {"type", "response"},
@@ -302,37 +321,51 @@ json DAP::HandleSetBreakpoints(const json& request)
                    normalized.begin(),
                    [](char c) { return c == '\\' ? '/' : static_cast<char>(std::tolower(c)); });
 
-    auto& breakpoints = m_debugger->GetBreakpoints();
-    breakpoints[normalized].clear();
-
+    std::vector<Breakpoint> breakpoints;
     std::vector<json> confirmedBPs;
     for (const auto& bp : lines)
     {
-        int line = bp["line"];
-        breakpoints[normalized].push_back(line);
-        confirmedBPs.push_back({{"verified", true}, {"line", line}});
+        Breakpoint breakpoint;
+        breakpoint.line = bp["line"];
+        breakpoint.condition = bp.value("condition", "");
+        breakpoint.hitCondition = bp.value("hitCondition", "");
+        breakpoint.logMessage = bp.value("logMessage", "");
+        breakpoints.push_back(breakpoint);
+        confirmedBPs.push_back({{"verified", true}, {"line", breakpoint.line}});
     }
+    m_debugger->SetBreakpoints(normalized, breakpoints);
 
     return {{"breakpoints", confirmedBPs}};
 }
 
 json DAP::HandleConfigurationDone(const json& /*request*/) { return json::object(); }
 
-json DAP::HandleThreads(const json& /*request*/) { return {{"threads", {{{"id", 1}, {"name", "Main Thread"}}}}}; }
+json DAP::HandleThreads(const json& /*request*/)
+{
+    std::vector<json> threads;
+    for (const DebugThread& thread : m_debugger->Threads())
+    {
+        threads.push_back({{"id", thread.id}, {"name", thread.name}});
+    }
+
+    return {{"threads", threads}};
+}
 
-json DAP::HandleContinue(const json& /*request*/)
+json DAP::HandleContinue(const json& request)
 {
-    m_debugger->Continue();
-    return {{"allThreadsContinued", true}};
+    const int threadId = m_debugger->NonStop() ? request["arguments"].value("threadId", 0) : 0;
+    ForgetReferences(threadId);
+    m_debugger->Continue(threadId);
+
+    return {{"allThreadsContinued", threadId == 0}};
 }
 
-json DAP::HandleStackTrace(const json& /*request*/)
+json DAP::HandleStackTrace(const json& request)
 {
+    const int threadId = request["arguments"].value("threadId", 0);
     std::vector<json> frames;
 
-    if (m_debugger->m_currentContext)
-    {
-        asIScriptContext* ctx = m_debugger->m_currentContext;
+    m_debugger->Inspect(threadId, [&](asIScriptContext* ctx) {
         asUINT stackSize = ctx->GetCallstackSize();
 
         for (asUINT i = 0; i < stackSize; i++)
@@ -346,88 +379,162 @@ json DAP::HandleStackTrace(const json& /*request*/)
             std::string filePath = section ? section : "";
             std::string fileName = filePath.empty() ? "" : std::filesystem::path(filePath).filename().string();
 
-            frames.push_back({{"id", i},
+            frames.push_back({{"id", AddFrame({threadId, i})},
                               {"name", funcName},
                               {"line", line},
                               {"column", column},
                               {"source", {{"name", fileName}, {"path", filePath}}}});
         }
-    }
+    });
 
     return {{"stackFrames", frames}, {"totalFrames", frames.size()}};
 }
 
 json DAP::HandleScopes(const json& request)
 {
-    int frameId = request["arguments"]["frameId"];
+    const FrameReference frame = Frame(request["arguments"]["frameId"]);
+
+    int locals = AddReference({ReferenceKind::Locals, frame.threadId, frame.level, 0, nullptr});
+    int globals = AddReference({ReferenceKind::Globals, frame.threadId, frame.level, 0, nullptr});
 
     return {{"scopes",
-             {{{"name", "Locals"}, {"variablesReference", frameId * 1000 + 1}, {"expensive", false}},
-              {{"name", "Globals"}, {"variablesReference", frameId * 1000 + 2}, {"expensive", false}}}}};
+             {{{"name", "Locals"}, {"variablesReference", locals}, {"expensive", false}},
+              {{"name", "Globals"}, {"variablesReference", globals}, {"expensive", false}}}}};
 }
 
 json DAP::HandleVariables(const json& request)
 {
-    int varRef = request["arguments"]["variablesReference"];
-    int frameId = varRef / 1000;
-    // 1=locals, 2=globals
-    int scopeType = varRef % 1000;
-
-    std::vector<json> variables;
-    asIScriptContext* ctx = m_debugger->m_currentContext;
+    const json& args = request["arguments"];
+    int varRef = args["variablesReference"];
+    const std::string filter = args.value("filter", "");
+    const asUINT start = args.value("start", 0u);
+    const asUINT count = args.value("count", 0u);
+
+    auto it = m_references.find(varRef);
+    if (it == m_references.end())
+    {
+        return {{"variables", json::array()}};
+    }
 
-    if (!ctx)
+    // Arrays only have indexed children, everything else only named ones.
+    const bool indexed = it->second.kind == ReferenceKind::Array;
+    if ((filter == "indexed" && !indexed) || (filter == "named" && indexed))
     {
-        return {{"variables", variables}};
+        return {{"variables", json::array()}};
     }
 
-    int typeId = ctx->GetThisTypeId(frameId);
-    void* varPointer = ctx->GetThisPointer(frameId);
-    if (typeId && varPointer)
+    const auto page = std::make_pair(start, count);
+    auto cached = it->second.pages.find(page);
+    if (cached != it->second.pages.end())
     {
-        asITypeInfo* typeInfo = ctx->GetEngine()->GetTypeInfoById(typeId);
-        int thisVarRef = (frameId * 1000 + 3) + 1000000;
+        return {{"variables", cached->second}};
+    }
+
+    const VariableReference reference = it->second;
+    json variables = json::array();
+    m_debugger->Inspect(reference.threadId, [&](asIScriptContext* ctx) {
+        if (reference.frame < ctx->GetCallstackSize()) variables = Children(ctx, reference, start, count);
+    });
+
+    // Children may have added references, the map may have rehashed since.
+    m_references.at(varRef).pages[page] = variables;
+    return {{"variables", variables}};
+}
 
-        variables.push_back({{"name", "this"},
-                             {"value", typeInfo ? typeInfo->GetName() : "object"},
-                             {"type", reflection::GetTypename(typeId, ctx->GetEngine())},
-                             {"variablesReference", thisVarRef}});
+json DAP::Variable(asIScriptEngine* engine, int threadId, asUINT frame, const std::string& name, int typeId, void* address)
+{
+    json variable = {{"name", name}, {"type", engine->GetTypeDeclaration(typeId)}, {"variablesReference", 0}};
 
-        m_objectReferences[thisVarRef] = {typeId, varPointer};
+    void* object = address && (typeId & asTYPEID_OBJHANDLE) ? *static_cast<void**>(address) : address;
+    asITypeInfo* typeInfo = typeId & asTYPEID_MASK_OBJECT ? engine->GetTypeInfoById(typeId) : nullptr;
+    if (!object || !typeInfo)
+    {
+        variable["value"] = address && !object ? "null" : reflection::GetValue(typeId, address, engine);
+        return variable;
     }
 
-    if (varRef >= 1000000)
+    if ((typeInfo->GetFlags() & asOBJ_TEMPLATE) && std::strcmp(typeInfo->GetName(), "array") == 0)
     {
-        auto it = m_objectReferences.find(varRef);
-        if (it != m_objectReferences.end())
+        auto* array = static_cast<CScriptArray*>(object);
+        const asUINT size = array->GetSize();
+        variable["value"] = fmt::format("{}[{}]", engine->GetTypeDeclaration(array->GetElementTypeId()), size);
+        variable["indexedVariables"] = size;
+        if (size > 0) variable["variablesReference"] = AddReference({ReferenceKind::Array, threadId, frame, typeId, object});
+        return variable;
+    }
+
+    const asUINT properties = typeInfo->GetFlags() & asOBJ_SCRIPT_OBJECT ? static_cast<asIScriptObject*>(object)->GetPropertyCount()
+                                                                         : typeInfo->GetPropertyCount();
+    if (properties == 0)
+    {
+        variable["value"] = reflection::GetValue(typeId, address, engine);
+        return variable;
+    }
+
+    variable["value"] = typeInfo->GetName();
+    variable["namedVariables"] = properties;
+    variable["variablesReference"] = AddReference({ReferenceKind::Object, threadId, frame, typeId, object});
+    return variable;
+}
+
+json DAP::Children(asIScriptContext* ctx, const VariableReference& reference, asUINT start, asUINT count)
+{
+    asIScriptEngine* engine = ctx->GetEngine();
+    const asUINT frameId = reference.frame;
+    json variables = json::array();
+
+    auto add = [&](asUINT index, const std::string& name, int typeId, void* address) {
+        if (index >= start && (count == 0 || index - start < count))
         {
-            int objTypeId = it->second.typeId;
-            void* objPtr = it->second.ptr;
+            variables.push_back(Variable(engine, reference.threadId, frameId, name, typeId, address));
+        }
+    };
 
-            asITypeInfo* typeInfo = ctx->GetEngine()->GetTypeInfoById(objTypeId);
-            if (typeInfo)
+    if (reference.kind == ReferenceKind::Array)
+    {
+        auto* array = static_cast<CScriptArray*>(reference.ptr);
+        const int elementTypeId = array->GetElementTypeId();
+        const asUINT end = count == 0 ? array->GetSize() : std::min<asUINT>(array->GetSize(), start + count);
+        for (asUINT i = start; i < end; i++)
+        {
+            add(i, fmt::format("[{}]", i), elementTypeId, array->At(i));
+        }
+    }
+    else if (reference.kind == ReferenceKind::Object)
+    {
+        asITypeInfo* typeInfo = engine->GetTypeInfoById(reference.typeId);
+        if (typeInfo->GetFlags() & asOBJ_SCRIPT_OBJECT)
+        {
+            auto* object = static_cast<asIScriptObject*>(reference.ptr);
+            const asUINT end = count == 0 ? object->GetPropertyCount() : std::min(object->GetPropertyCount(), start + count);
+            for (asUINT i = start; i < end; i++)
             {
-                int propCount = typeInfo->GetPropertyCount();
-                for (int i = 0; i < propCount; i++)
-                {
-                    const char* propName;
-                    int propTypeId;
-                    int offset;
-                    typeInfo->GetProperty(i, &propName, &propTypeId, nullptr, nullptr, &offset);
-
-                    void* propPtr = static_cast<char*>(objPtr) + offset;
-                    std::string value = reflection::GetValue(propTypeId, propPtr, ctx->GetEngine());
-
-                    variables.push_back({{"name", propName},
-                                         {"value", value},
-                                         {"type", ctx->GetEngine()->GetTypeDeclaration(propTypeId)},
-                                         {"variablesReference", 0}});
-                }
+                add(i, object->GetPropertyName(i), object->GetPropertyTypeId(i), object->GetAddressOfProperty(i));
+            }
+        }
+        else
+        {
+            const asUINT end = count == 0 ? typeInfo->GetPropertyCount() : std::min(typeInfo->GetPropertyCount(), start + count);
+            for (asUINT i = start; i < end; i++)
+            {
+                const char* propName;
+                int propTypeId;
+                int offset;
+                typeInfo->GetProperty(i, &propName, &propTypeId, nullptr, nullptr, &offset);
+                add(i, propName, propTypeId, static_cast<char*>(reference.ptr) + offset);
             }
         }
     }
-    else if (scopeType == 1)
+    else if (reference.kind == ReferenceKind::Locals)
     {
+        asUINT index = 0;
+        int typeId = ctx->GetThisTypeId(frameId);
+        void* varPointer = ctx->GetThisPointer(frameId);
+        if (typeId && varPointer)
+        {
+            add(index++, "this", typeId, varPointer);
+        }
+
         int varCount = ctx->GetVarCount(frameId);
 
         for (int i = 0; i < varCount; i++)
@@ -436,20 +543,15 @@ json DAP::HandleVariables(const json& request)
             int varTypeId;
             SRPH_VERIFY(ctx->GetVar(i, frameId, &name, &varTypeId), "Failed to read var in scope.")
 
-            void* varPtr = ctx->GetAddressOfVar(i, frameId);
-            std::string value = reflection::GetValue(varTypeId, varPtr, ctx->GetEngine());
-            std::string type = reflection::GetTypename(varTypeId, ctx->GetEngine());
-            const char* typeDecl = ctx->GetEngine()->GetTypeDeclaration(varTypeId);
-
             if (name && name[0] != '\0' && ctx->IsVarInScope(i, frameId))
             {
-                variables.push_back({{"name", name}, {"value", value}, {"type", typeDecl}, {"variablesReference", 0}});
+                add(index++, name, varTypeId, ctx->GetAddressOfVar(i, frameId));
             }
         }
     }
-    else if (scopeType == 2)
+    else if (reference.kind == ReferenceKind::Globals)
     {
-        asIScriptModule* module = ctx->GetFunction()->GetModule();
+        asIScriptModule* module = ctx->GetFunction(frameId)->GetModule();
         if (module)
         {
             int globalCount = module->GetGlobalVarCount();
@@ -458,45 +560,68 @@ json DAP::HandleVariables(const json& request)
                 const char* name;
                 int globalTypeId;
                 module->GetGlobalVar(i, &name, nullptr, &globalTypeId);
-                void* varPtr = module->GetAddressOfGlobalVar(i);
-
-                std::string value = reflection::GetValue(globalTypeId, varPtr, ctx->GetEngine());
-                std::string type = reflection::GetTypename(globalTypeId, ctx->GetEngine());
-
-                variables.push_back({{"name", name}, {"value", value}, {"type", type}, {"variablesReference", 0}});
+                add(i, name, globalTypeId, module->GetAddressOfGlobalVar(i));
             }
         }
     }
 
-    return {{"variables", variables}};
+    return variables;
 }
 
-json DAP::HandleNext(const json& /*request*/)
+json DAP::HandleNext(const json& request)
 {
-    m_debugger->m_stepMode = StepMode::Over;
-    m_debugger->m_currentStackDepth = m_debugger->m_currentContext->GetCallstackSize();
-    m_debugger->Continue();
+    const int threadId = request["arguments"].value("threadId", 0);
+    ForgetReferences(threadId);
+    m_debugger->Step(threadId, StepMode::Over);
 
     return json::object();
 }
 
-json DAP::HandleStepIn(const json& /*request*/)
+json DAP::HandleStepIn(const json& request)
 {
-    m_debugger->m_stepMode = StepMode::In;
-    m_debugger->Continue();
+    const int threadId = request["arguments"].value("threadId", 0);
+    ForgetReferences(threadId);
+    m_debugger->Step(threadId, StepMode::In);
 
     return json::object();
 }
 
-json DAP::HandleStepOut(const json& /*request*/)
+json DAP::HandleStepOut(const json& request)
 {
-    m_debugger->m_stepMode = StepMode::Out;
-    m_debugger->m_currentStackDepth = m_debugger->m_currentContext->GetCallstackSize() - 1;
-    m_debugger->Continue();
+    const int threadId = request["arguments"].value("threadId", 0);
+    ForgetReferences(threadId);
+    m_debugger->Step(threadId, StepMode::Out);
 
     return json::object();
 }
 
+std::optional<json> DAP::HandleEvaluate(const json& request)
+{
+    const json& args = request["arguments"];
+    std::string expression = args["expression"];
+    const FrameReference frame = Frame(args.value("frameId", 0));
+
+    std::string result;
+    bool succeeded = m_debugger->Evaluate(frame.threadId, frame.level, expression, result);
+
+    json response = {{"seq", m_seqCounter++},
+                     {"type", "response"},
+                     {"request_seq", request["seq"]},
+                     {"success", succeeded},
+                     {"command", "evaluate"}};
+    if (succeeded)
+    {
+        response["body"] = {{"result", result}, {"variablesReference", 0}};
+    }
+    else
+    {
+        response["message"] = result;
+    }
+    SendMessage(response);
+
+    return std::nullopt;
+}
+
 std::optional<json> DAP::HandleDisconnect(const json& request)
 {
     json response = {{"seq", m_seqCounter++},
@@ -507,10 +632,43 @@ std::optional<json> DAP::HandleDisconnect(const json& request)
                      {"body", json::object()}};
     SendMessage(response);
 
-    m_debugger->m_breakpoints.clear();
-    m_debugger->Continue();
+    m_debugger->ClearBreakpoints();
+    ForgetReferences(0);
+    m_debugger->Continue(0);
 
     return std::nullopt;
 }
 
+int DAP::AddReference(const VariableReference& reference)
+{
+    const int id = m_nextReference++;
+    m_references.emplace(id, reference);
+    return id;
+}
+
+int DAP::AddFrame(const FrameReference& frame)
+{
+    const int id = m_nextFrame++;
+    m_frames.emplace(id, frame);
+    return id;
+}
+
+FrameReference DAP::Frame(int frameId) const
+{
+    auto it = m_frames.find(frameId);
+    return it != m_frames.end() ? it->second : FrameReference{0, 0};
+}
+
+void DAP::ForgetReferences(int threadId)
+{
+    for (auto it = m_references.begin(); it != m_references.end();)
+    {
+        it = threadId == 0 || it->second.threadId == threadId ? m_references.erase(it) : std::next(it);
+    }
+    for (auto it = m_frames.begin(); it != m_frames.end();)
+    {
+        it = threadId == 0 || it->second.threadId == threadId ? m_frames.erase(it) : std::next(it);
+    }
+}
+
 }  // namespace srph::debugger
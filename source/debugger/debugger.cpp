@@ -5,16 +5,76 @@
 #include "function_caller.hpp"
 #include "helpers.hpp"
 #include "debugger/debug_adapter.hpp"
+#include "runtime/scheduler.hpp"
+
+#include <climits>
+#include <cstdlib>
+
+// Finds the lines and sections of a function in its bytecode, the public interface only has the line of
+// a program position.
+#include "angelscript/source/as_scriptengine.h"
+#include "angelscript/source/as_scriptfunction.h"
 
 namespace srph
 {
 class Engine;
 }
 
+namespace
+{
+// Set on the functions the debugger caches something for
+constexpr asPWORD FUNCTION_USER_DATA = 0x53525044;
+
+bool HasLine(const std::vector<uint64_t>& bitmap, int line)
+{
+    const size_t word = static_cast<size_t>(line) / 64;
+    return line > 0 && word < bitmap.size() && (bitmap[word] >> (line % 64) & 1);
+}
+
+// A number compares with ">=", an unreadable condition always stops
+bool HitConditionMet(const std::string& condition, uint64_t hits)
+{
+    size_t pos = condition.find_first_not_of(" \t");
+    if (pos == std::string::npos) return true;
+
+    std::string op = ">=";
+    for (const char* candidate : {">=", "<=", "==", ">", "<", "%"})
+    {
+        if (condition.compare(pos, std::strlen(candidate), candidate) == 0)
+        {
+            op = candidate;
+            pos += op.size();
+            break;
+        }
+    }
+
+    char* end = nullptr;
+    const uint64_t count = std::strtoull(condition.c_str() + pos, &end, 10);
+    if (end == condition.c_str() + pos) return true;
+
+    if (op == "==") return hits == count;
+    if (op == ">") return hits > count;
+    if (op == "<") return hits < count;
+    if (op == "<=") return hits <= count;
+    if (op == "%") return count == 0 || hits % count == 0;
+    return hits >= count;
+}
+
+bool SameBreakpoint(const srph::debugger::Breakpoint& a, const srph::debugger::Breakpoint& b)
+{
+    return a.line == b.line && a.condition == b.condition && a.hitCondition == b.hitCondition && a.logMessage == b.logMessage;
+}
+}  // namespace
+
 srph::debugger::Debugger::~Debugger()
 {
     m_adapter->Stop();
     delete m_adapter;
+
+    // The compiled expressions hold references to the engine's functions.
+    ForgetFunctions();
+    m_files.clear();
+    if (m_expressionContext) m_expressionContext->Release();
 }
 
 srph::debugger::Debugger::Debugger(IDebugAdapter* adapter, Engine* engine)
@@ -22,6 +82,9 @@ srph::debugger::Debugger::Debugger(IDebugAdapter* adapter, Engine* engine)
     m_adapter = adapter;
     m_adapter->AttachDebugger(this);
     m_engine = engine;
+    m_nonStop = engine->m_configuration.debuggerNonStop;
+
+    m_engine->GetEngine()->SetFunctionUserDataCleanupCallback(FunctionDestroyed, FUNCTION_USER_DATA);
 }
 
 void srph::debugger::Debugger::Start()
@@ -30,88 +93,539 @@ void srph::debugger::Debugger::Start()
     m_adapter->Start();
 }
 
-void srph::debugger::Debugger::RegisterLineCallback()
+void srph::debugger::Debugger::SetBreakpoints(const std::string& file, const std::vector<Breakpoint>& breakpoints)
 {
-    m_engine->RegisterLineCallback("debugger", [this](asIScriptContext* context) { LineCallback(context); });
+    std::lock_guard<std::mutex> lock(m_breakpointMutex);
+    if (breakpoints.empty())
+    {
+        m_breakpoints.erase(file);
+    }
+    else
+    {
+        m_breakpoints[file] = breakpoints;
+    }
+    m_breakpointGeneration.fetch_add(1, std::memory_order_release);
 }
 
-void srph::debugger::Debugger::Continue()
+void srph::debugger::Debugger::ClearBreakpoints()
+{
+    std::lock_guard<std::mutex> lock(m_breakpointMutex);
+    m_breakpoints.clear();
+    m_breakpointGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void srph::debugger::Debugger::Continue(int threadId)
 {
     std::lock_guard<std::mutex> lock(m_resumeMutex);
-    m_resumed = true;
-    m_resumeCV.notify_one();
+    for (auto it = m_stopped.begin(); it != m_stopped.end();)
+    {
+        if (threadId != 0 && it->first != threadId)
+        {
+            ++it;
+        }
+        else if (it->second.coroutine)
+        {
+            m_engine->m_scheduler->Wake(it->second.coroutine);
+            it = m_stopped.erase(it);
+        }
+        else
+        {
+            it->second.resumed = true;
+            ++it;
+        }
+    }
+    m_resumeCV.notify_all();
 }
 
-void srph::debugger::Debugger::LineCallback(asIScriptContext* context)
+void srph::debugger::Debugger::Step(int threadId, StepMode mode)
 {
-    const char* scriptSection;
-    int line = context->GetLineNumber(0, nullptr, &scriptSection);
+    {
+        std::lock_guard<std::mutex> lock(m_resumeMutex);
+        auto it = m_stopped.find(threadId);
+        if (it == m_stopped.end()) return;
+
+        asIScriptContext* context = it->second.context;
+        m_stepContext.store(context, std::memory_order_relaxed);
+        const asUINT depth = context->GetCallstackSize();
+        m_stepDepth.store(mode == StepMode::Out ? depth - 1 : depth, std::memory_order_relaxed);
+        m_stepMode.store(mode, std::memory_order_release);
+    }
+
+    Continue(threadId);
+}
+
+std::vector<srph::debugger::DebugThread> srph::debugger::Debugger::Threads()
+{
+    std::vector<DebugThread> threads;
+    Post([&] {
+        std::unordered_map<asIScriptContext*, bool> stopped;
+        {
+            std::lock_guard<std::mutex> lock(m_resumeMutex);
+            for (auto& entry : m_stopped)
+            {
+                stopped[entry.second.context] = true;
+            }
+        }
+
+        // Pooled contexts are unprepared, waiting coroutines are suspended.
+        auto add = [&](asIScriptContext* context) {
+            const asEContextState state = context->GetState();
+            if (state != asEXECUTION_ACTIVE && state != asEXECUTION_SUSPENDED && stopped.find(context) == stopped.end()) return;
+
+            const int id = ThreadId(context);
+            const runtime::CoroutineId coroutine = m_engine->m_scheduler ? m_engine->m_scheduler->Find(context) : 0;
+            std::string name = coroutine != 0                 ? fmt::format("Coroutine {}", coroutine)
+                               : context == m_engine->m_context ? std::string("Main")
+                                                                : fmt::format("Context {}", id);
+            threads.push_back({id, std::move(name)});
+        };
+
+        add(m_engine->m_context);
+        for (asIScriptContext* context : m_engine->m_contexts)
+        {
+            add(context);
+        }
+    });
 
-    std::string sectionStr = scriptSection;
-    auto it = m_normalizedPaths.find(sectionStr);
-    if (it == m_normalizedPaths.end())
+    return threads;
+}
+
+bool srph::debugger::Debugger::Inspect(int threadId, const std::function<void(asIScriptContext*)>& inspect)
+{
+    bool found = false;
+    const bool ran = Post([&] {
+        asIScriptContext* context = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_resumeMutex);
+            auto it = m_stopped.find(threadId);
+            if (it != m_stopped.end()) context = it->second.context;
+        }
+
+        if (context)
+        {
+            found = true;
+            inspect(context);
+        }
+    });
+
+    return ran && found;
+}
+
+bool srph::debugger::Debugger::Evaluate(int threadId, asUINT frame, const std::string& expression, std::string& result)
+{
+    bool succeeded = false;
+    const bool stopped = Inspect(threadId, [&](asIScriptContext* context) {
+        if (frame >= context->GetCallstackSize())
+        {
+            result = "The frame does not exist";
+            return;
+        }
+
+        // Watch expressions are evaluated on every stop, the variables in scope only change with the line.
+        const auto key = std::make_tuple(context->GetFunction(frame), context->GetLineNumber(frame), expression);
+        bool condition = false;
+        succeeded = RunExpression(m_evaluations[key], context, frame, ExpressionKind::Value, expression, condition, result);
+    });
+
+    if (!stopped) result = "The thread is not stopped";
+    return stopped && succeeded;
+}
+
+void srph::debugger::Debugger::Tick()
+{
     {
-        std::string normalized = sectionStr;
-        std::transform(normalized.begin(),
-                       normalized.end(),
-                       normalized.begin(),
-                       [](char c) { return static_cast<char>(c == '\\' ? '/' : std::tolower(static_cast<unsigned char>(c))); });
-        it = m_normalizedPaths.emplace(std::move(sectionStr), std::move(normalized)).first;
+        std::lock_guard<std::mutex> lock(m_resumeMutex);
+        if (m_stopped.empty() && m_tasks.empty()) return;
+
+        // Stopped by the script or the application while suspended
+        for (auto it = m_stopped.begin(); it != m_stopped.end();)
+        {
+            it = it->second.coroutine && !m_engine->m_scheduler->Running(it->second.coroutine) ? m_stopped.erase(it) : std::next(it);
+        }
+    }
+
+    RunTasks();
+}
+
+void srph::debugger::Debugger::ForgetFunctions()
+{
+    m_functions.clear();
+    m_functionCache = {};
+
+    // Releasing an expression may destroy a function and call ForgetFunction, so the maps are emptied first.
+    std::vector<std::unique_ptr<CompiledExpression>> released;
+    for (auto& [key, compiled] : m_evaluations)
+    {
+        released.push_back(std::move(compiled));
+    }
+    m_evaluations.clear();
+
+    for (auto& [file, section] : m_files)
+    {
+        for (auto& [line, state] : section.states)
+        {
+            for (ExpressionCache* cache : {&state.conditions, &state.messages})
+            {
+                for (auto& [function, compiled] : *cache)
+                {
+                    released.push_back(std::move(compiled));
+                }
+                cache->clear();
+            }
+        }
+    }
+}
+
+void srph::debugger::Debugger::Track(asIScriptFunction* function)
+{
+    if (function && function->GetUserData(FUNCTION_USER_DATA) != m_engine)
+    {
+        function->SetUserData(m_engine, FUNCTION_USER_DATA);
+    }
+}
+
+// The engine outlives its functions, the debugger may be stopped before them
+void srph::debugger::Debugger::FunctionDestroyed(asIScriptFunction* function)
+{
+    Engine* engine = static_cast<Engine*>(function->GetUserData(FUNCTION_USER_DATA));
+    if (engine->m_debugger) engine->m_debugger->ForgetFunction(function);
+}
+
+void srph::debugger::Debugger::ForgetFunction(asIScriptFunction* function)
+{
+    m_functions.erase(function);
+
+    CachedFunction& cached = m_functionCache[(reinterpret_cast<uintptr_t>(function) >> 4) % FUNCTION_CACHE_SIZE];
+    if (cached.function == function) cached = {};
+
+    std::vector<std::unique_ptr<CompiledExpression>> released;
+    for (auto it = m_evaluations.begin(); it != m_evaluations.end();)
+    {
+        if (std::get<0>(it->first) == function)
+        {
+            released.push_back(std::move(it->second));
+            it = m_evaluations.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (auto& [file, section] : m_files)
+    {
+        for (auto& [line, state] : section.states)
+        {
+            for (ExpressionCache* cache : {&state.conditions, &state.messages})
+            {
+                auto it = cache->find(function);
+                if (it == cache->end()) continue;
+
+                released.push_back(std::move(it->second));
+                cache->erase(it);
+            }
+        }
     }
+}
 
-    const std::string& normalized = it->second;
+void srph::debugger::Debugger::LineCallback(asIScriptContext* context)
+{
+    if (m_breakpointGeneration.load(std::memory_order_acquire) != m_seenGeneration) RefreshBreakpoints();
 
-    if (m_stepMode == StepMode::Over)
+    const StepMode stepMode = m_stepMode.load(std::memory_order_acquire);
+    const bool stepping = stepMode != StepMode::None && context == m_stepContext.load(std::memory_order_relaxed);
+    if (!stepping)
     {
-        if (m_currentContext->GetCallstackSize() <= m_currentStackDepth)
+        if (m_files.empty()) return;
+
+        // Most lines end here, functions without a breakpoint are never looked at again.
+        asIScriptFunction* function = context->GetFunction(0);
+        CachedFunction& cached = m_functionCache[(reinterpret_cast<uintptr_t>(function) >> 4) % FUNCTION_CACHE_SIZE];
+        if (cached.function != function)
         {
-            m_shouldStop = true;
-            m_stepMode = StepMode::None;
+            cached.function = function;
+            cached.hasBreakpoint = HasBreakpoint(function);
         }
+        if (!cached.hasBreakpoint) return;
+    }
+
+    // The callback runs once more when an execution returns, at the line it stopped on.
+    if (context->GetState() != asEXECUTION_ACTIVE) return;
+
+    const char* scriptSection = nullptr;
+    int line = context->GetLineNumber(0, nullptr, &scriptSection);
+
+    bool stop = false;
+    if (stepping &&
+        (stepMode == StepMode::In || context->GetCallstackSize() <= m_stepDepth.load(std::memory_order_relaxed)))
+    {
+        stop = true;
     }
-    else if (m_stepMode == StepMode::In)
+    else if (IsBreakpoint(scriptSection, line))
     {
-        m_shouldStop = true;
-        m_stepMode = StepMode::None;
+        stop = ShouldStop(context, *FindSection(scriptSection), line);
     }
-    else if (m_stepMode == StepMode::Out)
+
+    if (stop)
+    {
+        Stop(context, scriptSection, line);
+    }
+}
+
+void srph::debugger::Debugger::Stop(asIScriptContext* context, const char* section, int line)
+{
+    const int threadId = ThreadId(context);
+    const runtime::CoroutineId coroutine = m_nonStop && m_engine->m_scheduler ? m_engine->m_scheduler->SuspendContext(context) : 0;
     {
-        if (m_currentContext->GetCallstackSize() <= m_currentStackDepth)
+        std::lock_guard<std::mutex> lock(m_resumeMutex);
+        m_stepMode.store(StepMode::None, std::memory_order_relaxed);
+        m_stepContext.store(nullptr, std::memory_order_relaxed);
+        m_stopped[threadId] = {context, coroutine, false};
+    }
+
+    m_adapter->OnBreakpointHit(threadId, coroutine == 0, section ? section : "", line);
+
+    // The coroutine returns to the scheduler and continues on the tick after it is resumed.
+    if (coroutine) return;
+
+    std::unique_lock<std::mutex> lock(m_resumeMutex);
+    for (;;)
+    {
+        m_resumeCV.wait(lock, [&] { return m_stopped.at(threadId).resumed || !m_tasks.empty(); });
+        if (m_stopped.at(threadId).resumed) break;
+
+        lock.unlock();
+        RunTasks();
+        lock.lock();
+    }
+    m_stopped.erase(threadId);
+    lock.unlock();
+
+    // Note(Seb): This is a bit of an oddity, but it makes sense... I need to reset the function timeout timer, since it has
+    // definitely timed out after hitting a breakpoint
+    if (m_engine->m_currentFunctionCaller) m_engine->m_currentFunctionCaller->m_startTime = std::chrono::steady_clock::now();
+}
+
+int srph::debugger::Debugger::ThreadId(asIScriptContext* context)
+{
+    const runtime::CoroutineId coroutine = m_engine->m_scheduler ? m_engine->m_scheduler->Find(context) : 0;
+    if (coroutine)
+    {
+        auto it = m_coroutineThreads.find(coroutine);
+        if (it == m_coroutineThreads.end()) it = m_coroutineThreads.emplace(coroutine, m_nextThreadId++).first;
+        return it->second;
+    }
+
+    auto it = m_contextThreads.find(context);
+    if (it == m_contextThreads.end()) it = m_contextThreads.emplace(context, m_nextThreadId++).first;
+    return it->second;
+}
+
+void srph::debugger::Debugger::CoroutineFinished(uint32_t coroutine) { m_coroutineThreads.erase(coroutine); }
+
+void srph::debugger::Debugger::ContextReleased(asIScriptContext* context) { m_contextThreads.erase(context); }
+
+bool srph::debugger::Debugger::Post(const std::function<void()>& task)
+{
+    Task pending;
+    pending.run = &task;
+
+    std::unique_lock<std::mutex> lock(m_resumeMutex);
+    m_tasks.push_back(&pending);
+    m_resumeCV.notify_all();
+
+    if (!m_taskCV.wait_for(lock, TASK_TIMEOUT, [&] { return pending.started; }))
+    {
+        m_tasks.erase(std::find(m_tasks.begin(), m_tasks.end(), &pending));
+        return false;
+    }
+
+    m_taskCV.wait(lock, [&] { return pending.done; });
+    return true;
+}
+
+void srph::debugger::Debugger::RunTasks()
+{
+    std::unique_lock<std::mutex> lock(m_resumeMutex);
+    while (!m_tasks.empty())
+    {
+        Task* task = m_tasks.front();
+        m_tasks.pop_front();
+        task->started = true;
+        m_taskCV.notify_all();
+
+        lock.unlock();
+        (*task->run)();
+        lock.lock();
+
+        task->done = true;
+        m_taskCV.notify_all();
+    }
+}
+
+void srph::debugger::Debugger::RefreshBreakpoints()
+{
+    std::lock_guard<std::mutex> lock(m_breakpointMutex);
+    m_seenGeneration = m_breakpointGeneration.load(std::memory_order_relaxed);
+
+    // The client sends all breakpoints of a file at once, the ones that didn't change keep their hit counts.
+    std::unordered_map<std::string, SectionBreakpoints> previous = std::move(m_files);
+    m_files.clear();
+    for (auto& [file, breakpoints] : m_breakpoints)
+    {
+        auto previousSection = previous.find(file);
+        SectionBreakpoints& section = m_files[file];
+        for (const Breakpoint& breakpoint : breakpoints)
         {
-            m_shouldStop = true;
-            m_stepMode = StepMode::None;
+            const int line = breakpoint.line;
+            if (line <= 0) continue;
+            const size_t word = static_cast<size_t>(line) / 64;
+            if (section.lines.size() <= word) section.lines.resize(word + 1, 0);
+            section.lines[word] |= uint64_t(1) << (line % 64);
+
+            if (!breakpoint.condition.empty() || !breakpoint.hitCondition.empty() || !breakpoint.logMessage.empty())
+            {
+                BreakpointState& state = section.states[line];
+                state.breakpoint = breakpoint;
+
+                if (previousSection == previous.end()) continue;
+                auto previousState = previousSection->second.states.find(line);
+                if (previousState != previousSection->second.states.end() && SameBreakpoint(previousState->second.breakpoint, breakpoint))
+                {
+                    state.hits = previousState->second.hits;
+                }
+            }
         }
     }
-    else if (IsBreakpoint(normalized, line))
+
+    m_sections.clear();
+    ForgetFunctions();
+}
+
+srph::debugger::Debugger::SectionBreakpoints* srph::debugger::Debugger::FindSection(const char* section)
+{
+    if (!section) return nullptr;
+
+    auto it = m_sections.find(section);
+    if (it == m_sections.end())
     {
-        m_shouldStop = true;
+        std::string normalized = section;
+        std::transform(normalized.begin(),
+                       normalized.end(),
+                       normalized.begin(),
+                       [](char c) { return static_cast<char>(c == '\\' ? '/' : std::tolower(static_cast<unsigned char>(c))); });
+
+        auto file = m_files.find(normalized);
+        it = m_sections.emplace(section, file != m_files.end() ? &file->second : nullptr).first;
     }
 
-    if (m_shouldStop)
+    return it->second;
+}
+
+bool srph::debugger::Debugger::HasBreakpoint(asIScriptFunction* function)
+{
+    if (!function) return false;
+
+    auto it = m_functions.find(function);
+    if (it != m_functions.end()) return it->second;
+
+    // A function counts as containing a breakpoint when one of its sections has one between its first and
+    // last line, which is exact unless the function was compiled from several sections.
+    bool result = false;
+    asCScriptFunction* scriptFunction = static_cast<asCScriptFunction*>(function);
+    if (scriptFunction->scriptData && scriptFunction->scriptData->lineNumbers.GetLength() > 0)
     {
-        m_shouldStop = false;
+        const asCArray<int>& lineNumbers = scriptFunction->scriptData->lineNumbers;
+        int first = INT_MAX;
+        int last = 0;
+        for (asUINT i = 1; i < lineNumbers.GetLength(); i += 2)
+        {
+            // The column is kept in the upper bits.
+            const int line = lineNumbers[i] & 0xFFFFF;
+            first = std::min(first, line);
+            last = std::max(last, line);
+        }
+
+        asCScriptEngine* engine = static_cast<asCScriptEngine*>(function->GetEngine());
+        const asCArray<int>& sectionIdxs = scriptFunction->scriptData->sectionIdxs;
+        for (asUINT i = 0; i <= sectionIdxs.GetLength() && !result; i += 2)
+        {
+            const int sectionIdx = i < sectionIdxs.GetLength() ? sectionIdxs[i + 1] : scriptFunction->scriptData->scriptSectionIdx;
+            if (sectionIdx < 0 || sectionIdx >= static_cast<int>(engine->scriptSectionNames.GetLength())) continue;
+
+            const SectionBreakpoints* section = FindSection(engine->scriptSectionNames[sectionIdx]->AddressOf());
+            for (int line = first; section && line <= last && !result; line++)
+            {
+                result = HasLine(section->lines, line);
+            }
+        }
+    }
+
+    Track(function);
+    m_functions.emplace(function, result);
+    return result;
+}
+
+bool srph::debugger::Debugger::IsBreakpoint(const char* section, int line)
+{
+    const SectionBreakpoints* breakpoints = FindSection(section);
+    return breakpoints && HasLine(breakpoints->lines, line);
+}
 
-        m_currentContext = context;
-        m_currentFile = scriptSection;
-        m_currentLine = line;
+bool srph::debugger::Debugger::ShouldStop(asIScriptContext* context, SectionBreakpoints& section, int line)
+{
+    auto it = section.states.find(line);
+    if (it == section.states.end()) return true;
+
+    BreakpointState& state = it->second;
+    const Breakpoint& breakpoint = state.breakpoint;
+    bool condition = true;
+    std::string text;
 
-        m_adapter->OnBreakpointHit(scriptSection, line);
+    // A condition that fails stops, so the error is seen next to the line it belongs to.
+    if (!breakpoint.condition.empty() &&
+        !RunExpression(state.conditions[context->GetFunction(0)], context, 0, ExpressionKind::Condition, breakpoint.condition, condition, text))
+    {
+        m_adapter->OnOutput(fmt::format("Breakpoint condition '{}' on line {} failed: {}", breakpoint.condition, line, text));
+        return true;
+    }
+    if (!condition) return false;
 
-        std::unique_lock<std::mutex> lock(m_resumeMutex);
-        m_resumed = false;
-        m_resumeCV.wait(lock, [this] { return m_resumed; });
+    state.hits++;
+    if (!HitConditionMet(breakpoint.hitCondition, state.hits)) return false;
 
-        // Note(Seb): This is a bit of an oddity, but it makes sense... I need to reset the function timeout timer, since it has
-        // definitely timed out after hitting a breakpoint
-        m_engine->m_currentFunctionCaller->m_startTime = std::chrono::steady_clock::now();
+    if (!breakpoint.logMessage.empty())
+    {
+        if (!RunExpression(state.messages[context->GetFunction(0)], context, 0, ExpressionKind::Message, breakpoint.logMessage, condition, text))
+        {
+            text = fmt::format("Logpoint '{}' on line {} failed: {}", breakpoint.logMessage, line, text);
+        }
+        m_adapter->OnOutput(text);
+        return false;
     }
+
+    return true;
 }
 
-bool srph::debugger::Debugger::IsBreakpoint(const std::string& file, int line)
+bool srph::debugger::Debugger::RunExpression(std::unique_ptr<CompiledExpression>& compiled,
+                                             asIScriptContext* context,
+                                             asUINT frame,
+                                             ExpressionKind kind,
+                                             const std::string& expression,
+                                             bool& condition,
+                                             std::string& text)
 {
-    if (m_breakpoints.find(file) == m_breakpoints.end()) return false;
+    if (!compiled)
+    {
+        Track(context->GetFunction(frame));
+        compiled = std::make_unique<CompiledExpression>();
+        compiled->Compile(context, frame, kind, expression);
+    }
 
-    auto& lines = m_breakpoints.at(file);
+    if (!m_expressionContext)
+    {
+        m_expressionContext = context->GetEngine()->CreateContext();
+    }
 
-    return std::find(lines.begin(), lines.end(), line) != lines.end();
-}
\ No newline at end of file
+    return compiled->Run(context, frame, m_expressionContext, condition, text);
+}
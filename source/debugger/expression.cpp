@@ -0,0 +1,256 @@
+#include "srph_common.hpp"
+#include "debugger/expression.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+#include <fmt/format.h>
+
+namespace
+{
+// Escapes text for a script string literal, and for the format string when it is one
+std::string Literal(const std::string& text, bool formatString)
+{
+    std::string literal;
+    literal.reserve(text.size() + 2);
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\') literal += '\\';
+        if (c == '\n')
+        {
+            literal += "\\n";
+            continue;
+        }
+        if (formatString && (c == '{' || c == '}')) literal += c;
+        literal += c;
+    }
+    return literal;
+}
+
+void CollectErrors(const asSMessageInfo* message, void* errors)
+{
+    if (message->type != asMSGTYPE_ERROR) return;
+
+    std::string& text = *static_cast<std::string*>(errors);
+    if (!text.empty()) text += "; ";
+    text += message->message;
+}
+
+bool IsIdentifier(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+// The expression is compiled into a global function, its object arrives as the parameter __this.
+std::string ReplaceThis(const std::string& expression)
+{
+    std::string replaced;
+    char quote = 0;
+    for (size_t i = 0; i < expression.size(); i++)
+    {
+        const char c = expression[i];
+        if (quote)
+        {
+            replaced += c;
+            if (c == '\\' && i + 1 < expression.size()) replaced += expression[++i];
+            else if (c == quote) quote = 0;
+            continue;
+        }
+        if (c == '"' || c == '\'')
+        {
+            quote = c;
+            replaced += c;
+            continue;
+        }
+
+        const bool after = i + 4 < expression.size() && IsIdentifier(expression[i + 4]);
+        if (expression.compare(i, 4, "this") == 0 && (i == 0 || !IsIdentifier(expression[i - 1])) && !after)
+        {
+            replaced += "__this";
+            i += 3;
+            continue;
+        }
+        replaced += c;
+    }
+    return replaced;
+}
+
+// Turns "x is {x}" into the format string "x is {}" and its expressions. Text outside the braces is kept as it is.
+std::string ParseMessage(const std::string& message, std::vector<std::string>& expressions)
+{
+    std::string format;
+    size_t pos = 0;
+    while (pos < message.size())
+    {
+        const size_t open = message.find('{', pos);
+        const size_t close = open == std::string::npos ? std::string::npos : message.find('}', open + 1);
+        if (close == std::string::npos)
+        {
+            format += Literal(message.substr(pos), true);
+            break;
+        }
+
+        format += Literal(message.substr(pos, open - pos), true);
+        format += "{}";
+        expressions.push_back(message.substr(open + 1, close - open - 1));
+        pos = close + 1;
+    }
+    return format;
+}
+}  // namespace
+
+srph::debugger::CompiledExpression::~CompiledExpression()
+{
+    if (m_function) m_function->Release();
+}
+
+bool srph::debugger::CompiledExpression::Compile(asIScriptContext* frameContext,
+                                                 asUINT frame,
+                                                 ExpressionKind kind,
+                                                 const std::string& expression)
+{
+    m_kind = kind;
+
+    asIScriptFunction* function = frameContext->GetFunction(frame);
+    asIScriptModule* module = function ? function->GetModule() : nullptr;
+    if (!module)
+    {
+        m_error = "The function has no module";
+        return false;
+    }
+
+    asIScriptEngine* engine = frameContext->GetEngine();
+
+    // Later arguments are in inner scopes, so they replace the outer ones of the same name.
+    auto add = [this](Argument argument) {
+        auto it = std::find_if(m_arguments.begin(), m_arguments.end(), [&](const Argument& a) { return a.name == argument.name; });
+        if (it != m_arguments.end()) m_arguments.erase(it);
+        m_arguments.push_back(std::move(argument));
+    };
+
+    const int thisTypeId = frameContext->GetThisPointer(frame) ? frameContext->GetThisTypeId(frame) : 0;
+    if (asITypeInfo* type = thisTypeId ? engine->GetTypeInfoById(thisTypeId) : nullptr)
+    {
+        add({Source::This, 0, thisTypeId | asTYPEID_OBJHANDLE, true, "__this"});
+        for (asUINT i = 0; i < type->GetPropertyCount(); i++)
+        {
+            const char* name = nullptr;
+            int typeId = 0;
+            if (type->GetProperty(i, &name, &typeId) < 0 || !name) continue;
+            add({Source::Property, static_cast<int>(i), typeId, (typeId & asTYPEID_OBJHANDLE) != 0, name});
+        }
+    }
+
+    const int varCount = frameContext->GetVarCount(frame);
+    for (int i = 0; i < varCount; i++)
+    {
+        const char* name = nullptr;
+        int typeId = 0;
+        if (frameContext->GetVar(i, frame, &name, &typeId) < 0 || !name || name[0] == '\0') continue;
+        if (!frameContext->IsVarInScope(i, frame)) continue;
+
+        add({Source::Variable, i, typeId, (typeId & asTYPEID_OBJHANDLE) != 0, name});
+    }
+
+    std::string parameters;
+    for (const Argument& argument : m_arguments)
+    {
+        const char* type = engine->GetTypeDeclaration(argument.typeId, true);
+
+        if (!parameters.empty()) parameters += ", ";
+        parameters += argument.handle ? fmt::format("{} {}", type, argument.name) : fmt::format("const {} &in {}", type, argument.name);
+    }
+
+    std::string code;
+    if (kind == ExpressionKind::Condition)
+    {
+        code = fmt::format("bool __condition({}) {{ return ({}); }}", parameters, thisTypeId ? ReplaceThis(expression) : expression);
+    }
+    else
+    {
+        std::vector<std::string> expressions;
+        std::string format = kind == ExpressionKind::Message ? ParseMessage(expression, expressions) : "{}";
+        if (kind == ExpressionKind::Value) expressions.push_back(expression);
+
+        std::string arguments;
+        for (const std::string& e : expressions)
+        {
+            arguments += fmt::format(", ({})", thisTypeId ? ReplaceThis(e) : e);
+        }
+        code = fmt::format("string __value({}) {{ return format(\"{}\"{}); }}", parameters, format, arguments);
+    }
+
+    // The errors are meant for the debugger's client, not for the engine's log.
+    asSFuncPtr callback;
+    void* callbackObject = nullptr;
+    asDWORD callbackConvention = 0;
+    SRPH_VERIFY(engine->GetMessageCallback(&callback, &callbackObject, &callbackConvention), "Failed to get the message callback.")
+    SRPH_VERIFY(engine->SetMessageCallback(asFUNCTION(CollectErrors), &m_error, asCALL_CDECL), "Failed to set the message callback.")
+    const int r = module->CompileFunction("debugger", code.c_str(), 0, 0, &m_function);
+    SRPH_VERIFY(engine->SetMessageCallback(callback, callbackObject, callbackConvention), "Failed to restore the message callback.")
+
+    if (r < 0 && m_error.empty()) m_error = "The expression does not compile";
+    return r >= 0;
+}
+
+bool srph::debugger::CompiledExpression::Run(asIScriptContext* frameContext,
+                                             asUINT frame,
+                                             asIScriptContext* context,
+                                             bool& condition,
+                                             std::string& text) const
+{
+    if (!m_function)
+    {
+        text = m_error;
+        return false;
+    }
+
+    SRPH_VERIFY(context->Prepare(m_function), "Failed to prepare an expression.")
+
+    asIScriptObject* object = static_cast<asIScriptObject*>(frameContext->GetThisPointer(frame));
+    for (asUINT i = 0; i < m_arguments.size(); i++)
+    {
+        const Argument& argument = m_arguments[i];
+        if (argument.source == Source::This)
+        {
+            context->SetArgObject(i, object);
+            continue;
+        }
+
+        void* address = argument.source == Source::Property ? (object ? object->GetAddressOfProperty(argument.index) : nullptr)
+                                                            : frameContext->GetAddressOfVar(argument.index, frame);
+        if (argument.handle)
+        {
+            context->SetArgObject(i, address ? *static_cast<void**>(address) : nullptr);
+        }
+        else if (address)
+        {
+            context->SetArgAddress(i, address);
+        }
+        else
+        {
+            // Objects declared further down the scope aren't constructed yet.
+            text = fmt::format("'{}' is not initialized", argument.name);
+            context->Unprepare();
+            return false;
+        }
+    }
+
+    const int r = context->Execute();
+    if (r != asEXECUTION_FINISHED)
+    {
+        const char* exception = r == asEXECUTION_EXCEPTION ? context->GetExceptionString() : nullptr;
+        text = exception ? exception : "The expression did not finish";
+        context->Unprepare();
+        return false;
+    }
+
+    if (m_kind == ExpressionKind::Condition)
+    {
+        condition = context->GetReturnByte() != 0;
+    }
+    else
+    {
+        text = *static_cast<std::string*>(context->GetAddressOfReturnValue());
+    }
+
+    context->Unprepare();
+    return true;
+}
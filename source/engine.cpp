@@ -3,26 +3,84 @@
 #include "debugger/dap.hpp"
 
 #include "helpers.hpp"
+#include "script_format.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <random>
+#include "magic_enum/magic_enum.hpp"
 
 #include "function_caller.hpp"
 #include "debugger/debugger.hpp"
+#include "profiler/sampling_profiler.hpp"
+#include "profiler/tracer.hpp"
+#include "profiler/metrics.hpp"
+#include "profiler/metrics_server.hpp"
+#include "memory/frame_arena.hpp"
+#include "jit/jit_compiler.hpp"
+#include "jit/aot.hpp"
+#include "runtime/scheduler.hpp"
+#include "runtime/job_pool.hpp"
+#include "runtime/event_bus.hpp"
+#include "runtime/command_queue.hpp"
+#include "runtime/timer_wheel.hpp"
+#include "runtime/garbage_collector.hpp"
+
+namespace
+{
+// The AngelScript engine points back to its Engine, and so do the functions passed to TrackFunction
+constexpr asPWORD ENGINE_USER_DATA = 0x53525045;
+constexpr asPWORD FUNCTION_USER_DATA = 0x53525046;
+}  // namespace
 
 void srph::Engine::Initialize(EngineConfiguration configuration)
 {
-    Log::Info("Initializing Seraph.");
-    m_engine = asCreateScriptEngine();
+    SRPH_LOG_INFO("Initializing Seraph.");
     m_configuration = configuration;
 
+    // Has to happen before the engine allocates anything.
+    if (!memory::Install(m_configuration.allocator, m_configuration.customAllocator))
+    {
+        SRPH_LOG_WARN("Script allocator {} is already installed, ignoring {}.",
+                      magic_enum::enum_name(memory::InstalledStrategy()),
+                      magic_enum::enum_name(m_configuration.allocator));
+    }
+
+    if (m_configuration.moduleMemoryAccounting || !m_configuration.memoryBudgets.empty())
+    {
+        memory::EnableAccounting();
+    }
+
+    for (const auto& [account, bytes] : m_configuration.memoryBudgets)
+    {
+        SetMemoryBudget(account, bytes);
+    }
+
+    m_engine = asCreateScriptEngine();
+
     if (!m_engine)
     {
-        Log::Critical("Failed to create AngelScript engine.");
+        SRPH_LOG_CRITICAL("Failed to create AngelScript engine.");
     }
 
     SRPH_VERIFY(m_engine->SetMessageCallback(asMETHOD(Engine, MessageCallback), this, asCALL_THISCALL),
                 "Failed to set message callback")
 
+    m_engine->SetUserData(this, ENGINE_USER_DATA);
+    m_engine->SetFunctionUserDataCleanupCallback(FunctionDestroyed, FUNCTION_USER_DATA);
+
+    SRPH_VERIFY(m_engine->SetEngineProperty(asEP_INIT_STACK_SIZE, m_configuration.initialStackBytes),
+                "Failed to set the initial stack size.")
+    SRPH_VERIFY(m_engine->SetEngineProperty(asEP_SUPERINSTRUCTIONS, m_configuration.superinstructions),
+                "Failed to set superinstructions.")
+
+    if (m_configuration.jit || m_configuration.aot)
+    {
+        EnableJit();
+    }
+
+    Log::SetRateLimit(LogLevel::Script, m_configuration.scriptPrintsPerSecond);
+
     RegisterAddOns();
 
     SRPH_VERIFY(m_engine->RegisterGlobalFunction("void print(const string& in)",
@@ -31,12 +89,97 @@ void srph::Engine::Initialize(EngineConfiguration configuration)
                                                  this),
                 "Failed to register print internal call.")
 
+    SRPH_VERIFY(m_engine->RegisterGlobalFunction("void print(const string&in fmt, const ?&in ...)",
+                                                 asFUNCTION(Engine::PrintFormatted),
+                                                 asCALL_GENERIC,
+                                                 this),
+                "Failed to register formatted print internal call.")
+
+    SRPH_VERIFY(m_engine->RegisterGlobalFunction("string format(const string&in fmt, const ?&in ...)",
+                                                 asFUNCTION(formatting::ScriptFormat),
+                                                 asCALL_GENERIC),
+                "Failed to register format internal call.")
+
+    m_scheduler = new runtime::Scheduler(this);
+    m_scheduler->RegisterInterface();
+    m_timers = new runtime::TimerWheel(this, m_configuration.timerResolutionMillis);
+    m_timers->RegisterInterface();
+    m_eventBus = new runtime::EventBus(this);
+    m_commandQueue = new runtime::CommandQueue(this, m_configuration.commandQueueBytes);
+    m_garbageCollector = new runtime::GarbageCollector(this, m_configuration.gcBudgetMicros, m_configuration.gcBackgroundMarking);
+
     m_context = m_engine->CreateContext();
 
     SRPH_VERIFY(m_context->SetLineCallback(asMETHOD(Engine, LineCallback), this, asCALL_THISCALL),
                 "Could not set line callback.")
 }
 
+void srph::Engine::BeginFrame()
+{
+    if (!m_frameArena)
+    {
+        m_frameArena = new memory::FrameArena(m_configuration.frameArenaChunkBytes);
+    }
+
+    m_frameArena->Begin();
+}
+
+void srph::Engine::EndFrame()
+{
+    if (m_frameArena)
+    {
+        // Suspended coroutines can point into array elements, their buffers have to stay where they are
+        m_frameArena->End(m_scheduler->Count() == 0);
+    }
+}
+
+void srph::Engine::Tick(double deltaSeconds)
+{
+    runtime::ScriptAccess access(m_garbageCollector);
+    if (m_debugger) m_debugger->Tick();
+    m_timers->Advance(deltaSeconds);
+    m_scheduler->Tick(deltaSeconds);
+    m_garbageCollector->Collect(m_configuration.gcBudgetMicros);
+}
+
+srph::runtime::CoroutineId srph::Engine::StartCoroutine(const std::string& moduleName,
+                                                       const std::string& functionDecl,
+                                                       InstanceHandle instance)
+{
+    if (!m_built) return 0;
+
+    runtime::ScriptAccess access(m_garbageCollector);
+    asIScriptFunction* function = nullptr;
+    asIScriptObject* object = nullptr;
+
+    if (instance.Valid())
+    {
+        auto it = m_instances.find(instance);
+        if (it == m_instances.end())
+        {
+            SRPH_LOG_ERROR("Coroutine {} started on an instance that does not exist.", functionDecl);
+            return 0;
+        }
+
+        object = it->second;
+        function = GetMethod(object->GetObjectType(), functionDecl);
+    }
+    else
+    {
+        asIScriptModule* module = GetModule(moduleName);
+        function = module ? GetFunction(module, functionDecl) : nullptr;
+    }
+
+    if (!function)
+    {
+        SRPH_LOG_ERROR("Coroutine {} does not exist in module '{}'.", functionDecl, moduleName);
+        return 0;
+    }
+
+    function->AddRef();
+    return m_scheduler->Start(function, object);
+}
+
 void srph::Engine::AttachDebugger()
 {
     if (!m_debugger)
@@ -48,8 +191,83 @@ void srph::Engine::AttachDebugger()
             m_debugger->Start();
         }
     }
+}
+
+void srph::Engine::StartProfiler(uint32_t intervalMicros)
+{
+    if (!m_profiler)
+    {
+        m_profiler = new profiler::SamplingProfiler(intervalMicros);
+    }
+
+    m_profiler->Start();
+}
+
+void srph::Engine::StopProfiler()
+{
+    delete m_profiler;
+    m_profiler = nullptr;
+}
+
+void srph::Engine::StartTracer(const profiler::TracerOptions& options)
+{
+    StopTracer();
+
+    m_tracer = new profiler::Tracer(options);
+    if (options.scriptCalls)
+    {
+        RegisterLineCallback("tracer", [this](asIScriptContext* context) { m_tracer->LineCallback(context); });
+    }
+}
+
+void srph::Engine::StopTracer()
+{
+    RemoveLineCallback("tracer");
+    delete m_tracer;
+    m_tracer = nullptr;
+}
+
+void srph::Engine::EnableMetrics(uint16_t httpPort)
+{
+    if (!m_metrics)
+    {
+        m_metrics = new profiler::MetricsRegistry();
+    }
+
+    if (httpPort != 0 && !m_metricsServer)
+    {
+        m_metricsServer = new profiler::MetricsServer(m_metrics, httpPort);
+        m_metricsServer->Start();
+    }
+}
+
+void srph::Engine::DisableMetrics()
+{
+    delete m_metricsServer;
+    m_metricsServer = nullptr;
+    delete m_metrics;
+    m_metrics = nullptr;
+}
+
+srph::memory::MemoryStats srph::Engine::GetMemoryStats() const { return memory::Stats(); }
+
+srph::memory::FrameArenaStats srph::Engine::GetFrameArenaStats() const
+{
+    return m_frameArena ? m_frameArena->Stats() : memory::FrameArenaStats{};
+}
 
-    m_debugger->RegisterLineCallback();
+void srph::Engine::SetMemoryBudget(const std::string& account, uint64_t bytes) const
+{
+    memory::SetBudget(memory::Account(account), bytes);
+}
+
+void srph::Engine::AssignMemoryAccount(asIScriptModule* module) const
+{
+    if (!memory::AccountingEnabled()) return;
+
+    const std::string moduleName = module->GetName();
+    auto tenant = m_configuration.memoryTenants.find(moduleName);
+    memory::AssignModule(module, memory::Account(tenant != m_configuration.memoryTenants.end() ? tenant->second : moduleName));
 }
 
 void srph::Engine::RegisterLineCallback(const std::string& key, const std::function<void(asIScriptContext* context)>& f)
@@ -61,6 +279,27 @@ void srph::Engine::RemoveLineCallback(const std::string& key) { m_lineCallbacks.
 
 void srph::Engine::Shutdown()
 {
+    // Running jobs complete their futures and wake coroutines, so the pool goes before the scheduler. The
+    // coroutines hold references to instances and return their contexts.
+    delete m_jobPool;
+    m_jobPool = nullptr;
+
+    delete m_scheduler;
+    m_scheduler = nullptr;
+
+    delete m_timers;
+    m_timers = nullptr;
+
+    delete m_eventBus;
+    m_eventBus = nullptr;
+
+    delete m_commandQueue;
+    m_commandQueue = nullptr;
+
+    // Stops the marking thread, releasing the engine collects the rest on this thread.
+    delete m_garbageCollector;
+    m_garbageCollector = nullptr;
+
     // TODO(Seb): Call DiscardModule here?
     for (auto& instance : m_instances)
     {
@@ -80,12 +319,60 @@ void srph::Engine::Shutdown()
 
     m_contexts.clear();
     m_context->Release();
+
+    // Holds the functions compiled for breakpoint conditions and watch expressions.
+    StopDebugger();
+
+    StopProfiler();
+    StopTracer();
+    DisableMetrics();
     m_engine->Release();
+
+    // Releasing the engine cleans up the compiled functions through the JIT.
+    delete m_aot;
+    m_aot = nullptr;
+    delete m_jit;
+    m_jit = nullptr;
+
+    // After the engine, releasing it frees the remaining arrays and ends the frame's buffers.
+    delete m_frameArena;
+    m_frameArena = nullptr;
+
+    m_asyncFunctions.clear();
+
+    Log::Flush();
+}
+
+void srph::Engine::EnableJit()
+{
+    if (m_configuration.jit && !jit::JitCompiler::Supported())
+    {
+        SRPH_LOG_WARN("The JIT only supports x86-64, scripts run in the interpreter.");
+    }
+    else if (m_configuration.jit)
+    {
+        m_jit = new jit::JitCompiler(m_configuration.jitHotEntries);
+    }
+
+    if (m_configuration.aot)
+    {
+        m_aot = new jit::AotLinker(m_jit);
+    }
+
+    if (!m_jit && !m_aot) return;
+
+    SRPH_VERIFY(m_engine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, true), "Failed to include JIT instructions.")
+    SRPH_VERIFY(m_engine->SetEngineProperty(asEP_JIT_INTERFACE_VERSION, 2), "Failed to set the JIT interface version.")
+
+    // The linker hands the functions without native code to the JIT.
+    asIJITCompilerAbstract* compiler = m_aot ? static_cast<asIJITCompilerAbstract*>(m_aot) : m_jit;
+    SRPH_VERIFY(m_engine->SetJITCompiler(compiler), "Failed to set the JIT compiler.")
 }
 
 void srph::Engine::RegisterAddOns() const
 {
     RegisterStdString(m_engine);
+    CScriptArray::SetBufferMemoryFunctions(memory::FrameArena::AllocateBuffer, memory::FrameArena::FreeBuffer);
     RegisterScriptArray(m_engine, true);
 }
 
@@ -159,7 +446,7 @@ srph::InstanceHandle srph::Engine::CreateInstance(const std::string& typeName, c
 
     if (!type)
     {
-        Log::Error("Type '{}' is not registered in module '{}'.", typeName, moduleName);
+        SRPH_LOG_ERROR("Type '{}' is not registered in module '{}'.", typeName, moduleName);
         return {};
     }
 
@@ -178,12 +465,14 @@ srph::InstanceHandle srph::Engine::CreateInstance(const std::string& typeName, c
 
     if (factory)
     {
+        runtime::ScriptAccess access(m_garbageCollector);
         m_context->Prepare(factory);
-        m_context->Execute();
+        Execute(m_context);
 
         InstanceHandle handle = {RandomHandle()};
         m_instances[handle] = *static_cast<asIScriptObject**>(m_context->GetAddressOfReturnValue());
         SRPH_VERIFY(m_instances[handle]->AddRef(), "Could not AddRef() to the new class.")
+        m_eventBus->AddInstance(m_instances[handle]);
 
         return handle;
     }
@@ -195,10 +484,13 @@ srph::InstanceHandle srph::Engine::CreateInstance(const std::string& typeName, c
 srph::InstanceHandle srph::Engine::CreateInstance(srph::FunctionCaller& functionCall)
 {
     if (!m_built) return {};
+
+    runtime::ScriptAccess access(m_garbageCollector);
     FunctionResult result = functionCall.Call(ReturnType::Object);
 
     InstanceHandle handle = {RandomHandle()};
     m_instances[handle] = std::get<asIScriptObject*>(result.value);
+    m_eventBus->AddInstance(m_instances[handle]);
 
     return handle;
 }
@@ -253,7 +545,11 @@ void srph::Engine::Namespace(const std::string& ns) const
 
 void srph::Engine::GeneratePredefined(const std::string& path) { GenerateScriptPredefined(m_engine, path); }
 
-void srph::Engine::StopDebugger() { delete m_debugger; }
+void srph::Engine::StopDebugger()
+{
+    delete m_debugger;
+    m_debugger = nullptr;
+}
 
 void srph::Engine::MessageCallback(const asSMessageInfo* msg) const
 {
@@ -264,11 +560,11 @@ void srph::Engine::MessageCallback(const asSMessageInfo* msg) const
 
     if (msg->type == asMSGTYPE_ERROR)
     {
-        Log::Error("[{}] {}: {}", typeStr, location, msg->message);
+        SRPH_LOG_ERROR("[{}] {}: {}", typeStr, location, msg->message);
     }
     else if (msg->type == asMSGTYPE_WARNING)
     {
-        Log::Warn("[{}] {}: {}", typeStr, location, msg->message);
+        SRPH_LOG_WARN("[{}] {}: {}", typeStr, location, msg->message);
     }
     else
     {
@@ -278,13 +574,57 @@ void srph::Engine::MessageCallback(const asSMessageInfo* msg) const
 
 void srph::Engine::LineCallback(asIScriptContext* context) const
 {
+    // Called directly instead of through the map, it returns right away for most lines.
+    if (m_debugger) m_debugger->LineCallback(context);
+
     for (auto& entry : m_lineCallbacks)
     {
         entry.second(context);
     }
 }
 
-void srph::Engine::Print(const std::string& str) const { Log::ScriptInfo("{}", str); }
+void srph::Engine::Print(const std::string& str) const { SRPH_LOG_SCRIPT("{}", str); }
+
+void srph::Engine::LogException(asIScriptContext* context, const std::string& call) const
+{
+    const char* sectionName = "";
+    int columnNumber = 0;
+    int lineNumber = context->GetExceptionLineNumber(&columnNumber, &sectionName);
+
+    SRPH_LOG_ERROR("Exception '{}' in {}:{},{} {}.",
+                   context->GetExceptionString(),
+                   sectionName ? sectionName : "",
+                   lineNumber,
+                   columnNumber,
+                   call);
+}
+
+bool srph::Engine::AbortOnTimeout(asIScriptContext* context,
+                                  std::chrono::steady_clock::time_point start,
+                                  const char* what) const
+{
+    auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (elapsed <= m_configuration.scriptTimeoutMillis) return false;
+
+    asIScriptFunction* function = context->GetFunction(context->GetCallstackSize() - 1);
+    SRPH_LOG_INFO("{} {} timed out!", what, function ? function->GetDeclaration(true, true) : "");
+    context->Abort();
+    return true;
+}
+
+void srph::Engine::TimedOut() const
+{
+    if (m_timeoutCallback) m_timeoutCallback();
+}
+
+void srph::Engine::PrintFormatted(asIScriptGeneric* generic)
+{
+    fmt::memory_buffer buffer;
+    if (formatting::FormatArgs(generic, 0, buffer))
+    {
+        SRPH_LOG_SCRIPT("{}", fmt::string_view(buffer.data(), buffer.size()));
+    }
+}
 
 asIScriptContext* srph::Engine::GetContext()
 {
@@ -293,13 +633,75 @@ asIScriptContext* srph::Engine::GetContext()
 
     SRPH_VERIFY(ctx->SetLineCallback(asMETHOD(Engine, LineCallback), this, asCALL_THISCALL), "Could not set line callback.")
 
+    if (m_metrics) m_metrics->ContextCreated();
+
     return m_contexts.back();
 }
 
 void srph::Engine::ReleaseContext(asIScriptContext* ctx)
 {
     m_contexts.erase(std::find(m_contexts.begin(), m_contexts.end(), ctx));
+    if (m_debugger) m_debugger->ContextReleased(ctx);
     SRPH_VERIFY(ctx->Release(), "Failed to release context.")
+
+    if (m_metrics) m_metrics->ContextReleased();
+}
+
+int srph::Engine::Execute(asIScriptContext* ctx)
+{
+    m_garbageCollector->EnterScript();
+    if (!m_profiler)
+    {
+        const int result = ctx->Execute();
+        m_garbageCollector->LeaveScript();
+        return result;
+    }
+
+    m_profiler->Enter(ctx);
+
+    int result = ctx->Execute();
+    while (result == asEXECUTION_SUSPENDED && m_profiler->ConsumeSample(ctx))
+    {
+        result = ctx->Execute();
+    }
+
+    m_profiler->Leave(ctx);
+    m_garbageCollector->LeaveScript();
+
+    return result;
+}
+
+void srph::Engine::Suspend(asIScriptContext* ctx)
+{
+    if (m_profiler) m_profiler->SuspendRequested(ctx);
+    ctx->Suspend();
+}
+
+void srph::Engine::TrackFunction(const asIScriptFunction* function)
+{
+    if (!function || function->GetUserData(FUNCTION_USER_DATA)) return;
+
+    // User data is kept beside the function, setting it doesn't change the function itself
+    auto* tracked = const_cast<asIScriptFunction*>(function);
+    tracked->SetUserData(function->GetEngine()->GetUserData(ENGINE_USER_DATA), FUNCTION_USER_DATA);
+}
+
+void srph::Engine::FunctionDestroyed(asIScriptFunction* function)
+{
+    Engine* engine = static_cast<Engine*>(function->GetUserData(FUNCTION_USER_DATA));
+    if (engine->m_profiler) engine->m_profiler->FunctionDestroyed(function);
+    if (engine->m_tracer) engine->m_tracer->FunctionDestroyed(function);
+    if (engine->m_metrics) engine->m_metrics->FunctionDestroyed(function);
+}
+
+srph::runtime::JobPool* srph::Engine::GetJobPool()
+{
+    if (!m_jobPool)
+    {
+        m_jobPool = new runtime::JobPool(m_configuration.jobThreads);
+    }
+
+    return m_jobPool;
 }
 
 asIScriptModule* srph::Engine::GetModule(const std::string& moduleName)
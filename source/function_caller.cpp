@@ -5,6 +5,9 @@
 
 #include "engine.hpp"
 #include "debugger/debugger.hpp"
+#include "profiler/tracer.hpp"
+#include "profiler/metrics.hpp"
+#include "runtime/garbage_collector.hpp"
 
 srph::FunctionCaller::FunctionCaller(Engine* engine)
 {
@@ -24,6 +27,7 @@ srph::FunctionCaller& srph::FunctionCaller::Function(const std::string& function
 {
     if (!m_engine->m_built) return *this;
 
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
     asIScriptModule* module = m_engine->GetModule(m_moduleName);
 
     asIScriptFunction* func = nullptr;
@@ -51,11 +55,11 @@ srph::FunctionCaller& srph::FunctionCaller::Function(const std::string& function
 
         if (instance.Valid())
         {
-            Log::Error("Method with signature {} was not on class {}.", functionSignature, m_engine->GetTypeName(instance));
+            SRPH_LOG_ERROR("Method with signature {} was not on class {}.", functionSignature, m_engine->GetTypeName(instance));
         }
         else
         {
-            Log::Error("Function with signature {} was not found in the module.", functionSignature);
+            SRPH_LOG_ERROR("Function with signature {} was not found in the module.", functionSignature);
         }
     }
 
@@ -75,13 +79,14 @@ srph::FunctionCaller& srph::FunctionCaller::Factory(const std::string& factoryDe
 {
     if (!m_engine->m_built) return *this;
 
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
     asIScriptModule* module = m_engine->GetModule(m_moduleName);
     asITypeInfo* type = module->GetTypeInfoByDecl(typeName.c_str());
 
     asIScriptFunction* factory = type->GetFactoryByDecl(factoryDecl.c_str());
     if (factory == nullptr)
     {
-        Log::Error("Constructor with signature {} was not found on {}.", factoryDecl, type->GetName());
+        SRPH_LOG_ERROR("Constructor with signature {} was not found on {}.", factoryDecl, type->GetName());
     }
     SRPH_VERIFY(m_context->Prepare(factory), "Failed to prepare for factory call.")
 
@@ -92,133 +97,126 @@ void srph::FunctionCaller::Call()
 {
     if (!m_engine->m_built) return;
 
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
     if (m_isOptional)
     {
         Cleanup();
         return;
     }
 
-    m_engine->m_currentFunctionCaller = this;
+    Execute();
 
-    m_startTime = std::chrono::steady_clock::now();
-    m_timeoutMillis = m_engine->m_configuration.scriptTimeoutMillis;
+    Cleanup();
+}
 
-    m_engine->RegisterLineCallback(m_functionSignature, [this](asIScriptContext* context) { LineCallback(context); });
+srph::FunctionResult srph::FunctionCaller::Call(ReturnType type)
+{
+    if (!m_engine->m_built || m_isOptional) return {};
+
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
+    Execute();
 
-    int result = m_context->Execute();
-    if (result != asEXECUTION_FINISHED)
+    FunctionResult res = {};
+    switch (type)
     {
-        if (result == asEXECUTION_EXCEPTION)
-        {
-            const char* exceptionString = m_context->GetExceptionString();
-            const char* sectionName;
-            int columnNumber = 0;
-            int lineNumber = m_context->GetExceptionLineNumber(&columnNumber, &sectionName);
-
-            if (m_instanceName.empty())
-            {
-                Log::Error("Exception '{}' in {}:{},{} while calling function {}.",
-                           exceptionString,
-                           sectionName,
-                           lineNumber,
-                           columnNumber,
-                           m_functionSignature);
-            }
-            else
-            {
-                Log::Error("Exception '{}' in {}:{},{} while calling method {}::{}.",
-                           exceptionString,
-                           sectionName,
-                           lineNumber,
-                           columnNumber,
-                           m_instanceName,
-                           m_functionSignature);
-            }
-        }
+    case ReturnType::Byte: res.value = m_context->GetReturnByte(); break;
+    case ReturnType::Word: res.value = m_context->GetReturnWord(); break;
+    case ReturnType::QWord: res.value = m_context->GetReturnQWord(); break;
+    case ReturnType::DWord: res.value = m_context->GetReturnDWord(); break;
+    case ReturnType::Float: res.value = m_context->GetReturnFloat(); break;
+    case ReturnType::Double: res.value = m_context->GetReturnDouble(); break;
+    case ReturnType::Object:
+    {
+        // Note(Seb): Calling AddRef here makes the pointer valid after the release of the context. It is a bit dangerous, but I
+        // keep the Release up to the user of this function.
+        asIScriptObject* obj = *static_cast<asIScriptObject**>(m_context->GetAddressOfReturnValue());
+        obj->AddRef();
+        res.value = obj;
+        break;
+    }
     }
-
-    m_executionFinished = true;
 
     Cleanup();
+
+    return res;
 }
 
-srph::FunctionResult srph::FunctionCaller::Call(ReturnType type)
+int srph::FunctionCaller::Execute()
 {
-    if (!m_engine->m_built || m_isOptional) return {};
-
     m_engine->m_currentFunctionCaller = this;
 
     m_startTime = std::chrono::steady_clock::now();
-    m_timeoutMillis = m_engine->m_configuration.scriptTimeoutMillis;
 
     m_engine->RegisterLineCallback(m_functionSignature, [this](asIScriptContext* context) { LineCallback(context); });
 
-    int result = m_context->Execute();
-    if (result != asEXECUTION_FINISHED)
+    profiler::Tracer* tracer = m_engine->m_tracer;
+    if (tracer) tracer->Begin(m_context, m_instanceName);
+
+    // Captured up front, an aborted context no longer reports it
+    const asIScriptFunction* function = m_context->GetFunction(0);
+
+    int result = m_engine->Execute(m_context);
+
+    if (tracer) tracer->End(ToTraceStatus(result));
+
+    if (profiler::MetricsRegistry* metrics = m_engine->m_metrics)
     {
-        if (result == asEXECUTION_EXCEPTION)
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime);
+        metrics->Record(function, m_instanceName, static_cast<uint64_t>(elapsed.count()), ToTraceStatus(result));
+    }
+
+    if (result == asEXECUTION_EXCEPTION)
+    {
+        if (m_instanceName.empty())
+        {
+            m_engine->LogException(m_context, fmt::format("while calling function {}", m_functionSignature));
+        }
+        else
         {
-            const char* exceptionString = m_context->GetExceptionString();
-            const char* sectionName;
-            int columnNumber = 0;
-            int lineNumber = m_context->GetExceptionLineNumber(&columnNumber, &sectionName);
-
-            if (m_instanceName.empty())
-            {
-                Log::Error("Exception '{}' in {}:{},{} while calling function {}.",
-                           exceptionString,
-                           sectionName,
-                           lineNumber,
-                           columnNumber,
-                           m_functionSignature);
-            }
-            else
-            {
-                Log::Error("Exception '{}' in {}:{},{} while calling method {}::{}.",
-                           exceptionString,
-                           sectionName,
-                           lineNumber,
-                           columnNumber,
-                           m_instanceName,
-                           m_functionSignature);
-            }
+            m_engine->LogException(m_context,
+                                   fmt::format("while calling method {}::{}", m_instanceName, m_functionSignature));
         }
     }
+    else if (m_timedOut)
+    {
+        m_engine->TimedOut();
+    }
 
     m_executionFinished = true;
 
-    FunctionResult res = {};
-    if (type == ReturnType::Object)
-    {
-        // Note(Seb): Calling AddRef here makes the pointer valid after the release of the context. It is a bit dangerous, but I
-        // keep the Release up to the user of this function.
-        asIScriptObject* obj = *static_cast<asIScriptObject**>(m_context->GetAddressOfReturnValue());
-        obj->AddRef();
-        res.value = obj;
-    }
+    return result;
+}
 
-    Cleanup();
+void srph::FunctionCaller::SetArgObject(void* object)
+{
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
+    m_context->SetArgObject(m_argIdx++, object);
+}
 
-    return res;
+srph::profiler::TraceStatus srph::FunctionCaller::ToTraceStatus(int result) const
+{
+    switch (result)
+    {
+        case asEXECUTION_FINISHED:
+            return profiler::TraceStatus::Finished;
+        case asEXECUTION_EXCEPTION:
+            return profiler::TraceStatus::Exception;
+        case asEXECUTION_SUSPENDED:
+            return profiler::TraceStatus::Suspended;
+        default:
+            return m_timedOut ? profiler::TraceStatus::Timeout : profiler::TraceStatus::Aborted;
+    }
 }
 
 asIScriptContext* srph::FunctionCaller::GetContext() const { return m_context; }
 
 void srph::FunctionCaller::LineCallback(asIScriptContext* context)
 {
-    if (m_executionFinished) return;
+    if (m_executionFinished || m_timedOut) return;
 
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_startTime).count();
-    if (elapsed > m_timeoutMillis)
+    if (m_engine->AbortOnTimeout(context, m_startTime, "Function"))
     {
-        Log::Info("Function {} timed out!", m_functionSignature);
-        context->Abort();
-        context->Unprepare();
-        if (m_engine->m_timeoutCallback)
-        {
-            m_engine->m_timeoutCallback();
-        }
+        m_timedOut = true;
     }
 }
 
@@ -0,0 +1,491 @@
+#include "srph_common.hpp"
+#include "jit/aot.hpp"
+#include "jit/jit_compiler.hpp"
+
+#include <climits>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+// Suspending changes the context's state and the public interface can't list the script functions, only
+// the engine's own headers describe them.
+#include "angelscript/source/as_context.h"
+#include "angelscript/source/as_scriptengine.h"
+
+namespace
+{
+struct Instruction
+{
+    asEBCInstr op;
+    asUINT position;
+    const asDWORD* ip;
+};
+
+// Module and declaration -> registered functions, several when declarations repeat (lambdas)
+std::unordered_multimap<std::string, const srph::jit::AotFunction*>& Registry()
+{
+    static std::unordered_multimap<std::string, const srph::jit::AotFunction*> registry;
+    return registry;
+}
+
+std::string Key(const char* module, const char* declaration) { return fmt::format("{}\n{}", module, declaration); }
+
+std::string Declaration(asIScriptFunction* function) { return function->GetDeclaration(true, true, false); }
+
+asUINT InstructionSize(asEBCInstr op) { return asBCTypeSize[asBCInfo[op].type]; }
+
+std::vector<Instruction> Decode(asIScriptFunction* function)
+{
+    std::vector<Instruction> instructions;
+
+    asUINT length = 0;
+    const asDWORD* byteCode = function->GetByteCode(&length);
+    for (asUINT position = 0; byteCode && position < length;)
+    {
+        const auto op = static_cast<asEBCInstr>(*reinterpret_cast<const asBYTE*>(byteCode + position));
+        instructions.push_back({op, position, byteCode + position});
+        position += InstructionSize(op);
+    }
+
+    return instructions;
+}
+
+bool IsJump(asEBCInstr op)
+{
+    switch (op)
+    {
+    case asBC_JMP:
+    case asBC_JZ:
+    case asBC_JNZ:
+    case asBC_JS:
+    case asBC_JNS:
+    case asBC_JP:
+    case asBC_JNP:
+    case asBC_JLowZ:
+    case asBC_JLowNZ: return true;
+    default: return false;
+    }
+}
+
+std::string Int(int32_t value) { return value == INT32_MIN ? "(-2147483647 - 1)" : std::to_string(value); }
+
+// C++ statement of the instruction, empty when the interpreter runs it. Mirrors the interpreter, with unsigned
+// arithmetic where signed overflow would be undefined and shift counts masked like the hardware does.
+std::string Translate(const Instruction& instruction, asUINT length)
+{
+    const asDWORD* ip = instruction.ip;
+    const bool wide = InstructionSize(instruction.op) > 1;
+    const int a0 = asBC_SWORDARG0(ip);
+    const int a1 = wide ? asBC_SWORDARG1(ip) : 0;
+    const int a2 = wide ? asBC_SWORDARG2(ip) : 0;
+    const asDWORD dword = wide ? asBC_DWORDARG(ip) : 0;
+
+    auto var = [](const char* type, int offset) { return fmt::format("Var<{}>(frame, {})", type, offset); };
+    auto binary = [&](const char* type, const char* op) { return fmt::format("{} = {} {} {};", var(type, a0), var(type, a1), op, var(type, a2)); };
+    auto shift = [&](const char* type, const char* op, int mask)
+    { return fmt::format("{} = {} {} ({} & {});", var(type, a0), var(type, a1), op, var("asDWORD", a2), mask); };
+    auto convert = [&](const char* to, const char* expression, const char* from, int source)
+    { return fmt::format("{} = {}({});", var(to, a0), expression, var(from, source)); };
+    // The interpreter raises the exception
+    auto guard = [&](const std::string& condition) { return fmt::format("if ({}) return Leave(registers, byteCode + {});\n    ", condition, instruction.position); };
+    auto divide = [&](const char* type, const char* op, const char* minimum)
+    {
+        std::string check = fmt::format("{} == 0", var(type, a2));
+        if (minimum) check += fmt::format(" || ({} == -1 && {} == {})", var(type, a2), var(type, a1), minimum);
+        return guard(check) + binary(type, op);
+    };
+    auto compare = [&](const char* type, const std::string& right) { return fmt::format("Value<int>(registers) = Compare<{}>({}, {});", type, var(type, a0), right); };
+    auto test = [](const char* condition) { return fmt::format("Value<asQWORD>(registers) = Value<int>(registers) {} ? 1 : 0;", condition); };
+    auto jump = [&](const char* condition) -> std::string
+    {
+        const asUINT target = instruction.position + 2 + asBC_INTARG(ip);
+        if (target >= length) return "";
+        if (!condition) return fmt::format("goto i{};", target);
+        return fmt::format("if ({}) goto i{};", condition, target);
+    };
+
+    switch (instruction.op)
+    {
+    case asBC_SetV1:
+    case asBC_SetV2:
+    case asBC_SetV4: return fmt::format("{} = {:#x}u;", var("asDWORD", a0), dword);
+    case asBC_SetV8: return fmt::format("{} = {:#x}ull;", var("asQWORD", a0), asBC_QWORDARG(ip));
+    case asBC_CpyVtoV4: return fmt::format("{} = {};", var("asDWORD", a0), var("asDWORD", a1));
+    case asBC_CpyVtoV8: return fmt::format("{} = {};", var("asQWORD", a0), var("asQWORD", a1));
+    case asBC_CpyVtoR4: return fmt::format("Value<asDWORD>(registers) = {};", var("asDWORD", a0));
+    case asBC_CpyVtoR8: return fmt::format("Value<asQWORD>(registers) = {};", var("asQWORD", a0));
+    case asBC_CpyRtoV4: return fmt::format("{} = Value<asDWORD>(registers);", var("asDWORD", a0));
+    case asBC_CpyRtoV8: return fmt::format("{} = Value<asQWORD>(registers);", var("asQWORD", a0));
+    case asBC_ClrHi: return "Value<asDWORD>(registers) &= 0xFFu;";
+    case asBC_LDV: return fmt::format("Value<asDWORD*>(registers) = frame - {};", a0);
+
+    case asBC_INCi: return "++Deref<asDWORD>(registers);";
+    case asBC_DECi: return "--Deref<asDWORD>(registers);";
+    case asBC_INCi8: return "++Deref<asBYTE>(registers);";
+    case asBC_DECi8: return "--Deref<asBYTE>(registers);";
+    case asBC_INCi16: return "++Deref<asWORD>(registers);";
+    case asBC_DECi16: return "--Deref<asWORD>(registers);";
+    case asBC_INCi64: return "++Deref<asQWORD>(registers);";
+    case asBC_DECi64: return "--Deref<asQWORD>(registers);";
+    case asBC_INCf: return "++Deref<float>(registers);";
+    case asBC_DECf: return "--Deref<float>(registers);";
+    case asBC_INCd: return "++Deref<double>(registers);";
+    case asBC_DECd: return "--Deref<double>(registers);";
+    case asBC_IncVi: return fmt::format("++{};", var("asDWORD", a0));
+    case asBC_DecVi: return fmt::format("--{};", var("asDWORD", a0));
+
+    case asBC_ADDi: return binary("asDWORD", "+");
+    case asBC_SUBi: return binary("asDWORD", "-");
+    case asBC_MULi: return binary("asDWORD", "*");
+    case asBC_DIVi: return divide("int", "/", "INT32_MIN");
+    case asBC_MODi: return divide("int", "%", "INT32_MIN");
+    case asBC_DIVu: return divide("asDWORD", "/", nullptr);
+    case asBC_MODu: return divide("asDWORD", "%", nullptr);
+    case asBC_BAND: return binary("asDWORD", "&");
+    case asBC_BOR: return binary("asDWORD", "|");
+    case asBC_BXOR: return binary("asDWORD", "^");
+    case asBC_BSLL: return shift("asDWORD", "<<", 31);
+    case asBC_BSRL: return shift("asDWORD", ">>", 31);
+    case asBC_BSRA: return shift("int", ">>", 31);
+    case asBC_NEGi: return fmt::format("{0} = 0u - {0};", var("asDWORD", a0));
+    case asBC_BNOT: return fmt::format("{0} = ~{0};", var("asDWORD", a0));
+    case asBC_ADDIi: return fmt::format("{} = {} + {:#x}u;", var("asDWORD", a0), var("asDWORD", a1), ip[2]);
+    case asBC_SUBIi: return fmt::format("{} = {} - {:#x}u;", var("asDWORD", a0), var("asDWORD", a1), ip[2]);
+    case asBC_MULIi: return fmt::format("{} = {} * {:#x}u;", var("asDWORD", a0), var("asDWORD", a1), ip[2]);
+
+    case asBC_ADDi64: return binary("asQWORD", "+");
+    case asBC_SUBi64: return binary("asQWORD", "-");
+    case asBC_MULi64: return binary("asQWORD", "*");
+    case asBC_DIVi64: return divide("asINT64", "/", "INT64_MIN");
+    case asBC_MODi64: return divide("asINT64", "%", "INT64_MIN");
+    case asBC_DIVu64: return divide("asQWORD", "/", nullptr);
+    case asBC_MODu64: return divide("asQWORD", "%", nullptr);
+    case asBC_BAND64: return binary("asQWORD", "&");
+    case asBC_BOR64: return binary("asQWORD", "|");
+    case asBC_BXOR64: return binary("asQWORD", "^");
+    case asBC_BSLL64: return shift("asQWORD", "<<", 63);
+    case asBC_BSRL64: return shift("asQWORD", ">>", 63);
+    case asBC_BSRA64: return shift("asINT64", ">>", 63);
+    case asBC_NEGi64: return fmt::format("{0} = 0ull - {0};", var("asQWORD", a0));
+    case asBC_BNOT64: return fmt::format("{0} = ~{0};", var("asQWORD", a0));
+
+    case asBC_ADDf: return binary("float", "+");
+    case asBC_SUBf: return binary("float", "-");
+    case asBC_MULf: return binary("float", "*");
+    case asBC_DIVf: return guard(var("float", a2) + " == 0") + binary("float", "/");
+    case asBC_MODf:
+        return guard(var("float", a2) + " == 0") + fmt::format("{} = std::fmod({}, {});", var("float", a0), var("float", a1), var("float", a2));
+    case asBC_ADDd: return binary("double", "+");
+    case asBC_SUBd: return binary("double", "-");
+    case asBC_MULd: return binary("double", "*");
+    case asBC_DIVd: return guard(var("double", a2) + " == 0") + binary("double", "/");
+    case asBC_MODd:
+        return guard(var("double", a2) + " == 0") + fmt::format("{} = std::fmod({}, {});", var("double", a0), var("double", a1), var("double", a2));
+    case asBC_ADDIf: return fmt::format("{} = {} + AsFloat({:#x}u);", var("float", a0), var("float", a1), ip[2]);
+    case asBC_SUBIf: return fmt::format("{} = {} - AsFloat({:#x}u);", var("float", a0), var("float", a1), ip[2]);
+    case asBC_MULIf: return fmt::format("{} = {} * AsFloat({:#x}u);", var("float", a0), var("float", a1), ip[2]);
+    case asBC_NEGf: return fmt::format("{0} = -{0};", var("float", a0));
+    case asBC_NEGd: return fmt::format("{0} = -{0};", var("double", a0));
+
+    // Some conversions are in place and some are not, exactly like the interpreter.
+    case asBC_iTOf: return convert("float", "float", "int", a0);
+    case asBC_uTOf: return convert("float", "float", "asDWORD", a0);
+    case asBC_fTOi: return convert("int", "int", "float", a0);
+    case asBC_fTOu: return fmt::format("{} = asDWORD(int({}));", var("asDWORD", a0), var("float", a0));
+    case asBC_iTOd: return convert("double", "double", "int", a1);
+    case asBC_uTOd: return convert("double", "double", "asDWORD", a1);
+    case asBC_dTOi: return convert("int", "int", "double", a1);
+    case asBC_dTOu: return fmt::format("{} = asDWORD(int({}));", var("asDWORD", a0), var("double", a1));
+    case asBC_fTOd: return convert("double", "double", "float", a1);
+    case asBC_dTOf: return convert("float", "float", "double", a1);
+    case asBC_sbTOi: return convert("int", "int", "signed char", a0);
+    case asBC_swTOi: return convert("int", "int", "short", a0);
+    case asBC_ubTOi: return convert("asDWORD", "asDWORD", "asBYTE", a0);
+    case asBC_uwTOi: return convert("asDWORD", "asDWORD", "asWORD", a0);
+    case asBC_iTOb: return fmt::format("{} &= 0xFFu;", var("asDWORD", a0));
+    case asBC_iTOw: return fmt::format("{} &= 0xFFFFu;", var("asDWORD", a0));
+    case asBC_iTOi64: return convert("asINT64", "asINT64", "int", a1);
+    case asBC_uTOi64: return convert("asINT64", "asINT64", "asDWORD", a1);
+    case asBC_i64TOi: return convert("asDWORD", "asDWORD", "asQWORD", a1);
+    case asBC_fTOi64: return convert("asINT64", "asINT64", "float", a1);
+    case asBC_dTOi64: return convert("asINT64", "asINT64", "double", a0);
+    case asBC_fTOu64: return fmt::format("{} = asQWORD(asINT64({}));", var("asQWORD", a0), var("float", a1));
+    case asBC_dTOu64: return fmt::format("{} = asQWORD(asINT64({}));", var("asQWORD", a0), var("double", a0));
+    case asBC_i64TOf: return convert("float", "float", "asINT64", a1);
+    case asBC_u64TOf: return convert("float", "float", "asQWORD", a1);
+    case asBC_i64TOd: return convert("double", "double", "asINT64", a0);
+    case asBC_u64TOd: return convert("double", "double", "asQWORD", a0);
+
+    case asBC_CMPi: return compare("int", var("int", a1));
+    case asBC_CMPu: return compare("asDWORD", var("asDWORD", a1));
+    case asBC_CMPi64: return compare("asINT64", var("asINT64", a1));
+    case asBC_CMPu64: return compare("asQWORD", var("asQWORD", a1));
+    case asBC_CMPf: return compare("float", var("float", a1));
+    case asBC_CMPd: return compare("double", var("double", a1));
+    case asBC_CMPIi: return compare("int", Int(static_cast<int32_t>(dword)));
+    case asBC_CMPIu: return compare("asDWORD", fmt::format("{:#x}u", dword));
+    case asBC_CMPIf: return compare("float", fmt::format("AsFloat({:#x}u)", dword));
+
+    case asBC_TZ: return test("== 0");
+    case asBC_TNZ: return test("!= 0");
+    case asBC_TS: return test("< 0");
+    case asBC_TNS: return test(">= 0");
+    case asBC_TP: return test("> 0");
+    case asBC_TNP: return test("<= 0");
+
+    case asBC_JMP: return jump(nullptr);
+    case asBC_JZ: return jump("Value<int>(registers) == 0");
+    case asBC_JNZ: return jump("Value<int>(registers) != 0");
+    case asBC_JS: return jump("Value<int>(registers) < 0");
+    case asBC_JNS: return jump("Value<int>(registers) >= 0");
+    case asBC_JP: return jump("Value<int>(registers) > 0");
+    case asBC_JNP: return jump("Value<int>(registers) <= 0");
+    case asBC_JLowZ: return jump("Value<asBYTE>(registers) == 0");
+    case asBC_JLowNZ: return jump("Value<asBYTE>(registers) != 0");
+
+    case asBC_RDR1: return fmt::format("{} = Deref<asBYTE>(registers);", var("asDWORD", a0));
+    case asBC_RDR2: return fmt::format("{} = Deref<asWORD>(registers);", var("asDWORD", a0));
+    case asBC_RDR4: return fmt::format("{} = Deref<asDWORD>(registers);", var("asDWORD", a0));
+    case asBC_RDR8: return fmt::format("{} = Deref<asQWORD>(registers);", var("asQWORD", a0));
+    case asBC_WRTV1: return fmt::format("Deref<asBYTE>(registers) = {};", var("asBYTE", a0));
+    case asBC_WRTV2: return fmt::format("Deref<asWORD>(registers) = {};", var("asWORD", a0));
+    case asBC_WRTV4: return fmt::format("Deref<asDWORD>(registers) = {};", var("asDWORD", a0));
+    case asBC_WRTV8: return fmt::format("Deref<asQWORD>(registers) = {};", var("asQWORD", a0));
+    case asBC_PshC4: return fmt::format("Push<asDWORD>(registers, {:#x}u);", dword);
+    case asBC_PshV4: return fmt::format("Push<asDWORD>(registers, {});", var("asDWORD", a0));
+    case asBC_PshC8: return fmt::format("Push<asQWORD>(registers, {:#x}ull);", asBC_QWORDARG(ip));
+    case asBC_PshV8: return fmt::format("Push<asQWORD>(registers, {});", var("asQWORD", a0));
+
+    default: return "";
+    }
+}
+
+uint64_t Fnv(uint64_t hash, const void* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string Escape(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Body of the generated function, empty when nothing in the function is translated
+std::string GenerateFunction(asIScriptFunction* function, const std::string& name)
+{
+    asUINT length = 0;
+    function->GetByteCode(&length);
+    const std::vector<Instruction> instructions = Decode(function);
+
+    std::vector<std::string> statements;
+    std::vector<bool> labels(length, false);
+    size_t translated = 0;
+
+    for (const Instruction& instruction : instructions)
+    {
+        std::string statement;
+        if (instruction.op == asBC_JitEntry)
+        {
+            labels[instruction.position] = true;
+        }
+        else if (instruction.op == asBC_SUSPEND)
+        {
+            statement = fmt::format("if (registers->doProcessSuspend) {{ Leave(registers, byteCode + {}); if (Suspend(registers)) return; }}",
+                                    instruction.position);
+        }
+        else
+        {
+            statement = Translate(instruction, length);
+            if (statement.empty())
+            {
+                statement = fmt::format("return Leave(registers, byteCode + {});", instruction.position);
+            }
+            else
+            {
+                translated++;
+                if (IsJump(instruction.op)) labels[instruction.position + 2 + asBC_INTARG(instruction.ip)] = true;
+            }
+        }
+        statements.push_back(std::move(statement));
+    }
+
+    if (translated == 0) return "";
+
+    std::string body = fmt::format("// {}\nvoid {}(asSVMRegisters* registers, asPWORD entry)\n{{\n", Declaration(function), name);
+    body += "    asDWORD* const byteCode = registers->programPointer - (entry - 1);\n";
+    body += "    asDWORD* const frame = registers->stackFramePointer;\n\n";
+    body += "    switch (entry)\n    {\n";
+    for (const Instruction& instruction : instructions)
+    {
+        if (instruction.op == asBC_JitEntry) body += fmt::format("    case {}: goto i{};\n", instruction.position + 1, instruction.position);
+    }
+    body += "    default: return;\n    }\n\n";
+
+    for (size_t i = 0; i < instructions.size(); i++)
+    {
+        if (labels[instructions[i].position]) body += fmt::format("i{}:\n", instructions[i].position);
+        if (!statements[i].empty()) body += fmt::format("    {}\n", statements[i]);
+    }
+
+    // Every function ends with RET, which the interpreter runs.
+    body += "}\n";
+    return body;
+}
+}  // namespace
+
+srph::jit::AotRegistration::AotRegistration(const AotFunction* functions, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        Registry().emplace(Key(functions[i].module, functions[i].declaration), &functions[i]);
+    }
+}
+
+srph::jit::AotLinker::AotLinker(JitCompiler* jit) { m_jit = jit; }
+
+void srph::jit::AotLinker::NewFunction(asIScriptFunction* function)
+{
+    asUINT length = 0;
+    asDWORD* byteCode = function->GetByteCode(&length);
+    if (!byteCode) return;
+
+    m_stats.functions++;
+
+    const char* module = function->GetModuleName();
+    auto [begin, end] = Registry().equal_range(Key(module ? module : "", Declaration(function).c_str()));
+
+    const AotFunction* match = nullptr;
+    if (begin != end)
+    {
+        const uint64_t hash = Hash(function);
+        for (auto it = begin; it != end && !match; ++it)
+        {
+            if (it->second->hash == hash) match = it->second;
+        }
+
+        if (!match)
+        {
+            SRPH_LOG_WARN("Native code of {} was generated from other scripts, it runs from its bytecode.", Declaration(function));
+            m_stats.stale++;
+        }
+    }
+
+    if (!match)
+    {
+        if (m_jit) m_jit->NewFunction(function);
+        return;
+    }
+
+    // The entry tells the native code where it resumes
+    for (const Instruction& instruction : Decode(function))
+    {
+        if (instruction.op == asBC_JitEntry)
+        {
+            *reinterpret_cast<asPWORD*>(byteCode + instruction.position + 1) = instruction.position + 1;
+        }
+    }
+
+    function->SetJITFunction(match->function);
+    m_bound.insert(function);
+    m_stats.bound++;
+}
+
+void srph::jit::AotLinker::CleanFunction(asIScriptFunction* function, asJITFunction jitFunction)
+{
+    if (m_bound.erase(function) == 0 && m_jit)
+    {
+        m_jit->CleanFunction(function, jitFunction);
+    }
+}
+
+bool srph::jit::AotLinker::Generate(asIScriptModule* module, const std::string& path) const
+{
+    // Includes methods, constructors and lambdas, in id order so the same scripts give the same output.
+    auto* engine = static_cast<asCScriptEngine*>(module->GetEngine());
+    std::vector<asIScriptFunction*> functions;
+    for (asUINT id = 0; id < engine->scriptFunctions.GetLength(); id++)
+    {
+        asIScriptFunction* function = engine->scriptFunctions[id];
+        if (function && function->GetModule() == module && function->GetByteCode()) functions.push_back(function);
+    }
+
+    std::string source = fmt::format("// Generated by Seraph from module {}, do not edit.\n", module->GetName());
+    source += "#include \"jit/aot.hpp\"\n\n#include <cstdint>\n\nnamespace\n{\nusing namespace srph::jit::aot;\n\n";
+
+    std::string table;
+    uint32_t count = 0;
+    for (asIScriptFunction* function : functions)
+    {
+        const std::string name = fmt::format("Aot{}", count);
+        const std::string body = GenerateFunction(function, name);
+        if (body.empty()) continue;
+
+        source += body + "\n";
+        table += fmt::format("    {{\"{}\", \"{}\", {:#x}ull, {}}},\n", Escape(module->GetName()), Escape(Declaration(function)), Hash(function), name);
+        count++;
+    }
+
+    if (count == 0)
+    {
+        source += "}  // namespace\n";
+    }
+    else
+    {
+        source += "const srph::jit::AotFunction FUNCTIONS[] = {\n" + table + "};\n\n";
+        source += "const srph::jit::AotRegistration REGISTRATION(FUNCTIONS, sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]));\n";
+        source += "}  // namespace\n";
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        SRPH_LOG_ERROR("Failed to write the native code of module {} to {}.", module->GetName(), path);
+        return false;
+    }
+
+    file << source;
+    SRPH_LOG_INFO("Wrote the native code of {} functions of module {} to {}.", count, module->GetName(), path);
+    return true;
+}
+
+uint64_t srph::jit::AotLinker::Hash(asIScriptFunction* function)
+{
+    asUINT length = 0;
+    function->GetByteCode(&length);
+
+    uint64_t hash = Fnv(14695981039346656037ull, &length, sizeof(length));
+    for (const Instruction& instruction : Decode(function))
+    {
+        hash = Fnv(hash, &instruction.op, sizeof(instruction.op));
+
+        // Arguments of the other instructions hold pointers and ids that differ between runs, they run from
+        // the bytecode anyway.
+        if (!Translate(instruction, length).empty())
+        {
+            hash = Fnv(hash, instruction.ip, InstructionSize(instruction.op) * sizeof(asDWORD));
+        }
+    }
+
+    return hash;
+}
+
+bool srph::jit::aot::Suspend(asSVMRegisters* registers)
+{
+    auto* context = static_cast<asCContext*>(registers->ctx);
+    if (context->m_lineCallback) context->CallLineCallback();
+    if (!context->m_doSuspend) return false;
+
+    registers->programPointer++;
+    context->m_status = asEXECUTION_SUSPENDED;
+    return true;
+}
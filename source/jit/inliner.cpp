@@ -0,0 +1,510 @@
+#include "srph_common.hpp"
+#include "jit/inliner.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+// Rewrites the bytecode of the module's functions and resolves virtual calls, which the public interface
+// doesn't expose.
+#include "angelscript/source/as_objecttype.h"
+#include "angelscript/source/as_scriptengine.h"
+#include "angelscript/source/as_scriptfunction.h"
+
+namespace
+{
+// Body of a getter (read) or setter (write): the property at `offset` of objects of `typeId`, through RDRn or WRTVn
+struct Accessor
+{
+    bool write = false;
+    asEBCInstr access = asBC_RDR4;
+    short offset = 0;
+    int typeId = 0;
+};
+
+// Body of a leaf function: straight-line arithmetic on the parameters and constants that only writes `temporary`,
+// then CpyVtoRn of `returned`. `parameters` holds the offset of each parameter.
+struct Leaf
+{
+    std::vector<const asDWORD*> body;
+    asEBCInstr result = asBC_CpyVtoR4;
+    short returned = 0;
+    short temporary = 0;
+    std::vector<short> parameters;
+};
+
+// Superinstructions keep the replaced opcode in asBCInfo, every other entry maps to itself
+asEBCInstr Op(const asDWORD* instruction) { return asEBCInstr(asBCInfo[*(const asBYTE*)instruction].bc); }
+
+asUINT Size(const asDWORD* instruction) { return asBCTypeSize[asBCInfo[*(const asBYTE*)instruction].type]; }
+
+std::vector<asUINT> Positions(const asDWORD* byteCode, asUINT length)
+{
+    std::vector<asUINT> positions;
+    for (asUINT position = 0; position < length; position += Size(byteCode + position)) positions.push_back(position);
+    return positions;
+}
+
+bool Primitive(const asCDataType& type, asUINT bytes)
+{
+    return type.IsPrimitive() && !type.IsReference() && type.GetSizeInMemoryBytes() == int(bytes);
+}
+
+// [SUSPEND] LoadThisR; RDRn tmp; CpyVtoRn tmp; [SUSPEND] RET   or   [SUSPEND] LoadThisR; WRTVn param; [SUSPEND] RET
+bool MatchAccessor(asCScriptFunction* function, Accessor& accessor)
+{
+    if (function->funcType != asFUNC_SCRIPT || !function->objectType || !function->scriptData) return false;
+
+    std::vector<const asDWORD*> body;
+    const asDWORD* byteCode = function->scriptData->byteCode.AddressOf();
+    for (asUINT position : Positions(byteCode, function->scriptData->byteCode.GetLength()))
+    {
+        if (Op(byteCode + position) != asBC_SUSPEND) body.push_back(byteCode + position);
+    }
+
+    if (body.size() < 3 || Op(body[0]) != asBC_LoadThisR || Op(body.back()) != asBC_RET) return false;
+    accessor.offset = asBC_SWORDARG0(body[0]);
+    accessor.typeId = asBC_INTARG(body[0]);
+
+    if (body.size() == 4 && function->parameterTypes.GetLength() == 0)
+    {
+        const asEBCInstr read = Op(body[1]);
+        const asEBCInstr copy = Op(body[2]);
+        const bool dword = read == asBC_RDR4 && copy == asBC_CpyVtoR4 && Primitive(function->returnType, 4);
+        const bool qword = read == asBC_RDR8 && copy == asBC_CpyVtoR8 && Primitive(function->returnType, 8);
+        accessor.write = false;
+        accessor.access = read;
+        return (dword || qword) && asBC_SWORDARG0(body[1]) == asBC_SWORDARG0(body[2]);
+    }
+
+    // The only parameter is the only variable below `this` at offset 0.
+    if (body.size() == 3 && function->parameterTypes.GetLength() == 1 && function->returnType.GetTokenType() == ttVoid)
+    {
+        const asEBCInstr write = Op(body[1]);
+        const bool dword = write == asBC_WRTV4 && Primitive(function->parameterTypes[0], 4);
+        const bool qword = write == asBC_WRTV8 && Primitive(function->parameterTypes[0], 8);
+        accessor.write = true;
+        accessor.access = write;
+        return (dword || qword) && asBC_SWORDARG0(body[1]) < 0;
+    }
+
+    return false;
+}
+
+// Virtual calls only bind to the method when no class can override it: final classes, or the module's own classes
+// when none of them replaces the method. Interfaces and inheritable shared classes can be implemented anywhere.
+asCScriptFunction* Resolve(asCScriptEngine* engine, asEBCInstr call, int functionId)
+{
+    if (functionId <= 0 || asUINT(functionId) >= engine->scriptFunctions.GetLength()) return nullptr;
+    asCScriptFunction* function = engine->scriptFunctions[functionId];
+    if (!function) return nullptr;
+    if (call == asBC_CALL) return function;
+    if (function->funcType != asFUNC_VIRTUAL || !function->objectType) return nullptr;
+
+    asCObjectType* type = function->objectType;
+    if (function->vfTableIdx < 0 || asUINT(function->vfTableIdx) >= type->virtualFunctionTable.GetLength()) return nullptr;
+    asCScriptFunction* target = type->virtualFunctionTable[function->vfTableIdx];
+    if (type->flags & asOBJ_NOINHERIT) return target;
+    if ((type->flags & asOBJ_SHARED) || !type->GetModule()) return nullptr;
+
+    asIScriptModule* module = type->GetModule();
+    for (asUINT i = 0; i < module->GetObjectTypeCount(); i++)
+    {
+        auto* derived = static_cast<asCObjectType*>(module->GetObjectTypeByIndex(i));
+        if (derived != type && derived->DerivesFrom(type) && derived->virtualFunctionTable[function->vfTableIdx] != target)
+        {
+            return nullptr;
+        }
+    }
+    return target;
+}
+
+std::unordered_set<asUINT> JumpTargets(asCScriptFunction* function, const std::vector<asUINT>& positions)
+{
+    std::unordered_set<asUINT> targets;
+    const asDWORD* byteCode = function->scriptData->byteCode.AddressOf();
+    for (asUINT position : positions)
+    {
+        const asEBCInstr op = Op(byteCode + position);
+        if (op == asBC_JMP || (op >= asBC_JZ && op <= asBC_JNP) || op == asBC_JLowZ || op == asBC_JLowNZ)
+        {
+            targets.insert(position + Size(byteCode + position) + asBC_INTARG(byteCode + position));
+        }
+    }
+    for (asUINT i = 0; i < function->scriptData->tryCatchInfo.GetLength(); i++)
+    {
+        targets.insert(function->scriptData->tryCatchInfo[i].catchPos);
+    }
+    for (asUINT i = 0; i < function->scriptData->objVariableInfo.GetLength(); i++)
+    {
+        targets.insert(function->scriptData->objVariableInfo[i].programPos);
+    }
+    return targets;
+}
+
+// Writes the property access over the call sequence at `site`, `size` dwords long. The object comes from `object`,
+// the value goes to or from `value`. What the access doesn't use is jumped over.
+void Rewrite(asDWORD* site, asUINT size, short object, short value, const Accessor& accessor)
+{
+    for (asUINT i = 0; i < size; i++) site[i] = 0;
+
+    *(asBYTE*)site = asBC_LoadRObjR;
+    asBC_SWORDARG0(site) = object;
+    asBC_SWORDARG1(site) = accessor.offset;
+    *(int*)(site + 2) = accessor.typeId;
+
+    *(asBYTE*)(site + 3) = asBYTE(accessor.access);
+    asBC_SWORDARG0((site + 3)) = value;
+
+    if (size > 4)
+    {
+        *(asBYTE*)(site + 4) = asBC_JMP;
+        asBC_INTARG((site + 4)) = int(size - 6);
+        for (asUINT i = 6; i < size; i++) *(asBYTE*)(site + i) = asBC_SUSPEND;
+    }
+}
+
+// Tries the getter and setter call sequences starting at positions[index], moves `index` to the last instruction
+// of the sequence when it was replaced
+bool InlineSite(asCScriptEngine* engine,
+                asCScriptFunction* function,
+                const std::vector<asUINT>& positions,
+                size_t& index,
+                const std::unordered_set<asUINT>& targets)
+{
+    asDWORD* byteCode = function->scriptData->byteCode.AddressOf();
+    auto at = [&](size_t i) { return i < positions.size() ? byteCode + positions[i] : nullptr; };
+    auto op = [&](size_t i) { return i < positions.size() ? Op(at(i)) : asBC_MAXBYTECODE; };
+
+    // Setters push the value before the object
+    const bool setter = op(index) == asBC_PshV4 || op(index) == asBC_PshV8;
+    size_t i = setter ? index + 1 : index;
+    if (op(i) != asBC_PshVPtr) return false;
+    const short object = asBC_SWORDARG0(at(i));
+
+    // Handles the call could change are copied to a temporary first, the temporary stays null when inlined
+    asCObjectType* copied = nullptr;
+    if (op(i + 1) == asBC_RefCpyV)
+    {
+        copied = reinterpret_cast<asCObjectType*>(asBC_PTRARG(at(i + 1)));
+        i++;
+    }
+
+    const asEBCInstr call = op(i + 1);
+    if (call != asBC_CALL && call != asBC_CALLINTF) return false;
+    const int calledId = asBC_INTARG(at(i + 1));
+    i++;
+
+    Accessor accessor;
+    asCScriptFunction* target = Resolve(engine, call, calledId);
+    if (!target || !MatchAccessor(target, accessor) || accessor.write != setter) return false;
+
+    short value = 0;
+    if (setter)
+    {
+        value = asBC_SWORDARG0(at(index));
+        const bool dword = op(index) == asBC_PshV4 && accessor.access == asBC_WRTV4;
+        const bool qword = op(index) == asBC_PshV8 && accessor.access == asBC_WRTV8;
+        if (!dword && !qword) return false;
+    }
+    else
+    {
+        i++;
+        const bool dword = op(i) == asBC_CpyRtoV4 && accessor.access == asBC_RDR4;
+        const bool qword = op(i) == asBC_CpyRtoV8 && accessor.access == asBC_RDR8;
+        if (!dword && !qword) return false;
+        value = asBC_SWORDARG0(at(i));
+    }
+
+    for (size_t inner = index + 1; inner <= i; inner++)
+    {
+        if (targets.count(positions[inner])) return false;
+    }
+
+    const asUINT end = i + 1 < positions.size() ? positions[i + 1] : function->scriptData->byteCode.GetLength();
+    const asUINT size = end - positions[index];
+    if (size != 4 && size < 6) return false;
+
+    // The references the call and the handle copy held are released here, ReleaseReferences won't see
+    // them in the bytecode anymore.
+    Rewrite(at(index), size, object, value, accessor);
+    engine->scriptFunctions[calledId]->ReleaseInternal();
+    if (copied) copied->ReleaseInternal();
+    index = i;
+    return true;
+}
+
+// Bytes written by the instructions a leaf may contain, 0 for the others: whatever can throw (division, null
+// checks), branch, call or touch memory outside the function's variables.
+asUINT Written(asEBCInstr op)
+{
+    switch (op)
+    {
+    case asBC_ADDi: case asBC_SUBi: case asBC_MULi: case asBC_ADDf: case asBC_SUBf: case asBC_MULf:
+    case asBC_ADDIi: case asBC_SUBIi: case asBC_MULIi: case asBC_ADDIf: case asBC_SUBIf: case asBC_MULIf:
+    case asBC_BAND: case asBC_BOR: case asBC_BXOR: case asBC_BSLL: case asBC_BSRL: case asBC_BSRA: case asBC_BNOT:
+    case asBC_NEGi: case asBC_NEGf: case asBC_SetV4: case asBC_CpyVtoV4:
+    case asBC_iTOf: case asBC_fTOi: case asBC_uTOf: case asBC_fTOu: case asBC_dTOi: case asBC_dTOu: case asBC_dTOf:
+    case asBC_i64TOi: case asBC_i64TOf: case asBC_u64TOf:
+        return 4;
+    case asBC_ADDd: case asBC_SUBd: case asBC_MULd: case asBC_ADDi64: case asBC_SUBi64: case asBC_MULi64:
+    case asBC_BAND64: case asBC_BOR64: case asBC_BXOR64: case asBC_BSLL64: case asBC_BSRL64: case asBC_BSRA64:
+    case asBC_BNOT64: case asBC_NEGd: case asBC_NEGi64: case asBC_SetV8: case asBC_CpyVtoV8:
+    case asBC_iTOd: case asBC_uTOd: case asBC_fTOd: case asBC_uTOi64: case asBC_iTOi64: case asBC_fTOi64:
+    case asBC_dTOi64: case asBC_fTOu64: case asBC_dTOu64: case asBC_i64TOd: case asBC_u64TOd:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+// Variable operands of an instruction, the first one is written. rW_ARG instructions read it before.
+int Operands(asEBCInstr op)
+{
+    switch (asBCInfo[op].type)
+    {
+    case asBCTYPE_wW_rW_rW_ARG: return 3;
+    case asBCTYPE_wW_rW_DW_ARG: case asBCTYPE_wW_rW_ARG: return 2;
+    case asBCTYPE_wW_DW_ARG: case asBCTYPE_wW_QW_ARG: case asBCTYPE_rW_ARG: return 1;
+    default: return 0;
+    }
+}
+
+short& Variable(asDWORD* instruction, int operand) { return reinterpret_cast<short*>(instruction)[1 + operand]; }
+
+short Variable(const asDWORD* instruction, int operand)
+{
+    return reinterpret_cast<const short*>(instruction)[1 + operand];
+}
+
+// [SUSPEND] body; CpyVtoRn returned; [SUSPEND] RET, with primitive parameters and return value
+bool MatchLeaf(asCScriptFunction* function, Leaf& leaf)
+{
+    if (function->funcType != asFUNC_SCRIPT || !function->scriptData) return false;
+    if (function->scriptData->tryCatchInfo.GetLength() || function->scriptData->objVariableInfo.GetLength())
+    {
+        return false;
+    }
+
+    const asUINT bytes = Primitive(function->returnType, 4) ? 4 : Primitive(function->returnType, 8) ? 8 : 0;
+    if (bytes == 0) return false;
+
+    // Parameters are below `this`, the first one at the top
+    short offset = function->objectType ? -AS_PTR_SIZE : 0;
+    leaf.parameters.clear();
+    for (asUINT i = 0; i < function->parameterTypes.GetLength(); i++)
+    {
+        const asCDataType& type = function->parameterTypes[i];
+        if (!Primitive(type, 4) && !Primitive(type, 8)) return false;
+        leaf.parameters.push_back(offset);
+        offset -= short(type.GetSizeOnStackDWords());
+    }
+
+    leaf.body.clear();
+    const asDWORD* byteCode = function->scriptData->byteCode.AddressOf();
+    for (asUINT position : Positions(byteCode, function->scriptData->byteCode.GetLength()))
+    {
+        if (Op(byteCode + position) != asBC_SUSPEND) leaf.body.push_back(byteCode + position);
+    }
+
+    if (leaf.body.size() < 2 || Op(leaf.body.back()) != asBC_RET) return false;
+    leaf.result = Op(leaf.body[leaf.body.size() - 2]);
+    leaf.returned = asBC_SWORDARG0(leaf.body[leaf.body.size() - 2]);
+    if (leaf.result != (bytes == 4 ? asBC_CpyVtoR4 : asBC_CpyVtoR8)) return false;
+    leaf.body.resize(leaf.body.size() - 2);
+
+    auto parameter = [&](short variable)
+    { return std::find(leaf.parameters.begin(), leaf.parameters.end(), variable) != leaf.parameters.end(); };
+
+    leaf.temporary = 0;
+    for (const asDWORD* instruction : leaf.body)
+    {
+        const asEBCInstr op = Op(instruction);
+        const int operands = Operands(op);
+        if (Written(op) == 0 || Written(op) > bytes || operands == 0) return false;
+
+        for (int i = asBCInfo[op].type == asBCTYPE_rW_ARG ? 0 : 1; i < operands; i++)
+        {
+            const short read = Variable(instruction, i);
+            if (!parameter(read) && (leaf.temporary <= 0 || read != leaf.temporary)) return false;
+        }
+
+        const short written = Variable(instruction, 0);
+        if (written <= 0 || (leaf.temporary > 0 && written != leaf.temporary)) return false;
+        leaf.temporary = written;
+    }
+
+    // Either computed into the temporary or one of the parameters returned as is
+    if (leaf.body.empty()) return parameter(leaf.returned);
+    return leaf.returned == leaf.temporary;
+}
+
+// Appends an instruction of `dwords` dwords and returns it, valid until the next append
+asDWORD* Append(std::vector<asDWORD>& code, asEBCInstr op, asUINT dwords)
+{
+    code.insert(code.end(), dwords, 0);
+    asDWORD* instruction = code.data() + code.size() - dwords;
+    *(asBYTE*)instruction = asBYTE(op);
+    return instruction;
+}
+
+// Tries the call sequence of a leaf function starting at positions[index]: the arguments pushed from variables, the
+// object for methods, the call and the copy of the returned value. Moves `index` to the copy when it was replaced.
+bool InlineCall(asCScriptEngine* engine,
+                asCScriptFunction* function,
+                const std::vector<asUINT>& positions,
+                size_t& index,
+                const std::unordered_set<asUINT>& targets)
+{
+    asDWORD* byteCode = function->scriptData->byteCode.AddressOf();
+    auto at = [&](size_t i) { return i < positions.size() ? byteCode + positions[i] : nullptr; };
+    auto op = [&](size_t i) { return i < positions.size() ? Op(at(i)) : asBC_MAXBYTECODE; };
+
+    // Arguments are pushed from the last one
+    size_t i = index;
+    std::vector<short> arguments;
+    std::vector<short> sizes;
+    while (op(i) == asBC_PshV4 || op(i) == asBC_PshV8)
+    {
+        arguments.insert(arguments.begin(), asBC_SWORDARG0(at(i)));
+        sizes.insert(sizes.begin(), op(i) == asBC_PshV8 ? 2 : 1);
+        i++;
+    }
+
+    const bool method = op(i) == asBC_PshVPtr;
+    const short object = method ? asBC_SWORDARG0(at(i)) : 0;
+    asCObjectType* copied = nullptr;
+    if (method && op(i + 1) == asBC_RefCpyV)
+    {
+        copied = reinterpret_cast<asCObjectType*>(asBC_PTRARG(at(i + 1)));
+        i++;
+    }
+    if (method) i++;
+
+    const asEBCInstr call = op(i);
+    if (call != asBC_CALL && call != asBC_CALLINTF) return false;
+    const int calledId = asBC_INTARG(at(i));
+
+    Leaf leaf;
+    asCScriptFunction* target = Resolve(engine, call, calledId);
+    if (!target || (target->objectType != nullptr) != method || !MatchLeaf(target, leaf)) return false;
+    if (arguments.size() != leaf.parameters.size()) return false;
+    for (size_t p = 0; p < arguments.size(); p++)
+    {
+        if (sizes[p] != short(target->parameterTypes[p].GetSizeOnStackDWords())) return false;
+    }
+
+    i++;
+    if (op(i) != (leaf.result == asBC_CpyVtoR4 ? asBC_CpyRtoV4 : asBC_CpyRtoV8)) return false;
+    const short destination = asBC_SWORDARG0(at(i));
+    const short width = leaf.result == asBC_CpyVtoR4 ? 1 : 2;
+
+    for (size_t inner = index + 1; inner <= i; inner++)
+    {
+        if (targets.count(positions[inner])) return false;
+    }
+
+    // The temporary becomes the variable the caller copies the value to. An argument sharing it can only be read
+    // until the first write.
+    bool written = false;
+    auto map = [&](short variable, short& mapped)
+    {
+        if (leaf.temporary > 0 && variable == leaf.temporary)
+        {
+            mapped = destination;
+            return true;
+        }
+        for (size_t p = 0; p < leaf.parameters.size(); p++)
+        {
+            if (variable != leaf.parameters[p]) continue;
+            mapped = arguments[p];
+            const bool overlaps = mapped - sizes[p] < destination && destination - width < mapped;
+            return !(written && overlaps);
+        }
+        return false;
+    };
+
+    std::vector<asDWORD> code;
+    if (method) asBC_SWORDARG0(Append(code, asBC_ChkNullV, 1)) = object;
+    for (const asDWORD* source : leaf.body)
+    {
+        const asEBCInstr instructionOp = Op(source);
+        asDWORD* instruction = Append(code, instructionOp, Size(source));
+        for (asUINT d = 1; d < Size(source); d++) instruction[d] = source[d];
+        for (int operand = Operands(instructionOp) - 1; operand >= 0; operand--)
+        {
+            if (!map(Variable(source, operand), Variable(instruction, operand))) return false;
+        }
+        written = true;
+    }
+    if (leaf.body.empty())
+    {
+        asDWORD* copy = Append(code, leaf.result == asBC_CpyVtoR4 ? asBC_CpyVtoV4 : asBC_CpyVtoV8, 2);
+        asBC_SWORDARG0(copy) = destination;
+        if (!map(leaf.returned, asBC_SWORDARG1(copy))) return false;
+    }
+
+    // The value is also left in the register, like the call did
+    const asUINT end = i + 1 < positions.size() ? positions[i + 1] : function->scriptData->byteCode.GetLength();
+    const asUINT size = end - positions[index];
+    if (code.size() + 1 > size) return false;
+    const asUINT remaining = size - asUINT(code.size()) - 1;
+    if (remaining == 1) asBC_SWORDARG0(Append(code, leaf.result, 1)) = destination;
+    if (remaining >= 2)
+    {
+        asBC_INTARG(Append(code, asBC_JMP, 2)) = int(remaining - 2);
+        for (asUINT filler = 2; filler < remaining; filler++) Append(code, asBC_SUSPEND, 1);
+    }
+    asBC_SWORDARG0(Append(code, leaf.result, 1)) = destination;
+
+    std::copy(code.begin(), code.end(), at(index));
+    engine->scriptFunctions[calledId]->ReleaseInternal();
+    if (copied) copied->ReleaseInternal();
+    index = i;
+    return true;
+}
+}  // namespace
+
+srph::jit::InlineStats srph::jit::InlineAccessors(asIScriptModule* module)
+{
+    InlineStats stats;
+    auto* engine = static_cast<asCScriptEngine*>(module->GetEngine());
+    if (engine->GetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS))
+    {
+        SRPH_LOG_WARN("Calls in module {} are not inlined, it was built for native code.", module->GetName());
+        return stats;
+    }
+
+    for (asUINT id = 0; id < engine->scriptFunctions.GetLength(); id++)
+    {
+        asCScriptFunction* function = engine->scriptFunctions[id];
+        if (!function || function->GetModule() != module || !function->scriptData) continue;
+
+        // A superinstruction also executes the instruction after it, which may become part of a rewrite.
+        // They are split first and fused again afterwards.
+        asDWORD* byteCode = function->scriptData->byteCode.AddressOf();
+        const std::vector<asUINT> positions = Positions(byteCode, function->scriptData->byteCode.GetLength());
+        for (asUINT position : positions) *(asBYTE*)(byteCode + position) = asBYTE(Op(byteCode + position));
+
+        const std::unordered_set<asUINT> targets = JumpTargets(function, positions);
+        for (size_t index = 0; index < positions.size(); index++)
+        {
+            const asEBCInstr op = Op(byteCode + positions[index]);
+            if (op == asBC_CALL || op == asBC_CALLINTF) stats.calls++;
+            if (InlineSite(engine, function, positions, index, targets) ||
+                InlineCall(engine, function, positions, index, targets))
+            {
+                stats.calls++;
+                stats.inlined++;
+            }
+        }
+
+        if (engine->ep.superInstructions) function->FuseInstructions();
+    }
+
+    if (stats.inlined > 0)
+    {
+        SRPH_LOG_INFO("Inlined {} of {} calls in module {}.", stats.inlined, stats.calls, module->GetName());
+    }
+    return stats;
+}
@@ -0,0 +1,771 @@
+#include "srph_common.hpp"
+#include "jit/jit_compiler.hpp"
+#include "jit/aot.hpp"
+#include "jit/x64_assembler.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SRPH_JIT_X64 1
+#else
+#define SRPH_JIT_X64 0
+#endif
+
+namespace
+{
+using namespace srph::jit;
+
+#ifdef _WIN32
+constexpr Reg ARG0 = Reg::RCX;
+constexpr Reg ARG1 = Reg::RDX;
+#else
+constexpr Reg ARG0 = Reg::RDI;
+constexpr Reg ARG1 = Reg::RSI;
+#endif
+
+// Pinned while the native code runs: the VM registers and the stack frame of the function
+constexpr Reg REGISTERS = Reg::RBX;
+constexpr Reg FRAME = Reg::R12;
+
+constexpr Mem PROGRAM_POINTER{REGISTERS, offsetof(asSVMRegisters, programPointer)};
+constexpr Mem STACK_FRAME_POINTER{REGISTERS, offsetof(asSVMRegisters, stackFramePointer)};
+constexpr Mem VALUE_REGISTER{REGISTERS, offsetof(asSVMRegisters, valueRegister)};
+constexpr Mem PROCESS_SUSPEND{REGISTERS, offsetof(asSVMRegisters, doProcessSuspend)};
+
+constexpr uint32_t FLOAT_ONE = 0x3F800000;
+constexpr uint64_t DOUBLE_ONE = 0x3FF0000000000000;
+
+Mem Var(short offset) { return {FRAME, -4 * static_cast<int32_t>(offset)}; }
+Mem Deref(Reg reg) { return {reg, 0}; }
+
+uint32_t InstructionSize(asEBCInstr op) { return asBCTypeSize[asBCInfo[op].type]; }
+
+void* AllocateCode(const std::vector<uint8_t>& code)
+{
+#ifdef _WIN32
+    void* memory = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory) return nullptr;
+
+    std::memcpy(memory, code.data(), code.size());
+    DWORD previous = 0;
+    if (!VirtualProtect(memory, code.size(), PAGE_EXECUTE_READ, &previous))
+    {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return nullptr;
+    }
+    FlushInstructionCache(GetCurrentProcess(), memory, code.size());
+#else
+    void* memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(memory, code.size());
+        return nullptr;
+    }
+#endif
+    return memory;
+}
+
+void FreeCode(void* memory, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, size);
+#endif
+}
+
+// Translates the bytecode of one function. Every instruction gets a label, the ones without a translation store
+// their address as program pointer and leave.
+class Translator
+{
+public:
+    Translator(asDWORD* byteCode, asUINT length) : m_byteCode(byteCode), m_length(length), m_positions(length, NO_LABEL) {}
+
+    void Run()
+    {
+        for (asUINT position = 0; position < m_length; position += InstructionSize(Op(position)))
+        {
+            m_positions[position] = m_assembler.NewLabel();
+        }
+
+        m_exit = m_assembler.NewLabel();
+        m_leave = m_assembler.NewLabel();
+
+        // rsp is 16 byte aligned for the calls after the two pushes and 40 bytes, which include the
+        // shadow space of the Windows calling convention.
+        m_assembler.Push(REGISTERS);
+        m_assembler.Push(FRAME);
+        m_assembler.Alu64(Alu::SUB, Reg::RSP, 40);
+        m_assembler.Mov64(REGISTERS, ARG0);
+        m_assembler.Mov64(FRAME, STACK_FRAME_POINTER);
+        m_assembler.Jmp(ARG1);
+
+        for (asUINT position = 0; position < m_length; position += InstructionSize(Op(position)))
+        {
+            m_assembler.Bind(m_positions[position]);
+
+            const asEBCInstr op = Op(position);
+            if (op == asBC_JitEntry || op == asBC_SUSPEND)
+            {
+                if (op == asBC_SUSPEND) EmitSuspend(m_byteCode + position);
+                continue;
+            }
+
+            if (Emit(op, m_byteCode + position))
+            {
+                m_translated++;
+            }
+            else
+            {
+                EmitExit(m_byteCode + position);
+                m_fallbacks++;
+            }
+        }
+
+        for (const auto& [label, instruction] : m_stubs)
+        {
+            m_assembler.Bind(label);
+            EmitExit(instruction);
+        }
+
+        m_assembler.Bind(m_exit);
+        m_assembler.Mov64(PROGRAM_POINTER, Reg::RAX);
+        m_assembler.Bind(m_leave);
+        m_assembler.Alu64(Alu::ADD, Reg::RSP, 40);
+        m_assembler.Pop(FRAME);
+        m_assembler.Pop(REGISTERS);
+        m_assembler.Ret();
+    }
+
+    bool Finish() { return m_assembler.Finish(); }
+    const std::vector<uint8_t>& Code() const { return m_assembler.Code(); }
+    size_t Offset(asUINT position) const { return m_assembler.Offset(m_positions[position]); }
+    asEBCInstr Op(asUINT position) const { return static_cast<asEBCInstr>(*reinterpret_cast<const asBYTE*>(m_byteCode + position)); }
+
+    uint64_t Translated() const { return m_translated; }
+    uint64_t Fallbacks() const { return m_fallbacks; }
+
+private:
+    static constexpr Label NO_LABEL = UINT32_MAX;
+
+    bool Emit(asEBCInstr op, const asDWORD* ip);
+    void EmitSuspend(const asDWORD* ip);
+    void EmitExit(const asDWORD* ip);
+    bool EmitJump(const asDWORD* ip, Condition condition, bool lowByte);
+    void EmitCompare(Condition greater, Condition less);
+    void EmitFloatCompare(Precision precision);
+    void EmitTest(Condition condition);
+    // Label of a stub leaving at the instruction, for the cases the interpreter raises an exception for
+    Label Bailout(const asDWORD* ip);
+
+private:
+    X64Assembler m_assembler;
+    asDWORD* m_byteCode;
+    asUINT m_length;
+    std::vector<Label> m_positions;
+    std::vector<std::pair<Label, const asDWORD*>> m_stubs;
+    Label m_exit = 0;
+    Label m_leave = 0;
+    uint64_t m_translated = 0;
+    uint64_t m_fallbacks = 0;
+};
+
+bool Translator::Emit(asEBCInstr op, const asDWORD* ip)
+{
+    X64Assembler& a = m_assembler;
+
+    // The second and third argument are in the second DWORD, single DWORD instructions don't have one
+    const bool wide = InstructionSize(op) > 1;
+    const short arg0 = asBC_SWORDARG0(ip);
+    const short arg1 = wide ? asBC_SWORDARG1(ip) : 0;
+    const short arg2 = wide ? asBC_SWORDARG2(ip) : 0;
+
+    // dst = arg1 <op> arg2
+    auto binary32 = [&](Alu alu)
+    {
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Alu32(alu, Reg::RAX, Var(arg2));
+        a.Mov32(Var(arg0), Reg::RAX);
+    };
+    auto binary64 = [&](Alu alu)
+    {
+        a.Mov64(Reg::RAX, Var(arg1));
+        a.Alu64(alu, Reg::RAX, Var(arg2));
+        a.Mov64(Var(arg0), Reg::RAX);
+    };
+    auto shift32 = [&](Shift shift)
+    {
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Mov32(Reg::RCX, Var(arg2));
+        a.Shift32(shift, Reg::RAX);
+        a.Mov32(Var(arg0), Reg::RAX);
+    };
+    auto shift64 = [&](Shift shift)
+    {
+        a.Mov64(Reg::RAX, Var(arg1));
+        a.Mov32(Reg::RCX, Var(arg2));
+        a.Shift64(shift, Reg::RAX);
+        a.Mov64(Var(arg0), Reg::RAX);
+    };
+    auto arith = [&](SseOp sse, Precision precision)
+    {
+        a.Movs(precision, Xmm::XMM0, Var(arg1));
+        a.Arith(sse, precision, Xmm::XMM0, Var(arg2));
+        a.Movs(precision, Var(arg0), Xmm::XMM0);
+    };
+    auto arithImmediate = [&](SseOp sse)
+    {
+        a.Movs(Precision::Single, Xmm::XMM0, Var(arg1));
+        a.Mov32(Reg::RAX, static_cast<int32_t>(ip[2]));
+        a.Movd(Xmm::XMM1, Reg::RAX);
+        a.Arith(sse, Precision::Single, Xmm::XMM0, Xmm::XMM1);
+        a.Movs(Precision::Single, Var(arg0), Xmm::XMM0);
+    };
+    // Through the pointer LDV left in the value register
+    auto step = [&](Alu alu, bool quad)
+    {
+        a.Mov64(Reg::RAX, VALUE_REGISTER);
+        if (quad) a.Alu64(alu, Deref(Reg::RAX), 1);
+        else a.Alu32(alu, Deref(Reg::RAX), 1);
+    };
+    auto stepFloat = [&](SseOp sse, Precision precision)
+    {
+        a.Mov64(Reg::RAX, VALUE_REGISTER);
+        a.Movs(precision, Xmm::XMM0, Deref(Reg::RAX));
+        if (precision == Precision::Single)
+        {
+            a.Mov32(Reg::RCX, static_cast<int32_t>(FLOAT_ONE));
+            a.Movd(Xmm::XMM1, Reg::RCX);
+        }
+        else
+        {
+            a.Mov64(Reg::RCX, DOUBLE_ONE);
+            a.Movq(Xmm::XMM1, Reg::RCX);
+        }
+        a.Arith(sse, precision, Xmm::XMM0, Xmm::XMM1);
+        a.Movs(precision, Deref(Reg::RAX), Xmm::XMM0);
+    };
+    auto divide = [&](bool isSigned, bool remainder)
+    {
+        const Label bailout = Bailout(ip);
+        a.Mov32(Reg::RCX, Var(arg2));
+        a.Test32(Reg::RCX, Reg::RCX);
+        a.Jcc(Condition::E, bailout);
+        if (isSigned)
+        {
+            // INT_MIN / -1 overflows, the interpreter raises the exception
+            const Label safe = a.NewLabel();
+            a.Alu32(Alu::CMP, Reg::RCX, -1);
+            a.Jcc(Condition::NE, safe);
+            a.Alu32(Alu::CMP, Var(arg1), INT32_MIN);
+            a.Jcc(Condition::E, bailout);
+            a.Bind(safe);
+            a.Mov32(Reg::RAX, Var(arg1));
+            a.Cdq();
+            a.Idiv32(Reg::RCX);
+        }
+        else
+        {
+            a.Mov32(Reg::RAX, Var(arg1));
+            a.Alu32(Alu::XOR, Reg::RDX, Reg::RDX);
+            a.Div32(Reg::RCX);
+        }
+        a.Mov32(Var(arg0), remainder ? Reg::RDX : Reg::RAX);
+    };
+
+    switch (op)
+    {
+    case asBC_SetV1:
+    case asBC_SetV2:
+    case asBC_SetV4: a.Mov32(Var(arg0), static_cast<int32_t>(asBC_DWORDARG(ip))); return true;
+    case asBC_SetV8:
+        a.Mov64(Reg::RAX, static_cast<uint64_t>(asBC_QWORDARG(ip)));
+        a.Mov64(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_CpyVtoV4:
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_CpyVtoV8:
+        a.Mov64(Reg::RAX, Var(arg1));
+        a.Mov64(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_CpyVtoR4:
+        a.Mov32(Reg::RAX, Var(arg0));
+        a.Mov32(VALUE_REGISTER, Reg::RAX);
+        return true;
+    case asBC_CpyVtoR8:
+        a.Mov64(Reg::RAX, Var(arg0));
+        a.Mov64(VALUE_REGISTER, Reg::RAX);
+        return true;
+    case asBC_CpyRtoV4:
+        a.Mov32(Reg::RAX, VALUE_REGISTER);
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_CpyRtoV8:
+        a.Mov64(Reg::RAX, VALUE_REGISTER);
+        a.Mov64(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_ClrHi: a.Alu32(Alu::AND, VALUE_REGISTER, 0xFF); return true;
+    case asBC_LDV:
+        a.Lea64(Reg::RAX, Var(arg0));
+        a.Mov64(VALUE_REGISTER, Reg::RAX);
+        return true;
+
+    case asBC_INCi: step(Alu::ADD, false); return true;
+    case asBC_DECi: step(Alu::SUB, false); return true;
+    case asBC_INCi64: step(Alu::ADD, true); return true;
+    case asBC_DECi64: step(Alu::SUB, true); return true;
+    case asBC_INCf: stepFloat(SseOp::ADD, Precision::Single); return true;
+    case asBC_DECf: stepFloat(SseOp::SUB, Precision::Single); return true;
+    case asBC_INCd: stepFloat(SseOp::ADD, Precision::Double); return true;
+    case asBC_DECd: stepFloat(SseOp::SUB, Precision::Double); return true;
+    case asBC_IncVi: a.Alu32(Alu::ADD, Var(arg0), 1); return true;
+    case asBC_DecVi: a.Alu32(Alu::SUB, Var(arg0), 1); return true;
+
+    case asBC_ADDi: binary32(Alu::ADD); return true;
+    case asBC_SUBi: binary32(Alu::SUB); return true;
+    case asBC_BAND: binary32(Alu::AND); return true;
+    case asBC_BOR: binary32(Alu::OR); return true;
+    case asBC_BXOR: binary32(Alu::XOR); return true;
+    case asBC_MULi:
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Imul32(Reg::RAX, Var(arg2));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_DIVi: divide(true, false); return true;
+    case asBC_MODi: divide(true, true); return true;
+    case asBC_DIVu: divide(false, false); return true;
+    case asBC_MODu: divide(false, true); return true;
+    case asBC_BSLL: shift32(Shift::SHL); return true;
+    case asBC_BSRL: shift32(Shift::SHR); return true;
+    case asBC_BSRA: shift32(Shift::SAR); return true;
+    case asBC_NEGi: a.Neg32(Var(arg0)); return true;
+    case asBC_BNOT: a.Not32(Var(arg0)); return true;
+    case asBC_ADDIi:
+    case asBC_SUBIi:
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Alu32(op == asBC_ADDIi ? Alu::ADD : Alu::SUB, Reg::RAX, static_cast<int32_t>(ip[2]));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_MULIi:
+        a.Mov32(Reg::RCX, Var(arg1));
+        a.Imul32(Reg::RAX, Reg::RCX, static_cast<int32_t>(ip[2]));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+
+    case asBC_ADDi64: binary64(Alu::ADD); return true;
+    case asBC_SUBi64: binary64(Alu::SUB); return true;
+    case asBC_BAND64: binary64(Alu::AND); return true;
+    case asBC_BOR64: binary64(Alu::OR); return true;
+    case asBC_BXOR64: binary64(Alu::XOR); return true;
+    case asBC_MULi64:
+        a.Mov64(Reg::RAX, Var(arg1));
+        a.Imul64(Reg::RAX, Var(arg2));
+        a.Mov64(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_BSLL64: shift64(Shift::SHL); return true;
+    case asBC_BSRL64: shift64(Shift::SHR); return true;
+    case asBC_BSRA64: shift64(Shift::SAR); return true;
+    case asBC_NEGi64: a.Neg64(Var(arg0)); return true;
+    case asBC_BNOT64: a.Not64(Var(arg0)); return true;
+
+    case asBC_ADDf: arith(SseOp::ADD, Precision::Single); return true;
+    case asBC_SUBf: arith(SseOp::SUB, Precision::Single); return true;
+    case asBC_MULf: arith(SseOp::MUL, Precision::Single); return true;
+    case asBC_ADDd: arith(SseOp::ADD, Precision::Double); return true;
+    case asBC_SUBd: arith(SseOp::SUB, Precision::Double); return true;
+    case asBC_MULd: arith(SseOp::MUL, Precision::Double); return true;
+    case asBC_DIVf:
+        // Both zeros raise the exception, NaN does not
+        a.Mov32(Reg::RAX, Var(arg2));
+        a.Alu32(Alu::AND, Reg::RAX, 0x7FFFFFFF);
+        a.Jcc(Condition::E, Bailout(ip));
+        arith(SseOp::DIV, Precision::Single);
+        return true;
+    case asBC_DIVd:
+        a.Mov64(Reg::RAX, Var(arg2));
+        a.Alu64(Alu::ADD, Reg::RAX, Reg::RAX);
+        a.Jcc(Condition::E, Bailout(ip));
+        arith(SseOp::DIV, Precision::Double);
+        return true;
+    case asBC_ADDIf: arithImmediate(SseOp::ADD); return true;
+    case asBC_SUBIf: arithImmediate(SseOp::SUB); return true;
+    case asBC_MULIf: arithImmediate(SseOp::MUL); return true;
+    case asBC_NEGf: a.Alu32(Alu::XOR, Var(arg0), INT32_MIN); return true;
+    case asBC_NEGd:
+        a.Mov64(Reg::RAX, uint64_t(1) << 63);
+        a.Alu64(Alu::XOR, Var(arg0), Reg::RAX);
+        return true;
+
+    case asBC_iTOf:
+        a.Cvtsi2s(Precision::Single, Xmm::XMM0, Var(arg0), false);
+        a.Movs(Precision::Single, Var(arg0), Xmm::XMM0);
+        return true;
+    case asBC_uTOf:
+        a.Mov32(Reg::RAX, Var(arg0));
+        a.Cvtsi2s(Precision::Single, Xmm::XMM0, Reg::RAX, true);
+        a.Movs(Precision::Single, Var(arg0), Xmm::XMM0);
+        return true;
+    case asBC_fTOi:
+    case asBC_fTOu:
+        a.Cvtts2si(Precision::Single, Reg::RAX, Var(arg0));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_iTOd:
+        a.Cvtsi2s(Precision::Double, Xmm::XMM0, Var(arg1), false);
+        a.Movs(Precision::Double, Var(arg0), Xmm::XMM0);
+        return true;
+    case asBC_uTOd:
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Cvtsi2s(Precision::Double, Xmm::XMM0, Reg::RAX, true);
+        a.Movs(Precision::Double, Var(arg0), Xmm::XMM0);
+        return true;
+    case asBC_dTOi:
+    case asBC_dTOu:
+        a.Cvtts2si(Precision::Double, Reg::RAX, Var(arg1));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_fTOd:
+        a.Cvts2s(Precision::Single, Xmm::XMM0, Var(arg1));
+        a.Movs(Precision::Double, Var(arg0), Xmm::XMM0);
+        return true;
+    case asBC_dTOf:
+        a.Cvts2s(Precision::Double, Xmm::XMM0, Var(arg1));
+        a.Movs(Precision::Single, Var(arg0), Xmm::XMM0);
+        return true;
+    case asBC_sbTOi:
+    case asBC_swTOi:
+    case asBC_ubTOi:
+    case asBC_uwTOi:
+        if (op == asBC_sbTOi) a.Movsx8(Reg::RAX, Var(arg0));
+        else if (op == asBC_swTOi) a.Movsx16(Reg::RAX, Var(arg0));
+        else if (op == asBC_ubTOi) a.Movzx8(Reg::RAX, Var(arg0));
+        else a.Movzx16(Reg::RAX, Var(arg0));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_iTOb: a.Alu32(Alu::AND, Var(arg0), 0xFF); return true;
+    case asBC_iTOw: a.Alu32(Alu::AND, Var(arg0), 0xFFFF); return true;
+    case asBC_iTOi64:
+        a.Movsxd(Reg::RAX, Var(arg1));
+        a.Mov64(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_uTOi64:
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Mov64(Var(arg0), Reg::RAX);
+        return true;
+    case asBC_i64TOi:
+        a.Mov32(Reg::RAX, Var(arg1));
+        a.Mov32(Var(arg0), Reg::RAX);
+        return true;
+
+    case asBC_CMPi:
+    case asBC_CMPu:
+        a.Mov32(Reg::RAX, Var(arg0));
+        a.Alu32(Alu::CMP, Reg::RAX, Var(arg1));
+        if (op == asBC_CMPi) EmitCompare(Condition::G, Condition::L);
+        else EmitCompare(Condition::A, Condition::B);
+        return true;
+    case asBC_CMPIi:
+    case asBC_CMPIu:
+        a.Mov32(Reg::RAX, Var(arg0));
+        a.Alu32(Alu::CMP, Reg::RAX, static_cast<int32_t>(asBC_DWORDARG(ip)));
+        if (op == asBC_CMPIi) EmitCompare(Condition::G, Condition::L);
+        else EmitCompare(Condition::A, Condition::B);
+        return true;
+    case asBC_CMPi64:
+    case asBC_CMPu64:
+        a.Mov64(Reg::RAX, Var(arg0));
+        a.Alu64(Alu::CMP, Reg::RAX, Var(arg1));
+        if (op == asBC_CMPi64) EmitCompare(Condition::G, Condition::L);
+        else EmitCompare(Condition::A, Condition::B);
+        return true;
+    case asBC_CMPf:
+    case asBC_CMPd:
+    {
+        const Precision precision = op == asBC_CMPf ? Precision::Single : Precision::Double;
+        a.Movs(precision, Xmm::XMM0, Var(arg0));
+        a.Movs(precision, Xmm::XMM1, Var(arg1));
+        EmitFloatCompare(precision);
+        return true;
+    }
+    case asBC_CMPIf:
+        a.Movs(Precision::Single, Xmm::XMM0, Var(arg0));
+        a.Mov32(Reg::RAX, static_cast<int32_t>(asBC_DWORDARG(ip)));
+        a.Movd(Xmm::XMM1, Reg::RAX);
+        EmitFloatCompare(Precision::Single);
+        return true;
+
+    case asBC_TZ: EmitTest(Condition::E); return true;
+    case asBC_TNZ: EmitTest(Condition::NE); return true;
+    case asBC_TS: EmitTest(Condition::L); return true;
+    case asBC_TNS: EmitTest(Condition::GE); return true;
+    case asBC_TP: EmitTest(Condition::G); return true;
+    case asBC_TNP: EmitTest(Condition::LE); return true;
+
+    case asBC_JMP:
+    {
+        const asUINT target = static_cast<asUINT>((ip - m_byteCode) + 2 + asBC_INTARG(ip));
+        if (target >= m_length || m_positions[target] == NO_LABEL) return false;
+        a.Jmp(m_positions[target]);
+        return true;
+    }
+    case asBC_JZ: return EmitJump(ip, Condition::E, false);
+    case asBC_JNZ: return EmitJump(ip, Condition::NE, false);
+    case asBC_JS: return EmitJump(ip, Condition::L, false);
+    case asBC_JNS: return EmitJump(ip, Condition::GE, false);
+    case asBC_JP: return EmitJump(ip, Condition::G, false);
+    case asBC_JNP: return EmitJump(ip, Condition::LE, false);
+    case asBC_JLowZ: return EmitJump(ip, Condition::E, true);
+    case asBC_JLowNZ: return EmitJump(ip, Condition::NE, true);
+
+    default: return false;
+    }
+}
+
+void Translator::EmitSuspend(const asDWORD* ip)
+{
+    X64Assembler& a = m_assembler;
+    const Label next = a.NewLabel();
+
+    a.Cmp8(PROCESS_SUSPEND, 0);
+    a.Jcc(Condition::E, next);
+    a.Mov64(Reg::RAX, reinterpret_cast<uint64_t>(ip));
+    a.Mov64(PROGRAM_POINTER, Reg::RAX);
+    a.Mov64(ARG0, REGISTERS);
+    a.Mov64(Reg::RAX, reinterpret_cast<uint64_t>(&aot::Suspend));
+    a.Call(Reg::RAX);
+    a.Test8(Reg::RAX, Reg::RAX);
+    a.Jcc(Condition::NE, m_leave);
+    a.Bind(next);
+}
+
+void Translator::EmitExit(const asDWORD* ip)
+{
+    m_assembler.Mov64(Reg::RAX, reinterpret_cast<uint64_t>(ip));
+    m_assembler.Jmp(m_exit);
+}
+
+bool Translator::EmitJump(const asDWORD* ip, Condition condition, bool lowByte)
+{
+    const asUINT target = static_cast<asUINT>((ip - m_byteCode) + 2 + asBC_INTARG(ip));
+    if (target >= m_length || m_positions[target] == NO_LABEL) return false;
+
+    if (lowByte) m_assembler.Cmp8(VALUE_REGISTER, 0);
+    else m_assembler.Alu32(Alu::CMP, VALUE_REGISTER, 0);
+    m_assembler.Jcc(condition, m_positions[target]);
+    return true;
+}
+
+void Translator::EmitCompare(Condition greater, Condition less)
+{
+    // value register = (a > b) - (a < b), only the lower 32 bits like the interpreter
+    X64Assembler& a = m_assembler;
+    a.Setcc(greater, Reg::RCX);
+    a.Setcc(less, Reg::RDX);
+    a.Movzx8(Reg::RCX, Reg::RCX);
+    a.Movzx8(Reg::RDX, Reg::RDX);
+    a.Alu32(Alu::SUB, Reg::RCX, Reg::RDX);
+    a.Mov32(VALUE_REGISTER, Reg::RCX);
+}
+
+void Translator::EmitFloatCompare(Precision precision)
+{
+    // Like the interpreter: 0 when equal, -1 when less, 1 otherwise, which includes NaN
+    X64Assembler& a = m_assembler;
+    a.Ucomis(precision, Xmm::XMM1, Xmm::XMM0);
+    a.Setcc(Condition::A, Reg::RAX);
+    a.Setcc(Condition::E, Reg::RCX);
+    a.Setcc(Condition::NP, Reg::RDX);
+    a.Alu32(Alu::AND, Reg::RCX, Reg::RDX);
+    a.Movzx8(Reg::RAX, Reg::RAX);
+    a.Movzx8(Reg::RCX, Reg::RCX);
+    a.Mov32(Reg::RDX, 1);
+    a.Alu32(Alu::SUB, Reg::RDX, Reg::RCX);
+    a.Alu32(Alu::SUB, Reg::RDX, Reg::RAX);
+    a.Alu32(Alu::SUB, Reg::RDX, Reg::RAX);
+    a.Mov32(VALUE_REGISTER, Reg::RDX);
+}
+
+void Translator::EmitTest(Condition condition)
+{
+    // The boolean in the low byte, the rest of the register cleared
+    X64Assembler& a = m_assembler;
+    a.Alu32(Alu::XOR, Reg::RCX, Reg::RCX);
+    a.Alu32(Alu::CMP, VALUE_REGISTER, 0);
+    a.Setcc(condition, Reg::RCX);
+    a.Mov64(VALUE_REGISTER, Reg::RCX);
+}
+
+Label Translator::Bailout(const asDWORD* ip)
+{
+    const Label label = m_assembler.NewLabel();
+    m_stubs.push_back({label, ip});
+    return label;
+}
+}  // namespace
+
+srph::jit::JitCompiler::JitCompiler(uint32_t hotEntries) { m_hotEntries = hotEntries; }
+
+srph::jit::JitCompiler::~JitCompiler()
+{
+    for (auto& [function, record] : m_functions)
+    {
+        Free(*record);
+    }
+}
+
+bool srph::jit::JitCompiler::Supported() { return SRPH_JIT_X64; }
+
+void srph::jit::JitCompiler::NewFunction(asIScriptFunction* function)
+{
+    asUINT length = 0;
+    asDWORD* byteCode = function->GetByteCode(&length);
+    if (!byteCode) return;
+
+    m_stats.functions++;
+
+    std::unique_ptr<Function>& record = m_functions[function];
+    if (record) Free(*record);
+    record = std::make_unique<Function>(Function{this, function});
+
+    // Every entry counts towards the threshold until the function is translated
+    for (asUINT position = 0; position < length; position += InstructionSize(static_cast<asEBCInstr>(*reinterpret_cast<asBYTE*>(byteCode + position))))
+    {
+        if (*reinterpret_cast<asBYTE*>(byteCode + position) == asBC_JitEntry)
+        {
+            *reinterpret_cast<asPWORD*>(byteCode + position + 1) = reinterpret_cast<asPWORD>(record.get());
+        }
+    }
+
+    function->SetJITFunction(CountEntry);
+
+    if (m_hotEntries == 0) Translate(*record);
+}
+
+void srph::jit::JitCompiler::CleanFunction(asIScriptFunction* function, asJITFunction jitFunction)
+{
+    // Called when Translate replaces CountEntry, the record stays.
+    if (jitFunction == CountEntry && function == m_replacing) return;
+
+    auto it = m_functions.find(function);
+    if (it == m_functions.end()) return;
+
+    Free(*it->second);
+    m_functions.erase(it);
+}
+
+bool srph::jit::JitCompiler::Compile(asIScriptFunction* function)
+{
+    auto it = m_functions.find(function);
+    if (it == m_functions.end()) return false;
+    if (it->second->code) return true;
+
+    return Translate(*it->second);
+}
+
+void srph::jit::JitCompiler::CountEntry(asSVMRegisters* registers, asPWORD argument)
+{
+    auto* function = reinterpret_cast<Function*>(argument);
+    JitCompiler* compiler = function->compiler;
+
+    if (++function->entries < compiler->m_hotEntries || !compiler->Translate(*function))
+    {
+        registers->programPointer += 1 + AS_PTR_SIZE;
+        return;
+    }
+
+    // Continue in the native code, the entry now holds its address
+    const asPWORD entry = *reinterpret_cast<asPWORD*>(registers->programPointer + 1);
+    reinterpret_cast<asJITFunction>(function->code)(registers, entry);
+}
+
+bool srph::jit::JitCompiler::Translate(Function& function)
+{
+    asUINT length = 0;
+    asDWORD* byteCode = function.function->GetByteCode(&length);
+
+    m_replacing = function.function;
+
+    Translator translator(byteCode, length);
+    translator.Run();
+
+    // Nothing but calls and stack operations, the interpreter is as fast
+    if (translator.Translated() == 0 || !translator.Finish())
+    {
+        Reject(function);
+        return false;
+    }
+
+    void* code = AllocateCode(translator.Code());
+    if (!code)
+    {
+        SRPH_LOG_WARN("Failed to allocate executable memory for {}, it stays interpreted.", function.function->GetDeclaration());
+        Reject(function);
+        return false;
+    }
+
+    for (asUINT position = 0; position < length; position += InstructionSize(translator.Op(position)))
+    {
+        if (translator.Op(position) == asBC_JitEntry)
+        {
+            *reinterpret_cast<asPWORD*>(byteCode + position + 1) = reinterpret_cast<asPWORD>(code) + translator.Offset(position);
+        }
+    }
+
+    function.code = code;
+    function.codeBytes = translator.Code().size();
+    function.function->SetJITFunction(reinterpret_cast<asJITFunction>(code));
+    m_replacing = nullptr;
+
+    m_stats.compiled++;
+    m_stats.instructions += translator.Translated();
+    m_stats.fallbacks += translator.Fallbacks();
+    m_stats.codeBytes += function.codeBytes;
+
+    return true;
+}
+
+void srph::jit::JitCompiler::Reject(Function& function)
+{
+    asUINT length = 0;
+    asDWORD* byteCode = function.function->GetByteCode(&length);
+    for (asUINT position = 0; position < length; position += InstructionSize(static_cast<asEBCInstr>(*reinterpret_cast<asBYTE*>(byteCode + position))))
+    {
+        if (*reinterpret_cast<asBYTE*>(byteCode + position) == asBC_JitEntry)
+        {
+            *reinterpret_cast<asPWORD*>(byteCode + position + 1) = 0;
+        }
+    }
+
+    function.function->SetJITFunction(nullptr);
+    m_replacing = nullptr;
+    m_stats.rejected++;
+
+    // Last, function is the record
+    m_functions.erase(function.function);
+}
+
+void srph::jit::JitCompiler::Free(Function& function)
+{
+    if (function.code)
+    {
+        FreeCode(function.code, function.codeBytes);
+        function.code = nullptr;
+    }
+}
@@ -0,0 +1,267 @@
+#include "jit/x64_assembler.hpp"
+
+#include <cstring>
+
+namespace
+{
+uint8_t Encoding(srph::jit::Reg reg) { return static_cast<uint8_t>(reg); }
+uint8_t Encoding(srph::jit::Xmm reg) { return static_cast<uint8_t>(reg); }
+
+constexpr uint8_t SSE_PREFIX[] = {0xF3, 0xF2};
+uint8_t Prefix(srph::jit::Precision precision) { return SSE_PREFIX[static_cast<uint8_t>(precision)]; }
+}  // namespace
+
+srph::jit::Label srph::jit::X64Assembler::NewLabel()
+{
+    m_labels.push_back(UNBOUND);
+    return static_cast<Label>(m_labels.size() - 1);
+}
+
+void srph::jit::X64Assembler::Bind(Label label) { m_labels[label] = m_code.size(); }
+
+bool srph::jit::X64Assembler::Finish()
+{
+    for (const Patch& patch : m_patches)
+    {
+        if (m_labels[patch.label] == UNBOUND) return false;
+
+        const auto relative = static_cast<int32_t>(m_labels[patch.label] - (patch.position + 4));
+        std::memcpy(m_code.data() + patch.position, &relative, 4);
+    }
+
+    m_patches.clear();
+    return true;
+}
+
+void srph::jit::X64Assembler::Push(Reg reg)
+{
+    Rex(false, 0, 0, Encoding(reg));
+    Byte(0x50 + (Encoding(reg) & 7));
+}
+
+void srph::jit::X64Assembler::Pop(Reg reg)
+{
+    Rex(false, 0, 0, Encoding(reg));
+    Byte(0x58 + (Encoding(reg) & 7));
+}
+
+void srph::jit::X64Assembler::Ret() { Byte(0xC3); }
+
+void srph::jit::X64Assembler::Jmp(Label label)
+{
+    Byte(0xE9);
+    Rel32(label);
+}
+
+void srph::jit::X64Assembler::Jmp(Reg reg) { Op(0, false, {0xFF}, 4, reg); }
+
+void srph::jit::X64Assembler::Jcc(Condition condition, Label label)
+{
+    Byte(0x0F);
+    Byte(0x80 + static_cast<uint8_t>(condition));
+    Rel32(label);
+}
+
+void srph::jit::X64Assembler::Call(Reg reg) { Op(0, false, {0xFF}, 2, reg); }
+
+void srph::jit::X64Assembler::Mov32(Reg dst, Mem src) { Op(0, false, {0x8B}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Mov32(Mem dst, Reg src) { Op(0, false, {0x89}, Encoding(src), dst); }
+
+void srph::jit::X64Assembler::Mov32(Mem dst, int32_t imm)
+{
+    Op(0, false, {0xC7}, 0, dst);
+    Dword(static_cast<uint32_t>(imm));
+}
+
+void srph::jit::X64Assembler::Mov32(Reg dst, int32_t imm)
+{
+    Rex(false, 0, 0, Encoding(dst));
+    Byte(0xB8 + (Encoding(dst) & 7));
+    Dword(static_cast<uint32_t>(imm));
+}
+
+void srph::jit::X64Assembler::Mov64(Reg dst, Mem src) { Op(0, true, {0x8B}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Mov64(Mem dst, Reg src) { Op(0, true, {0x89}, Encoding(src), dst); }
+void srph::jit::X64Assembler::Mov64(Reg dst, Reg src) { Op(0, true, {0x89}, Encoding(src), dst); }
+
+void srph::jit::X64Assembler::Mov64(Reg dst, uint64_t imm)
+{
+    Rex(true, 0, 0, Encoding(dst));
+    Byte(0xB8 + (Encoding(dst) & 7));
+    Qword(imm);
+}
+
+void srph::jit::X64Assembler::Lea64(Reg dst, Mem src) { Op(0, true, {0x8D}, Encoding(dst), src); }
+
+void srph::jit::X64Assembler::Movzx8(Reg dst, Reg src) { Op(0, false, {0x0F, 0xB6}, Encoding(dst), src, true); }
+void srph::jit::X64Assembler::Movzx8(Reg dst, Mem src) { Op(0, false, {0x0F, 0xB6}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Movsx8(Reg dst, Mem src) { Op(0, false, {0x0F, 0xBE}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Movzx16(Reg dst, Mem src) { Op(0, false, {0x0F, 0xB7}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Movsx16(Reg dst, Mem src) { Op(0, false, {0x0F, 0xBF}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Movsxd(Reg dst, Mem src) { Op(0, true, {0x63}, Encoding(dst), src); }
+
+void srph::jit::X64Assembler::Alu32(Alu op, Reg dst, Mem src)
+{
+    Op(0, false, {static_cast<uint8_t>((static_cast<uint8_t>(op) << 3) | 3)}, Encoding(dst), src);
+}
+
+void srph::jit::X64Assembler::Alu32(Alu op, Reg dst, Reg src)
+{
+    Op(0, false, {static_cast<uint8_t>((static_cast<uint8_t>(op) << 3) | 3)}, Encoding(dst), src);
+}
+
+void srph::jit::X64Assembler::Alu32(Alu op, Reg dst, int32_t imm)
+{
+    Op(0, false, {0x81}, static_cast<uint8_t>(op), dst);
+    Dword(static_cast<uint32_t>(imm));
+}
+
+void srph::jit::X64Assembler::Alu32(Alu op, Mem dst, int32_t imm)
+{
+    Op(0, false, {0x81}, static_cast<uint8_t>(op), dst);
+    Dword(static_cast<uint32_t>(imm));
+}
+
+void srph::jit::X64Assembler::Alu64(Alu op, Reg dst, Mem src)
+{
+    Op(0, true, {static_cast<uint8_t>((static_cast<uint8_t>(op) << 3) | 3)}, Encoding(dst), src);
+}
+
+void srph::jit::X64Assembler::Alu64(Alu op, Reg dst, Reg src)
+{
+    Op(0, true, {static_cast<uint8_t>((static_cast<uint8_t>(op) << 3) | 3)}, Encoding(dst), src);
+}
+
+void srph::jit::X64Assembler::Alu64(Alu op, Reg dst, int32_t imm)
+{
+    Op(0, true, {0x81}, static_cast<uint8_t>(op), dst);
+    Dword(static_cast<uint32_t>(imm));
+}
+
+void srph::jit::X64Assembler::Alu64(Alu op, Mem dst, Reg src)
+{
+    Op(0, true, {static_cast<uint8_t>((static_cast<uint8_t>(op) << 3) | 1)}, Encoding(src), dst);
+}
+
+void srph::jit::X64Assembler::Alu64(Alu op, Mem dst, int32_t imm)
+{
+    Op(0, true, {0x81}, static_cast<uint8_t>(op), dst);
+    Dword(static_cast<uint32_t>(imm));
+}
+
+void srph::jit::X64Assembler::Cmp8(Mem dst, int8_t imm)
+{
+    Op(0, false, {0x80}, 7, dst);
+    Byte(static_cast<uint8_t>(imm));
+}
+
+void srph::jit::X64Assembler::Test32(Reg a, Reg b) { Op(0, false, {0x85}, Encoding(b), a); }
+void srph::jit::X64Assembler::Test8(Reg a, Reg b) { Op(0, false, {0x84}, Encoding(b), a, true); }
+
+void srph::jit::X64Assembler::Imul32(Reg dst, Mem src) { Op(0, false, {0x0F, 0xAF}, Encoding(dst), src); }
+
+void srph::jit::X64Assembler::Imul32(Reg dst, Reg src, int32_t imm)
+{
+    Op(0, false, {0x69}, Encoding(dst), src);
+    Dword(static_cast<uint32_t>(imm));
+}
+
+void srph::jit::X64Assembler::Imul64(Reg dst, Mem src) { Op(0, true, {0x0F, 0xAF}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Not32(Mem dst) { Op(0, false, {0xF7}, 2, dst); }
+void srph::jit::X64Assembler::Neg32(Mem dst) { Op(0, false, {0xF7}, 3, dst); }
+void srph::jit::X64Assembler::Not64(Mem dst) { Op(0, true, {0xF7}, 2, dst); }
+void srph::jit::X64Assembler::Neg64(Mem dst) { Op(0, true, {0xF7}, 3, dst); }
+void srph::jit::X64Assembler::Shift32(Shift op, Reg dst) { Op(0, false, {0xD3}, static_cast<uint8_t>(op), dst); }
+void srph::jit::X64Assembler::Shift64(Shift op, Reg dst) { Op(0, true, {0xD3}, static_cast<uint8_t>(op), dst); }
+void srph::jit::X64Assembler::Cdq() { Byte(0x99); }
+void srph::jit::X64Assembler::Idiv32(Reg divisor) { Op(0, false, {0xF7}, 7, divisor); }
+void srph::jit::X64Assembler::Div32(Reg divisor) { Op(0, false, {0xF7}, 6, divisor); }
+
+void srph::jit::X64Assembler::Setcc(Condition condition, Reg dst)
+{
+    Op(0, false, {0x0F, static_cast<uint8_t>(0x90 + static_cast<uint8_t>(condition))}, 0, dst, true);
+}
+
+void srph::jit::X64Assembler::Movs(Precision precision, Xmm dst, Mem src) { Op(Prefix(precision), false, {0x0F, 0x10}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Movs(Precision precision, Mem dst, Xmm src) { Op(Prefix(precision), false, {0x0F, 0x11}, Encoding(src), dst); }
+
+void srph::jit::X64Assembler::Arith(SseOp op, Precision precision, Xmm dst, Mem src)
+{
+    Op(Prefix(precision), false, {0x0F, static_cast<uint8_t>(op)}, Encoding(dst), src);
+}
+
+void srph::jit::X64Assembler::Arith(SseOp op, Precision precision, Xmm dst, Xmm src)
+{
+    Op(Prefix(precision), false, {0x0F, static_cast<uint8_t>(op)}, Encoding(dst), static_cast<Reg>(Encoding(src)));
+}
+
+void srph::jit::X64Assembler::Ucomis(Precision precision, Xmm a, Xmm b)
+{
+    Op(precision == Precision::Double ? 0x66 : 0, false, {0x0F, 0x2E}, Encoding(a), static_cast<Reg>(Encoding(b)));
+}
+
+void srph::jit::X64Assembler::Movd(Xmm dst, Reg src) { Op(0x66, false, {0x0F, 0x6E}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Movq(Xmm dst, Reg src) { Op(0x66, true, {0x0F, 0x6E}, Encoding(dst), src); }
+
+void srph::jit::X64Assembler::Cvtsi2s(Precision precision, Xmm dst, Mem src, bool wide)
+{
+    Op(Prefix(precision), wide, {0x0F, 0x2A}, Encoding(dst), src);
+}
+
+void srph::jit::X64Assembler::Cvtsi2s(Precision precision, Xmm dst, Reg src, bool wide)
+{
+    Op(Prefix(precision), wide, {0x0F, 0x2A}, Encoding(dst), src);
+}
+
+void srph::jit::X64Assembler::Cvtts2si(Precision precision, Reg dst, Mem src) { Op(Prefix(precision), false, {0x0F, 0x2C}, Encoding(dst), src); }
+void srph::jit::X64Assembler::Cvts2s(Precision from, Xmm dst, Mem src) { Op(Prefix(from), false, {0x0F, 0x5A}, Encoding(dst), src); }
+
+void srph::jit::X64Assembler::Dword(uint32_t value)
+{
+    for (int i = 0; i < 4; i++) Byte(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+void srph::jit::X64Assembler::Qword(uint64_t value)
+{
+    for (int i = 0; i < 8; i++) Byte(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+void srph::jit::X64Assembler::Rex(bool w, uint8_t reg, uint8_t index, uint8_t base, bool force)
+{
+    const uint8_t rex = 0x40 | (w ? 8 : 0) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+    if (rex != 0x40 || force) Byte(rex);
+}
+
+void srph::jit::X64Assembler::ModRm(uint8_t reg, Mem mem)
+{
+    // Always disp32, rsp and r12 as base need a SIB byte.
+    const uint8_t base = Encoding(mem.base) & 7;
+    Byte(static_cast<uint8_t>(0x80 | ((reg & 7) << 3) | base));
+    if (base == 4) Byte(0x24);
+    Dword(static_cast<uint32_t>(mem.disp));
+}
+
+void srph::jit::X64Assembler::ModRm(uint8_t reg, Reg rm) { Byte(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (Encoding(rm) & 7))); }
+
+void srph::jit::X64Assembler::Op(uint8_t prefix, bool w, std::initializer_list<uint8_t> opcode, uint8_t reg, Mem mem)
+{
+    if (prefix) Byte(prefix);
+    Rex(w, reg, 0, Encoding(mem.base));
+    for (uint8_t byte : opcode) Byte(byte);
+    ModRm(reg, mem);
+}
+
+void srph::jit::X64Assembler::Op(uint8_t prefix, bool w, std::initializer_list<uint8_t> opcode, uint8_t reg, Reg rm, bool byteRegs)
+{
+    if (prefix) Byte(prefix);
+    // spl, bpl, sil and dil need a REX prefix, without one they encode ah, ch, dh and bh
+    Rex(w, reg, 0, Encoding(rm), byteRegs && ((reg & 7) >= 4 || (Encoding(rm) & 7) >= 4));
+    for (uint8_t byte : opcode) Byte(byte);
+    ModRm(reg, rm);
+}
+
+void srph::jit::X64Assembler::Rel32(Label label)
+{
+    m_patches.push_back({m_code.size(), label});
+    Dword(0);
+}
@@ -0,0 +1,769 @@
+#include "srph_common.hpp"
+#include "memory/allocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+
+namespace
+{
+using namespace srph::memory;
+
+constexpr size_t LARGE_CLASS = SIZE_CLASSES.size();
+constexpr size_t CHUNK_SIZE = 64 * 1024;
+// Blocks a thread keeps per size class before handing half of them back to the global pool
+constexpr uint32_t THREAD_CACHE_BYTES = 32 * 1024;
+// Live bytes a thread counts on its own before adding them to the global total, which also bounds the error of the peak
+constexpr int64_t LIVE_FLUSH_BYTES = 64 * 1024;
+
+// Placed in front of every allocation so frees know their size class, keeps the 16 byte alignment of the block.
+struct Header
+{
+    uint64_t size;
+    uint32_t sizeClass;
+    uint32_t tag;
+};
+constexpr size_t HEADER_SIZE = 16;
+static_assert(sizeof(Header) == HEADER_SIZE, "Allocation header must keep 16 byte alignment.");
+
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+constexpr std::array<uint8_t, SIZE_CLASSES.back() / 16 + 1> MakeClassLookup()
+{
+    std::array<uint8_t, SIZE_CLASSES.back() / 16 + 1> lookup = {};
+    size_t sizeClass = 0;
+    for (size_t i = 0; i < lookup.size(); i++)
+    {
+        while (SIZE_CLASSES[sizeClass] < i * 16) sizeClass++;
+        lookup[i] = static_cast<uint8_t>(sizeClass);
+    }
+    return lookup;
+}
+
+// Indexed by the request size rounded up to 16 bytes
+constexpr auto CLASS_LOOKUP = MakeClassLookup();
+
+uint32_t SizeClass(size_t size)
+{
+    if (size > SIZE_CLASSES.back()) return static_cast<uint32_t>(LARGE_CLASS);
+    return CLASS_LOOKUP[(size + 15) / 16];
+}
+
+size_t BlockSize(uint32_t sizeClass) { return SIZE_CLASSES[sizeClass] + HEADER_SIZE; }
+
+void AtomicMax(std::atomic<uint64_t>& target, uint64_t value)
+{
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Adds without a locked instruction, for counters only their own thread writes
+template <typename T>
+void LocalAdd(std::atomic<T>& counter, T value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Statistics of one thread. Blocks may be freed by another thread than the one that allocated them, so the live
+// counts of a single thread can be negative, only their sum is meaningful.
+struct ThreadCounters
+{
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    // Not yet added to Counters::liveBytes
+    std::atomic<int64_t> unflushedBytes{0};
+
+    struct SizeClass
+    {
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<int64_t> live{0};
+        std::atomic<int64_t> liveBytes{0};
+    };
+    std::array<SizeClass, SIZE_CLASS_COUNT> sizeClasses;
+};
+
+struct Counters
+{
+    std::atomic<int64_t> liveBytes{0};
+    std::atomic<uint64_t> peakBytes{0};
+    std::atomic<uint64_t> reservedBytes{0};
+
+    std::mutex threadsMutex;
+    std::vector<ThreadCounters*> threads;
+    // Counters of the threads that exited, and of allocations made after a thread's counters were destroyed
+    ThreadCounters retired;
+
+    void Allocated(const Header& header);
+    void Freed(const Header& header);
+
+    // Adds the thread's live bytes to the total once enough of them accumulated
+    void Flush(ThreadCounters& local, bool force)
+    {
+        const int64_t unflushed = local.unflushedBytes.load(std::memory_order_relaxed);
+        if (!force && unflushed < LIVE_FLUSH_BYTES && unflushed > -LIVE_FLUSH_BYTES) return;
+
+        local.unflushedBytes.store(0, std::memory_order_relaxed);
+        const int64_t live = liveBytes.fetch_add(unflushed, std::memory_order_relaxed) + unflushed;
+        if (live > 0) AtomicMax(peakBytes, static_cast<uint64_t>(live));
+    }
+
+    void Retire(ThreadCounters* local)
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        Flush(*local, true);
+        retired.allocations.fetch_add(local->allocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        retired.frees.fetch_add(local->frees.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+        {
+            retired.sizeClasses[i].allocations.fetch_add(local->sizeClasses[i].allocations.load(std::memory_order_relaxed),
+                                                         std::memory_order_relaxed);
+            retired.sizeClasses[i].live.fetch_add(local->sizeClasses[i].live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            retired.sizeClasses[i].liveBytes.fetch_add(local->sizeClasses[i].liveBytes.load(std::memory_order_relaxed),
+                                                       std::memory_order_relaxed);
+        }
+        threads.erase(std::find(threads.begin(), threads.end(), local));
+    }
+};
+
+// Global free list of one size class. Chunks are never returned to the system.
+class SizeClassPool
+{
+public:
+    void* Pop(uint32_t sizeClass)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_head) Refill(sizeClass);
+
+        FreeBlock* block = m_head;
+        m_head = block->next;
+        return block;
+    }
+
+    void Push(void* block)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        static_cast<FreeBlock*>(block)->next = m_head;
+        m_head = static_cast<FreeBlock*>(block);
+    }
+
+    // Takes up to `count` blocks at once, returns the number taken
+    uint32_t PopBatch(uint32_t sizeClass, FreeBlock*& out, uint32_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_head) Refill(sizeClass);
+
+        uint32_t taken = 0;
+        while (m_head && taken < count)
+        {
+            FreeBlock* block = m_head;
+            m_head = block->next;
+            block->next = out;
+            out = block;
+            taken++;
+        }
+        return taken;
+    }
+
+    void PushList(FreeBlock* first, FreeBlock* last)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        last->next = m_head;
+        m_head = first;
+    }
+
+private:
+    void Refill(uint32_t sizeClass);
+
+private:
+    std::mutex m_mutex;
+    FreeBlock* m_head = nullptr;
+};
+
+struct Account
+{
+    // Written once when the account is created
+    std::string name;
+    std::atomic<uint64_t> budget{0};
+    std::atomic<uint64_t> liveBytes{0};
+    std::atomic<uint64_t> peakBytes{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> denied{0};
+    // Set from the first allocation over the budget until frees bring the account below it, limits the logging
+    std::atomic<bool> overBudget{false};
+};
+
+struct State
+{
+    AllocatorStrategy strategy = AllocatorStrategy::None;
+    IAllocator* custom = nullptr;
+    Counters counters;
+    std::array<SizeClassPool, SIZE_CLASSES.size()> pools;
+
+    std::atomic<bool> accounting{false};
+    // Bumped whenever a module gets an account, invalidates the per-thread module cache
+    std::atomic<uint64_t> moduleGeneration{1};
+    std::mutex accountsMutex;
+    // Index 0 is the unattributed account and is not reported
+    std::array<Account, MAX_ACCOUNTS> accounts;
+    uint32_t accountCount = 1;
+    // Not kept in the module user data, reading that takes the engine lock, which may already be held
+    // exclusively further up when AngelScript allocates.
+    std::unordered_map<const asIScriptModule*, uint32_t> moduleAccounts;
+    srph::memory::BudgetCallback budgetCallback;
+};
+
+// Intentionally leaked, AngelScript may free memory during static destruction.
+State& GlobalState()
+{
+    static State* state = new State();
+    return *state;
+}
+
+std::mutex g_installMutex;
+bool g_installed = false;
+
+// Module user data type, set so the engine reports when a module with an account is destroyed
+constexpr asPWORD MODULE_ACCOUNT_USER_DATA = 0x5352504D;
+
+void ModuleDestroyed(asIScriptModule* module)
+{
+    State& state = GlobalState();
+    {
+        std::lock_guard<std::mutex> lock(state.accountsMutex);
+        state.moduleAccounts.erase(module);
+    }
+    state.moduleGeneration.fetch_add(1, std::memory_order_release);
+}
+
+struct LocalCounters
+{
+    ThreadCounters* counters = nullptr;
+
+    ~LocalCounters();
+};
+
+// Trivially destructible, so it can still be read after the counters are destroyed at thread exit
+thread_local bool t_countersDestroyed = false;
+thread_local LocalCounters t_counters;
+
+LocalCounters::~LocalCounters()
+{
+    if (counters)
+    {
+        GlobalState().counters.Retire(counters);
+        delete counters;
+    }
+    t_countersDestroyed = true;
+}
+
+// nullptr once the thread's counters are destroyed, the shared retired counters are used then
+ThreadCounters* ThreadLocalCounters()
+{
+    if (t_countersDestroyed) return nullptr;
+
+    if (!t_counters.counters)
+    {
+        ThreadCounters* counters = new ThreadCounters();
+
+        Counters& global = GlobalState().counters;
+        std::lock_guard<std::mutex> lock(global.threadsMutex);
+        global.threads.push_back(counters);
+        t_counters.counters = counters;
+    }
+    return t_counters.counters;
+}
+
+void Counters::Allocated(const Header& header)
+{
+    ThreadCounters* local = ThreadLocalCounters();
+    if (!local)
+    {
+        const int64_t live = liveBytes.fetch_add(static_cast<int64_t>(header.size), std::memory_order_relaxed) + header.size;
+        AtomicMax(peakBytes, static_cast<uint64_t>(live));
+        retired.allocations.fetch_add(1, std::memory_order_relaxed);
+        retired.sizeClasses[header.sizeClass].allocations.fetch_add(1, std::memory_order_relaxed);
+        retired.sizeClasses[header.sizeClass].live.fetch_add(1, std::memory_order_relaxed);
+        retired.sizeClasses[header.sizeClass].liveBytes.fetch_add(static_cast<int64_t>(header.size), std::memory_order_relaxed);
+        return;
+    }
+
+    LocalAdd<uint64_t>(local->allocations, 1);
+    LocalAdd<int64_t>(local->unflushedBytes, static_cast<int64_t>(header.size));
+    ThreadCounters::SizeClass& sizeClass = local->sizeClasses[header.sizeClass];
+    LocalAdd<uint64_t>(sizeClass.allocations, 1);
+    LocalAdd<int64_t>(sizeClass.live, 1);
+    LocalAdd<int64_t>(sizeClass.liveBytes, static_cast<int64_t>(header.size));
+    Flush(*local, false);
+}
+
+void Counters::Freed(const Header& header)
+{
+    ThreadCounters* local = ThreadLocalCounters();
+    if (!local)
+    {
+        liveBytes.fetch_sub(static_cast<int64_t>(header.size), std::memory_order_relaxed);
+        retired.frees.fetch_add(1, std::memory_order_relaxed);
+        retired.sizeClasses[header.sizeClass].live.fetch_sub(1, std::memory_order_relaxed);
+        retired.sizeClasses[header.sizeClass].liveBytes.fetch_sub(static_cast<int64_t>(header.size), std::memory_order_relaxed);
+        return;
+    }
+
+    LocalAdd<uint64_t>(local->frees, 1);
+    LocalAdd<int64_t>(local->unflushedBytes, -static_cast<int64_t>(header.size));
+    ThreadCounters::SizeClass& sizeClass = local->sizeClasses[header.sizeClass];
+    LocalAdd<int64_t>(sizeClass.live, -1);
+    LocalAdd<int64_t>(sizeClass.liveBytes, -static_cast<int64_t>(header.size));
+    Flush(*local, false);
+}
+
+void SizeClassPool::Refill(uint32_t sizeClass)
+{
+    const size_t blockSize = BlockSize(sizeClass);
+    const size_t count = CHUNK_SIZE / blockSize;
+
+    char* chunk = static_cast<char*>(std::malloc(blockSize * count));
+    if (!chunk)
+    {
+        SRPH_LOG_CRITICAL("Script allocator is out of memory.");
+    }
+    GlobalState().counters.reservedBytes.fetch_add(blockSize * count, std::memory_order_relaxed);
+
+    for (size_t i = count; i-- > 0;)
+    {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+        block->next = m_head;
+        m_head = block;
+    }
+}
+
+struct ThreadCache
+{
+    std::array<FreeBlock*, SIZE_CLASSES.size()> heads = {};
+    std::array<uint32_t, SIZE_CLASSES.size()> counts = {};
+
+    static uint32_t Capacity(uint32_t sizeClass) { return std::max<uint32_t>(THREAD_CACHE_BYTES / SIZE_CLASSES[sizeClass], 4); }
+
+    void* Pop(uint32_t sizeClass)
+    {
+        if (!heads[sizeClass])
+        {
+            counts[sizeClass] += GlobalState().pools[sizeClass].PopBatch(sizeClass, heads[sizeClass], Capacity(sizeClass) / 2);
+        }
+
+        FreeBlock* block = heads[sizeClass];
+        heads[sizeClass] = block->next;
+        counts[sizeClass]--;
+        return block;
+    }
+
+    void Push(uint32_t sizeClass, void* memory)
+    {
+        FreeBlock* block = static_cast<FreeBlock*>(memory);
+        block->next = heads[sizeClass];
+        heads[sizeClass] = block;
+
+        if (++counts[sizeClass] > Capacity(sizeClass)) Release(sizeClass, counts[sizeClass] / 2);
+    }
+
+    void Release(uint32_t sizeClass, uint32_t count)
+    {
+        if (count == 0 || !heads[sizeClass]) return;
+
+        FreeBlock* first = heads[sizeClass];
+        FreeBlock* last = first;
+        uint32_t released = 1;
+        for (; released < count && last->next; released++)
+        {
+            last = last->next;
+        }
+
+        heads[sizeClass] = last->next;
+        counts[sizeClass] -= released;
+        GlobalState().pools[sizeClass].PushList(first, last);
+    }
+
+    ~ThreadCache();
+};
+
+// Trivially destructible, so it can still be read after the cache itself is destroyed at thread exit
+thread_local bool t_cacheDestroyed = false;
+thread_local ThreadCache t_cache;
+
+ThreadCache::~ThreadCache()
+{
+    for (uint32_t sizeClass = 0; sizeClass < SIZE_CLASSES.size(); sizeClass++)
+    {
+        Release(sizeClass, counts[sizeClass]);
+    }
+    t_cacheDestroyed = true;
+}
+
+// Set while the accounting code runs, allocations made by AngelScript or the budget callback in the meantime stay
+// unattributed instead of recursing
+thread_local bool t_inAccounting = false;
+
+struct ModuleCache
+{
+    const asIScriptModule* module = nullptr;
+    uint64_t generation = 0;
+    uint32_t account = 0;
+};
+thread_local ModuleCache t_moduleCache;
+
+uint32_t ModuleAccount(State& state, const asIScriptModule* module)
+{
+    const uint64_t generation = state.moduleGeneration.load(std::memory_order_acquire);
+    if (t_moduleCache.module != module || t_moduleCache.generation != generation)
+    {
+        t_moduleCache.module = module;
+        t_moduleCache.generation = generation;
+
+        std::lock_guard<std::mutex> lock(state.accountsMutex);
+        auto it = state.moduleAccounts.find(module);
+        t_moduleCache.account = it != state.moduleAccounts.end() ? it->second : 0;
+    }
+
+    return t_moduleCache.account;
+}
+
+uint32_t CurrentAccount(State& state, asIScriptContext*& context)
+{
+    t_inAccounting = true;
+
+    uint32_t account = 0;
+    context = asGetActiveContext();
+    if (context)
+    {
+        // Generated functions like template factory stubs have no module, the caller owns the allocation
+        const asUINT callstackSize = context->GetCallstackSize();
+        for (asUINT level = 0; level < callstackSize; level++)
+        {
+            asIScriptFunction* function = context->GetFunction(level);
+            asIScriptModule* module = function ? function->GetModule() : nullptr;
+            if (module)
+            {
+                account = ModuleAccount(state, module);
+                break;
+            }
+        }
+    }
+
+    t_inAccounting = false;
+    return account;
+}
+
+srph::memory::AccountStats AccountSnapshot(const Account& account)
+{
+    srph::memory::AccountStats stats;
+    stats.name = account.name;
+    stats.budgetBytes = account.budget.load(std::memory_order_relaxed);
+    stats.liveBytes = account.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = account.peakBytes.load(std::memory_order_relaxed);
+    stats.allocations = account.allocations.load(std::memory_order_relaxed);
+    stats.deniedAllocations = account.denied.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Returns true if the budget callback allows the allocation. Otherwise the executing script gets an exception. The
+// memory is handed out either way, the native code that asked for it does not expect nullptr.
+bool BudgetExceeded(State& state, Account& account, size_t size, asIScriptContext* context)
+{
+    t_inAccounting = true;
+
+    BudgetCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(state.accountsMutex);
+        callback = state.budgetCallback;
+    }
+
+    const bool allow = callback && callback(AccountSnapshot(account), size);
+    if (!allow && context)
+    {
+        const std::string message = fmt::format("Script memory budget of '{}' exceeded ({} bytes).",
+                                                account.name,
+                                                account.budget.load(std::memory_order_relaxed));
+        if (!account.overBudget.exchange(true, std::memory_order_relaxed))
+        {
+            SRPH_LOG_ERROR("{}", message);
+        }
+
+        // Raised when the registered function that allocates returns. Allocations the VM makes itself, such as script
+        // objects and stack growth, can't raise exceptions, so the context is aborted instead.
+        if (context->SetException(message.c_str()) < 0)
+        {
+            context->Abort();
+        }
+    }
+
+    t_inAccounting = false;
+    return allow;
+}
+
+void* AllocateBlock(State& state, uint32_t sizeClass, size_t size)
+{
+    if (sizeClass == LARGE_CLASS) return std::malloc(size + HEADER_SIZE);
+
+    if (state.strategy == AllocatorStrategy::ThreadCache && !t_cacheDestroyed) return t_cache.Pop(sizeClass);
+    return state.pools[sizeClass].Pop(sizeClass);
+}
+
+void FreeBlockMemory(State& state, uint32_t sizeClass, void* block)
+{
+    if (sizeClass == LARGE_CLASS)
+    {
+        std::free(block);
+    }
+    else if (state.strategy == AllocatorStrategy::ThreadCache && !t_cacheDestroyed)
+    {
+        t_cache.Push(sizeClass, block);
+    }
+    else
+    {
+        state.pools[sizeClass].Push(block);
+    }
+}
+
+void* ScriptAlloc(size_t size)
+{
+    State& state = GlobalState();
+    const uint32_t sizeClass = SizeClass(size);
+
+    uint32_t accountId = 0;
+    if (state.accounting.load(std::memory_order_relaxed) && !t_inAccounting)
+    {
+        asIScriptContext* context = nullptr;
+        accountId = CurrentAccount(state, context);
+        if (accountId != 0)
+        {
+            Account& account = state.accounts[accountId];
+            const uint64_t budget = account.budget.load(std::memory_order_relaxed);
+            const uint64_t live = account.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+            if (budget != 0 && live > budget && !BudgetExceeded(state, account, size, context))
+            {
+                account.denied.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            AtomicMax(account.peakBytes, live);
+            account.allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void* block = nullptr;
+    switch (state.strategy)
+    {
+        case AllocatorStrategy::Pooled:
+        case AllocatorStrategy::ThreadCache:
+            block = AllocateBlock(state, sizeClass, size);
+            break;
+        case AllocatorStrategy::Custom:
+            block = state.custom->Allocate(size + HEADER_SIZE);
+            break;
+        default:
+            block = std::malloc(size + HEADER_SIZE);
+            break;
+    }
+
+    if (!block)
+    {
+        if (accountId != 0) state.accounts[accountId].liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Header* header = static_cast<Header*>(block);
+    header->size = size;
+    header->sizeClass = sizeClass;
+    header->tag = accountId;
+    state.counters.Allocated(*header);
+
+    return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void ScriptFree(void* memory)
+{
+    if (!memory) return;
+
+    State& state = GlobalState();
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(memory) - HEADER_SIZE);
+    state.counters.Freed(*header);
+    if (header->tag != 0)
+    {
+        Account& account = state.accounts[header->tag];
+        const uint64_t live = account.liveBytes.fetch_sub(header->size, std::memory_order_relaxed) - header->size;
+        if (account.overBudget.load(std::memory_order_relaxed) && live <= account.budget.load(std::memory_order_relaxed))
+        {
+            account.overBudget.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    switch (state.strategy)
+    {
+        case AllocatorStrategy::Pooled:
+        case AllocatorStrategy::ThreadCache:
+            FreeBlockMemory(state, header->sizeClass, header);
+            break;
+        case AllocatorStrategy::Custom:
+            state.custom->Free(header, header->size + HEADER_SIZE);
+            break;
+        default:
+            std::free(header);
+            break;
+    }
+}
+}  // namespace
+
+bool srph::memory::Install(AllocatorStrategy strategy, IAllocator* custom)
+{
+    std::lock_guard<std::mutex> lock(g_installMutex);
+
+    State& state = GlobalState();
+    if (g_installed)
+    {
+        return state.strategy == strategy && (strategy != AllocatorStrategy::Custom || state.custom == custom);
+    }
+
+    if (strategy == AllocatorStrategy::Custom && !custom)
+    {
+        SRPH_LOG_ERROR("AllocatorStrategy::Custom requires EngineConfiguration::customAllocator, using System instead.");
+        strategy = AllocatorStrategy::System;
+    }
+
+    g_installed = true;
+    state.strategy = strategy;
+    state.custom = custom;
+
+    if (strategy != AllocatorStrategy::None)
+    {
+        SRPH_VERIFY(asSetGlobalMemoryFunctions(ScriptAlloc, ScriptFree), "Failed to set the global memory functions.")
+    }
+
+    return true;
+}
+
+srph::memory::AllocatorStrategy srph::memory::InstalledStrategy()
+{
+    std::lock_guard<std::mutex> lock(g_installMutex);
+    return GlobalState().strategy;
+}
+
+srph::memory::MemoryStats srph::memory::Stats()
+{
+    State& state = GlobalState();
+    Counters& counters = state.counters;
+
+    MemoryStats stats;
+    stats.strategy = InstalledStrategy();
+    stats.reservedBytes = counters.reservedBytes.load(std::memory_order_relaxed);
+
+    int64_t liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+    std::array<int64_t, SIZE_CLASS_COUNT> live = {};
+    std::array<int64_t, SIZE_CLASS_COUNT> classBytes = {};
+    auto merge = [&](const ThreadCounters& thread)
+    {
+        stats.allocations += thread.allocations.load(std::memory_order_relaxed);
+        stats.frees += thread.frees.load(std::memory_order_relaxed);
+        liveBytes += thread.unflushedBytes.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+        {
+            stats.sizeClasses[i].allocations += thread.sizeClasses[i].allocations.load(std::memory_order_relaxed);
+            live[i] += thread.sizeClasses[i].live.load(std::memory_order_relaxed);
+            classBytes[i] += thread.sizeClasses[i].liveBytes.load(std::memory_order_relaxed);
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(counters.threadsMutex);
+        merge(counters.retired);
+        for (const ThreadCounters* thread : counters.threads)
+        {
+            merge(*thread);
+        }
+    }
+
+    // The threads are read one after the other while they keep counting, so a sum may briefly be off
+    stats.liveBytes = static_cast<uint64_t>(std::max<int64_t>(liveBytes, 0));
+    stats.peakBytes = std::max(counters.peakBytes.load(std::memory_order_relaxed), stats.liveBytes);
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+    {
+        SizeClassStats& sizeClass = stats.sizeClasses[i];
+        sizeClass.maxSize = i < SIZE_CLASSES.size() ? SIZE_CLASSES[i] : 0;
+        sizeClass.liveAllocations = static_cast<uint64_t>(std::max<int64_t>(live[i], 0));
+        sizeClass.liveBytes = static_cast<uint64_t>(std::max<int64_t>(classBytes[i], 0));
+    }
+
+    std::lock_guard<std::mutex> lock(state.accountsMutex);
+    for (uint32_t i = 1; i < state.accountCount; i++)
+    {
+        stats.accounts.push_back(AccountSnapshot(state.accounts[i]));
+    }
+
+    return stats;
+}
+
+void srph::memory::EnableAccounting()
+{
+    if (InstalledStrategy() == AllocatorStrategy::None)
+    {
+        SRPH_LOG_WARN("Module memory accounting requires a script allocator other than AllocatorStrategy::None.");
+        return;
+    }
+
+    GlobalState().accounting.store(true, std::memory_order_relaxed);
+}
+
+bool srph::memory::AccountingEnabled() { return GlobalState().accounting.load(std::memory_order_relaxed); }
+
+uint32_t srph::memory::Account(const std::string& name)
+{
+    State& state = GlobalState();
+    std::lock_guard<std::mutex> lock(state.accountsMutex);
+
+    for (uint32_t i = 1; i < state.accountCount; i++)
+    {
+        if (state.accounts[i].name == name) return i;
+    }
+
+    if (state.accountCount == MAX_ACCOUNTS)
+    {
+        SRPH_LOG_ERROR("Out of memory accounts, allocations of '{}' stay unattributed.", name);
+        return 0;
+    }
+
+    state.accounts[state.accountCount].name = name;
+    return state.accountCount++;
+}
+
+void srph::memory::SetBudget(uint32_t account, uint64_t bytes)
+{
+    if (account == 0 || account >= MAX_ACCOUNTS) return;
+    GlobalState().accounts[account].budget.store(bytes, std::memory_order_relaxed);
+}
+
+void srph::memory::SetBudgetCallback(const BudgetCallback& callback)
+{
+    State& state = GlobalState();
+    std::lock_guard<std::mutex> lock(state.accountsMutex);
+    state.budgetCallback = callback;
+}
+
+void srph::memory::AssignModule(asIScriptModule* module, uint32_t account)
+{
+    State& state = GlobalState();
+    {
+        std::lock_guard<std::mutex> lock(state.accountsMutex);
+        state.moduleAccounts[module] = account;
+    }
+    state.moduleGeneration.fetch_add(1, std::memory_order_release);
+
+    // The account stays until the module is discarded and destroyed
+    module->GetEngine()->SetModuleUserDataCleanupCallback(ModuleDestroyed, MODULE_ACCOUNT_USER_DATA);
+    module->SetUserData(module, MODULE_ACCOUNT_USER_DATA);
+}
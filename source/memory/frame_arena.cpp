@@ -0,0 +1,231 @@
+#include "srph_common.hpp"
+#include "memory/frame_arena.hpp"
+
+#include <cstdlib>
+
+namespace
+{
+enum class BufferKind : uint32_t
+{
+    Heap,
+    Arena,
+    // Freed arena buffer, its memory is reclaimed when the frame ends
+    Dead
+};
+
+constexpr size_t HEADER_SIZE = 32;
+
+constexpr size_t Align(size_t size) { return (size + 15) & ~size_t(15); }
+
+thread_local srph::memory::FrameArena* t_frameArena = nullptr;
+}  // namespace
+
+// Frees know where the buffer came from, arena buffers keep the chunk of the arena that handed them out
+struct srph::memory::FrameArena::BufferHeader
+{
+    CScriptArray* owner;
+    Chunk* chunk;
+    uint32_t size;
+    std::atomic<BufferKind> kind;
+};
+
+srph::memory::FrameArena::FrameArena(size_t chunkSize) : m_chunkSize(Align(chunkSize)) {}
+
+srph::memory::FrameArena::~FrameArena()
+{
+    if (m_active) End(true);
+
+    for (Chunk* chunk : m_chunks)
+    {
+        std::free(chunk->memory);
+        delete chunk;
+    }
+
+    for (Chunk* chunk : m_retained)
+    {
+        std::free(chunk->memory);
+        delete chunk;
+    }
+}
+
+void srph::memory::FrameArena::Begin()
+{
+    if (m_active)
+    {
+        SRPH_LOG_WARN("Frame already begun, call EndFrame first.");
+        return;
+    }
+
+    if (t_frameArena)
+    {
+        SRPH_LOG_WARN("Another frame is active on this thread.");
+        return;
+    }
+
+    m_active = true;
+    t_frameArena = this;
+}
+
+void srph::memory::FrameArena::End(bool relocate)
+{
+    if (!m_active) return;
+
+    uint64_t used = 0;
+    std::vector<Chunk*> chunks;
+    chunks.reserve(m_chunks.size());
+
+    for (Chunk* chunk : m_chunks)
+    {
+        used += chunk->used;
+        if (chunk->used == 0 || Release(chunk, relocate))
+        {
+            chunks.push_back(chunk);
+        }
+        else
+        {
+            m_retained.push_back(chunk);
+            m_stats.retainedChunks++;
+        }
+    }
+
+    // Chunks kept by earlier frames come back once their buffers are gone or may be moved
+    for (size_t i = 0; i < m_retained.size();)
+    {
+        if (Release(m_retained[i], relocate))
+        {
+            chunks.push_back(m_retained[i]);
+            m_retained[i] = m_retained.back();
+            m_retained.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    m_chunks = std::move(chunks);
+    m_stats.frames++;
+    m_stats.lastFrameBytes = used;
+    m_current = 0;
+    m_active = false;
+    t_frameArena = nullptr;
+}
+
+bool srph::memory::FrameArena::Release(Chunk* chunk, bool relocate)
+{
+    if (chunk->live.load(std::memory_order_acquire) != 0)
+    {
+        if (!relocate) return false;
+        Promote(chunk);
+    }
+
+    chunk->used = 0;
+    return true;
+}
+
+void srph::memory::FrameArena::Promote(Chunk* chunk)
+{
+    for (size_t offset = 0; offset < chunk->used;)
+    {
+        BufferHeader* header = reinterpret_cast<BufferHeader*>(chunk->memory + offset);
+        offset += HEADER_SIZE + Align(header->size);
+
+        if (header->kind.load(std::memory_order_acquire) != BufferKind::Arena) continue;
+
+        void* buffer = HeapBuffer(header->owner, header->size);
+        if (!buffer)
+        {
+            SRPH_LOG_CRITICAL("Out of memory while promoting a frame arena buffer.");
+        }
+
+        header->owner->RelocateBuffer(buffer);
+        header->kind.store(BufferKind::Dead, std::memory_order_relaxed);
+        chunk->live.fetch_sub(1, std::memory_order_relaxed);
+
+        m_stats.promotions++;
+        m_stats.promotedBytes += header->size;
+    }
+}
+
+srph::memory::FrameArena::BufferHeader* srph::memory::FrameArena::Header(void* buffer)
+{
+    static_assert(sizeof(BufferHeader) <= HEADER_SIZE, "Buffer header must fit in front of the buffer.");
+    return reinterpret_cast<BufferHeader*>(static_cast<char*>(buffer) - HEADER_SIZE);
+}
+
+void* srph::memory::FrameArena::HeapBuffer(CScriptArray* owner, size_t size)
+{
+    BufferHeader* header = static_cast<BufferHeader*>(asAllocMem(size + HEADER_SIZE));
+    if (!header) return nullptr;
+
+    header->owner = owner;
+    header->chunk = nullptr;
+    header->size = static_cast<uint32_t>(size);
+    header->kind.store(BufferKind::Heap, std::memory_order_relaxed);
+    return reinterpret_cast<char*>(header) + HEADER_SIZE;
+}
+
+void* srph::memory::FrameArena::Allocate(CScriptArray* owner, size_t size)
+{
+    const size_t blockSize = HEADER_SIZE + Align(size);
+    if (blockSize > m_chunkSize / 4) return HeapBuffer(owner, size);
+
+    while (m_current < m_chunks.size() && m_chunks[m_current]->used + blockSize > m_chunks[m_current]->size)
+    {
+        m_current++;
+    }
+
+    if (m_current == m_chunks.size())
+    {
+        char* memory = static_cast<char*>(std::malloc(m_chunkSize));
+        if (!memory) return HeapBuffer(owner, size);
+
+        Chunk* chunk = new Chunk;
+        chunk->memory = memory;
+        chunk->size = m_chunkSize;
+        m_chunks.push_back(chunk);
+        m_stats.reservedBytes += m_chunkSize;
+    }
+
+    Chunk* chunk = m_chunks[m_current];
+    BufferHeader* header = reinterpret_cast<BufferHeader*>(chunk->memory + chunk->used);
+    chunk->used += blockSize;
+    chunk->live.fetch_add(1, std::memory_order_relaxed);
+
+    header->owner = owner;
+    header->chunk = chunk;
+    header->size = static_cast<uint32_t>(size);
+    header->kind.store(BufferKind::Arena, std::memory_order_relaxed);
+
+    m_stats.allocations++;
+
+    return reinterpret_cast<char*>(header) + HEADER_SIZE;
+}
+
+void* srph::memory::FrameArena::AllocateBuffer(CScriptArray* owner, void* replacedBuffer, size_t size)
+{
+    // Only buffers of running scripts, arrays created by the application tend to outlive the frame. Arrays
+    // growing out of a heap buffer were created in an earlier frame and would only be promoted again.
+    const bool grows = replacedBuffer && Header(replacedBuffer)->kind.load(std::memory_order_relaxed) == BufferKind::Heap;
+    if (t_frameArena && !grows && asGetActiveContext())
+    {
+        return t_frameArena->Allocate(owner, size);
+    }
+
+    return HeapBuffer(owner, size);
+}
+
+void srph::memory::FrameArena::FreeBuffer(CScriptArray*, void* buffer)
+{
+    BufferHeader* header = Header(buffer);
+    if (header->kind.load(std::memory_order_relaxed) == BufferKind::Heap)
+    {
+        asFreeMem(header);
+        return;
+    }
+
+    // Counted on the chunk it came from, whichever thread frees it and whether or not its frame is over
+    Chunk* chunk = header->chunk;
+    header->kind.store(BufferKind::Dead, std::memory_order_relaxed);
+    chunk->live.fetch_sub(1, std::memory_order_release);
+}
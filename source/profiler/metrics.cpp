@@ -0,0 +1,300 @@
+#include "srph_common.hpp"
+#include "profiler/metrics.hpp"
+#include "profiler/tracer.hpp"
+
+#include <algorithm>
+#include <mutex>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "engine.hpp"
+
+namespace
+{
+uint32_t HighestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+void AtomicMax(std::atomic<uint64_t>& target, uint64_t value)
+{
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+srph::profiler::CallMetrics ToMetrics(const std::string& name,
+                                      const std::string& module,
+                                      const srph::profiler::CallCounters& counters)
+{
+    return {name,
+            module,
+            counters.calls.load(std::memory_order_relaxed),
+            counters.exceptions.load(std::memory_order_relaxed),
+            counters.timeouts.load(std::memory_order_relaxed),
+            counters.latency.SumNanos(),
+            counters.latency.Percentile(0.5),
+            counters.latency.Percentile(0.99)};
+}
+
+std::string EscapeLabel(const std::string& value)
+{
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (c == '\n')
+        {
+            out += "\\n";
+        }
+        else
+        {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+std::string Labels(const char* label, const srph::profiler::CallMetrics& metrics)
+{
+    std::string labels = fmt::format("{}=\"{}\"", label, EscapeLabel(metrics.name));
+    if (!metrics.module.empty()) labels += fmt::format(",module=\"{}\"", EscapeLabel(metrics.module));
+    return labels;
+}
+
+void WriteCallMetrics(fmt::memory_buffer& out,
+                      const char* prefix,
+                      const char* label,
+                      const std::vector<srph::profiler::CallMetrics>& metrics)
+{
+    auto series = [&](const char* name, const char* type, const char* help, auto value)
+    {
+        fmt::format_to(std::back_inserter(out), "# HELP seraph_{}_{} {}\n# TYPE seraph_{}_{} {}\n", prefix, name, help, prefix, name, type);
+        for (const srph::profiler::CallMetrics& m : metrics)
+        {
+            fmt::format_to(std::back_inserter(out), "seraph_{}_{}{{{}}} {}\n", prefix, name, Labels(label, m), value(m));
+        }
+    };
+
+    series("calls_total", "counter", "Calls made through FunctionCaller.", [](const auto& m) { return m.calls; });
+    series("exceptions_total", "counter", "Calls that ended in a script exception.", [](const auto& m) { return m.exceptions; });
+    series("timeouts_total", "counter", "Calls aborted by the script timeout.", [](const auto& m) { return m.timeouts; });
+
+    fmt::format_to(std::back_inserter(out),
+                   "# HELP seraph_{}_latency_seconds Call latency.\n# TYPE seraph_{}_latency_seconds summary\n",
+                   prefix,
+                   prefix);
+    for (const srph::profiler::CallMetrics& m : metrics)
+    {
+        fmt::format_to(std::back_inserter(out),
+                       "seraph_{0}_latency_seconds{{{1},quantile=\"0.5\"}} {2:.9f}\n"
+                       "seraph_{0}_latency_seconds{{{1},quantile=\"0.99\"}} {3:.9f}\n"
+                       "seraph_{0}_latency_seconds_sum{{{1}}} {4:.9f}\n"
+                       "seraph_{0}_latency_seconds_count{{{1}}} {5}\n",
+                       prefix,
+                       Labels(label, m),
+                       static_cast<double>(m.p50Nanos) * 1e-9,
+                       static_cast<double>(m.p99Nanos) * 1e-9,
+                       static_cast<double>(m.totalNanos) * 1e-9,
+                       m.calls);
+    }
+}
+}  // namespace
+
+void srph::profiler::LatencyHistogram::Record(uint64_t nanos)
+{
+    m_buckets[BucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+uint64_t srph::profiler::LatencyHistogram::Percentile(double p) const
+{
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    if (total == 0) return 0;
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * static_cast<double>(total) + 0.5));
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank) return BucketUpperBound(i);
+    }
+
+    return BucketUpperBound(BUCKET_COUNT - 1);
+}
+
+uint32_t srph::profiler::LatencyHistogram::BucketIndex(uint64_t nanos)
+{
+    constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    if (nanos < SUB_BUCKETS) return static_cast<uint32_t>(nanos);
+
+    // The highest bit selects the power of two, the next SUB_BUCKET_BITS bits the linear sub-bucket.
+    const uint32_t msb = HighestBit(nanos);
+    const uint32_t sub = static_cast<uint32_t>(nanos >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return ((msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub;
+}
+
+uint64_t srph::profiler::LatencyHistogram::BucketUpperBound(uint32_t index)
+{
+    constexpr uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    if (index < SUB_BUCKETS) return index;
+
+    const uint32_t shift = (index >> SUB_BUCKET_BITS) - 1;
+    const uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + (index & (SUB_BUCKETS - 1))) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+void srph::profiler::MetricsRegistry::Record(const asIScriptFunction* function,
+                                             const std::string& instanceType,
+                                             uint64_t nanos,
+                                             TraceStatus status)
+{
+    auto record = [&](CallCounters& counters)
+    {
+        counters.calls.fetch_add(1, std::memory_order_relaxed);
+        if (status == TraceStatus::Exception) counters.exceptions.fetch_add(1, std::memory_order_relaxed);
+        if (status == TraceStatus::Timeout) counters.timeouts.fetch_add(1, std::memory_order_relaxed);
+        counters.latency.Record(nanos);
+    };
+
+    if (function) record(FunctionCounters(function));
+    if (!instanceType.empty()) record(TypeCounters(instanceType));
+}
+
+void srph::profiler::MetricsRegistry::ContextCreated()
+{
+    m_contextsCreated.fetch_add(1, std::memory_order_relaxed);
+    AtomicMax(m_contextsPeak, m_contextsActive.fetch_add(1, std::memory_order_relaxed) + 1);
+}
+
+void srph::profiler::MetricsRegistry::ContextReleased()
+{
+    // Contexts created before metrics were enabled are released without being counted.
+    uint64_t active = m_contextsActive.load(std::memory_order_relaxed);
+    while (active > 0 && !m_contextsActive.compare_exchange_weak(active, active - 1, std::memory_order_relaxed))
+    {
+    }
+}
+
+srph::profiler::CallCounters& srph::profiler::MetricsRegistry::FunctionCounters(const asIScriptFunction* function)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_functions.find(function);
+        if (it != m_functions.end()) return it->second->counters;
+    }
+
+    // Resolved once, so the name stays valid after the module is discarded
+    const char* module = function->GetModuleName();
+    std::pair<std::string, std::string> key(module ? module : "", function->GetDeclaration(true, true));
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto& entry = m_series[key];
+    if (!entry)
+    {
+        entry = std::make_unique<FunctionEntry>();
+        entry->module = std::move(key.first);
+        entry->name = std::move(key.second);
+    }
+
+    m_functions[function] = entry.get();
+    Engine::TrackFunction(function);
+    return entry->counters;
+}
+
+void srph::profiler::MetricsRegistry::FunctionDestroyed(const asIScriptFunction* function)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_functions.erase(function);
+}
+
+srph::profiler::CallCounters& srph::profiler::MetricsRegistry::TypeCounters(const std::string& typeName)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_types.find(typeName);
+        if (it != m_types.end()) return *it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto& entry = m_types[typeName];
+    if (!entry) entry = std::make_unique<CallCounters>();
+
+    return *entry;
+}
+
+srph::profiler::MetricsSnapshot srph::profiler::MetricsRegistry::Snapshot() const
+{
+    MetricsSnapshot snapshot;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+        snapshot.functions.reserve(m_series.size());
+        for (auto& [key, entry] : m_series)
+        {
+            snapshot.functions.push_back(ToMetrics(entry->name, entry->module, entry->counters));
+        }
+
+        snapshot.types.reserve(m_types.size());
+        for (auto& [name, counters] : m_types)
+        {
+            snapshot.types.push_back(ToMetrics(name, {}, *counters));
+        }
+    }
+
+    auto byName = [](const CallMetrics& a, const CallMetrics& b) { return a.name < b.name; };
+    std::sort(snapshot.functions.begin(), snapshot.functions.end(), byName);
+    std::sort(snapshot.types.begin(), snapshot.types.end(), byName);
+
+    snapshot.contexts.created = m_contextsCreated.load(std::memory_order_relaxed);
+    snapshot.contexts.active = m_contextsActive.load(std::memory_order_relaxed);
+    snapshot.contexts.peak = m_contextsPeak.load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+std::string srph::profiler::MetricsRegistry::Prometheus() const
+{
+    const MetricsSnapshot snapshot = Snapshot();
+
+    fmt::memory_buffer out;
+    WriteCallMetrics(out, "function", "function", snapshot.functions);
+    WriteCallMetrics(out, "type", "type", snapshot.types);
+
+    fmt::format_to(std::back_inserter(out),
+                   "# HELP seraph_contexts_created_total Script contexts created.\n"
+                   "# TYPE seraph_contexts_created_total counter\n"
+                   "seraph_contexts_created_total {}\n"
+                   "# HELP seraph_contexts_active Script contexts currently in use.\n"
+                   "# TYPE seraph_contexts_active gauge\n"
+                   "seraph_contexts_active {}\n"
+                   "# HELP seraph_contexts_peak Highest number of script contexts in use at once.\n"
+                   "# TYPE seraph_contexts_peak gauge\n"
+                   "seraph_contexts_peak {}\n",
+                   snapshot.contexts.created,
+                   snapshot.contexts.active,
+                   snapshot.contexts.peak);
+
+    return fmt::to_string(out);
+}
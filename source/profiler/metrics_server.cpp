@@ -0,0 +1,180 @@
+#include "srph_common.hpp"
+#include "profiler/metrics_server.hpp"
+#include "profiler/metrics.hpp"
+
+namespace
+{
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+constexpr auto CLIENT_TIMEOUT = std::chrono::seconds(5);
+}  // namespace
+
+struct srph::profiler::MetricsServer::Client
+{
+    explicit Client(asio::ip::tcp::socket s) : socket(std::move(s)), deadline(socket.get_executor()) {}
+
+    asio::ip::tcp::socket socket;
+    asio::steady_timer deadline;
+    std::string request;
+    std::string response;
+};
+
+srph::profiler::MetricsServer::MetricsServer(const MetricsRegistry* registry, uint16_t port)
+{
+    m_registry = registry;
+    m_port = port;
+}
+
+srph::profiler::MetricsServer::~MetricsServer() { Stop(); }
+
+bool srph::profiler::MetricsServer::Start()
+{
+    if (m_running.load()) return true;
+
+    m_io = std::make_unique<asio::io_context>();
+
+    asio::error_code ec;
+    m_acceptor = std::make_unique<asio::ip::tcp::acceptor>(*m_io);
+    asio::ip::tcp::endpoint endpoint(asio::ip::address_v4::loopback(), m_port);
+    m_acceptor->open(endpoint.protocol(), ec);
+    if (!ec) m_acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true), ec);
+    if (!ec) m_acceptor->bind(endpoint, ec);
+    if (!ec) m_acceptor->listen(asio::socket_base::max_listen_connections, ec);
+
+    if (ec)
+    {
+        SRPH_LOG_ERROR("Failed to start metrics endpoint on port {}: {}", m_port, ec.message());
+        m_acceptor.reset();
+        m_io.reset();
+        return false;
+    }
+
+    m_running.store(true);
+    m_thread = std::thread([this]() { ServerLoop(); });
+
+    return true;
+}
+
+void srph::profiler::MetricsServer::Stop()
+{
+    m_running.store(false);
+
+    // Closing the acceptor and the open connections on the server thread completes their pending operations, after
+    // which the io_context runs out of work and the server thread ends.
+    if (m_io && m_thread.joinable())
+    {
+        asio::post(*m_io,
+                   [this]()
+                   {
+                       asio::error_code ec;
+                       m_acceptor->close(ec);
+
+                       const std::vector<std::shared_ptr<Client>> clients(m_clients.begin(), m_clients.end());
+                       for (const auto& client : clients)
+                       {
+                           Close(client);
+                       }
+                   });
+    }
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    m_clients.clear();
+    m_acceptor.reset();
+    m_io.reset();
+}
+
+void srph::profiler::MetricsServer::ServerLoop()
+{
+    SRPH_LOG_INFO("Seraph metrics endpoint listening on http://127.0.0.1:{}/metrics", m_port);
+
+    Accept();
+    m_io->run();
+}
+
+void srph::profiler::MetricsServer::Accept()
+{
+    m_acceptor->async_accept(
+        [this](const asio::error_code& ec, asio::ip::tcp::socket socket)
+        {
+            if (ec || !m_running.load())
+            {
+                if (m_running.load())
+                {
+                    SRPH_LOG_ERROR("Metrics endpoint accept failed: {}", ec.message());
+                }
+                return;
+            }
+
+            auto client = std::make_shared<Client>(std::move(socket));
+            m_clients.insert(client);
+            Read(client);
+
+            Accept();
+        });
+}
+
+void srph::profiler::MetricsServer::Read(const std::shared_ptr<Client>& client)
+{
+    client->deadline.expires_after(CLIENT_TIMEOUT);
+    client->deadline.async_wait(
+        [this, client](const asio::error_code& ec)
+        {
+            if (!ec) Close(client);
+        });
+
+    asio::async_read_until(client->socket,
+                           asio::dynamic_buffer(client->request, MAX_REQUEST_SIZE),
+                           "\r\n\r\n",
+                           [this, client](const asio::error_code& ec, size_t /*bytes*/)
+                           {
+                               if (ec)
+                               {
+                                   Close(client);
+                                   return;
+                               }
+
+                               client->response = Response(client->request);
+                               asio::async_write(client->socket,
+                                                 asio::buffer(client->response),
+                                                 [this, client](const asio::error_code& /*ec*/, size_t /*bytes*/) { Close(client); });
+                           });
+}
+
+void srph::profiler::MetricsServer::Close(const std::shared_ptr<Client>& client)
+{
+    if (m_clients.erase(client) == 0) return;
+
+    asio::error_code ec;
+    client->deadline.cancel();
+    client->socket.shutdown(asio::socket_base::shutdown_both, ec);
+    client->socket.close(ec);
+}
+
+std::string srph::profiler::MetricsServer::Response(const std::string& request) const
+{
+    const size_t lineEnd = request.find("\r\n");
+    const std::string requestLine = request.substr(0, lineEnd);
+
+    std::string status = "200 OK";
+    std::string body;
+    if (requestLine.rfind("GET /metrics ", 0) == 0 || requestLine.rfind("GET / ", 0) == 0)
+    {
+        body = m_registry->Prometheus();
+    }
+    else
+    {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+
+    return fmt::format("HTTP/1.1 {}\r\n"
+                       "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                       "Content-Length: {}\r\n"
+                       "Connection: close\r\n\r\n{}",
+                       status,
+                       body.size(),
+                       body);
+}
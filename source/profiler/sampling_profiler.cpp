@@ -0,0 +1,265 @@
+#include "srph_common.hpp"
+#include "profiler/sampling_profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#include "engine.hpp"
+
+srph::profiler::SamplingProfiler::SamplingProfiler(uint32_t intervalMicros) { m_intervalMicros = intervalMicros; }
+
+srph::profiler::SamplingProfiler::~SamplingProfiler() { Stop(); }
+
+void srph::profiler::SamplingProfiler::Start()
+{
+    if (m_running.exchange(true)) return;
+
+    m_thread = std::thread([this]() { SamplerLoop(); });
+}
+
+void srph::profiler::SamplingProfiler::Stop()
+{
+    m_running.store(false);
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void srph::profiler::SamplingProfiler::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_samplesMutex);
+    m_sampleCount = 0;
+    m_functions.clear();
+    m_lines.clear();
+    m_stacks.clear();
+}
+
+void srph::profiler::SamplingProfiler::Enter(asIScriptContext* context)
+{
+    std::lock_guard<std::mutex> lock(m_activeMutex);
+    m_active[std::this_thread::get_id()].push_back({context, false, false});
+}
+
+void srph::profiler::SamplingProfiler::Leave(asIScriptContext* context)
+{
+    std::lock_guard<std::mutex> lock(m_activeMutex);
+    auto& stack = m_active[std::this_thread::get_id()];
+    if (!stack.empty() && stack.back().context == context)
+    {
+        stack.pop_back();
+    }
+}
+
+bool srph::profiler::SamplingProfiler::ConsumeSample(asIScriptContext* context)
+{
+    bool resume = false;
+    {
+        std::lock_guard<std::mutex> lock(m_activeMutex);
+        auto& stack = m_active[std::this_thread::get_id()];
+        if (stack.empty() || stack.back().context != context || !stack.back().pending) return false;
+
+        // A yield, time slice or breakpoint in the same line, the context has to stay suspended
+        resume = !stack.back().suspendRequested;
+        stack.back().pending = false;
+        stack.back().suspendRequested = false;
+    }
+
+    Record(context);
+    return resume;
+}
+
+void srph::profiler::SamplingProfiler::SuspendRequested(asIScriptContext* context)
+{
+    std::lock_guard<std::mutex> lock(m_activeMutex);
+    auto& stack = m_active[std::this_thread::get_id()];
+    if (!stack.empty() && stack.back().context == context)
+    {
+        stack.back().suspendRequested = true;
+    }
+}
+
+void srph::profiler::SamplingProfiler::SamplerLoop()
+{
+    while (m_running.load())
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(m_intervalMicros));
+
+        std::lock_guard<std::mutex> lock(m_activeMutex);
+        for (auto& [thread, stack] : m_active)
+        {
+            if (stack.empty() || stack.back().pending) continue;
+
+            // Suspend only sets a flag, the context stops at the next line cue and the engine resumes it after
+            // recording the sample.
+            stack.back().pending = true;
+            stack.back().context->Suspend();
+        }
+    }
+}
+
+void srph::profiler::SamplingProfiler::Record(asIScriptContext* context)
+{
+    std::lock_guard<std::mutex> lock(m_samplesMutex);
+
+    const asUINT depth = context->GetCallstackSize();
+    if (depth == 0) return;
+
+    m_sampleCount++;
+
+    // Outermost frame first
+    m_scratch.clear();
+    for (asUINT i = depth; i-- > 0;)
+    {
+        asIScriptFunction* function = context->GetFunction(i);
+        if (!function) continue;
+
+        m_scratch.push_back(FunctionId(function));
+    }
+
+    if (m_scratch.empty()) return;
+
+    m_stacks[m_scratch]++;
+
+    const uint32_t top = m_scratch.back();
+    m_lines[{top, context->GetLineNumber(0)}]++;
+
+    // Count every function once per sample, even when recursing
+    for (size_t i = 0; i < m_scratch.size(); i++)
+    {
+        if (std::find(m_scratch.begin(), m_scratch.begin() + i, m_scratch[i]) == m_scratch.begin() + i)
+        {
+            FunctionSamples& samples = m_functions[m_scratch[i]];
+            if (samples.name.empty()) samples.name = m_infos[m_scratch[i]].name;
+            samples.totalSamples++;
+        }
+    }
+
+    m_functions[top].selfSamples++;
+}
+
+uint32_t srph::profiler::SamplingProfiler::FunctionId(asIScriptFunction* function)
+{
+    auto it = m_ids.find(function);
+    if (it != m_ids.end()) return it->second;
+
+    const char* section = nullptr;
+    function->GetDeclaredAt(&section, nullptr, nullptr);
+    m_infos.push_back({function->GetDeclaration(true, true), section ? section : ""});
+    Engine::TrackFunction(function);
+
+    return m_ids.emplace(function, static_cast<uint32_t>(m_infos.size() - 1)).first->second;
+}
+
+void srph::profiler::SamplingProfiler::FunctionDestroyed(const asIScriptFunction* function)
+{
+    std::lock_guard<std::mutex> lock(m_samplesMutex);
+    m_ids.erase(function);
+}
+
+uint64_t srph::profiler::SamplingProfiler::SampleCount() const
+{
+    std::lock_guard<std::mutex> lock(m_samplesMutex);
+    return m_sampleCount;
+}
+
+std::vector<srph::profiler::FunctionSamples> srph::profiler::SamplingProfiler::TopFunctions(size_t count) const
+{
+    std::vector<FunctionSamples> out;
+    {
+        std::lock_guard<std::mutex> lock(m_samplesMutex);
+        out.reserve(m_functions.size());
+        for (auto& entry : m_functions)
+        {
+            out.push_back(entry.second);
+        }
+    }
+
+    std::sort(out.begin(),
+              out.end(),
+              [](const FunctionSamples& a, const FunctionSamples& b)
+              { return a.selfSamples != b.selfSamples ? a.selfSamples > b.selfSamples : a.totalSamples > b.totalSamples; });
+    if (out.size() > count) out.resize(count);
+
+    return out;
+}
+
+std::vector<srph::profiler::LineSamples> srph::profiler::SamplingProfiler::TopLines(size_t count) const
+{
+    std::vector<LineSamples> out;
+    {
+        std::lock_guard<std::mutex> lock(m_samplesMutex);
+        out.reserve(m_lines.size());
+        for (auto& [frame, samples] : m_lines)
+        {
+            const FunctionInfo& info = m_infos[frame.function];
+            out.push_back({info.name, info.section, frame.line, samples});
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const LineSamples& a, const LineSamples& b) { return a.samples > b.samples; });
+    if (out.size() > count) out.resize(count);
+
+    return out;
+}
+
+std::string srph::profiler::SamplingProfiler::CollapsedStacks() const
+{
+    std::lock_guard<std::mutex> lock(m_samplesMutex);
+
+    fmt::memory_buffer out;
+    for (auto& [stack, samples] : m_stacks)
+    {
+        for (size_t i = 0; i < stack.size(); i++)
+        {
+            if (i > 0) out.push_back(';');
+            const std::string& name = m_infos[stack[i]].name;
+            out.append(name.data(), name.data() + name.size());
+        }
+        fmt::format_to(std::back_inserter(out), " {}\n", samples);
+    }
+
+    return fmt::to_string(out);
+}
+
+bool srph::profiler::SamplingProfiler::WriteCollapsedStacks(const std::string& path) const
+{
+    std::ofstream stream{path};
+    if (!stream) return false;
+
+    stream << CollapsedStacks();
+    return stream.good();
+}
+
+std::string srph::profiler::SamplingProfiler::Report(size_t count) const
+{
+    const uint64_t total = SampleCount();
+    if (total == 0) return "No samples recorded.\n";
+
+    fmt::memory_buffer out;
+    auto percent = [total](uint64_t samples) { return 100.0 * static_cast<double>(samples) / static_cast<double>(total); };
+
+    fmt::format_to(std::back_inserter(out), "{} samples\n\n{:>8} {:>8}  Function\n", total, "Self %", "Total %");
+    for (const FunctionSamples& function : TopFunctions(count))
+    {
+        fmt::format_to(std::back_inserter(out),
+                       "{:>7.2f}% {:>7.2f}%  {}\n",
+                       percent(function.selfSamples),
+                       percent(function.totalSamples),
+                       function.name);
+    }
+
+    fmt::format_to(std::back_inserter(out), "\n{:>8}  Line\n", "Self %");
+    for (const LineSamples& line : TopLines(count))
+    {
+        fmt::format_to(std::back_inserter(out),
+                       "{:>7.2f}%  {}:{} ({})\n",
+                       percent(line.samples),
+                       line.section,
+                       line.line,
+                       line.function);
+    }
+
+    return fmt::to_string(out);
+}
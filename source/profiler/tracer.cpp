@@ -0,0 +1,260 @@
+#include "srph_common.hpp"
+#include "profiler/tracer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "magic_enum/magic_enum.hpp"
+
+#include "engine.hpp"
+
+namespace
+{
+constexpr uint32_t NO_NAME = UINT32_MAX;
+
+std::atomic<uint64_t> g_nextTracerId{1};
+
+struct CachedBuffer
+{
+    uint64_t tracerId = 0;
+    void* buffer = nullptr;
+};
+
+thread_local CachedBuffer t_buffer;
+}  // namespace
+
+srph::profiler::Tracer::Tracer(const TracerOptions& options)
+{
+    m_options = options;
+    m_options.eventsPerThread = std::max(m_options.eventsPerThread, 1u);
+    m_id = g_nextTracerId.fetch_add(1);
+    m_epoch = std::chrono::steady_clock::now();
+}
+
+srph::profiler::Tracer::~Tracer() = default;
+
+void srph::profiler::Tracer::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (auto& buffer : m_buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->head = 0;
+    }
+}
+
+uint64_t srph::profiler::Tracer::EventCount() const
+{
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+    uint64_t count = 0;
+    for (auto& buffer : m_buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        count += std::min<uint64_t>(buffer->head, buffer->events.size());
+    }
+
+    return count;
+}
+
+uint64_t srph::profiler::Tracer::OverwrittenCount() const
+{
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+    uint64_t count = 0;
+    for (auto& buffer : m_buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if (buffer->head > buffer->events.size()) count += buffer->head - buffer->events.size();
+    }
+
+    return count;
+}
+
+void srph::profiler::Tracer::Begin(asIScriptContext* context, const std::string& instanceType)
+{
+    ThreadBuffer* buffer = Buffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    // The context is prepared, so the entry function is already on the callstack.
+    const asIScriptFunction* function = context->GetFunction(0);
+    const uint32_t type = instanceType.empty() ? NO_NAME : Intern(buffer, instanceType);
+
+    buffer->scopes.push_back({context, function, type, Now(), {}});
+}
+
+void srph::profiler::Tracer::End(TraceStatus status)
+{
+    const uint64_t now = Now();
+
+    ThreadBuffer* buffer = Buffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    if (buffer->scopes.empty()) return;
+
+    Scope& scope = buffer->scopes.back();
+
+    for (size_t i = scope.frames.size(); i-- > 0;)
+    {
+        const OpenFrame& frame = scope.frames[i];
+        Push(buffer, {Intern(buffer, frame.function), NO_NAME, status, true, frame.startNanos, now - frame.startNanos});
+    }
+
+    if (scope.function)
+    {
+        Push(buffer, {Intern(buffer, scope.function), scope.instanceType, status, false, scope.startNanos, now - scope.startNanos});
+    }
+
+    buffer->scopes.pop_back();
+}
+
+void srph::profiler::Tracer::LineCallback(asIScriptContext* context)
+{
+    ThreadBuffer* buffer = Buffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    auto scope = std::find_if(buffer->scopes.rbegin(),
+                              buffer->scopes.rend(),
+                              [context](const Scope& s) { return s.context == context; });
+    if (scope == buffer->scopes.rend()) return;
+
+    // Frame i of the scope is the function at depth i + 1, counted from the entry function.
+    std::vector<OpenFrame>& frames = scope->frames;
+    const asUINT depth = context->GetCallstackSize();
+    const size_t callDepth = depth > 0 ? depth - 1 : 0;
+
+    size_t common = 0;
+    while (common < frames.size() && common < callDepth &&
+           frames[common].function == context->GetFunction(depth - 2 - static_cast<asUINT>(common)))
+    {
+        common++;
+    }
+
+    if (common == frames.size() && common == callDepth) return;
+
+    const uint64_t now = Now();
+    while (frames.size() > common)
+    {
+        const OpenFrame& frame = frames.back();
+        Push(buffer,
+             {Intern(buffer, frame.function), NO_NAME, TraceStatus::Finished, true, frame.startNanos, now - frame.startNanos});
+        frames.pop_back();
+    }
+
+    for (size_t i = common; i < callDepth; i++)
+    {
+        frames.push_back({context->GetFunction(depth - 2 - static_cast<asUINT>(i)), now});
+    }
+}
+
+srph::profiler::Tracer::ThreadBuffer* srph::profiler::Tracer::Buffer()
+{
+    if (t_buffer.tracerId == m_id) return static_cast<ThreadBuffer*>(t_buffer.buffer);
+
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->index = static_cast<uint32_t>(m_buffers.size());
+    buffer->events.resize(m_options.eventsPerThread);
+
+    t_buffer = {m_id, buffer.get()};
+    m_buffers.push_back(std::move(buffer));
+
+    return m_buffers.back().get();
+}
+
+uint64_t srph::profiler::Tracer::Now() const
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+}
+
+void srph::profiler::Tracer::Push(ThreadBuffer* buffer, const TraceEvent& event)
+{
+    buffer->events[buffer->head % buffer->events.size()] = event;
+    buffer->head++;
+}
+
+uint32_t srph::profiler::Tracer::Intern(ThreadBuffer* buffer, const asIScriptFunction* function)
+{
+    if (!function) return NO_NAME;
+
+    auto it = buffer->functionNames.find(function);
+    if (it != buffer->functionNames.end()) return it->second;
+
+    const uint32_t index = static_cast<uint32_t>(buffer->names.size());
+    buffer->names.push_back(function->GetDeclaration(true, true));
+    buffer->functionNames.emplace(function, index);
+    Engine::TrackFunction(function);
+
+    return index;
+}
+
+void srph::profiler::Tracer::FunctionDestroyed(const asIScriptFunction* function)
+{
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (auto& buffer : m_buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->functionNames.erase(function);
+    }
+}
+
+uint32_t srph::profiler::Tracer::Intern(ThreadBuffer* buffer, const std::string& typeName)
+{
+    auto it = buffer->typeNames.find(typeName);
+    if (it != buffer->typeNames.end()) return it->second;
+
+    const uint32_t index = static_cast<uint32_t>(buffer->names.size());
+    buffer->names.push_back(typeName);
+    buffer->typeNames.emplace(typeName, index);
+
+    return index;
+}
+
+std::string srph::profiler::Tracer::ExportChromeTrace() const
+{
+    nlohmann::json events = nlohmann::json::array();
+
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (auto& buffer : m_buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+        events.push_back({{"name", "thread_name"},
+                          {"ph", "M"},
+                          {"pid", 1},
+                          {"tid", buffer->index},
+                          {"args", {{"name", fmt::format("Script thread {}", buffer->index)}}}});
+
+        const uint64_t capacity = buffer->events.size();
+        const uint64_t first = buffer->head > capacity ? buffer->head - capacity : 0;
+        for (uint64_t i = first; i < buffer->head; i++)
+        {
+            const TraceEvent& event = buffer->events[i % capacity];
+
+            nlohmann::json args = {{"status", magic_enum::enum_name(event.status)}};
+            if (event.instanceType != NO_NAME) args["instance"] = buffer->names[event.instanceType];
+
+            events.push_back({{"name", event.name != NO_NAME ? buffer->names[event.name] : "<unknown>"},
+                              {"cat", event.scriptCall ? "script" : "native"},
+                              {"ph", "X"},
+                              {"ts", static_cast<double>(event.startNanos) / 1000.0},
+                              {"dur", static_cast<double>(event.durationNanos) / 1000.0},
+                              {"pid", 1},
+                              {"tid", buffer->index},
+                              {"args", std::move(args)}});
+        }
+    }
+
+    return nlohmann::json{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}}.dump();
+}
+
+bool srph::profiler::Tracer::WriteChromeTrace(const std::string& path) const
+{
+    std::ofstream stream{path};
+    if (!stream) return false;
+
+    stream << ExportChromeTrace();
+    return stream.good();
+}
@@ -0,0 +1,204 @@
+#include "srph_common.hpp"
+#include "runtime/command_queue.hpp"
+
+#include <cstring>
+
+#include "engine.hpp"
+
+namespace
+{
+// Fills the rest of the ring when a command does not fit in front of the wrap
+constexpr uint32_t PADDING = UINT32_MAX;
+
+struct EntryHeader
+{
+    uint32_t command;
+    uint32_t size;
+};
+constexpr uint64_t HEADER_SIZE = sizeof(EntryHeader);
+static_assert(HEADER_SIZE == 8, "Entries are aligned to 8 bytes.");
+
+constexpr uint64_t Align(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+uint32_t RoundUpPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 64;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+std::atomic<uint64_t> s_nextQueueId{1};
+
+// Ring of the last queue the thread posted to
+struct ThreadRingCache
+{
+    uint64_t queueId = 0;
+    void* ring = nullptr;
+};
+thread_local ThreadRingCache t_ringCache;
+}  // namespace
+
+class srph::runtime::CommandQueue::Ring
+{
+public:
+    explicit Ring(uint32_t capacity) : m_buffer(new char[capacity]), m_capacity(capacity) {}
+    ~Ring() { delete[] m_buffer; }
+
+    // Producer thread only
+    bool Write(uint32_t command, const void* data, uint32_t size)
+    {
+        const uint64_t entrySize = HEADER_SIZE + Align(size);
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        const uint64_t tail = m_tail.load(std::memory_order_acquire);
+
+        const uint64_t offset = head & (m_capacity - 1);
+        const uint64_t untilEnd = m_capacity - offset;
+        const uint64_t needed = entrySize > untilEnd ? untilEnd + entrySize : entrySize;
+        if (head + needed - tail > m_capacity) return false;
+
+        if (entrySize > untilEnd)
+        {
+            *reinterpret_cast<EntryHeader*>(m_buffer + offset) = {PADDING, static_cast<uint32_t>(untilEnd - HEADER_SIZE)};
+            head += untilEnd;
+        }
+
+        char* entry = m_buffer + (head & (m_capacity - 1));
+        *reinterpret_cast<EntryHeader*>(entry) = {command, size};
+        std::memcpy(entry + HEADER_SIZE, data, size);
+
+        m_head.store(head + entrySize, std::memory_order_release);
+        m_posted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer thread only, commands posted while draining are left for the next drain
+    template <typename Func>
+    uint32_t Read(Func&& func)
+    {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+
+        uint32_t count = 0;
+        while (tail != head)
+        {
+            const char* entry = m_buffer + (tail & (m_capacity - 1));
+            const EntryHeader header = *reinterpret_cast<const EntryHeader*>(entry);
+
+            if (header.command != PADDING)
+            {
+                func(header.command, entry + HEADER_SIZE);
+                count++;
+            }
+
+            tail += HEADER_SIZE + Align(header.size);
+            // Per command, the producer can refill the space while long handlers run.
+            m_tail.store(tail, std::memory_order_release);
+        }
+
+        return count;
+    }
+
+    uint64_t Posted() const { return m_posted.load(std::memory_order_relaxed); }
+
+private:
+    char* m_buffer;
+    uint64_t m_capacity;
+
+    // On their own cache lines, written by different threads.
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+    std::atomic<uint64_t> m_posted{0};
+};
+
+srph::runtime::CommandQueue::CommandQueue(Engine* engine, uint32_t ringBytes)
+{
+    m_engine = engine;
+    m_id = s_nextQueueId.fetch_add(1, std::memory_order_relaxed);
+    m_ringBytes = RoundUpPowerOfTwo(ringBytes);
+}
+
+srph::runtime::CommandQueue::~CommandQueue() = default;
+
+void srph::runtime::CommandQueue::RegisterCommand(const std::string& typeName,
+                                                   uint32_t size,
+                                                   std::function<void(const void*)> handler)
+{
+    if (HEADER_SIZE + Align(size) > m_ringBytes)
+    {
+        SRPH_LOG_ERROR("Command {} does not fit in a ring of {} bytes.", typeName, m_ringBytes);
+        return;
+    }
+
+    Command& command = m_commands.emplace_back(Command{this, static_cast<uint32_t>(m_commands.size()), size, std::move(handler)});
+
+    const std::string decl = fmt::format("bool post(const {}&in)", typeName);
+    SRPH_VERIFY(m_engine->GetEngine()->RegisterGlobalFunction(decl.c_str(), asFUNCTION(ScriptPost), asCALL_GENERIC, &command),
+                "Failed to register command post.")
+}
+
+uint32_t srph::runtime::CommandQueue::Drain()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        m_draining.clear();
+        for (const std::unique_ptr<Ring>& ring : m_rings)
+        {
+            m_draining.push_back(ring.get());
+        }
+    }
+
+    uint32_t count = 0;
+    for (Ring* ring : m_draining)
+    {
+        count += ring->Read([this](uint32_t command, const void* data) { m_commands[command].handler(data); });
+    }
+
+    m_drained += count;
+    return count;
+}
+
+srph::runtime::CommandQueueStats srph::runtime::CommandQueue::Stats() const
+{
+    CommandQueueStats stats;
+    stats.drained = m_drained;
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    stats.rings = static_cast<uint32_t>(m_rings.size());
+    for (const std::unique_ptr<Ring>& ring : m_rings)
+    {
+        stats.posted += ring->Posted();
+    }
+
+    return stats;
+}
+
+bool srph::runtime::CommandQueue::Post(const Command& command, const void* data)
+{
+    if (ThreadRing()->Write(command.index, data, command.size)) return true;
+
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+srph::runtime::CommandQueue::Ring* srph::runtime::CommandQueue::ThreadRing()
+{
+    if (t_ringCache.queueId == m_id) return static_cast<Ring*>(t_ringCache.ring);
+
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    Ring*& ring = m_threadRings[std::this_thread::get_id()];
+    if (!ring)
+    {
+        ring = m_rings.emplace_back(std::make_unique<Ring>(m_ringBytes)).get();
+    }
+
+    t_ringCache = {m_id, ring};
+    return ring;
+}
+
+void srph::runtime::CommandQueue::ScriptPost(asIScriptGeneric* generic)
+{
+    const Command* command = static_cast<const Command*>(generic->GetAuxiliary());
+    const bool posted = command->queue->Post(*command, generic->GetArgAddress(0));
+    generic->SetReturnByte(posted ? 1 : 0);
+}
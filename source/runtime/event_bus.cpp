@@ -0,0 +1,178 @@
+#include "srph_common.hpp"
+#include "runtime/event_bus.hpp"
+
+#include "engine.hpp"
+
+namespace
+{
+constexpr const char* LINE_CALLBACK = "event_bus";
+}
+
+srph::runtime::EventBus::EventBus(Engine* engine) { m_engine = engine; }
+
+srph::runtime::EventBus::~EventBus()
+{
+    for (auto& [type, handlers] : m_handlers)
+    {
+        type->Release();
+    }
+
+    if (m_context)
+    {
+        m_engine->ReleaseContext(m_context);
+    }
+}
+
+srph::runtime::EventId srph::runtime::EventBus::Register(const std::string& handlerDecl)
+{
+    for (EventId id = 0; id < m_events.size(); id++)
+    {
+        if (m_events[id].handlerDecl == handlerDecl) return id;
+    }
+
+    const EventId id = static_cast<EventId>(m_events.size());
+    m_events.push_back({handlerDecl, {}});
+
+    for (auto& [type, handlers] : m_handlers)
+    {
+        handlers.push_back(type->GetMethodByDecl(handlerDecl.c_str()));
+    }
+
+    // Instances created before the event existed
+    for (const auto& [handle, object] : m_engine->m_instances)
+    {
+        if (asIScriptFunction* handler = Handlers(object->GetObjectType())[id])
+        {
+            m_events[id].subscribers.push_back({object, handler});
+        }
+    }
+
+    return id;
+}
+
+void srph::runtime::EventBus::AddModule(asIScriptModule* module)
+{
+    for (asUINT i = 0; i < module->GetObjectTypeCount(); i++)
+    {
+        Handlers(module->GetObjectTypeByIndex(i));
+    }
+}
+
+void srph::runtime::EventBus::AddInstance(asIScriptObject* object)
+{
+    const std::vector<asIScriptFunction*>& handlers = Handlers(object->GetObjectType());
+    for (EventId id = 0; id < handlers.size(); id++)
+    {
+        if (handlers[id])
+        {
+            m_events[id].subscribers.push_back({object, handlers[id]});
+        }
+    }
+}
+
+std::vector<asIScriptFunction*>& srph::runtime::EventBus::Handlers(asITypeInfo* type)
+{
+    auto it = m_handlers.find(type);
+    if (it != m_handlers.end()) return it->second;
+
+    // Keeps the type alive, a rebuilt module could otherwise hand out a new type at the same address.
+    type->AddRef();
+
+    std::vector<asIScriptFunction*>& handlers = m_handlers[type];
+    handlers.reserve(m_events.size());
+    for (const Event& event : m_events)
+    {
+        handlers.push_back(type->GetMethodByDecl(event.handlerDecl.c_str()));
+    }
+
+    return handlers;
+}
+
+bool srph::runtime::EventBus::CheckArguments(EventId id, size_t count) const
+{
+    // Every handler of an event has the same declaration
+    const asUINT expected = m_events[id].subscribers.front().handler->GetParamCount();
+    if (count != expected)
+    {
+        SRPH_LOG_ERROR("Event {} takes {} arguments, {} were published.", m_events[id].handlerDecl, expected, count);
+        return false;
+    }
+
+    return true;
+}
+
+asIScriptContext* srph::runtime::EventBus::BeginPublish()
+{
+    if (m_dispatching.empty())
+    {
+        m_engine->RegisterLineCallback(LINE_CALLBACK, [this](asIScriptContext* context) { LineCallback(context); });
+    }
+
+    // Nested publishes come from a handler that is running on m_context
+    asIScriptContext* context = nullptr;
+    if (!m_dispatching.empty())
+    {
+        context = m_engine->GetContext();
+    }
+    else
+    {
+        if (!m_context) m_context = m_engine->GetContext();
+        context = m_context;
+    }
+
+    m_dispatching.push_back({context, {}, false});
+    return context;
+}
+
+void srph::runtime::EventBus::EndPublish(asIScriptContext* context)
+{
+    m_dispatching.pop_back();
+
+    if (context != m_context)
+    {
+        m_engine->ReleaseContext(context);
+    }
+    else
+    {
+        context->Unprepare();
+    }
+
+    if (m_dispatching.empty())
+    {
+        m_engine->RemoveLineCallback(LINE_CALLBACK);
+    }
+}
+
+bool srph::runtime::EventBus::Dispatch(asIScriptContext* context, asIScriptFunction* handler)
+{
+    Dispatching& dispatching = m_dispatching.back();
+    dispatching.start = std::chrono::steady_clock::now();
+    dispatching.timedOut = false;
+
+    const int result = m_engine->Execute(context);
+    if (result == asEXECUTION_FINISHED) return true;
+
+    if (result == asEXECUTION_EXCEPTION)
+    {
+        m_engine->LogException(context, fmt::format("while handling event {}", handler->GetDeclaration(true, true)));
+    }
+    else if (m_dispatching.back().timedOut)
+    {
+        m_engine->TimedOut();
+    }
+
+    return false;
+}
+
+void srph::runtime::EventBus::LineCallback(asIScriptContext* context)
+{
+    if (m_dispatching.empty()) return;
+
+    Dispatching& dispatching = m_dispatching.back();
+    if (context != dispatching.context || dispatching.timedOut) return;
+
+    if (m_engine->AbortOnTimeout(context, dispatching.start, "Event handler"))
+    {
+        dispatching.timedOut = true;
+    }
+}
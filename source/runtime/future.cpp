@@ -0,0 +1,108 @@
+#include "srph_common.hpp"
+#include "runtime/future.hpp"
+
+#include "runtime/scheduler.hpp"
+
+namespace
+{
+// Jobs produce native values, handles and script classes cannot be returned
+bool TemplateCallback(asITypeInfo* type, bool& dontGarbageCollect)
+{
+    const int subTypeId = type->GetSubTypeId();
+    if ((subTypeId & asTYPEID_OBJHANDLE) || (subTypeId & asTYPEID_SCRIPTOBJECT) || subTypeId == asTYPEID_VOID)
+    {
+        type->GetEngine()->WriteMessage("future", 0, 0, asMSGTYPE_ERROR, "future<T> only holds primitives and registered value types.");
+        return false;
+    }
+
+    dontGarbageCollect = true;
+    return true;
+}
+}  // namespace
+
+void srph::runtime::ScriptFuture::Register(asIScriptEngine* engine)
+{
+    SRPH_VERIFY(engine->RegisterObjectType("future<class T>", 0, asOBJ_REF | asOBJ_TEMPLATE), "Failed to register future type.")
+
+    SRPH_VERIFY(engine->RegisterObjectBehaviour("future<T>",
+                                                asBEHAVE_TEMPLATE_CALLBACK,
+                                                "bool f(int&in, bool&out)",
+                                                asFUNCTION(TemplateCallback),
+                                                asCALL_CDECL),
+                "Failed to register future template callback.")
+    SRPH_VERIFY(engine->RegisterObjectBehaviour("future<T>", asBEHAVE_ADDREF, "void f()", asMETHOD(ScriptFuture, AddRef), asCALL_THISCALL),
+                "Failed to register future AddRef.")
+    SRPH_VERIFY(engine->RegisterObjectBehaviour("future<T>", asBEHAVE_RELEASE, "void f()", asMETHOD(ScriptFuture, Release), asCALL_THISCALL),
+                "Failed to register future Release.")
+
+    SRPH_VERIFY(engine->RegisterObjectMethod("future<T>", "bool ready() const", asMETHOD(ScriptFuture, Ready), asCALL_THISCALL),
+                "Failed to register future ready.")
+    SRPH_VERIFY(engine->RegisterObjectMethod("future<T>", "bool failed() const", asMETHOD(ScriptFuture, Failed), asCALL_THISCALL),
+                "Failed to register future failed.")
+    SRPH_VERIFY(engine->RegisterObjectMethod("future<T>", "string error() const", asMETHOD(ScriptFuture, Error), asCALL_THISCALL),
+                "Failed to register future error.")
+    SRPH_VERIFY(engine->RegisterObjectMethod("future<T>", "void await()", asMETHOD(ScriptFuture, Await), asCALL_THISCALL),
+                "Failed to register future await.")
+    SRPH_VERIFY(engine->RegisterObjectMethod("future<T>", "const T& get() const", asMETHOD(ScriptFuture, Get), asCALL_THISCALL),
+                "Failed to register future get.")
+}
+
+void srph::runtime::ScriptFuture::Release()
+{
+    if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete this;
+    }
+}
+
+void srph::runtime::ScriptFuture::Resolve(State state, std::string error)
+{
+    CoroutineId waiter = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = std::move(error);
+        m_state.store(state, std::memory_order_release);
+        std::swap(waiter, m_waiter);
+    }
+
+    if (waiter != 0)
+    {
+        m_scheduler->Wake(waiter);
+    }
+}
+
+std::string srph::runtime::ScriptFuture::Error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_error;
+}
+
+void srph::runtime::ScriptFuture::Await()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (GetState() != State::Pending) return;
+
+    if (m_waiter != 0)
+    {
+        asGetActiveContext()->SetException("The future is already awaited by another coroutine.");
+        return;
+    }
+
+    // Suspending only flags the context, the waiter is in place before the coroutine actually stops.
+    m_waiter = m_scheduler->Suspend("await");
+}
+
+const void* srph::runtime::ScriptFuture::Get() const
+{
+    switch (GetState())
+    {
+        case State::Ready:
+            return m_value->Address();
+        case State::Failed:
+            asGetActiveContext()->SetException(fmt::format("The job failed: {}", Error()).c_str());
+            return nullptr;
+        default:
+            asGetActiveContext()->SetException("The future is not ready, await it first.");
+            return nullptr;
+    }
+}
@@ -0,0 +1,158 @@
+#include "srph_common.hpp"
+#include "runtime/garbage_collector.hpp"
+
+#include "engine.hpp"
+
+namespace
+{
+// Steps between two looks at the clock, one step looks at a single object
+constexpr uint32_t STEPS_PER_CHECK = 16;
+// Longest the marking thread keeps scripts waiting, and its pause between slices
+constexpr std::chrono::microseconds MARK_SLICE(200);
+constexpr std::chrono::microseconds MARK_INTERVAL(50);
+// Pause of the marking thread once a cycle is marked, until the script thread destroyed the garbage
+constexpr std::chrono::milliseconds MARK_IDLE(10);
+
+// Contexts AngelScript asks for on its own, for destructors of objects released outside a script call
+asIScriptContext* RequestContext(asIScriptEngine* engine, void* collector)
+{
+    static_cast<srph::runtime::GarbageCollector*>(collector)->EnterScript();
+    return engine->CreateContext();
+}
+
+void ReturnContext(asIScriptEngine*, asIScriptContext* context, void* collector)
+{
+    context->Release();
+    static_cast<srph::runtime::GarbageCollector*>(collector)->LeaveScript();
+}
+}  // namespace
+
+srph::runtime::GarbageCollector::GarbageCollector(Engine* engine, uint32_t budgetMicros, bool backgroundMarking)
+{
+    m_engine = engine;
+    m_background = backgroundMarking;
+
+    // Otherwise every script call and every new object runs a few steps, however long they take.
+    if (budgetMicros > 0)
+    {
+        SRPH_VERIFY(m_engine->GetEngine()->SetEngineProperty(asEP_AUTO_GARBAGE_COLLECT, false),
+                    "Failed to disable the automatic garbage collection.")
+    }
+
+    if (m_background)
+    {
+        SRPH_VERIFY(m_engine->GetEngine()->SetContextCallbacks(RequestContext, ReturnContext, this),
+                    "Failed to set the context callbacks.")
+        m_marker = std::thread(&GarbageCollector::MarkLoop, this);
+    }
+}
+
+srph::runtime::GarbageCollector::~GarbageCollector()
+{
+    if (m_marker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_marker.join();
+
+        SRPH_VERIFY(m_engine->GetEngine()->SetContextCallbacks(nullptr, nullptr, nullptr), "Failed to reset the context callbacks.")
+    }
+}
+
+void srph::runtime::GarbageCollector::Collect(uint32_t budgetMicros)
+{
+    asUINT objects = 0;
+    m_engine->GetEngine()->GetGCStatistics(&objects);
+    if (objects == 0 || budgetMicros == 0) return;
+
+    EnterScript();
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::microseconds(budgetMicros);
+    // Returns 0 once a full cycle is done, the rest of the budget would only start over.
+    int result = 1;
+    do
+    {
+        result = m_engine->GetEngine()->GarbageCollect(asGC_ONE_STEP | asGC_DETECT_GARBAGE | asGC_DESTROY_GARBAGE, STEPS_PER_CHECK);
+        m_steps += STEPS_PER_CHECK;
+    } while (result == 1 && std::chrono::steady_clock::now() < deadline);
+    Record(start);
+    LeaveScript();
+}
+
+void srph::runtime::GarbageCollector::FullCycle()
+{
+    EnterScript();
+    const auto start = std::chrono::steady_clock::now();
+    m_engine->GetEngine()->GarbageCollect(asGC_FULL_CYCLE);
+    Record(start);
+    LeaveScript();
+}
+
+srph::runtime::GcStats srph::runtime::GarbageCollector::Stats() const
+{
+    asUINT objects = 0;
+    asUINT destroyed = 0;
+    asUINT detected = 0;
+    m_engine->GetEngine()->GetGCStatistics(&objects, &destroyed, &detected);
+
+    GcStats stats;
+    stats.objects = objects;
+    stats.destroyed = destroyed;
+    stats.detected = detected;
+    stats.steps = m_steps;
+    stats.backgroundSteps = m_backgroundSteps.load(std::memory_order_relaxed);
+    stats.pauses = m_pauses.Count();
+    stats.p50PauseNanos = m_pauses.Percentile(0.5);
+    stats.p99PauseNanos = m_pauses.Percentile(0.99);
+    stats.maxPauseNanos = m_maxPause.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void srph::runtime::GarbageCollector::Lock()
+{
+    if (m_scriptMutex.try_lock()) return;
+
+    const auto start = std::chrono::steady_clock::now();
+    m_scriptMutex.lock();
+    Record(start);
+}
+
+void srph::runtime::GarbageCollector::Record(std::chrono::steady_clock::time_point start)
+{
+    const auto nanos = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    m_pauses.Record(nanos);
+    if (nanos > m_maxPause.load(std::memory_order_relaxed)) m_maxPause.store(nanos, std::memory_order_relaxed);
+}
+
+void srph::runtime::GarbageCollector::MarkLoop()
+{
+    asIScriptEngine* engine = m_engine->GetEngine();
+    std::unique_lock<std::mutex> wake(m_wakeMutex);
+    while (!m_stopping)
+    {
+        // Returns 0 once the cycle is marked, or when there is nothing to mark.
+        int result = 1;
+        {
+            std::lock_guard<std::mutex> lock(m_scriptMutex);
+            const auto deadline = std::chrono::steady_clock::now() + MARK_SLICE;
+            uint64_t steps = 0;
+            do
+            {
+                for (uint32_t i = 0; i < STEPS_PER_CHECK && result == 1; i++, steps++)
+                {
+                    result = engine->GarbageCollect(asGC_ONE_STEP | asGC_DETECT_GARBAGE | asGC_MARK_ONLY);
+                }
+            } while (result == 1 && std::chrono::steady_clock::now() < deadline);
+            m_backgroundSteps.fetch_add(steps, std::memory_order_relaxed);
+        }
+
+        m_wake.wait_for(wake, result == 1 ? MARK_INTERVAL : MARK_IDLE, [this] { return m_stopping; });
+    }
+
+    wake.unlock();
+    asThreadCleanup();
+}
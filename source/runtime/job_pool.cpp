@@ -0,0 +1,65 @@
+#include "srph_common.hpp"
+#include "runtime/job_pool.hpp"
+
+#include <algorithm>
+
+srph::runtime::JobPool::JobPool(uint32_t threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency() - 1);
+    }
+
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        m_threads.emplace_back(&JobPool::WorkerLoop, this);
+    }
+}
+
+srph::runtime::JobPool::~JobPool()
+{
+    std::deque<std::function<void()>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        dropped.swap(m_jobs);
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+
+    if (!dropped.empty())
+    {
+        SRPH_LOG_WARN("Dropped {} jobs that had not started.", dropped.size());
+    }
+}
+
+void srph::runtime::JobPool::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+}
+
+void srph::runtime::JobPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping) return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        job();
+    }
+}
@@ -0,0 +1,480 @@
+#include "srph_common.hpp"
+#include "runtime/scheduler.hpp"
+
+#include <algorithm>
+
+#include "engine.hpp"
+#include "debugger/debugger.hpp"
+#include "runtime/future.hpp"
+#include "runtime/garbage_collector.hpp"
+
+namespace
+{
+constexpr const char* LINE_CALLBACK = "scheduler";
+
+// Delegates carry their own object
+asIScriptFunction* EntryFunction(asIScriptFunction* function)
+{
+    return function->GetFuncType() == asFUNC_DELEGATE ? function->GetDelegateFunction() : function;
+}
+
+bool Prepare(asIScriptContext* context, asIScriptFunction* function, asIScriptObject* object)
+{
+    if (context->Prepare(EntryFunction(function)) < 0) return false;
+
+    if (function->GetFuncType() == asFUNC_DELEGATE)
+    {
+        context->SetObject(function->GetDelegateObject());
+    }
+    else if (object)
+    {
+        context->SetObject(object);
+    }
+
+    return true;
+}
+}  // namespace
+
+srph::runtime::Scheduler::Scheduler(Engine* engine)
+{
+    m_engine = engine;
+    m_tickBudgetMicros = engine->m_configuration.tickBudgetMicros;
+}
+
+srph::runtime::Scheduler::~Scheduler()
+{
+    while (!m_coroutines.empty())
+    {
+        Stop(m_coroutines.begin()->first);
+    }
+
+    for (asIScriptContext* context : m_pool)
+    {
+        m_engine->ReleaseContext(context);
+    }
+
+    if (m_conditionContext)
+    {
+        m_engine->ReleaseContext(m_conditionContext);
+    }
+}
+
+void srph::runtime::Scheduler::RegisterInterface()
+{
+    asIScriptEngine* engine = m_engine->GetEngine();
+
+    SRPH_VERIFY(engine->RegisterFuncdef("void coroutine()"), "Failed to register coroutine funcdef.")
+    SRPH_VERIFY(engine->RegisterFuncdef("bool coroutineCondition()"), "Failed to register coroutineCondition funcdef.")
+
+    SRPH_VERIFY(engine->RegisterGlobalFunction("void yield()", asMETHOD(Scheduler, ScriptYield), asCALL_THISCALL_ASGLOBAL, this),
+                "Failed to register yield.")
+    SRPH_VERIFY(engine->RegisterGlobalFunction("void wait(float seconds)", asMETHOD(Scheduler, ScriptWait), asCALL_THISCALL_ASGLOBAL, this),
+                "Failed to register wait.")
+    SRPH_VERIFY(engine->RegisterGlobalFunction("void waitUntil(coroutineCondition@ condition)",
+                                               asMETHOD(Scheduler, ScriptWaitUntil),
+                                               asCALL_THISCALL_ASGLOBAL,
+                                               this),
+                "Failed to register waitUntil.")
+    SRPH_VERIFY(engine->RegisterGlobalFunction("uint startCoroutine(coroutine@ routine)",
+                                               asMETHOD(Scheduler, ScriptStart),
+                                               asCALL_THISCALL_ASGLOBAL,
+                                               this),
+                "Failed to register startCoroutine.")
+    SRPH_VERIFY(engine->RegisterGlobalFunction("void stopCoroutine(uint id)", asMETHOD(Scheduler, ScriptStop), asCALL_THISCALL_ASGLOBAL, this),
+                "Failed to register stopCoroutine.")
+
+    ScriptFuture::Register(engine);
+}
+
+void srph::runtime::Scheduler::Tick(double deltaSeconds)
+{
+    m_time += deltaSeconds;
+
+    const bool sleeperDue = !m_sleeping.empty() && m_sleeping.top().wakeTime <= m_time;
+    const bool wakePending = m_wakePending.load(std::memory_order_acquire);
+    if (m_yielded.empty() && m_deferred.empty() && m_conditional.empty() && !sleeperDue && !wakePending) return;
+
+    m_engine->RegisterLineCallback(LINE_CALLBACK, [this](asIScriptContext* context) { LineCallback(context); });
+
+    // Deferred ones first, so a tick budget rotates through the coroutines instead of starving the tail.
+    // Coroutines yielding during this tick go into m_yielded for the next one.
+    m_batch.clear();
+    m_batch.swap(m_deferred);
+    m_batch.insert(m_batch.end(), m_yielded.begin(), m_yielded.end());
+    m_yielded.clear();
+
+    while (!m_sleeping.empty() && m_sleeping.top().wakeTime <= m_time)
+    {
+        m_batch.push_back(m_sleeping.top().id);
+        m_sleeping.pop();
+    }
+
+    if (wakePending)
+    {
+        std::lock_guard<std::mutex> lock(m_wokenMutex);
+        for (CoroutineId id : m_woken)
+        {
+            auto it = m_coroutines.find(id);
+            if (it != m_coroutines.end() && it->second.wait == WaitKind::External) m_batch.push_back(id);
+        }
+        m_woken.clear();
+        m_wakePending.store(false, std::memory_order_relaxed);
+    }
+
+    for (size_t i = 0; i < m_conditional.size();)
+    {
+        const CoroutineId id = m_conditional[i];
+        if (EvaluateCondition(m_coroutines.at(id).condition))
+        {
+            m_batch.push_back(id);
+            m_conditional[i] = m_conditional.back();
+            m_conditional.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    const auto tickStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < m_batch.size(); i++)
+    {
+        if (m_tickBudgetMicros != 0 && i != 0 &&
+            std::chrono::steady_clock::now() - tickStart >= std::chrono::microseconds(m_tickBudgetMicros))
+        {
+            m_deferred.assign(m_batch.begin() + static_cast<std::ptrdiff_t>(i), m_batch.end());
+            m_deferredResumes += m_deferred.size();
+            break;
+        }
+
+        Resume(m_batch[i]);
+    }
+
+    m_engine->RemoveLineCallback(LINE_CALLBACK);
+}
+
+srph::runtime::CoroutineId srph::runtime::Scheduler::Start(asIScriptFunction* function, asIScriptObject* object)
+{
+    if (!function) return 0;
+
+    asIScriptContext* context = AcquireContext();
+    if (!Prepare(context, function, object))
+    {
+        SRPH_LOG_ERROR("Failed to prepare coroutine {}.", function->GetDeclaration());
+        function->Release();
+        m_pool.push_back(context);
+        return 0;
+    }
+
+    if (object) object->AddRef();
+
+    // Starts on the next tick, so starting coroutines from a coroutine never nests executions.
+    const CoroutineId id = m_nextId++;
+    const EngineConfiguration& configuration = m_engine->m_configuration;
+    m_coroutines[id] = {context, function, object, nullptr, WaitKind::Yield, {configuration.coroutineSliceLines, configuration.coroutineSliceMicros}};
+    m_yielded.push_back(id);
+
+    return id;
+}
+
+void srph::runtime::Scheduler::Stop(CoroutineId id)
+{
+    auto it = m_coroutines.find(id);
+    if (it == m_coroutines.end()) return;
+
+    it->second.context->Abort();
+
+    // Finished once its execution returns
+    if (id == m_running)
+    {
+        m_stopRunning = true;
+        return;
+    }
+
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
+    Finish(id, asEXECUTION_ABORTED);
+}
+
+void srph::runtime::Scheduler::SetSliceBudget(CoroutineId id, SliceBudget budget)
+{
+    auto it = m_coroutines.find(id);
+    if (it != m_coroutines.end())
+    {
+        it->second.budget = budget;
+    }
+}
+
+srph::runtime::CoroutineId srph::runtime::Scheduler::Suspend(const char* function)
+{
+    Coroutine* coroutine = RunningCoroutine(function);
+    if (!coroutine) return 0;
+
+    coroutine->wait = WaitKind::External;
+    m_engine->Suspend(coroutine->context);
+    return m_running;
+}
+
+void srph::runtime::Scheduler::Wake(CoroutineId id)
+{
+    std::lock_guard<std::mutex> lock(m_wokenMutex);
+    m_woken.push_back(id);
+    m_wakePending.store(true, std::memory_order_release);
+}
+
+srph::runtime::CoroutineId srph::runtime::Scheduler::SuspendContext(asIScriptContext* context)
+{
+    auto it = m_coroutines.find(m_running);
+    if (it == m_coroutines.end() || it->second.context != context || context->IsNested()) return 0;
+
+    it->second.wait = WaitKind::External;
+    m_engine->Suspend(context);
+    return m_running;
+}
+
+srph::runtime::CoroutineId srph::runtime::Scheduler::Find(asIScriptContext* context) const
+{
+    for (const auto& entry : m_coroutines)
+    {
+        if (entry.second.context == context) return entry.first;
+    }
+    return 0;
+}
+
+srph::runtime::SchedulerStats srph::runtime::Scheduler::Stats() const
+{
+    SchedulerStats stats;
+    stats.coroutines = static_cast<uint32_t>(m_coroutines.size());
+    stats.pooledContexts = static_cast<uint32_t>(m_pool.size());
+    stats.resumes = m_resumes;
+    stats.completed = m_completed;
+    stats.slices = m_slices;
+    stats.deferred = m_deferredResumes;
+
+    for (const auto& entry : m_coroutines)
+    {
+        switch (entry.second.wait)
+        {
+            case WaitKind::Yield:
+                stats.yielded++;
+                break;
+            case WaitKind::Time:
+                stats.sleeping++;
+                break;
+            case WaitKind::Condition:
+                stats.conditional++;
+                break;
+            case WaitKind::External:
+                stats.external++;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return stats;
+}
+
+void srph::runtime::Scheduler::Resume(CoroutineId id)
+{
+    // Stopped while it was waiting
+    auto it = m_coroutines.find(id);
+    if (it == m_coroutines.end() || it->second.wait == WaitKind::None) return;
+
+    Coroutine& coroutine = it->second;
+    if (coroutine.condition)
+    {
+        coroutine.condition->Release();
+        coroutine.condition = nullptr;
+    }
+    coroutine.wait = WaitKind::None;
+
+    asIScriptContext* context = coroutine.context;
+    m_running = id;
+    m_stopRunning = false;
+    m_executing = context;
+    m_executeStart = std::chrono::steady_clock::now();
+    m_timedOut = false;
+    m_slice = &coroutine.budget;
+    m_sliceLines = 0;
+    m_sliced = false;
+
+    const int result = m_engine->Execute(context);
+
+    m_running = 0;
+    m_executing = nullptr;
+    m_slice = nullptr;
+    m_resumes++;
+
+    if (result == asEXECUTION_SUSPENDED && !m_stopRunning)
+    {
+        if (m_sliced) m_slices++;
+
+        // Out of its slice or suspended by the application, continue on the next tick
+        Coroutine& suspended = m_coroutines.at(id);
+        if (suspended.wait == WaitKind::None)
+        {
+            suspended.wait = WaitKind::Yield;
+            m_yielded.push_back(id);
+        }
+        return;
+    }
+
+    Finish(id, result);
+}
+
+void srph::runtime::Scheduler::Finish(CoroutineId id, int result)
+{
+    auto it = m_coroutines.find(id);
+    Coroutine coroutine = it->second;
+    m_coroutines.erase(it);
+
+    // Due conditions already left the list when the tick collected them
+    auto conditional = std::find(m_conditional.begin(), m_conditional.end(), id);
+    if (coroutine.wait == WaitKind::Condition && conditional != m_conditional.end())
+    {
+        m_conditional.erase(conditional);
+    }
+
+    if (result == asEXECUTION_EXCEPTION)
+    {
+        const char* declaration = EntryFunction(coroutine.function)->GetDeclaration(true, true);
+        m_engine->LogException(coroutine.context, fmt::format("in coroutine {}", declaration));
+    }
+    else if (result == asEXECUTION_ABORTED && m_timedOut)
+    {
+        m_engine->TimedOut();
+    }
+
+    if (coroutine.condition) coroutine.condition->Release();
+    if (coroutine.object) coroutine.object->Release();
+    coroutine.function->Release();
+
+    coroutine.context->Unprepare();
+    m_pool.push_back(coroutine.context);
+    m_completed++;
+
+    if (m_engine->m_debugger) m_engine->m_debugger->CoroutineFinished(id);
+}
+
+bool srph::runtime::Scheduler::EvaluateCondition(asIScriptFunction* condition)
+{
+    if (!m_conditionContext)
+    {
+        m_conditionContext = m_engine->GetContext();
+    }
+
+    if (!Prepare(m_conditionContext, condition, nullptr)) return true;
+
+    m_executing = m_conditionContext;
+    m_executeStart = std::chrono::steady_clock::now();
+    m_timedOut = false;
+
+    const int result = m_engine->Execute(m_conditionContext);
+    m_executing = nullptr;
+
+    if (result == asEXECUTION_FINISHED)
+    {
+        return m_conditionContext->GetReturnByte() != 0;
+    }
+
+    // A broken condition would otherwise keep its coroutine waiting forever.
+    if (result == asEXECUTION_EXCEPTION)
+    {
+        const char* declaration = EntryFunction(condition)->GetDeclaration(true, true);
+        m_engine->LogException(m_conditionContext, fmt::format("in waitUntil condition {}", declaration));
+    }
+    m_conditionContext->Unprepare();
+
+    return true;
+}
+
+asIScriptContext* srph::runtime::Scheduler::AcquireContext()
+{
+    if (m_pool.empty())
+    {
+        return m_engine->GetContext();
+    }
+
+    asIScriptContext* context = m_pool.back();
+    m_pool.pop_back();
+    return context;
+}
+
+srph::runtime::Scheduler::Coroutine* srph::runtime::Scheduler::RunningCoroutine(const char* function)
+{
+    asIScriptContext* context = asGetActiveContext();
+    if (!context) return nullptr;
+
+    auto it = m_coroutines.find(m_running);
+    if (it == m_coroutines.end() || it->second.context != context || context->IsNested())
+    {
+        context->SetException(fmt::format("{}() can only be called from a coroutine.", function).c_str());
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+void srph::runtime::Scheduler::LineCallback(asIScriptContext* context)
+{
+    if (context != m_executing || m_timedOut || m_sliced) return;
+
+    const auto elapsed = std::chrono::steady_clock::now() - m_executeStart;
+
+    // Not while nested, the application function that started the nested call would get the suspension.
+    if (m_slice && !context->IsNested())
+    {
+        m_sliceLines++;
+        if ((m_slice->lines != 0 && m_sliceLines >= m_slice->lines) ||
+            (m_slice->micros != 0 && elapsed >= std::chrono::microseconds(m_slice->micros)))
+        {
+            m_sliced = true;
+            m_engine->Suspend(context);
+            return;
+        }
+    }
+
+    if (m_engine->AbortOnTimeout(context, m_executeStart, "Coroutine"))
+    {
+        m_timedOut = true;
+    }
+}
+
+void srph::runtime::Scheduler::ScriptYield()
+{
+    Coroutine* coroutine = RunningCoroutine("yield");
+    if (!coroutine) return;
+
+    coroutine->wait = WaitKind::Yield;
+    m_yielded.push_back(m_running);
+    m_engine->Suspend(coroutine->context);
+}
+
+void srph::runtime::Scheduler::ScriptWait(float seconds)
+{
+    Coroutine* coroutine = RunningCoroutine("wait");
+    if (!coroutine) return;
+
+    coroutine->wait = WaitKind::Time;
+    m_sleeping.push({m_time + std::max(seconds, 0.0f), m_running});
+    m_engine->Suspend(coroutine->context);
+}
+
+void srph::runtime::Scheduler::ScriptWaitUntil(asIScriptFunction* condition)
+{
+    Coroutine* coroutine = condition ? RunningCoroutine("waitUntil") : nullptr;
+    if (!coroutine)
+    {
+        if (condition) condition->Release();
+        return;
+    }
+
+    coroutine->wait = WaitKind::Condition;
+    coroutine->condition = condition;
+    m_conditional.push_back(m_running);
+    m_engine->Suspend(coroutine->context);
+}
+
+srph::runtime::CoroutineId srph::runtime::Scheduler::ScriptStart(asIScriptFunction* function) { return Start(function); }
+
+void srph::runtime::Scheduler::ScriptStop(CoroutineId id) { Stop(id); }
@@ -0,0 +1,321 @@
+#include "srph_common.hpp"
+#include "runtime/timer_wheel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "engine.hpp"
+#include "runtime/garbage_collector.hpp"
+
+namespace
+{
+constexpr const char* LINE_CALLBACK = "timers";
+}
+
+srph::runtime::TimerWheel::TimerWheel(Engine* engine, uint32_t resolutionMillis)
+{
+    m_engine = engine;
+    m_resolutionSeconds = std::max(1u, resolutionMillis) / 1000.0;
+    m_slots.fill(NONE);
+}
+
+srph::runtime::TimerWheel::~TimerWheel()
+{
+    for (Timer& timer : m_timers)
+    {
+        if (timer.callback) timer.callback->Release();
+    }
+
+    if (m_context)
+    {
+        m_engine->ReleaseContext(m_context);
+    }
+}
+
+void srph::runtime::TimerWheel::RegisterInterface()
+{
+    asIScriptEngine* engine = m_engine->GetEngine();
+
+    SRPH_VERIFY(engine->RegisterFuncdef("void timerCallback()"), "Failed to register timerCallback funcdef.")
+
+    SRPH_VERIFY(engine->RegisterGlobalFunction("uint64 setTimeout(timerCallback@ callback, float seconds)",
+                                               asMETHOD(TimerWheel, ScriptSetTimeout),
+                                               asCALL_THISCALL_ASGLOBAL,
+                                               this),
+                "Failed to register setTimeout.")
+    SRPH_VERIFY(engine->RegisterGlobalFunction("uint64 setInterval(timerCallback@ callback, float seconds)",
+                                               asMETHOD(TimerWheel, ScriptSetInterval),
+                                               asCALL_THISCALL_ASGLOBAL,
+                                               this),
+                "Failed to register setInterval.")
+    SRPH_VERIFY(engine->RegisterGlobalFunction("bool cancel(uint64 id)", asMETHOD(TimerWheel, ScriptCancel), asCALL_THISCALL_ASGLOBAL, this),
+                "Failed to register cancel.")
+}
+
+void srph::runtime::TimerWheel::Advance(double deltaSeconds)
+{
+    m_pendingTicks += deltaSeconds / m_resolutionSeconds;
+    auto steps = static_cast<uint64_t>(m_pendingTicks);
+    m_pendingTicks -= static_cast<double>(steps);
+
+    // Nothing can expire, only the clock moves
+    if (m_active == 0)
+    {
+        m_now += steps;
+        return;
+    }
+
+    bool callbackRegistered = false;
+
+    for (; steps > 0; steps--)
+    {
+        const uint32_t index = static_cast<uint32_t>(m_now & (ROOT_SLOTS - 1));
+        if (index == 0)
+        {
+            for (uint32_t level = 1; level < LEVELS && Cascade(level) == 0; level++)
+            {
+            }
+        }
+
+        m_now++;
+
+        uint32_t& head = m_slots[SlotOf(0, index)];
+        if (head == NONE) continue;
+
+        m_due.clear();
+        for (uint32_t timer = head; timer != NONE; timer = m_timers[timer].next)
+        {
+            m_timers[timer].slot = NONE;
+            m_due.push_back(IdOf(timer));
+        }
+        head = NONE;
+
+        // Added at the front of the slot, reversed to fire in the order the timers were added.
+        std::reverse(m_due.begin(), m_due.end());
+
+        if (!callbackRegistered)
+        {
+            m_engine->RegisterLineCallback(LINE_CALLBACK, [this](asIScriptContext* context) { LineCallback(context); });
+            callbackRegistered = true;
+        }
+
+        for (TimerId id : m_due)
+        {
+            // Cancelled by a callback that fired before
+            const uint32_t timer = IndexOf(id);
+            if (timer == NONE) continue;
+
+            asIScriptFunction* callback = m_timers[timer].callback;
+            if (m_timers[timer].interval != 0)
+            {
+                callback->AddRef();
+                m_timers[timer].expiry += m_timers[timer].interval;
+                Insert(timer);
+            }
+            else
+            {
+                m_timers[timer].callback = nullptr;
+                Free(timer);
+            }
+
+            Fire(callback);
+            callback->Release();
+        }
+    }
+
+    if (callbackRegistered)
+    {
+        m_engine->RemoveLineCallback(LINE_CALLBACK);
+    }
+}
+
+srph::runtime::TimerId srph::runtime::TimerWheel::Add(asIScriptFunction* callback, double delaySeconds, double intervalSeconds)
+{
+    if (!callback) return 0;
+
+    uint32_t index = 0;
+    if (!m_freeTimers.empty())
+    {
+        index = m_freeTimers.back();
+        m_freeTimers.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_timers.size());
+        m_timers.emplace_back().generation = 1;
+    }
+
+    Timer& timer = m_timers[index];
+    timer.callback = callback;
+    // Fires on the step that completes the delay
+    timer.expiry = m_now + Ticks(delaySeconds) - 1;
+    timer.interval = intervalSeconds > 0.0 ? Ticks(intervalSeconds) : 0;
+
+    Insert(index);
+    m_active++;
+
+    return IdOf(index);
+}
+
+bool srph::runtime::TimerWheel::Cancel(TimerId id)
+{
+    const uint32_t index = IndexOf(id);
+    if (index == NONE) return false;
+
+    if (m_timers[index].slot != NONE) Unlink(index);
+
+    // A delegate releases its object
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
+    m_timers[index].callback->Release();
+    m_timers[index].callback = nullptr;
+    Free(index);
+
+    return true;
+}
+
+srph::runtime::TimerStats srph::runtime::TimerWheel::Stats() const { return {m_active, m_fired, m_cascaded}; }
+
+void srph::runtime::TimerWheel::Insert(uint32_t index)
+{
+    Timer& timer = m_timers[index];
+
+    // Overdue timers fire on the next step
+    const uint64_t expiry = std::max(timer.expiry, m_now);
+    const uint64_t delta = expiry - m_now;
+
+    uint32_t slot = NONE;
+    if (delta < ROOT_SLOTS)
+    {
+        slot = SlotOf(0, static_cast<uint32_t>(expiry & (ROOT_SLOTS - 1)));
+    }
+    else
+    {
+        for (uint32_t level = 1; level < LEVELS; level++)
+        {
+            const uint32_t shift = ROOT_BITS + level * LEVEL_BITS;
+            if (delta < (uint64_t(1) << shift) || level == LEVELS - 1)
+            {
+                // Beyond the outermost level the timer waits in its furthest slot and is inserted again
+                // when that slot cascades.
+                const uint64_t reachable = std::min(expiry, m_now + (uint64_t(1) << shift) - 1);
+                slot = SlotOf(level, static_cast<uint32_t>((reachable >> (shift - LEVEL_BITS)) & (LEVEL_SLOTS - 1)));
+                break;
+            }
+        }
+    }
+
+    timer.slot = slot;
+    timer.prev = NONE;
+    timer.next = m_slots[slot];
+    if (timer.next != NONE) m_timers[timer.next].prev = index;
+    m_slots[slot] = index;
+}
+
+void srph::runtime::TimerWheel::Unlink(uint32_t index)
+{
+    Timer& timer = m_timers[index];
+
+    if (timer.prev != NONE) m_timers[timer.prev].next = timer.next;
+    else m_slots[timer.slot] = timer.next;
+
+    if (timer.next != NONE) m_timers[timer.next].prev = timer.prev;
+
+    timer.slot = NONE;
+    timer.prev = NONE;
+    timer.next = NONE;
+}
+
+uint32_t srph::runtime::TimerWheel::Cascade(uint32_t level)
+{
+    const uint32_t index = static_cast<uint32_t>((m_now >> (ROOT_BITS + (level - 1) * LEVEL_BITS)) & (LEVEL_SLOTS - 1));
+
+    uint32_t& head = m_slots[SlotOf(level, index)];
+    uint32_t timer = head;
+    head = NONE;
+
+    while (timer != NONE)
+    {
+        const uint32_t next = m_timers[timer].next;
+        Insert(timer);
+        m_cascaded++;
+        timer = next;
+    }
+
+    return index;
+}
+
+uint32_t srph::runtime::TimerWheel::SlotOf(uint32_t level, uint32_t index) const
+{
+    return level == 0 ? index : ROOT_SLOTS + (level - 1) * LEVEL_SLOTS + index;
+}
+
+void srph::runtime::TimerWheel::Free(uint32_t index)
+{
+    m_timers[index].generation++;
+    m_freeTimers.push_back(index);
+    m_active--;
+}
+
+uint32_t srph::runtime::TimerWheel::IndexOf(TimerId id) const
+{
+    const auto index = static_cast<uint32_t>(id & UINT32_MAX);
+    const auto generation = static_cast<uint32_t>(id >> 32);
+
+    if (index >= m_timers.size() || m_timers[index].generation != generation || !m_timers[index].callback) return NONE;
+    return index;
+}
+
+void srph::runtime::TimerWheel::Fire(asIScriptFunction* callback)
+{
+    if (!m_context) m_context = m_engine->GetContext();
+
+    const bool delegate = callback->GetFuncType() == asFUNC_DELEGATE;
+    if (m_context->Prepare(delegate ? callback->GetDelegateFunction() : callback) < 0) return;
+    if (delegate) m_context->SetObject(callback->GetDelegateObject());
+
+    m_fireStart = std::chrono::steady_clock::now();
+    m_timedOut = false;
+
+    const int result = m_engine->Execute(m_context);
+    m_fired++;
+
+    if (result == asEXECUTION_EXCEPTION)
+    {
+        const char* declaration = m_context->GetExceptionFunction()->GetDeclaration(true, true);
+        m_engine->LogException(m_context, fmt::format("in timer callback {}", declaration));
+    }
+    else if (m_timedOut)
+    {
+        m_engine->TimedOut();
+    }
+
+    m_context->Unprepare();
+}
+
+void srph::runtime::TimerWheel::LineCallback(asIScriptContext* context)
+{
+    if (context != m_context || m_timedOut) return;
+
+    if (m_engine->AbortOnTimeout(context, m_fireStart, "Timer callback"))
+    {
+        m_timedOut = true;
+    }
+}
+
+uint64_t srph::runtime::TimerWheel::Ticks(double seconds) const
+{
+    // Scripts pass floats, 0.1f is slightly above 100 steps of a millisecond and must not become 101.
+    return std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(seconds / m_resolutionSeconds - 1e-3)));
+}
+
+srph::runtime::TimerId srph::runtime::TimerWheel::ScriptSetTimeout(asIScriptFunction* callback, float seconds)
+{
+    return Add(callback, seconds);
+}
+
+srph::runtime::TimerId srph::runtime::TimerWheel::ScriptSetInterval(asIScriptFunction* callback, float seconds)
+{
+    return Add(callback, seconds, seconds);
+}
+
+bool srph::runtime::TimerWheel::ScriptCancel(TimerId id) { return Cancel(id); }
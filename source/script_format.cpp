@@ -0,0 +1,83 @@
+#include "srph_common.hpp"
+#include "script_format.hpp"
+
+#include <fmt/args.h>
+
+#include "script_reflection.hpp"
+
+template <>
+struct fmt::formatter<srph::reflection::ObjectValue> : fmt::formatter<fmt::string_view>
+{
+    template <typename FormatContext>
+    auto format(const srph::reflection::ObjectValue& value, FormatContext& ctx) const
+    {
+        return fmt::format_to(ctx.out(), "{}@{}", value.typeName, fmt::ptr(value.address));
+    }
+};
+
+namespace
+{
+using ArgStore = fmt::dynamic_format_arg_store<fmt::format_context>;
+
+struct PushArg
+{
+    ArgStore& store;
+
+    void operator()(srph::reflection::NullValue) const { store.push_back(fmt::string_view("null")); }
+    void operator()(srph::reflection::VoidValue) const { store.push_back(fmt::string_view("void")); }
+    void operator()(srph::reflection::UnknownValue) const { store.push_back(fmt::string_view("<unknown type>")); }
+    void operator()(const std::string* value) const { store.push_back(fmt::string_view(*value)); }
+
+    template <typename T>
+    void operator()(const T& value) const
+    {
+        store.push_back(value);
+    }
+};
+}  // namespace
+
+bool srph::formatting::FormatArgs(asIScriptGeneric* generic, unsigned fmtArg, fmt::memory_buffer& out)
+{
+    // The store is reused so a steady stream of format calls does not allocate for the arguments.
+    thread_local ArgStore store;
+    store.clear();
+
+    const asIScriptEngine* engine = generic->GetEngine();
+    const std::string& format = *static_cast<std::string*>(generic->GetArgAddress(fmtArg));
+
+    const int argCount = generic->GetArgCount();
+    for (int i = static_cast<int>(fmtArg) + 1; i < argCount; i++)
+    {
+        reflection::Value value = reflection::ReadValue(generic->GetArgTypeId(i), generic->GetArgAddress(i), engine);
+        std::visit(PushArg{store}, value);
+    }
+
+    try
+    {
+        fmt::vformat_to(std::back_inserter(out), format, store);
+    }
+    catch (const fmt::format_error& e)
+    {
+        asIScriptContext* context = asGetActiveContext();
+        if (context)
+        {
+            context->SetException(e.what());
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void srph::formatting::ScriptFormat(asIScriptGeneric* generic)
+{
+    fmt::memory_buffer buffer;
+    if (FormatArgs(generic, 0, buffer))
+    {
+        new (generic->GetAddressOfReturnLocation()) std::string(buffer.data(), buffer.size());
+    }
+    else
+    {
+        new (generic->GetAddressOfReturnLocation()) std::string();
+    }
+}
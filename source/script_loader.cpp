@@ -1,7 +1,30 @@
 #include "srph_common.hpp"
 #include "script_loader.hpp"
 
+#include <chrono>
+
 #include "engine.hpp"
+#include "runtime/event_bus.hpp"
+#include "runtime/garbage_collector.hpp"
+#include "jit/aot.hpp"
+#include "jit/inliner.hpp"
+#include "debugger/debugger.hpp"
+
+// The phase times of a build are kept by the module, the public interface doesn't expose them.
+#include "angelscript/source/as_module.h"
+
+namespace
+{
+uint64_t ToNanos(double seconds) { return static_cast<uint64_t>(seconds * 1e9); }
+
+uint64_t NanosSince(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+double ToMillis(uint64_t nanos) { return static_cast<double>(nanos) / 1e6; }
+}  // namespace
 
 srph::ScriptLoader::ScriptLoader(Engine* engine) { m_engine = engine; }
 
@@ -17,23 +40,74 @@ srph::ScriptLoader& srph::ScriptLoader::LoadScript(const std::string& path)
     return *this;
 }
 
+srph::ScriptLoader& srph::ScriptLoader::GenerateAot(const std::string& path)
+{
+    m_aotPath = path;
+    return *this;
+}
+
+srph::ScriptLoader& srph::ScriptLoader::InlineAccessors(bool enabled)
+{
+    m_inlineAccessors = enabled;
+    return *this;
+}
+
 bool srph::ScriptLoader::Build()
+{
+    m_profile = BuildProfile();
+    m_inlining = jit::InlineStats();
+    const auto start = std::chrono::steady_clock::now();
+    // Discarding the previous module releases its objects
+    runtime::ScriptAccess access(m_engine->m_garbageCollector);
+    const bool built = BuildModule();
+    m_profile.totalNanos = NanosSince(start);
+
+    if (m_engine->m_configuration.logBuildProfile)
+    {
+        SRPH_LOG_INFO("Built module {} in {:.2f} ms: load {:.2f}, parse {:.2f}, register {:.2f}, compile functions {:.2f}, "
+                      "init globals {:.2f}",
+                      m_moduleName, ToMillis(m_profile.totalNanos), ToMillis(m_profile.loadNanos),
+                      ToMillis(m_profile.parseNanos), ToMillis(m_profile.registrationNanos),
+                      ToMillis(m_profile.compileFunctionsNanos), ToMillis(m_profile.initGlobalsNanos));
+    }
+
+    return built;
+}
+
+bool srph::ScriptLoader::BuildModule()
 {
     m_engine->m_built = false;
+    if (m_engine->m_debugger) m_engine->m_debugger->ForgetFunctions();
+    // The module is replaced, the new one and its functions and types may reuse the old addresses.
+    m_engine->m_moduleCache.clear();
+    m_engine->m_functionCache.clear();
     CScriptBuilder builder;
     SRPH_VERIFY(builder.StartNewModule(m_engine->GetEngine(), m_moduleName.c_str()), "Failed to create module.")
+    m_engine->AssignMemoryAccount(builder.GetModule());
+    const auto loadStart = std::chrono::steady_clock::now();
     for (auto& script : m_scripts)
     {
         builder.AddSectionFromFile(script.c_str());
     }
+    m_profile.loadNanos = NanosSince(loadStart);
 
     int r = builder.BuildModule();
+    const asSBuildTimes& times = static_cast<asCModule*>(builder.GetModule())->m_buildTimes;
+    m_profile.parseNanos = ToNanos(times.parse);
+    m_profile.registrationNanos = ToNanos(times.registration);
+    m_profile.compileFunctionsNanos = ToNanos(times.compileFunctions);
+    m_profile.initGlobalsNanos = ToNanos(times.initGlobals);
     if (r != 0)
     {
         return false;
     }
     m_engine->m_built = true;
     asIScriptModule* module = m_engine->m_engine->GetModule(m_moduleName.c_str());
+    if (m_inlineAccessors.value_or(m_engine->m_configuration.inlineAccessors))
+    {
+        m_inlining = jit::InlineAccessors(module);
+    }
+
     for (asUINT i = 0; i < module->GetObjectTypeCount(); i++)
     {
         asITypeInfo* type = module->GetObjectTypeByIndex(i);
@@ -53,5 +127,19 @@ bool srph::ScriptLoader::Build()
             }
         }
     }
+
+    m_engine->m_eventBus->AddModule(module);
+
+    if (!m_aotPath.empty())
+    {
+        if (!m_engine->m_aot)
+        {
+            SRPH_LOG_ERROR("GenerateAot needs EngineConfiguration::aot, the build has no JIT instructions.");
+            return false;
+        }
+
+        return m_engine->m_aot->Generate(module, m_aotPath);
+    }
+
     return true;
 }
\ No newline at end of file
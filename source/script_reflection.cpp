@@ -1,6 +1,28 @@
 #include "srph_common.hpp"
 #include "script_reflection.hpp"
 
+namespace
+{
+struct Stringify
+{
+    std::string operator()(srph::reflection::NullValue) const { return "null"; }
+    std::string operator()(srph::reflection::VoidValue) const { return "void"; }
+    std::string operator()(srph::reflection::UnknownValue) const { return "<unknown type>"; }
+    std::string operator()(bool v) const { return v ? "true" : "false"; }
+    std::string operator()(const std::string* v) const { return "\"" + *v + "\""; }
+    std::string operator()(const srph::reflection::ObjectValue& v) const
+    {
+        return std::string(v.typeName) + "@" + std::to_string(reinterpret_cast<uintptr_t>(v.address));
+    }
+
+    template <typename T>
+    std::string operator()(T v) const
+    {
+        return std::to_string(v);
+    }
+};
+}  // namespace
+
 std::vector<srph::ReflectedProperty> srph::reflection::ReflectProperties(asIScriptObject* obj, const asIScriptEngine* engine)
 {
     const asUINT props = obj->GetPropertyCount();
@@ -36,64 +58,71 @@ std::vector<srph::ReflectedProperty> srph::reflection::ReflectProperties(asIScri
     return out;
 }
 
-std::string srph::reflection::GetValue(int typeId, void* value, const asIScriptEngine* engine)
+srph::reflection::Value srph::reflection::ReadValue(int typeId, void* value, const asIScriptEngine* engine)
 {
-    if (!value) return "null";
+    if (!value) return NullValue{};
 
     int baseTypeId = typeId & ~(asTYPEID_OBJHANDLE | asTYPEID_HANDLETOCONST);
 
     switch (baseTypeId)
     {
         case asTYPEID_VOID:
-            return "void";
+            return VoidValue{};
         case asTYPEID_BOOL:
-            return *static_cast<bool*>(value) ? "true" : "false";
+            return *static_cast<bool*>(value);
         case asTYPEID_INT8:
-            return std::to_string(*static_cast<int8_t*>(value));
+            return *static_cast<int8_t*>(value);
         case asTYPEID_INT16:
-            return std::to_string(*static_cast<int16_t*>(value));
+            return *static_cast<int16_t*>(value);
         case asTYPEID_INT32:
-            return std::to_string(*static_cast<int32_t*>(value));
+            return *static_cast<int32_t*>(value);
         case asTYPEID_INT64:
-            return std::to_string(*static_cast<int64_t*>(value));
+            return *static_cast<int64_t*>(value);
         case asTYPEID_UINT8:
-            return std::to_string(*static_cast<uint8_t*>(value));
+            return *static_cast<uint8_t*>(value);
         case asTYPEID_UINT16:
-            return std::to_string(*static_cast<uint16_t*>(value));
+            return *static_cast<uint16_t*>(value);
         case asTYPEID_UINT32:
-            return std::to_string(*static_cast<uint32_t*>(value));
+            return *static_cast<uint32_t*>(value);
         case asTYPEID_UINT64:
-            return std::to_string(*static_cast<uint64_t*>(value));
+            return *static_cast<uint64_t*>(value);
         case asTYPEID_FLOAT:
-            return std::to_string(*static_cast<float*>(value));
+            return *static_cast<float*>(value);
         case asTYPEID_DOUBLE:
-            return std::to_string(*static_cast<double*>(value));
+            return *static_cast<double*>(value);
         default:
+            asITypeInfo* typeInfo = engine->GetTypeInfoById(typeId);
+            if (!typeInfo) return UnknownValue{};
+
+            if (typeInfo->GetFlags() & asOBJ_ENUM)
+            {
+                return *static_cast<int32_t*>(value);
+            }
+
             if (typeId & asTYPEID_MASK_OBJECT)
             {
-                asITypeInfo* typeInfo = engine->GetTypeInfoById(typeId);
-                if (typeInfo)
+                if (strcmp(typeInfo->GetName(), "string") == 0)
                 {
-                    if (strcmp(typeInfo->GetName(), "string") == 0)
+                    if (typeId & asTYPEID_OBJHANDLE)
                     {
-                        if (typeId & asTYPEID_OBJHANDLE)
-                        {
-                            std::string* str = *static_cast<std::string**>(value);
-                            return str ? "\"" + *str + "\"" : "null";
-                        }
-                        else
-                        {
-                            return "\"" + *static_cast<std::string*>(value) + "\"";
-                        }
+                        std::string* str = *static_cast<std::string**>(value);
+                        return str ? Value(str) : Value(NullValue{});
                     }
 
-                    return std::string(typeInfo->GetName()) + "@" + std::to_string(reinterpret_cast<uintptr_t>(value));
+                    return static_cast<const std::string*>(value);
                 }
+
+                return ObjectValue{typeInfo->GetName(), value};
             }
-            return "<unknown type>";
+            return UnknownValue{};
     }
 }
 
+std::string srph::reflection::GetValue(int typeId, void* value, const asIScriptEngine* engine)
+{
+    return std::visit(Stringify{}, ReadValue(typeId, value, engine));
+}
+
 std::string srph::reflection::GetTypename(int typeId, const asIScriptEngine* engine)
 {
     std::string typeName;
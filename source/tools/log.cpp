@@ -0,0 +1,418 @@
+#include "tools/log.hpp"
+#include "tools/log_sinks.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t RING_CAPACITY = 256;
+constexpr size_t LEVEL_COUNT = static_cast<size_t>(srph::LogLevel::Critical) + 1;
+constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(5);
+constexpr auto LIMIT_REPORT_INTERVAL = std::chrono::seconds(1);
+
+// Single producer (the owning thread), single consumer (whoever holds the drain mutex).
+struct ThreadRing
+{
+    std::array<srph::LogRecord, RING_CAPACITY> records;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> limited{0};
+    std::atomic<bool> retired{false};
+
+    // Consumer-only
+    Clock::time_point lastLimitReport;
+
+    // Producer-only rate limiting state, starts with a full bucket
+    std::array<double, LEVEL_COUNT> tokens = MakeFullBucket();
+    Clock::time_point lastRefill = Clock::now();
+
+    static std::array<double, LEVEL_COUNT> MakeFullBucket()
+    {
+        std::array<double, LEVEL_COUNT> tokens;
+        tokens.fill(1e9);
+        return tokens;
+    }
+};
+
+struct LocalRing
+{
+    std::shared_ptr<ThreadRing> ring;
+
+    ~LocalRing()
+    {
+        if (ring) ring->retired.store(true, std::memory_order_release);
+    }
+};
+
+thread_local LocalRing t_ring;
+// Used once the backend is gone (static destruction), written synchronously.
+thread_local srph::LogRecord t_fallbackRecord;
+
+enum class BackendState : uint8_t
+{
+    NotStarted,
+    Running,
+    Destroyed
+};
+
+std::atomic<BackendState> g_backendState{BackendState::NotStarted};
+
+bool BackendDestroyed() { return g_backendState.load(std::memory_order_acquire) == BackendState::Destroyed; }
+
+class Backend
+{
+public:
+    static Backend& Instance()
+    {
+        static Backend backend;
+        return backend;
+    }
+
+    Backend()
+    {
+        m_sinks.push_back(std::make_shared<srph::ConsoleSink>());
+        for (auto& limit : m_rateLimits) limit.store(0);
+
+        g_backendState.store(BackendState::Running);
+        m_thread = std::thread([this]() { SinkLoop(); });
+    }
+
+    ~Backend()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_running = false;
+        }
+        m_wakeCV.notify_one();
+        m_thread.join();
+
+        Drain();
+        g_backendState.store(BackendState::Destroyed);
+    }
+
+    ThreadRing* Ring()
+    {
+        if (!t_ring.ring)
+        {
+            t_ring.ring = std::make_shared<ThreadRing>();
+            std::lock_guard<std::mutex> lock(m_ringsMutex);
+            m_rings.push_back(t_ring.ring);
+        }
+
+        return t_ring.ring.get();
+    }
+
+    bool Allow(ThreadRing* ring, srph::LogLevel level)
+    {
+        const uint32_t limit = m_rateLimits[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+        if (limit == 0) return true;
+
+        Clock::time_point now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - ring->lastRefill).count();
+        ring->lastRefill = now;
+
+        for (size_t i = 0; i < LEVEL_COUNT; i++)
+        {
+            const uint32_t levelLimit = m_rateLimits[i].load(std::memory_order_relaxed);
+            ring->tokens[i] = std::min(static_cast<double>(levelLimit), ring->tokens[i] + elapsed * levelLimit);
+        }
+
+        double& tokens = ring->tokens[static_cast<size_t>(level)];
+        if (tokens < 1.0) return false;
+
+        tokens -= 1.0;
+        return true;
+    }
+
+    void Drain()
+    {
+        std::lock_guard<std::mutex> drainLock(m_drainMutex);
+
+        std::vector<std::shared_ptr<ThreadRing>> rings;
+        {
+            std::lock_guard<std::mutex> lock(m_ringsMutex);
+            rings = m_rings;
+        }
+
+        std::lock_guard<std::mutex> sinkLock(m_sinkMutex);
+        bool wrote = false;
+
+        for (auto& ring : rings)
+        {
+            const bool retired = ring->retired.load(std::memory_order_acquire);
+
+            size_t tail = ring->tail.load(std::memory_order_relaxed);
+            const size_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++)
+            {
+                const srph::LogRecord& record = ring->records[tail % RING_CAPACITY];
+                WriteToSinks(record.level, record.Text());
+                wrote = true;
+            }
+            ring->tail.store(tail, std::memory_order_release);
+
+            if (uint64_t dropped = ring->dropped.exchange(0))
+            {
+                WriteToSinks(srph::LogLevel::Warn, fmt::format("{} log messages dropped, the log queue was full.", dropped));
+                wrote = true;
+            }
+            const bool reportLimited = retired || Clock::now() - ring->lastLimitReport >= LIMIT_REPORT_INTERVAL;
+            uint64_t limited = reportLimited ? ring->limited.exchange(0) : 0;
+            if (limited)
+            {
+                ring->lastLimitReport = Clock::now();
+                WriteToSinks(srph::LogLevel::Warn, fmt::format("{} log messages suppressed by the rate limit.", limited));
+                wrote = true;
+            }
+
+            if (retired)
+            {
+                std::lock_guard<std::mutex> lock(m_ringsMutex);
+                m_rings.erase(std::find(m_rings.begin(), m_rings.end(), ring));
+            }
+        }
+
+        if (wrote)
+        {
+            for (auto& sink : m_sinks) sink->Flush();
+        }
+    }
+
+    void WriteImmediate(srph::LogLevel level, std::string_view message)
+    {
+        std::lock_guard<std::mutex> sinkLock(m_sinkMutex);
+        WriteToSinks(level, message);
+        for (auto& sink : m_sinks) sink->Flush();
+    }
+
+    void AddSink(std::shared_ptr<srph::ILogSink> sink)
+    {
+        std::lock_guard<std::mutex> lock(m_sinkMutex);
+        m_sinks.push_back(std::move(sink));
+    }
+
+    void ClearSinks()
+    {
+        Drain();
+        std::lock_guard<std::mutex> lock(m_sinkMutex);
+        m_sinks.clear();
+    }
+
+    void SetRateLimit(srph::LogLevel level, uint32_t messagesPerSecond)
+    {
+        m_rateLimits[static_cast<size_t>(level)].store(messagesPerSecond);
+    }
+
+private:
+    void SinkLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        while (m_running)
+        {
+            m_wakeCV.wait_for(lock, DRAIN_INTERVAL);
+
+            lock.unlock();
+            Drain();
+            lock.lock();
+        }
+    }
+
+    void WriteToSinks(srph::LogLevel level, std::string_view message)
+    {
+        for (auto& sink : m_sinks) sink->Write(level, message);
+    }
+
+private:
+    std::mutex m_ringsMutex;
+    std::vector<std::shared_ptr<ThreadRing>> m_rings;
+
+    std::mutex m_sinkMutex;
+    std::vector<std::shared_ptr<srph::ILogSink>> m_sinks;
+
+    std::array<std::atomic<uint32_t>, LEVEL_COUNT> m_rateLimits;
+
+    std::mutex m_drainMutex;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCV;
+    bool m_running = true;
+    std::thread m_thread;
+};
+
+constexpr const char* LEVEL_COLORS[LEVEL_COUNT] = {"\033[32m", "\033[36m", "\033[35m", "\033[31m", "\033[31m"};
+constexpr const char* COLOR_RESET = "\033[0m";
+}  // namespace
+
+srph::LogRecord* srph::Log::Acquire(LogLevel level)
+{
+    if (BackendDestroyed())
+    {
+        // Logging during static destruction, the sink thread is gone so write it out directly.
+        t_fallbackRecord.level = level;
+        return &t_fallbackRecord;
+    }
+
+    Backend& backend = Backend::Instance();
+    ThreadRing* ring = backend.Ring();
+
+    if (!backend.Allow(ring, level))
+    {
+        ring->limited.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    const size_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= RING_CAPACITY)
+    {
+        if (level < LogLevel::Error)
+        {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // Writes the queued messages on this thread, which empties the ring since only this thread fills it
+        backend.Drain();
+    }
+
+    LogRecord* record = &ring->records[head % RING_CAPACITY];
+    record->level = level;
+    return record;
+}
+
+void srph::Log::Commit(LogRecord* record)
+{
+    if (record == &t_fallbackRecord)
+    {
+        ConsoleSink sink;
+        sink.Write(record->level, record->Text());
+        sink.Flush();
+        return;
+    }
+
+    ThreadRing* ring = t_ring.ring.get();
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void srph::Log::WriteImmediate(LogLevel level, std::string_view message)
+{
+    if (BackendDestroyed())
+    {
+        ConsoleSink sink;
+        sink.Write(level, message);
+        sink.Flush();
+        return;
+    }
+
+    Backend& backend = Backend::Instance();
+    backend.Drain();
+    backend.WriteImmediate(level, message);
+}
+
+void srph::Log::AddSink(std::shared_ptr<ILogSink> sink) { Backend::Instance().AddSink(std::move(sink)); }
+
+void srph::Log::ClearSinks() { Backend::Instance().ClearSinks(); }
+
+void srph::Log::SetRateLimit(LogLevel level, uint32_t messagesPerSecond)
+{
+    Backend::Instance().SetRateLimit(level, messagesPerSecond);
+}
+
+void srph::Log::Flush()
+{
+    if (!BackendDestroyed())
+    {
+        Backend::Instance().Drain();
+    }
+}
+
+const char* srph::Log::LevelName(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::Info:
+            return "info";
+        case LogLevel::Script:
+            return "script";
+        case LogLevel::Warn:
+            return "warn";
+        case LogLevel::Error:
+            return "error";
+        case LogLevel::Critical:
+            return "critical";
+    }
+
+    return "";
+}
+
+void srph::ConsoleSink::Write(LogLevel level, std::string_view message)
+{
+    fmt::format_to(std::back_inserter(m_buffer),
+                   "[{}{}{}] {}\n",
+                   LEVEL_COLORS[static_cast<size_t>(level)],
+                   Log::LevelName(level),
+                   COLOR_RESET,
+                   message);
+}
+
+void srph::ConsoleSink::Flush()
+{
+    fwrite(m_buffer.data(), 1, m_buffer.size(), stdout);
+    fflush(stdout);
+    m_buffer.clear();
+}
+
+srph::FileSink::FileSink(const std::string& path) { m_file = fopen(path.c_str(), "a"); }
+
+srph::FileSink::~FileSink()
+{
+    if (m_file)
+    {
+        Flush();
+        fclose(m_file);
+    }
+}
+
+void srph::FileSink::Write(LogLevel level, std::string_view message)
+{
+    fmt::format_to(std::back_inserter(m_buffer), "[{}] {}\n", Log::LevelName(level), message);
+}
+
+void srph::FileSink::Flush()
+{
+    if (m_file)
+    {
+        fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+        fflush(m_file);
+    }
+    m_buffer.clear();
+}
+
+void srph::MemorySink::Write(LogLevel level, std::string_view message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.size() >= m_capacity)
+    {
+        m_entries.pop_front();
+    }
+    m_entries.push_back({level, std::string(message)});
+}
+
+std::vector<srph::MemorySink::Entry> srph::MemorySink::Entries() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return {m_entries.begin(), m_entries.end()};
+}
+
+void srph::MemorySink::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}